@@ -30,6 +30,7 @@
 # include "util.h"
 # include <webvtt/string.h>
 # include <webvtt/node.h>
+# include <webvtt/region.h>
 
 #if defined(__cplusplus) || defined(c_plusplus)
 #define WEBVTT_CPLUSPLUS 1
@@ -65,6 +66,11 @@ webvtt_cue_settings_t {
   webvtt_uint position;
   webvtt_uint size;
   webvtt_align_type align;
+  /**
+   * The cue's region, or NULL. The cue keeps it alive, so it stays valid
+   * after the parser which read the cue is reset or deleted.
+   */
+  const webvtt_region *region;
 } webvtt_cue_settings;
 
 typedef struct
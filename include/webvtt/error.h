@@ -101,6 +101,43 @@ extern "C" {
     WEBVTT_CUE_CONTAINS_SEPARATOR,
     /* A webvtt cue contains only a cue-id, and no cuetimes or payload. */
     WEBVTT_CUE_INCOMPLETE,
+    /**
+     * A cue starts earlier than the cue before it.
+     * (Only reported by validators)
+     */
+    WEBVTT_CUE_OUT_OF_ORDER,
+    /* Unrecognized or malformed setting in a REGION block */
+    WEBVTT_INVALID_REGION_SETTING,
+    /* 'region' setting already exists for this cue. */
+    WEBVTT_REGION_ALREADY_SET,
+    /* 'region' value does not name a region defined in the header */
+    WEBVTT_REGION_BAD_VALUE,
+    /* A rule in a STYLE block is malformed, or its selector is unsupported */
+    WEBVTT_INVALID_STYLE_RULE,
+    /* A malformed UTF-8 sequence (see webvtt_set_utf8_mode) */
+    WEBVTT_INVALID_UTF8,
+    /**
+     * Errors for input beyond the parser's limits (see webvtt_set_limits).
+     * Each is reported once where the limit is reached, and never aborts
+     * parsing.
+     */
+    /* A line is longer than max_line_bytes */
+    WEBVTT_LINE_TOO_LONG,
+    /* A cue's text (or a STYLE block) is longer than max_body_bytes */
+    WEBVTT_CUE_TEXT_TOO_LONG,
+    /* More than max_cues cues, REGION and STYLE blocks */
+    WEBVTT_TOO_MANY_CUES,
+    /* A cue's text has more than max_nodes nodes */
+    WEBVTT_TOO_MANY_NODES,
+    /* Tags in a cue's text are nested deeper than max_depth */
+    WEBVTT_NESTING_TOO_DEEP,
+    /* The input is longer than max_total_bytes */
+    WEBVTT_INPUT_TOO_LONG,
+    /**
+     * The parser's state stack would grow past its fixed limit. Unlike the
+     * limits above, this one stops parsing.
+     */
+    WEBVTT_STATE_TOO_DEEP,
   };
   typedef enum webvtt_error_t webvtt_error;
 
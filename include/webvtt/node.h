@@ -28,6 +28,7 @@
 #ifndef __WEBVTT_NODE_H__
 # define __WEBVTT_NODE_H__
 # include <webvtt/string.h>
+# include <webvtt/style.h>
 
 #if defined(__cplusplus) || defined(c_plusplus)
 extern "C" {
@@ -114,6 +115,12 @@ webvtt_internal_node_data_t {
   webvtt_string lang;
   webvtt_stringlist *css_classes;
 
+  /**
+   * The declarations from the STYLE blocks of the file which apply to the
+   * node, or NULL if none do (see webvtt_get_node_style)
+   */
+  const webvtt_style *style;
+
   webvtt_uint alloc;
   webvtt_uint length;
   webvtt_node **children;
@@ -53,15 +53,333 @@ WEBVTT_EXPORT webvtt_status
 webvtt_create_parser( webvtt_cue_fn on_read, webvtt_error_fn on_error,
                       void * userdata, webvtt_parser *ppout );
 
+/**
+ * webvtt_create_validator
+ *
+ * create a parser which only checks its input. It runs the same state machine
+ * and reports the same errors (with line and column) as a parser created with
+ * webvtt_create_parser, but builds no cue objects and does no per-cue
+ * allocation. In addition, it reports WEBVTT_CUE_OUT_OF_ORDER when a cue
+ * starts before the cue preceding it.
+ *
+ * Use webvtt_parse_chunk, webvtt_finish_parsing and webvtt_delete_parser as
+ * with any other parser.
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_create_validator( webvtt_error_fn on_error, void *userdata,
+                         webvtt_parser *ppout );
+
 WEBVTT_EXPORT void
 webvtt_delete_parser( webvtt_parser parser );
 
+/**
+ * webvtt_reset_parser
+ *
+ * return a parser to the state it was in when created, so that it can parse
+ * another file. Any cue which has not been returned yet is discarded. The
+ * callbacks and userdata are kept, as is the storage of the parser's internal
+ * buffers, so that parsing many small files with one parser allocates less
+ * than creating a parser for each.
+ */
+WEBVTT_EXPORT void
+webvtt_reset_parser( webvtt_parser parser );
+
+/**
+ * An error collected by a parser (see webvtt_collect_errors)
+ */
+typedef struct webvtt_error_info_t {
+  webvtt_uint line;
+  webvtt_uint column;
+  webvtt_error error;
+} webvtt_error_info;
+
+/**
+ * webvtt_collect_errors
+ *
+ * rather than calling on_error for every error, append errors to a buffer
+ * with room for 'capacity' errors, to be drained in bulk with
+ * webvtt_drain_errors (for instance after each chunk). Errors which arrive
+ * while the buffer is full are discarded, and counted by
+ * webvtt_dropped_errors. Collected errors never abort parsing.
+ *
+ * A 'capacity' of 0 discards the buffer and returns to calling on_error.
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_collect_errors( webvtt_parser self, webvtt_uint capacity );
+
+/**
+ * webvtt_suppress_error
+ *
+ * stop reporting (or collecting) errors with the code 'error', or start again
+ * if 'suppress' is false. A suppressed error never aborts parsing, but is
+ * still counted by webvtt_error_count.
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_suppress_error( webvtt_parser self, webvtt_error error,
+                       webvtt_bool suppress );
+
+/**
+ * webvtt_drain_errors
+ *
+ * move up to 'max' collected errors, oldest first, into 'out'. Returns the
+ * number of errors moved.
+ */
+WEBVTT_EXPORT webvtt_uint
+webvtt_drain_errors( webvtt_parser self, webvtt_error_info *out,
+                     webvtt_uint max );
+
+/**
+ * The number of times 'error' has occurred since the parser was created or
+ * reset, whether it was reported, collected, suppressed or dropped.
+ */
+WEBVTT_EXPORT webvtt_uint
+webvtt_error_count( webvtt_parser self, webvtt_error error );
+
+/**
+ * The number of errors which did not fit in the collection buffer since the
+ * parser was created or reset.
+ */
+WEBVTT_EXPORT webvtt_uint
+webvtt_dropped_errors( webvtt_parser self );
+
+/**
+ * webvtt_get_region
+ *
+ * get a region defined by a REGION block in the header of the file being
+ * parsed, in the order they were defined. The parser's references are
+ * dropped when it is reset or deleted, but a cue keeps its own region
+ * ('settings.region') alive. Returns NULL if 'index' is out of range.
+ */
+WEBVTT_EXPORT const webvtt_region *
+webvtt_get_region( webvtt_parser self, int index );
+
+/**
+ * The number of regions defined so far in the file being parsed
+ */
+WEBVTT_EXPORT webvtt_uint
+webvtt_region_count( webvtt_parser self );
+
+/**
+ * webvtt_get_node_style
+ *
+ * get the declarations which apply to 'node'. STYLE blocks in the header are
+ * compiled once, and the rules matching each node of a cue's text are found
+ * while the cue is parsed, so that nodes which look alike (same kind, classes,
+ * voice and language) share a style. Rendering a node then needs no selector
+ * matching.
+ *
+ * The declarations are stored in '*pdeclarations' in cascade order (later
+ * ones override earlier ones), and their number is returned. They belong to
+ * the node's style ('internal_data->style'), which the node keeps alive after
+ * its parser has been reset or deleted.
+ */
+WEBVTT_EXPORT webvtt_uint
+webvtt_get_node_style( const webvtt_node *node,
+                       const webvtt_declaration **pdeclarations );
+
+/**
+ * How a parser treats malformed UTF-8 in its input (see webvtt_set_utf8_mode)
+ */
+typedef enum webvtt_utf8_mode_t {
+  /* Parse the input as it is (the default) */
+  WEBVTT_UTF8_TRUST = 0,
+  /* Report each malformed sequence, and parse it as it is */
+  WEBVTT_UTF8_VALIDATE,
+  /* Report each malformed sequence, and parse U+FFFD in its place */
+  WEBVTT_UTF8_REPAIR
+} webvtt_utf8_mode;
+
+/**
+ * webvtt_set_utf8_mode
+ *
+ * check the input for malformed UTF-8 before it is parsed. Each malformed
+ * sequence is reported as WEBVTT_INVALID_UTF8, at the line and column (in
+ * bytes) where it starts. In WEBVTT_UTF8_VALIDATE mode, parsing stops at the
+ * first one if on_error asks to abort. In WEBVTT_UTF8_REPAIR mode parsing
+ * always goes on, and every string the parser produces is well-formed UTF-8.
+ *
+ * Sequences split between chunks are checked whole. Set the mode before the
+ * first chunk of a file; it is kept by webvtt_reset_parser.
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_set_utf8_mode( webvtt_parser self, webvtt_utf8_mode mode );
+
+/**
+ * Limits on what a parser reads from one file (see webvtt_set_limits). A
+ * limit of 0 means no limit. Each limit has its own error code, reported
+ * once where the limit is reached; parsing always goes on.
+ */
+typedef struct webvtt_limits_t {
+  /**
+   * Bytes of a line (65536 by default). The rest of a longer line is skipped
+   * (WEBVTT_LINE_TOO_LONG).
+   */
+  webvtt_uint max_line_bytes;
+  /**
+   * Bytes of a cue's text, or of the text of a STYLE block. Text beyond it is
+   * skipped, and the cue is returned with what fits
+   * (WEBVTT_CUE_TEXT_TOO_LONG).
+   */
+  webvtt_uint max_body_bytes;
+  /**
+   * Cues, REGION and STYLE blocks in a file. Blocks beyond it are skipped
+   * (WEBVTT_TOO_MANY_CUES).
+   */
+  webvtt_uint max_cues;
+  /**
+   * Nodes in a cue's text. The text after the node which reaches the limit
+   * is skipped (WEBVTT_TOO_MANY_NODES).
+   */
+  webvtt_uint max_nodes;
+  /**
+   * Depth of nested tags in a cue's text. Start tags deeper than this are
+   * ignored, and their text goes to the enclosing node
+   * (WEBVTT_NESTING_TOO_DEEP).
+   */
+  webvtt_uint max_depth;
+  /**
+   * Bytes of input. The input is cut off at the limit, and the parser
+   * finishes as if it had ended there: the cue being read is returned, and
+   * webvtt_parse_chunk returns WEBVTT_PARSE_ERROR for the chunk which crosses
+   * the limit and for every later one (WEBVTT_INPUT_TOO_LONG).
+   */
+  webvtt_uint64 max_total_bytes;
+} webvtt_limits;
+
+/**
+ * webvtt_set_limits
+ *
+ * bound what a parser will read from untrusted input. With every limit set,
+ * the memory a parser holds (not counting the cues it has returned) has an
+ * upper bound whatever the input. Set the limits before the first chunk of a
+ * file; they are kept by webvtt_reset_parser. The parser's internal state
+ * stack has a fixed limit of its own, reported as WEBVTT_STATE_TOO_DEEP.
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_set_limits( webvtt_parser self, const webvtt_limits *limits );
+
+/**
+ * Get the limits of a parser, for instance to change one of them
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_get_limits( webvtt_parser self, webvtt_limits *out );
+
+/**
+ * webvtt_get_parser_stats
+ *
+ * get the memory allocated on behalf of the parser since it was created (see
+ * webvtt_parser_stats): the number of allocations and bytes requested, the
+ * bytes still live and their peak, each in total and by kind of object.
+ * The counts are kept per parser, so parsers on different threads do not
+ * contend for them. They are not cleared by webvtt_reset_parser; compare two
+ * snapshots to measure one file.
+ *
+ * Returns WEBVTT_NOT_SUPPORTED, with all counts 0, if allocation stats were
+ * off when the parser was created (see webvtt_set_alloc_stats).
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_get_parser_stats( webvtt_parser self, webvtt_parser_stats *out );
+
+/**
+ * Phases of parsing timed by a profiling parser (see webvtt_set_profiling).
+ * A phase's time includes the phases it calls: WEBVTT_PHASE_PARSE includes
+ * WEBVTT_PHASE_TIMINGS, which includes WEBVTT_PHASE_SETTINGS.
+ */
+typedef enum webvtt_phase_t {
+  WEBVTT_PHASE_PARSE = 0,     /* the line state machine (parse_webvtt) */
+  WEBVTT_PHASE_READ_CUETEXT,  /* collecting the lines of a cue's text */
+  WEBVTT_PHASE_PARSE_CUETEXT, /* building a cue's node tree */
+  WEBVTT_PHASE_TIMINGS,       /* a cue's timings and settings line */
+  WEBVTT_PHASE_SETTINGS,      /* the settings part of it */
+  WEBVTT_PHASES
+} webvtt_phase;
+
+/**
+ * Room for every parse state in webvtt_profile (see webvtt_parse_state_name)
+ */
+#define WEBVTT_PARSE_STATES 32
+
+typedef struct webvtt_profile_t {
+  /* Time spent in each phase, if profiling was on, and how often it ran */
+  webvtt_uint64 nanoseconds[ WEBVTT_PHASES ];
+  webvtt_uint64 calls[ WEBVTT_PHASES ];
+  webvtt_uint64 bytes;
+  webvtt_uint64 lines;
+  /* Cues returned to on_read (or checked, by a validator), or discarded */
+  webvtt_uint64 cues_emitted;
+  webvtt_uint64 cues_dropped;
+  /* Tokens handled by the state machine in each parse state */
+  webvtt_uint64 transitions[ WEBVTT_PARSE_STATES ];
+} webvtt_profile;
+
+/**
+ * webvtt_set_profiling
+ *
+ * time each webvtt_phase while parsing. The other counts in webvtt_profile
+ * are kept whether or not profiling is on, as they cost next to nothing.
+ *
+ * All of it can be left out of the library by building with
+ * WEBVTT_PROFILING=0, in which case this and webvtt_get_profile return
+ * WEBVTT_NOT_SUPPORTED.
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_set_profiling( webvtt_parser self, webvtt_bool enable );
+
+/**
+ * webvtt_get_profile
+ *
+ * get the times and counts recorded since the parser was created or reset
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_get_profile( webvtt_parser self, webvtt_profile *out );
+
+/**
+ * The name of a parse state, as indexed in webvtt_profile::transitions, or
+ * NULL if there is no such state
+ */
+WEBVTT_EXPORT const char *
+webvtt_parse_state_name( webvtt_uint state );
+
 WEBVTT_EXPORT webvtt_status
 webvtt_parse_chunk( webvtt_parser self, const void *buffer, webvtt_uint len );
 
 WEBVTT_EXPORT webvtt_status
 webvtt_finish_parsing( webvtt_parser self );
 
+/**
+ * How much of a chunk webvtt_parse_chunk_budget may parse in one call. A
+ * budget of 0 means no limit.
+ */
+typedef struct webvtt_parse_budget_t {
+  /* Bytes of input */
+  webvtt_uint max_bytes;
+  /* Time spent parsing, measured on a monotonic clock */
+  webvtt_uint64 max_nanoseconds;
+} webvtt_parse_budget;
+
+/**
+ * webvtt_parse_chunk_budget
+ *
+ * parse the start of a chunk, stopping once 'budget' is spent, and store in
+ * 'consumed' how many bytes of it were parsed. The caller resumes by passing
+ * the rest of the chunk (buffer + consumed) to a later call, on its own or
+ * followed by more input; the cues and errors are the same as if the input
+ * had been parsed in one call.
+ *
+ * The parser stops just after a line break, so that it does not hold a
+ * partial line between calls, unless a line is longer than the byte budget
+ * or than the slice of input parsed between two looks at the clock. The
+ * time budget is checked every few kilobytes; a call always parses at least
+ * one slice, so it may overrun the budget by the time that takes.
+ *
+ * Returns as webvtt_parse_chunk does. 'consumed' is less than 'len' only
+ * if the budget ran out, or if parsing failed.
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_parse_chunk_budget( webvtt_parser self, const void *buffer,
+                           webvtt_uint len, const webvtt_parse_budget *budget,
+                           webvtt_uint *consumed );
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }
 #endif
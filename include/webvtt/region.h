@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __WEBVTT_REGION_H__
+# define __WEBVTT_REGION_H__
+# include "util.h"
+# include <webvtt/string.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/**
+ * An index which names no region (see webvtt_get_region)
+ */
+#define WEBVTT_NO_REGION (-1)
+
+typedef enum
+webvtt_scroll_type_t {
+  WEBVTT_SCROLL_NONE = 0,
+  WEBVTT_SCROLL_UP = 1
+} webvtt_scroll_type;
+
+/**
+ * A region defined by a REGION block in the file header. Percentages are
+ * whole numbers from 0 to 100. A region does not change once its block has
+ * been read, and is kept alive by the parser which read it and by each cue
+ * placed in it.
+ */
+typedef struct
+webvtt_region_t {
+  /**
+   * PRIVATE.
+   */
+  struct webvtt_refcount_t refs;
+
+  /**
+   * PUBLIC:
+   */
+  webvtt_string id;
+  webvtt_uint width;
+  webvtt_uint lines;
+  webvtt_uint region_anchor_x;
+  webvtt_uint region_anchor_y;
+  webvtt_uint viewport_anchor_x;
+  webvtt_uint viewport_anchor_y;
+  webvtt_scroll_type scroll;
+} webvtt_region;
+
+/**
+ * Keep 'region' alive after its cues and parser have released it
+ */
+WEBVTT_EXPORT void
+webvtt_ref_region( const webvtt_region *region );
+
+WEBVTT_EXPORT void
+webvtt_release_region( const webvtt_region **pregion );
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif
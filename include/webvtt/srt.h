@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __WEBVTT_SRT_H__
+# define __WEBVTT_SRT_H__
+# include "parser.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/**
+ * SubRip (.srt) reader
+ *
+ * Reads SubRip text chunk by chunk and produces webvtt_cue objects directly,
+ * using the same callbacks as the WebVTT parser. Timestamps use a comma as
+ * the decimal separator, the numeric index of each block becomes the cue-id,
+ * and the common SubRip markup (<b>, <i>, <u>, <font color=...>) is mapped
+ * onto WebVTT cue text before the cue text parser builds the node tree.
+ *
+ * Only the line currently being read and the cue being built are held in
+ * memory, regardless of the size of the input.
+ */
+typedef struct webvtt_srt_reader_t *webvtt_srt_reader;
+
+WEBVTT_EXPORT webvtt_status
+webvtt_create_srt_reader( webvtt_cue_fn on_read, webvtt_error_fn on_error,
+                          void *userdata, webvtt_srt_reader *ppout );
+
+WEBVTT_EXPORT void
+webvtt_delete_srt_reader( webvtt_srt_reader reader );
+
+WEBVTT_EXPORT webvtt_status
+webvtt_srt_parse_chunk( webvtt_srt_reader self, const void *buffer,
+                        webvtt_uint len );
+
+WEBVTT_EXPORT webvtt_status
+webvtt_srt_finish_parsing( webvtt_srt_reader self );
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif
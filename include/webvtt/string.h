@@ -41,9 +41,25 @@ typedef struct webvtt_string_data_t webvtt_string_data;
 typedef struct webvtt_stringlist_t webvtt_stringlist;
 struct webvtt_string_data_t;
 
+/**
+ * Text of up to WEBVTT_SMALL_STRING bytes (cue ids, tag names, classes,
+ * annotations and the like) is kept in the string itself rather than in
+ * allocated data, so that it costs no allocation. Such a string is never
+ * shared: copying it copies the text, so the text of a copy is not at the
+ * same address as the original's, and does not outlive the copy. Use
+ * webvtt_string_text and webvtt_string_length rather than 'd' to read any
+ * string.
+ *
+ * This makes a webvtt_string 24 bytes rather than one pointer on 64-bit
+ * systems, so code built against older headers must be rebuilt.
+ */
+#define WEBVTT_SMALL_STRING 14
+
 struct
 webvtt_string_t {
   webvtt_string_data *d;
+  webvtt_uint8 small_length;
+  char small[ WEBVTT_SMALL_STRING + 1 ];
 };
 
 /**
@@ -116,6 +132,24 @@ webvtt_release_string( webvtt_string *str );
 WEBVTT_EXPORT webvtt_status
 webvtt_string_detach( webvtt_string *str );
 
+/**
+ * webvtt_string_reserve
+ *
+ * make room for at least 'capacity' bytes of text, so that the string can be
+ * filled without reallocating. the string is detached if it is shared.
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_string_reserve( webvtt_string *str, webvtt_uint capacity );
+
+/**
+ * webvtt_string_shrink_to_fit
+ *
+ * release the capacity a string holds beyond its length. text which is shared
+ * is left as it is.
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_string_shrink_to_fit( webvtt_string *str );
+
 /**
  * webvtt_copy_string
  *
@@ -127,7 +161,9 @@ webvtt_copy_string( webvtt_string *left, const webvtt_string *right );
 /**
  * webvtt_string_text
  *
- * return the text contents of a string
+ * return the text contents of a string. the text may be held in 'str' itself
+ * (see WEBVTT_SMALL_STRING), so it is only valid while 'str' is alive and
+ * unchanged, even if other strings share its text.
  */
 WEBVTT_EXPORT const char *
 webvtt_string_text( const webvtt_string *str );
@@ -338,6 +374,57 @@ webvtt_utf8_chcount( const char *utf8, const char *end );
 WEBVTT_EXPORT int
 webvtt_utf8_length( const char *utf8 );
 
+/**
+ * webvtt_utf8_decode
+ *
+ * return the code point of the character at 'begin', and move 'begin' past
+ * it. malformed sequences decode as U+FFFD. returns 0 at 'end'.
+ */
+WEBVTT_EXPORT webvtt_uint32
+webvtt_utf8_decode( const char **begin, const char *end );
+
+/**
+ * webvtt_utf8_to_utf16_buffer
+ *
+ * convert the utf8 text from 'utf8' to 'end' to utf16 in 'out', which has
+ * room for 'capacity' units. returns the number of units written. conversion
+ * stops before a character which would not fit, and 'next' (if not NULL) is
+ * set to the first character not converted.
+ */
+WEBVTT_EXPORT webvtt_uint
+webvtt_utf8_to_utf16_buffer( const char *utf8, const char *end,
+                             webvtt_uint16 *out, webvtt_uint capacity,
+                             const char **next );
+
+/**
+ * webvtt_utf8_to_utf32_buffer
+ *
+ * as webvtt_utf8_to_utf16_buffer, writing one code point per character
+ */
+WEBVTT_EXPORT webvtt_uint
+webvtt_utf8_to_utf32_buffer( const char *utf8, const char *end,
+                             webvtt_uint32 *out, webvtt_uint capacity,
+                             const char **next );
+
+/**
+ * webvtt_utf8_utf16_length
+ *
+ * return the number of utf16 units needed to hold the utf8 text from 'utf8'
+ * to 'end'
+ */
+WEBVTT_EXPORT webvtt_uint
+webvtt_utf8_utf16_length( const char *utf8, const char *end );
+
+/**
+ * webvtt_utf8_validate
+ *
+ * return a pointer to the first malformed sequence in the utf8 text from
+ * 'utf8' to 'end', or 'end' if it is all well-formed. a sequence cut short by
+ * 'end' is malformed. (non-characters are well-formed.)
+ */
+WEBVTT_EXPORT const char *
+webvtt_utf8_validate( const char *utf8, const char *end );
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }
 #endif
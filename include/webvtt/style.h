@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __WEBVTT_STYLE_H__
+# define __WEBVTT_STYLE_H__
+# include "util.h"
+# include <webvtt/string.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/**
+ * A CSS declaration from a STYLE block, eg. "color" and "lime" for
+ * "color: lime". The value is kept as written, without the trailing ';'.
+ */
+typedef struct
+webvtt_declaration_t {
+  webvtt_string property;
+  webvtt_string value;
+} webvtt_declaration;
+
+/**
+ * The declarations which apply to a node of cue text, in cascade order (later
+ * ones override earlier ones). Nodes which look alike (same kind, classes,
+ * voice and language) share a style. A style does not change once it has
+ * been resolved, and is kept alive by the parser which resolved it and by
+ * each node it applies to.
+ */
+typedef struct
+webvtt_style_t {
+  /**
+   * PRIVATE.
+   */
+  struct webvtt_refcount_t refs;
+
+  /**
+   * PUBLIC:
+   */
+  webvtt_declaration *declarations;
+  webvtt_uint count;
+} webvtt_style;
+
+/**
+ * Keep 'style' alive after its nodes and parser have released it
+ */
+WEBVTT_EXPORT void
+webvtt_ref_style( const webvtt_style *style );
+
+WEBVTT_EXPORT void
+webvtt_release_style( const webvtt_style **pstyle );
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif
@@ -181,6 +181,47 @@ extern "C" {
                                            webvtt_free_fn_ptr free,
                                            void *userdata );
 
+  /**
+   * What a block of memory is for, as broken down in webvtt_parser_stats.
+   * Anything not listed (the parser itself, regions, style sheets, cue text
+   * tokens, collected errors) is WEBVTT_OBJECT_OTHER.
+   */
+  typedef enum
+  webvtt_object_kind_t {
+    WEBVTT_OBJECT_OTHER = 0,
+    WEBVTT_OBJECT_CUE,
+    WEBVTT_OBJECT_STRING,     /* webvtt_string data */
+    WEBVTT_OBJECT_NODE,
+    WEBVTT_OBJECT_NODE_DATA,  /* internal node data and child arrays */
+    WEBVTT_OBJECT_STRINGLIST, /* lists and their item arrays */
+    WEBVTT_OBJECT_STACK,      /* parser state stack grown past its inline one */
+    WEBVTT_OBJECT_KINDS
+  } webvtt_object_kind;
+
+  typedef struct
+  webvtt_object_stats_t {
+    webvtt_uint64 allocations;
+    webvtt_uint64 bytes;      /* requested, over all allocations */
+    webvtt_uint64 live_bytes; /* requested and not yet freed */
+  } webvtt_object_stats;
+
+  /**
+   * Memory allocated on behalf of one parser: everything allocated while one
+   * of its functions was running (including the callbacks it makes). A block
+   * is counted against the parser that allocated it until it is freed, even
+   * if that happens outside the parser or after it has been deleted, so
+   * live_bytes includes cues still held by the application.
+   */
+  typedef struct
+  webvtt_parser_stats_t {
+    webvtt_uint64 allocations;
+    webvtt_uint64 frees;
+    webvtt_uint64 bytes;
+    webvtt_uint64 live_bytes;
+    webvtt_uint64 peak_live_bytes;
+    webvtt_object_stats objects[ WEBVTT_OBJECT_KINDS ];
+  } webvtt_parser_stats;
+
   enum
   webvtt_status_t {
     WEBVTT_SUCCESS = 0,
@@ -243,7 +284,13 @@ extern "C" {
     WEBVTT_ALREADY_POSITION = -27,
     WEBVTT_ALREADY_SIZE = -28,
     WEBVTT_ALREADY_VERTICAL = -29,
-    WEBVTT_ALREADY_CUESETTING_END = -29
+    WEBVTT_ALREADY_CUESETTING_END = -29,
+
+    /**
+     * 'region' cue-setting status errors
+     */
+    WEBVTT_BAD_REGION = -30,
+    WEBVTT_ALREADY_REGION = -31
   };
 
   typedef enum webvtt_status_t webvtt_status;
@@ -253,6 +300,16 @@ extern "C" {
    */
 # define WEBVTT_FAILED(status) ( (status) != WEBVTT_SUCCESS )
 
+  /**
+   * Turn per-parser allocation stats (see webvtt_get_parser_stats) on or off
+   * for the parsers created afterwards. They are off by default, as each
+   * block then carries a small header recording what it is counted against.
+   * Like webvtt_set_allocator, this only works while nothing is allocated;
+   * otherwise it returns WEBVTT_UNSUCCESSFUL, unless the setting is already
+   * the one asked for.
+   */
+  WEBVTT_EXPORT webvtt_status webvtt_set_alloc_stats( webvtt_bool enable );
+
   struct
   webvtt_refcount_t {
 # if WEBVTT_OS_WIN32
@@ -272,8 +329,18 @@ extern "C" {
 # define WEBVTT_REF_INIT(Value) { (Value) }
 
   /**
-   * TODO: Replace these with atomic instructions for systems that provide it
+   * Objects may be shared by cues released on different threads (a region by
+   * the cues placed in it, for instance), so reference counts are changed
+   * atomically where the compiler provides it.
    */
+# if !defined(WEBVTT_ATOMIC_INC) && defined(_MSC_VER)
+#   include <intrin.h>
+#   define WEBVTT_ATOMIC_INC(x) ( _InterlockedIncrement( &(x) ) )
+#   define WEBVTT_ATOMIC_DEC(x) ( _InterlockedDecrement( &(x) ) )
+# elif !defined(WEBVTT_ATOMIC_INC) && defined(__GNUC__)
+#   define WEBVTT_ATOMIC_INC(x) ( __sync_add_and_fetch( &(x), 1 ) )
+#   define WEBVTT_ATOMIC_DEC(x) ( __sync_sub_and_fetch( &(x), 1 ) )
+# endif
 # ifndef WEBVTT_ATOMIC_INC
 #   define WEBVTT_ATOMIC_INC(x) ( ++(x) )
 # endif
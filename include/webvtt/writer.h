@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __WEBVTT_WRITER_H__
+# define __WEBVTT_WRITER_H__
+# include "cue.h"
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+typedef struct webvtt_writer_t *webvtt_writer;
+
+typedef enum
+webvtt_output_format_t {
+  WEBVTT_FORMAT_VTT = 0,
+  WEBVTT_FORMAT_SRT
+} webvtt_output_format;
+
+/**
+ * Receives serialized output. Returning a negative value aborts writing, and
+ * the failing webvtt_writer_* call returns WEBVTT_UNSUCCESSFUL.
+ */
+typedef int ( WEBVTT_CALLBACK *webvtt_write_fn )( void *userdata,
+                                                  const char *buffer,
+                                                  webvtt_uint len );
+
+/**
+ * webvtt_create_writer
+ *
+ * create a writer which serializes cues in 'format'. Output is staged in a
+ * fixed-size internal buffer and handed to 'on_write' whenever it fills up,
+ * so memory use does not depend on the number of cues written.
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_create_writer( webvtt_output_format format, webvtt_write_fn on_write,
+                      void *userdata, webvtt_writer *ppout );
+
+/**
+ * webvtt_delete_writer
+ *
+ * flush any buffered output and free the writer
+ */
+WEBVTT_EXPORT void
+webvtt_delete_writer( webvtt_writer writer );
+
+/**
+ * webvtt_writer_write_cue
+ *
+ * serialize a single cue. SubRip output is generated from the cue's node
+ * tree when it has one, so markup without a SubRip equivalent is dropped
+ * rather than written out as text. Cues are numbered in the order they are
+ * written.
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_writer_write_cue( webvtt_writer self, const webvtt_cue *cue );
+
+/**
+ * webvtt_writer_flush
+ *
+ * hand any buffered output to the write callback
+ */
+WEBVTT_EXPORT webvtt_status
+webvtt_writer_flush( webvtt_writer self );
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif
@@ -24,111 +24,507 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
-
 #include <ctype.h>
 #include <errno.h>
+#include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <webvtt/parser.h>
+#ifndef _WIN32
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * parsevtt [options] <file|directory|->...
+ *
+ * Files are parsed on up to --threads threads, each with its own parser. The
+ * output for a file is collected in memory and written in one piece once the
+ * file is done, so that files never interleave, and so that formatting cues
+ * costs as little as possible next to parsing them.
+ */
+
+#define CHUNK_SIZE 0x10000
+
+static const char usage[] =
+    "Usage: parsevtt [options] [-f] <file|directory|->...\n"
+    "\n"
+    "Parses each file, every .vtt file under each directory, and standard\n"
+    "input for `-', printing the cues.\n"
+    "\n"
+    "  -j, --threads N  parse N files at a time\n"
+    "  -q, --quiet      print no cues or error messages\n"
+    "  -c, --count      print the number of cues and errors in each file\n"
+    "  -k, --keep-going carry on parsing a file after an error\n"
+    "      --json       print JSON lines rather than text\n"
+    "      --bench      print parsing speed and allocations for each file, and\n"
+    "                   in total (implies --quiet and --keep-going)\n";
+
+static struct {
+  int quiet;
+  int count;
+  int keep_going;
+  int json;
+  int bench;
+  int threads;
+  int many; /* more than one input */
+} options = {0, 0, 0, 0, 0, 1, 0};
+
+typedef struct {
+  char *data;
+  size_t length;
+  size_t capacity;
+} buffer;
+
+typedef struct {
+  char *path;
+  buffer out;
+  buffer err;
+  unsigned long long bytes;
+  unsigned long long cues;
+  unsigned long long errors;
+  double seconds;
+  webvtt_parser_stats stats;
+  int failed;
+} job;
+
+static void put(buffer *b, const char *text, size_t length) {
+  if (b->length + length > b->capacity) {
+    size_t capacity = b->capacity ? b->capacity : 0x1000;
+    char *data;
+    while (capacity < b->length + length) {
+      capacity *= 2;
+    }
+    if (!(data = (char *)realloc(b->data, capacity))) {
+      return;
+    }
+    b->data = data;
+    b->capacity = capacity;
+  }
+  memcpy(b->data + b->length, text, length);
+  b->length += length;
+}
+
+static void print(buffer *b, const char *format, ...) {
+  char text[0x200];
+  int n;
+  va_list args;
+  va_start(args, format);
+  n = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (n > 0) {
+    put(b, text, (size_t)n < sizeof(text) ? (size_t)n : sizeof(text) - 1);
+  }
+}
+
+/* 'text' as a JSON string */
+static void put_json(buffer *b, const char *text, size_t length) {
+  const char *run = text;
+  const char *end = text + length;
+  put(b, "\"", 1);
+  for (; text < end; ++text) {
+    unsigned char c = (unsigned char)*text;
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    put(b, run, text - run);
+    run = text + 1;
+    switch (c) {
+    case '"': put(b, "\\\"", 2); break;
+    case '\\': put(b, "\\\\", 2); break;
+    case '\n': put(b, "\\n", 2); break;
+    case '\r': put(b, "\\r", 2); break;
+    case '\t': put(b, "\\t", 2); break;
+    default: print(b, "\\u%04x", c); break;
+    }
+  }
+  put(b, run, end - run);
+  put(b, "\"", 1);
+}
+
+static double now(void) {
+  struct timespec ts;
+#ifdef _WIN32
+  timespec_get(&ts, TIME_UTC);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
 
 static int WEBVTT_CALLBACK error(void *userdata, webvtt_uint line,
                                  webvtt_uint col, webvtt_error errcode) {
-  fprintf(stderr, "`%s' at %u:%u -- error: %s\n", (const char *)userdata, line, col, webvtt_strerror(errcode));
-  return -1; /* Die on all errors */
+  job *j = (job *)userdata;
+  ++j->errors;
+  if (!options.quiet) {
+    if (options.json) {
+      put(&j->err, "{\"file\": ", 9);
+      put_json(&j->err, j->path, strlen(j->path));
+      print(&j->err, ", \"line\": %u, \"column\": %u, \"error\": ", line, col);
+      put_json(&j->err, webvtt_strerror(errcode),
+               strlen(webvtt_strerror(errcode)));
+      put(&j->err, "}\n", 2);
+    } else {
+      print(&j->err, "`%s' at %u:%u -- error: %s\n", j->path, line, col,
+            webvtt_strerror(errcode));
+    }
+  }
+  return options.keep_going ? 0 : -1; /* Die on all errors, unless -k */
 }
 
 static void WEBVTT_CALLBACK cue(void *userdata, webvtt_cue *cue) {
-  (void)userdata;
-  (void)cue;
+  job *j = (job *)userdata;
+  ++j->cues;
 
-  // the parsed cue text
-  const char *body_text = webvtt_string_text(&cue->body);
+  if (!options.quiet) {
+    // the parsed cue text
+    const char *body_text = webvtt_string_text(&cue->body);
 
-  // the start and end times, in milliseconds
-  uint64_t start_time = (uint64_t)cue->from;
-  uint64_t end_time = (uint64_t)cue->until;
+    // the start and end times, in milliseconds
+    uint64_t start_time = (uint64_t)cue->from;
+    uint64_t end_time = (uint64_t)cue->until;
+
+    if (options.json) {
+      put(&j->out, "{\"file\": ", 9);
+      put_json(&j->out, j->path, strlen(j->path));
+      put(&j->out, ", \"id\": ", 8);
+      put_json(&j->out, webvtt_string_text(&cue->id),
+               webvtt_string_length(&cue->id));
+      print(&j->out, ", \"start\": %llu, \"end\": %llu, \"text\": ",
+            (unsigned long long)start_time, (unsigned long long)end_time);
+      put_json(&j->out, body_text, webvtt_string_length(&cue->body));
+      put(&j->out, "}\n", 2);
+    } else {
+      print(&j->out, "\n[%llums --> %llums]\n",
+            (unsigned long long)start_time, (unsigned long long)end_time);
+      put(&j->out, body_text, webvtt_string_length(&cue->body));
+      put(&j->out, "\n", 1);
+    }
+  }
+  webvtt_release_cue(&cue);
+}
 
-  fprintf(stdout, "\n[%llums --> %llums]\n%s\n", start_time, end_time,
-          body_text);
+/**
+ * Read all of 'fh' (for --bench, so that only parsing is timed)
+ */
+static int slurp(FILE *fh, buffer *b) {
+  char chunk[CHUNK_SIZE];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), fh)) > 0) {
+    put(b, chunk, n);
+  }
+  return ferror(fh) ? -1 : 0;
 }
 
-int parse_fh(FILE *fh, webvtt_parser vtt) {
+int parse_fh(FILE *fh, webvtt_parser vtt, job *j) {
   /**
    * Try to parse the file.
    */
-  int finished;
-  webvtt_status result;
-  do {
-    char buffer[0x1000];
-    webvtt_uint n_read = (webvtt_uint)fread(buffer, 1, sizeof(buffer), fh);
-    finished = feof(fh);
-    if (WEBVTT_FAILED(result = webvtt_parse_chunk(vtt, buffer, n_read))) {
+  webvtt_status result = WEBVTT_SUCCESS;
+  double start;
+  if (options.bench) {
+    buffer text = {0, 0, 0};
+    size_t pos;
+    if (slurp(fh, &text)) {
+      free(text.data);
       return 1;
     }
-  } while (!finished && result == WEBVTT_SUCCESS);
-  webvtt_finish_parsing(vtt);
+    start = now();
+    for (pos = 0; pos < text.length && !WEBVTT_FAILED(result);
+         pos += CHUNK_SIZE) {
+      webvtt_uint n = (webvtt_uint)(text.length - pos < CHUNK_SIZE
+                                        ? text.length - pos
+                                        : CHUNK_SIZE);
+      result = webvtt_parse_chunk(vtt, text.data + pos, n);
+    }
+    j->bytes = text.length;
+    free(text.data);
+  } else {
+    int finished;
+    start = now();
+    do {
+      char buffer[CHUNK_SIZE];
+      webvtt_uint n_read = (webvtt_uint)fread(buffer, 1, sizeof(buffer), fh);
+      finished = feof(fh) || ferror(fh);
+      j->bytes += n_read;
+      result = webvtt_parse_chunk(vtt, buffer, n_read);
+    } while (!finished && !WEBVTT_FAILED(result));
+  }
+  if (!WEBVTT_FAILED(result)) {
+    webvtt_finish_parsing(vtt);
+  }
+  j->seconds = now() - start;
+  webvtt_get_parser_stats(vtt, &j->stats);
+
+  return WEBVTT_FAILED(result) ? 1 : 0;
+}
 
+static void run(job *j) {
+  webvtt_parser vtt;
+  int is_stdin = !strcmp(j->path, "-");
+  FILE *fh = is_stdin ? stdin : fopen(j->path, "rb");
+  if (!fh) {
+    print(&j->err, "error: failed to open `%s': %s\n", j->path,
+          strerror(errno));
+    j->failed = 1;
+    return;
+  }
+
+  if (webvtt_create_parser(&cue, &error, j, &vtt) != WEBVTT_SUCCESS) {
+    print(&j->err, "error: failed to create VTT parser.\n");
+    j->failed = 1;
+  } else {
+    j->failed = parse_fh(fh, vtt, j) || j->errors;
+    webvtt_delete_parser(vtt);
+  }
+  if (!is_stdin) {
+    fclose(fh);
+  }
+}
+
+/**
+ * The line printed for a file with --count or --bench, or for the total
+ */
+static void summarize(buffer *b, const char *path, unsigned long long bytes,
+                      unsigned long long cues, unsigned long long errors,
+                      double seconds, const webvtt_parser_stats *stats) {
+  double mbps = seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0;
+  double cps = seconds > 0 ? cues / seconds : 0;
+  if (options.json) {
+    put(b, "{\"file\": ", 9);
+    put_json(b, path, strlen(path));
+    print(b, ", \"cues\": %llu, \"errors\": %llu", cues, errors);
+    if (options.bench) {
+      print(b,
+            ", \"bytes\": %llu, \"seconds\": %.6f, \"mb_per_s\": %.2f, "
+            "\"cues_per_s\": %.0f, \"allocations\": %llu, "
+            "\"peak_bytes\": %llu",
+            bytes, seconds, mbps, cps,
+            (unsigned long long)stats->allocations,
+            (unsigned long long)stats->peak_live_bytes);
+    }
+    put(b, "}\n", 2);
+  } else if (options.bench) {
+    print(b,
+          "%s: %llu bytes, %llu cues, %llu errors, %.3f ms, %.1f MB/s, "
+          "%.0f cues/s, %llu allocations, %.1f KB peak\n",
+          path, bytes, cues, errors, seconds * 1e3, mbps, cps,
+          (unsigned long long)stats->allocations,
+          stats->peak_live_bytes / 1024.0);
+  } else {
+    print(b, "%s: %llu cues, %llu errors\n", path, cues, errors);
+  }
+}
+
+static struct {
+  job *jobs;
+  size_t count;
+  size_t next;
+#ifndef _WIN32
+  pthread_mutex_t lock;
+#endif
+} queue;
+
+static void lock(void) {
+#ifndef _WIN32
+  pthread_mutex_lock(&queue.lock);
+#endif
+}
+
+static void unlock(void) {
+#ifndef _WIN32
+  pthread_mutex_unlock(&queue.lock);
+#endif
+}
+
+static void *worker(void *unused) {
+  (void)unused;
+  for (;;) {
+    job *j;
+    lock();
+    j = queue.next < queue.count ? queue.jobs + queue.next++ : 0;
+    unlock();
+    if (!j) {
+      return 0;
+    }
+    run(j);
+    if (options.count || options.bench) {
+      summarize(&j->out, j->path, j->bytes, j->cues, j->errors, j->seconds,
+                &j->stats);
+    } else if (options.many && !options.json && !options.quiet) {
+      print(&j->out, "\n`%s':\n", j->path);
+    }
+
+    lock();
+    fwrite(j->err.data ? j->err.data : "", 1, j->err.length, stderr);
+    fwrite(j->out.data ? j->out.data : "", 1, j->out.length, stdout);
+    unlock();
+    free(j->out.data);
+    free(j->err.data);
+    j->out.data = j->err.data = 0;
+  }
+}
+
+static int add_input(const char *path, int top) {
+  job *jobs;
+  size_t length = strlen(path);
+#ifndef _WIN32
+  struct stat st;
+  if (strcmp(path, "-") && !stat(path, &st) && S_ISDIR(st.st_mode)) {
+    DIR *dir = opendir(path);
+    struct dirent *entry;
+    if (!dir) {
+      fprintf(stderr, "error: failed to open `%s': %s\n", path,
+              strerror(errno));
+      return 1;
+    }
+    while ((entry = readdir(dir))) {
+      char *child;
+      if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+        continue;
+      }
+      if (!(child = (char *)malloc(length + strlen(entry->d_name) + 2))) {
+        break;
+      }
+      sprintf(child, "%s/%s", path, entry->d_name);
+      add_input(child, 0);
+      free(child);
+    }
+    closedir(dir);
+    return 0;
+  }
+#endif
+  /* Files found in directories are only parsed if they look like WebVTT */
+  if (!top && (length < 4 || strcmp(path + length - 4, ".vtt"))) {
+    return 0;
+  }
+  if (!(jobs = (job *)realloc(queue.jobs, (queue.count + 1) * sizeof(job)))) {
+    return 1;
+  }
+  queue.jobs = jobs;
+  memset(jobs + queue.count, 0, sizeof(job));
+  if (!(jobs[queue.count].path = (char *)malloc(length + 1))) {
+    return 1;
+  }
+  memcpy(jobs[queue.count].path, path, length + 1);
+  ++queue.count;
   return 0;
 }
 
 int main(int argc, char **argv) {
-  const char *input_file = 0;
-  webvtt_status result;
-  webvtt_parser vtt;
-  FILE *fh;
   int i;
   int ret = 0;
-  for (i = 0; i < argc; ++i) {
+  int inputs = 0;
+  double start;
+  for (i = 1; i < argc; ++i) {
     const char *a = argv[i];
-    if (*a == '-') {
-      switch (a[1]) {
-      case 'f': {
-        const char *p = a + 2;
-        while (isspace(*p)) {
-          ++p;
-        }
-        if (*p) {
-          input_file = p;
-        } else if (i + 1 < argc) {
-          input_file = argv[i + 1];
-          ++i;
-        } else {
-          fprintf(stderr, "error: missing parameter for switch `-f'\n");
-        }
-      } break;
-
-      case '?': {
-        fprintf(stdout, "Usage: parsevtt -f <vttfile>\n");
-        return 0;
-      } break;
+    if (!strcmp(a, "-j") || !strcmp(a, "--threads")) {
+      if (i + 1 < argc) {
+        options.threads = atoi(argv[++i]);
+      }
+      if (options.threads < 1) {
+        fprintf(stderr, "error: `%s' needs a number of threads\n", a);
+        return 1;
+      }
+    } else if (!strcmp(a, "-q") || !strcmp(a, "--quiet")) {
+      options.quiet = 1;
+    } else if (!strcmp(a, "-c") || !strcmp(a, "--count")) {
+      options.count = options.quiet = 1;
+    } else if (!strcmp(a, "-k") || !strcmp(a, "--keep-going")) {
+      options.keep_going = 1;
+    } else if (!strcmp(a, "--json")) {
+      options.json = 1;
+    } else if (!strcmp(a, "--bench")) {
+      options.bench = options.quiet = options.keep_going = 1;
+    } else if (!strcmp(a, "-?") || !strcmp(a, "-h") || !strcmp(a, "--help")) {
+      fprintf(stdout, "%s", usage);
+      return 0;
+    } else if (a[0] == '-' && a[1] == 'f') {
+      const char *p = a + 2;
+      while (isspace(*p)) {
+        ++p;
       }
+      if (*p) {
+        ret |= add_input(p, 1);
+        ++inputs;
+      } else if (i + 1 < argc) {
+        ret |= add_input(argv[++i], 1);
+        ++inputs;
+      } else {
+        fprintf(stderr, "error: missing parameter for switch `-f'\n");
+      }
+    } else if (a[0] == '-' && a[1]) {
+      fprintf(stderr, "error: unknown option `%s'\n\n%s", a, usage);
+      return 1;
+    } else {
+      ret |= add_input(a, 1);
+      ++inputs;
     }
   }
-  if (!input_file) {
-    fprintf(stderr,
-            "error: missing input file.\n\nUsage: parsevtt -f <vttfile>\n");
+  if (!inputs) {
+    fprintf(stderr, "error: missing input file.\n\n%s", usage);
     return 1;
   }
-
-  fh = fopen(input_file, "rb");
-  if (!fh) {
-    fprintf(stderr,
-            "error: failed to open `%s'"
-            ": %s"
-            "\n",
-            input_file, strerror(errno));
-    return 1;
+  if (options.bench) {
+    webvtt_set_alloc_stats(1);
   }
+  options.many = queue.count > 1;
 
-  if ((result = webvtt_create_parser(&cue, &error, (void *)input_file, &vtt)) !=
-      WEBVTT_SUCCESS) {
-    fprintf(stderr, "error: failed to create VTT parser.\n");
-    fclose(fh);
-    return 1;
+  /* Output is written a file at a time, so buffer it fully */
+  setvbuf(stdout, 0, _IOFBF, 1 << 16);
+
+  start = now();
+#ifndef _WIN32
+  pthread_mutex_init(&queue.lock, 0);
+  if (options.threads > 1) {
+    /* The main thread is the last of the workers */
+    pthread_t *threads =
+        (pthread_t *)malloc((options.threads - 1) * sizeof(pthread_t));
+    int started = 0;
+    while (threads && started < options.threads - 1 &&
+           !pthread_create(threads + started, 0, &worker, 0)) {
+      ++started;
+    }
+    worker(0);
+    while (started--) {
+      pthread_join(threads[started], 0);
+    }
+    free(threads);
+  } else
+#endif
+  {
+    worker(0);
   }
 
-  ret = parse_fh(fh, vtt);
-  webvtt_delete_parser(vtt);
-  fclose(fh);
+  {
+    unsigned long long bytes = 0, cues = 0, errors = 0;
+    double seconds = now() - start;
+    webvtt_parser_stats total;
+    size_t n;
+    memset(&total, 0, sizeof(total));
+    for (n = 0; n < queue.count; ++n) {
+      job *j = queue.jobs + n;
+      ret |= j->failed;
+      bytes += j->bytes;
+      cues += j->cues;
+      errors += j->errors;
+      total.allocations += j->stats.allocations;
+      if (j->stats.peak_live_bytes > total.peak_live_bytes) {
+        total.peak_live_bytes = j->stats.peak_live_bytes;
+      }
+      free(j->path);
+    }
+    /* The total is over the wall-clock time, however many threads ran */
+    if (options.bench && queue.count > 1) {
+      buffer b = {0, 0, 0};
+      summarize(&b, "total", bytes, cues, errors, seconds, &total);
+      fwrite(b.data, 1, b.length, stdout);
+      free(b.data);
+    }
+    free(queue.jobs);
+  }
   return ret;
 }
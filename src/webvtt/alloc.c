@@ -25,10 +25,41 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <webvtt/util.h>
+#include "alloc_internal.h"
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_MSC_VER)
+# include <windows.h>
+# define THREAD_LOCAL __declspec(thread)
+# define COUNT_ALLOC() InterlockedIncrement( ( volatile LONG * )&allocator.n_alloc )
+# define COUNT_FREE() InterlockedDecrement( ( volatile LONG * )&allocator.n_alloc )
+# define ATOMIC_ADD( x, n ) \
+  ( InterlockedExchangeAdd64( ( volatile LONG64 * )&( x ), ( LONG64 )( n ) ) + \
+    ( n ) )
+# define ATOMIC_SUB( x, n ) ATOMIC_ADD( x, -( LONG64 )( n ) )
+# define ATOMIC_CAS( x, old, new ) \
+  ( InterlockedCompareExchange64( ( volatile LONG64 * )&( x ), ( new ), \
+                                  ( old ) ) == ( LONG64 )( old ) )
+#elif defined(__GNUC__)
+# define THREAD_LOCAL __thread
+# define COUNT_ALLOC() __sync_fetch_and_add( &allocator.n_alloc, 1 )
+# define COUNT_FREE() __sync_fetch_and_sub( &allocator.n_alloc, 1 )
+# define ATOMIC_ADD( x, n ) __sync_add_and_fetch( &( x ), ( n ) )
+# define ATOMIC_SUB( x, n ) __sync_sub_and_fetch( &( x ), ( n ) )
+# define ATOMIC_CAS( x, old, new ) \
+  __sync_bool_compare_and_swap( &( x ), ( old ), ( new ) )
+#else
+# define THREAD_LOCAL _Thread_local
+# define COUNT_ALLOC() ( ++allocator.n_alloc )
+# define COUNT_FREE() ( --allocator.n_alloc )
+# define ATOMIC_ADD( x, n ) ( ( x ) += ( n ) )
+# define ATOMIC_SUB( x, n ) ( ( x ) -= ( n ) )
+# define ATOMIC_CAS( x, old, new ) \
+  ( ( x ) == ( old ) ? ( ( x ) = ( new ), 1 ) : 0 )
+#endif
+#define ATOMIC_LOAD( x ) ATOMIC_ADD( x, 0 )
+
 static void *default_alloc( void *unused, webvtt_uint nb );
 static void default_free( void *unused, void *ptr );
 
@@ -36,12 +67,47 @@ struct {
   /**
    * Number of allocated objects. Forbid changing the allocator if this is not
    * equal to 0 
+   *
+   * Parsers may run on several threads at once, so it is only changed with
+   * COUNT_ALLOC and COUNT_FREE.
    */
   webvtt_uint n_alloc;
   webvtt_alloc_fn_ptr alloc;
   webvtt_free_fn_ptr free;
   void *alloc_data;
-} allocator = { 0, default_alloc, default_free, 0 };
+  /**
+   * Whether blocks carry an alloc_header, and parsers count their
+   * allocations. Like the allocator, only changed while nothing is allocated.
+   */
+  webvtt_bool stats;
+} allocator = { 0, default_alloc, default_free, 0, 0 };
+
+/**
+ * Blocks may be freed on any thread, so the counts and the references held
+ * by the blocks are only changed with the ATOMIC_ macros.
+ */
+struct
+webvtt_alloc_stats_t {
+  webvtt_uint64 refs;
+  webvtt_parser_stats counts;
+};
+
+/**
+ * Ahead of every block while allocation stats are on: its size and kind,
+ * and the stats it is counted against, if any. Padded so that the block
+ * keeps the alignment malloc gives.
+ */
+typedef union
+alloc_header_t {
+  struct {
+    webvtt_uint size;
+    webvtt_uint kind;
+    webvtt_alloc_stats *owner;
+  } h;
+  double align[ 2 ];
+} alloc_header;
+
+static THREAD_LOCAL webvtt_alloc_stats *current_stats;
 
 static void *WEBVTT_CALLBACK
 default_alloc( void *unused, webvtt_uint nb )
@@ -80,34 +146,170 @@ webvtt_set_allocator( webvtt_alloc_fn_ptr alloc, webvtt_free_fn_ptr free,
   }
 }
 
+WEBVTT_EXPORT webvtt_status
+webvtt_set_alloc_stats( webvtt_bool enable )
+{
+  if( allocator.n_alloc != 0 ) {
+    return ( !enable == !allocator.stats ) ? WEBVTT_SUCCESS
+                                           : WEBVTT_UNSUCCESSFUL;
+  }
+  allocator.stats = enable ? 1 : 0;
+  return WEBVTT_SUCCESS;
+}
+
+WEBVTT_INTERN webvtt_bool
+webvtt_alloc_stats_enabled( void )
+{
+  return allocator.stats;
+}
+
+WEBVTT_INTERN webvtt_alloc_stats *
+webvtt_create_alloc_stats( void )
+{
+  webvtt_alloc_stats *stats = ( webvtt_alloc_stats * )
+    allocator.alloc( allocator.alloc_data, sizeof( *stats ) );
+  if( stats ) {
+    COUNT_ALLOC();
+    memset( stats, 0, sizeof( *stats ) );
+    stats->refs = 1;
+  }
+  return stats;
+}
+
+WEBVTT_INTERN void
+webvtt_release_alloc_stats( webvtt_alloc_stats **pstats )
+{
+  if( pstats && *pstats ) {
+    if( ATOMIC_SUB( ( *pstats )->refs, 1 ) == 0 ) {
+      allocator.free( allocator.alloc_data, *pstats );
+      COUNT_FREE();
+    }
+    *pstats = 0;
+  }
+}
+
+WEBVTT_INTERN void
+webvtt_get_alloc_stats( const webvtt_alloc_stats *stats,
+                        webvtt_parser_stats *out )
+{
+  memset( out, 0, sizeof( *out ) );
+  if( stats ) {
+    webvtt_parser_stats *c = ( webvtt_parser_stats * )&stats->counts;
+    int i;
+    out->allocations = ATOMIC_LOAD( c->allocations );
+    out->frees = ATOMIC_LOAD( c->frees );
+    out->bytes = ATOMIC_LOAD( c->bytes );
+    out->live_bytes = ATOMIC_LOAD( c->live_bytes );
+    out->peak_live_bytes = ATOMIC_LOAD( c->peak_live_bytes );
+    for( i = 0; i < WEBVTT_OBJECT_KINDS; ++i ) {
+      webvtt_object_stats *o = &c->objects[ i ];
+      out->objects[ i ].allocations = ATOMIC_LOAD( o->allocations );
+      out->objects[ i ].bytes = ATOMIC_LOAD( o->bytes );
+      out->objects[ i ].live_bytes = ATOMIC_LOAD( o->live_bytes );
+    }
+  }
+}
+
+WEBVTT_INTERN webvtt_alloc_stats *
+webvtt_enter_alloc_stats( webvtt_alloc_stats *stats )
+{
+  webvtt_alloc_stats *previous = current_stats;
+  current_stats = stats;
+  return previous;
+}
+
+WEBVTT_INTERN void
+webvtt_leave_alloc_stats( webvtt_alloc_stats *previous )
+{
+  current_stats = previous;
+}
+
+WEBVTT_INTERN void *
+webvtt_alloc_as( webvtt_uint nb, webvtt_object_kind kind )
+{
+  alloc_header *block;
+  webvtt_alloc_stats *owner = current_stats;
+  webvtt_uint64 live, peak;
+  if( !allocator.stats ) {
+    void *ret = allocator.alloc( allocator.alloc_data, nb );
+    if( ret ) {
+      COUNT_ALLOC();
+    }
+    return ret;
+  }
+  if( nb > (webvtt_uint)-1 - sizeof( alloc_header ) ||
+      !( block = ( alloc_header * )allocator.alloc( allocator.alloc_data,
+                                                   nb +
+                                                   sizeof( alloc_header ) ) ) ) {
+    return 0;
+  }
+  COUNT_ALLOC();
+  block->h.size = nb;
+  block->h.kind = kind;
+  block->h.owner = owner;
+  if( owner ) {
+    webvtt_parser_stats *c = &owner->counts;
+    webvtt_object_stats *o = &c->objects[ kind ];
+    ATOMIC_ADD( owner->refs, 1 );
+    ATOMIC_ADD( c->allocations, 1 );
+    ATOMIC_ADD( c->bytes, nb );
+    live = ATOMIC_ADD( c->live_bytes, nb );
+    while( live > ( peak = ATOMIC_LOAD( c->peak_live_bytes ) ) &&
+           !ATOMIC_CAS( c->peak_live_bytes, peak, live ) ) {
+    }
+    ATOMIC_ADD( o->allocations, 1 );
+    ATOMIC_ADD( o->bytes, nb );
+    ATOMIC_ADD( o->live_bytes, nb );
+  }
+  return block + 1;
+}
+
+WEBVTT_INTERN void *
+webvtt_alloc0_as( webvtt_uint nb, webvtt_object_kind kind )
+{
+  void *ret = webvtt_alloc_as( nb, kind );
+  if( ret ) {
+    memset( ret, 0, nb );
+  }
+  return ret;
+}
+
 /**
  * public alloc/dealloc functions
  */
 WEBVTT_EXPORT void *
 webvtt_alloc( webvtt_uint nb )
 {
-  void *ret = allocator.alloc( allocator.alloc_data, nb );
-  if( ret )
-  { ++allocator.n_alloc; }
-  return ret;
+  return webvtt_alloc_as( nb, WEBVTT_OBJECT_OTHER );
 }
 
 WEBVTT_EXPORT void *
 webvtt_alloc0( webvtt_uint nb )
 {
-  void *ret = allocator.alloc( allocator.alloc_data, nb );
-  if( ret ) {
-    ++allocator.n_alloc;
-    memset( ret, 0, nb );
-  }
-  return ret;
+  return webvtt_alloc0_as( nb, WEBVTT_OBJECT_OTHER );
 }
 
 WEBVTT_EXPORT void
 webvtt_free( void *data )
 {
-  if( data && allocator.n_alloc ) {
+  /**
+   * 'n_alloc' is not read here: other threads change it, and a block being
+   * freed implies it is non-zero.
+   */
+  if( data && !allocator.stats ) {
     allocator.free( allocator.alloc_data, data );
-    --allocator.n_alloc;
+    COUNT_FREE();
+  } else if( data ) {
+    alloc_header *block = ( alloc_header * )data - 1;
+    webvtt_alloc_stats *owner = block->h.owner;
+    if( owner ) {
+      webvtt_parser_stats *c = &owner->counts;
+      ATOMIC_ADD( c->frees, 1 );
+      ATOMIC_SUB( c->live_bytes, block->h.size );
+      ATOMIC_SUB( c->objects[ block->h.kind ].live_bytes, block->h.size );
+      webvtt_release_alloc_stats( &owner );
+    }
+    allocator.free( allocator.alloc_data, block );
+    COUNT_FREE();
   }
 }
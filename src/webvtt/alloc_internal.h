@@ -0,0 +1,67 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __INTERN_ALLOC_H__
+# define __INTERN_ALLOC_H__
+# include <webvtt/util.h>
+
+/**
+ * Per-parser allocation accounting, when turned on by webvtt_set_alloc_stats.
+ * A parser then owns a webvtt_alloc_stats, and makes it the current one for
+ * the thread while any of its functions run; every block allocated meanwhile
+ * records it as its owner, and is taken off its counts again when freed. The
+ * stats are kept alive by the parser and by each block they own, so blocks
+ * can outlive the parser.
+ *
+ * A block may be freed on another thread than the one its parser runs on, so
+ * the counts and references are changed atomically.
+ */
+typedef struct webvtt_alloc_stats_t webvtt_alloc_stats;
+
+WEBVTT_INTERN webvtt_bool webvtt_alloc_stats_enabled( void );
+WEBVTT_INTERN webvtt_alloc_stats *webvtt_create_alloc_stats( void );
+WEBVTT_INTERN void webvtt_release_alloc_stats( webvtt_alloc_stats **pstats );
+WEBVTT_INTERN void webvtt_get_alloc_stats( const webvtt_alloc_stats *stats,
+                                           webvtt_parser_stats *out );
+
+/**
+ * Make 'stats' the owner of whatever is allocated on this thread, returning
+ * the previous owner, which must be given back to webvtt_leave_alloc_stats.
+ */
+WEBVTT_INTERN webvtt_alloc_stats *webvtt_enter_alloc_stats(
+  webvtt_alloc_stats *stats );
+WEBVTT_INTERN void webvtt_leave_alloc_stats( webvtt_alloc_stats *previous );
+
+/**
+ * webvtt_alloc and webvtt_alloc0 for a particular kind of object
+ */
+WEBVTT_INTERN void *webvtt_alloc_as( webvtt_uint nb, webvtt_object_kind kind );
+WEBVTT_INTERN void *webvtt_alloc0_as( webvtt_uint nb,
+                                      webvtt_object_kind kind );
+
+#endif
@@ -28,6 +28,8 @@
 #include <string.h>
 #include "parser_internal.h"
 #include "cue_internal.h"
+#include "region_internal.h"
+#include "alloc_internal.h"
 
 WEBVTT_EXPORT webvtt_status
 webvtt_create_cue( webvtt_cue **pcue )
@@ -36,10 +38,26 @@ webvtt_create_cue( webvtt_cue **pcue )
   if( !pcue ) {
     return WEBVTT_INVALID_PARAM;
   }
-  cue = (webvtt_cue *)webvtt_alloc0( sizeof(*cue) );
+  cue = (webvtt_cue *)webvtt_alloc0_as( sizeof(*cue), WEBVTT_OBJECT_CUE );
   if( !cue ) {
     return WEBVTT_OUT_OF_MEMORY;
   }
+  webvtt_ref( &cue->refs );
+  webvtt_init_string( &cue->id );
+  webvtt_init_string( &cue->body );
+  webvtt_reset_cue( cue );
+
+  *pcue = cue;
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Reset the timings, settings and flags of a cue to their initial values,
+ * releasing its region. The id, body and node tree are left alone.
+ */
+WEBVTT_INTERN void
+webvtt_reset_cue( webvtt_cue *cue )
+{
   /**
    * From http://dev.w3.org/html5/webvtt/#parsing (10/25/2012)
    *
@@ -53,9 +71,7 @@ webvtt_create_cue( webvtt_cue **pcue )
    *
    * Let cue's text track cue alignment be middle alignment.
    */
-  webvtt_ref( &cue->refs );
-  webvtt_init_string( &cue->id );
-  webvtt_init_string( &cue->body );
+  cue->flags = 0;
   cue->from = 0xFFFFFFFFFFFFFFFF;
   cue->until = 0xFFFFFFFFFFFFFFFF;
   cue->snap_to_lines = 1;
@@ -64,9 +80,7 @@ webvtt_create_cue( webvtt_cue **pcue )
   cue->settings.align = WEBVTT_ALIGN_MIDDLE;
   cue->settings.line = WEBVTT_AUTO;
   cue->settings.vertical = WEBVTT_HORIZONTAL;
-
-  *pcue = cue;
-  return WEBVTT_SUCCESS;
+  webvtt_release_region( &cue->settings.region );
 }
 
 WEBVTT_EXPORT void
@@ -87,6 +101,7 @@ webvtt_release_cue( webvtt_cue **pcue )
       webvtt_release_string( &cue->id );
       webvtt_release_string( &cue->body );
       webvtt_release_node( &cue->node_head );
+      webvtt_release_region( &cue->settings.region );
       webvtt_free( cue );
     }
   }
@@ -124,24 +139,98 @@ cue_is_incomplete( const webvtt_cue *cue ) {
   return !cue || ( cue->flags & CUE_HEADER_MASK ) == CUE_HAVE_ID;
 }
 
-WEBVTT_EXPORT webvtt_status
-webvtt_cue_set_align( webvtt_cue *cue, const char *value )
+/**
+ * The cue-setting value parsers take the value as a pointer and a length, so
+ * that settings can be parsed in place, straight from the cue timings line.
+ */
+typedef webvtt_status ( *setting_fn )( webvtt_cue *cue, const char *value,
+                                       webvtt_uint len );
+
+/**
+ * Interpret a value which has already been checked to consist of an optional
+ * leading '-' followed by digits as an integer, as webvtt_parse_int would.
+ */
+static webvtt_int64
+parse_number( const char *value, const char *end )
 {
-  unsigned i;
-  static const char *values[] = {
-    "start",
-    "middle",
-    "end",
-    "left",
-    "right",
-  };
+  webvtt_int64 result = 0;
+  webvtt_int64 mul = 1;
+  if( value < end && *value == '-' ) {
+    mul = -1;
+    ++value;
+  }
+  while( value < end && webvtt_isdigit( *value ) ) {
+    result = result * 10 + ( *value++ - '0' );
+  }
+  return result * mul;
+}
 
-  if( !cue || !value ) {
-    return WEBVTT_INVALID_PARAM;
+/**
+ * Interpret a percentage value for 'position' or 'size' (or a region setting).
+ * Returns 0 if the value is not a number in the range 0 <= number <= 100,
+ * followed by a U+0025 PERCENT SIGN character (%).
+ */
+WEBVTT_INTERN int
+webvtt_parse_percentage( const char *value, webvtt_uint len, webvtt_int64 *number )
+{
+  const char *end = value + len;
+  const char *c;
+  int digits = 0;
+
+  /**
+   * 1. If value contains any characters other than U+0025 PERCENT SIGN
+   * characters (%) and ASCII digits, then jump to the step labeled next
+   * setting.
+   *
+   * 2. If value does not contain at least one ASCII digit, then jump to the
+   * step labeled next setting.
+   *
+   * 3. If any character in value other than the last character is a U+0025
+   * PERCENT SIGN character (%), then jump to the step labeled next setting.
+   *
+   * 4. If the last character in value is not a U+0025 PERCENT SIGN character
+   * (%), then jump to the step labeled next setting.
+   */
+  for( c = value; c < end; ++c ) {
+    if( webvtt_isdigit( *c ) ) {
+      ++digits;
+    } else if( *c != '%' || c + 1 != end ) {
+      return 0;
+    }
+  }
+  if( !digits || len < 2 || end[ -1 ] != '%' ) {
+    return 0;
   }
 
+  /**
+   * 5. Ignoring the trailing percent sign, interpret value as an integer, and
+   * let number be that number.
+   *
+   * 6. If number is not in the range 0 <= number <= 100, then jump to the step
+   * labeled next setting.
+   */
+  *number = parse_number( value, end - 1 );
+  return *number <= 100;
+}
+
+static webvtt_status
+set_align( webvtt_cue *cue, const char *value, webvtt_uint len )
+{
+  unsigned i;
+  static const struct
+  {
+    const char *name;
+    webvtt_uint len;
+  } values[] = {
+    { "start", 5 },
+    { "middle", 6 },
+    { "end", 3 },
+    { "left", 4 },
+    { "right", 5 },
+  };
+
   for( i=0 ; i < sizeof(values)/sizeof(*values) ; ++i ) {
-    if( !strcmp( value, values[i] ) ) {
+    if( len == values[i].len && !memcmp( value, values[i].name, len ) ) {
       cue->settings.align = (webvtt_align_type)i;
       if( cue->flags & CUE_HAVE_ALIGN ) {
         return WEBVTT_ALREADY_ALIGN;
@@ -153,26 +242,34 @@ webvtt_cue_set_align( webvtt_cue *cue, const char *value )
   return WEBVTT_BAD_ALIGN;
 }
 
-WEBVTT_EXPORT webvtt_status
-webvtt_cue_set_line( webvtt_cue *cue, const char *value )
+static webvtt_status
+set_line( webvtt_cue *cue, const char *value, webvtt_uint len )
 {
+  const char *end = value + len;
+  const char *percent = 0;
+  const char *c;
   webvtt_int64 number;
   int digits = 0;
-  const char *c;
-
-  if( !cue || !value ) {
-    return WEBVTT_INVALID_PARAM;
-  }
 
   /**
    * 1. If value contains any characters other than U+002D HYPHEN-MINUS
    * characters (-), U+0025 PERCENT SIGN characters (%), and ASCII digits,
    * then jump to the step labeled next setting
+   *
+   * 3. If any character in value other than the first character is a U+002D
+   * HYPHEN-MINUS character (-), then jump to the step labeled next setting.
    */
-  for( c = value; *c; ++c ) {
+  for( c = value; c < end; ++c ) {
     if( webvtt_isdigit( *c ) ) {
       ++digits;
-    } else if( *c == '-' || *c == '%' ) {
+    } else if( *c == '-' ) {
+      if( c != value ) {
+        return WEBVTT_BAD_LINE;
+      }
+    } else if( *c == '%' ) {
+      if( !percent ) {
+        percent = c;
+      }
     } else {
       return WEBVTT_BAD_LINE;
     }
@@ -186,15 +283,7 @@ webvtt_cue_set_line( webvtt_cue *cue, const char *value )
     return WEBVTT_BAD_LINE;
   }
 
-  if( strchr( value + 1, '-' ) ) {
-    /**
-     * 3. If any character in value other than the first character is a U+002D
-     * HYPHEN-MINUS character (-), then jump to the step labeled next setting.
-     */
-    return WEBVTT_BAD_LINE;
-  }
-
-  if( ( c = strchr( value, '%' ) ) && ( ( c[1] != '\0' ) || *value == '-' ) ) {
+  if( percent && ( ( percent + 1 != end ) || *value == '-' ) ) {
     /**
      * 4. If any character in value other than the last character is a U+0025
      * PERCENT SIGN character (%), then jump to the step labeled next setting.
@@ -210,10 +299,9 @@ webvtt_cue_set_line( webvtt_cue *cue, const char *value )
    * Ignoring the trailing percent sign, if any, interpret value as a
    * (potentially signed) integer and let number be that number.
    */
-  c = value;
-  number = webvtt_parse_int( &c, &digits );
+  number = parse_number( value, percent ? percent : end );
 
-  if( *c == '%' ) {
+  if( percent ) {
     /**
      * 7. If the last character in value is a U+0025 PERCENT SIGN character (%),
      * but number is not in the range 0 < number < 100, then jump to the step
@@ -242,67 +330,11 @@ webvtt_cue_set_line( webvtt_cue *cue, const char *value )
   return WEBVTT_SUCCESS;
 }
 
-WEBVTT_EXPORT webvtt_status
-webvtt_cue_set_position( webvtt_cue *cue, const char *value )
+static webvtt_status
+set_position( webvtt_cue *cue, const char *value, webvtt_uint len )
 {
-  int digits = 0;
   webvtt_int64 number;
-  const char *c;
-
-  if( !cue || !value ) {
-    return WEBVTT_INVALID_PARAM;
-  }
-
-  /**
-   * 1. If value contains any characters other than U+0025 PERCENT SIGN
-   * characters (%) and ASCII digits, then jump to the step labeled next
-   * setting.
-   */
-  for( c = value; *c; ++c ) {
-    if( webvtt_isdigit( *c ) ) {
-      ++digits;
-    } else if( *c == '%' ) {
-    } else {
-      return WEBVTT_BAD_POSITION;
-    }
-  }
-
-  /**
-   * 2. If value does not contain at least one ASCII digit, then jump to the
-   * step labeled next setting.
-   */
-  if( !digits ) {
-    return WEBVTT_BAD_POSITION;
-  }
-
-  /**
-   * 3. If any character in value other than the last character is a U+0025
-   * PERCENT SIGN character (%), then jump to the step labeled next setting.
-   */
-  if( ( c = strchr( value, '%' ) ) && ( c[1] != '\0' ) ) {
-    return WEBVTT_BAD_POSITION;
-  }
-
-  /**
-   * 4. If the last character in value is not a U+0025 PERCENT SIGN character
-   * (%), then jump to the step labeled next setting.
-   */
-  if( !c ) {
-    return WEBVTT_BAD_POSITION;
-  }
-
-  /**
-   * 5. Ignoring the trailing percent sign, interpret value as an integer, and
-   * let number be that number.
-   */
-  c = value;
-  number = webvtt_parse_int( &c, &digits );
-
-  /**
-   * 6. If number is not in the range 0 <= number <= 100, then jump to the step
-   * labeled next setting.
-   */
-  if( number > 100 ) {
+  if( !webvtt_parse_percentage( value, len, &number ) ) {
     return WEBVTT_BAD_POSITION;
   }
 
@@ -315,115 +347,161 @@ webvtt_cue_set_position( webvtt_cue *cue, const char *value )
   return WEBVTT_SUCCESS;
 }
 
-WEBVTT_EXPORT webvtt_status
-webvtt_cue_set_size( webvtt_cue *cue, const char *value )
+static webvtt_status
+set_size( webvtt_cue *cue, const char *value, webvtt_uint len )
 {
-  int digits = 0;
   webvtt_int64 number;
-  const char *c;
-  if( !cue || !value ) {
-    return WEBVTT_INVALID_PARAM;
+  if( !webvtt_parse_percentage( value, len, &number ) ) {
+    return WEBVTT_BAD_SIZE;
   }
 
-  /**
-   * 1. If value contains any characters other than U+0025 PERCENT SIGN
-   * characters (%) and ASCII digits, then jump to the step labeled next
-   * setting.
-   */
-  for( c = value; *c; ++c ) {
-    if( webvtt_isdigit( *c ) ) {
-      ++digits;
-    } else if( *c == '%' ) {
-    } else {
-      return WEBVTT_BAD_SIZE;
-    }
+  /* 7. Let cue's text track cue size be number */
+  cue->settings.size = (int)number;
+  if( cue->flags & CUE_HAVE_SIZE ) {
+    return WEBVTT_ALREADY_SIZE;
   }
+  cue->flags |= CUE_HAVE_SIZE;
+  return WEBVTT_SUCCESS;
+}
 
-  /**
-   * 2. If value does not contain at least one ASCII digit, then jump to the
-   * step labeled next setting.
-   */
-  if( !digits ) {
-    return WEBVTT_BAD_SIZE;
+static webvtt_status
+set_vertical( webvtt_cue *cue, const char *value, webvtt_uint len )
+{
+  webvtt_vertical_type vertical;
+  if( len != 2 ) {
+    return WEBVTT_BAD_VERTICAL;
+  }
+  if( value[0] == 'l' && value[1] == 'r' ) {
+    vertical = WEBVTT_VERTICAL_LR;
+  } else if( value[0] == 'r' && value[1] == 'l' ) {
+    vertical = WEBVTT_VERTICAL_RL;
+  } else {
+    return WEBVTT_BAD_VERTICAL;
   }
-
-  /**
-   * 3. If any character in value other than the last character is a U+0025
-   * PERCENT SIGN character (%), then jump to the step labeled next setting.
-   */
-  if( ( c = strchr( value, '%' ) ) && ( c[1] != '\0' ) ) {
-    return WEBVTT_BAD_SIZE;
+  cue->settings.vertical = vertical;
+  if( cue->flags & CUE_HAVE_VERTICAL ) {
+    return WEBVTT_ALREADY_VERTICAL;
   }
+  cue->flags |= CUE_HAVE_VERTICAL;
+  return WEBVTT_SUCCESS;
+}
 
-  /**
-   * 4. If the last character in value is not a U+0025 PERCENT SIGN character
-   * (%), then jump to the step labeled next setting.
-   */
-  if( !c ) {
-    return WEBVTT_BAD_SIZE;
+/**
+ * 'region' names a region defined in the header of the file being parsed, so
+ * it can only be set while parsing.
+ */
+static webvtt_status
+set_region( webvtt_parser self, webvtt_cue *cue, const char *value,
+            webvtt_uint len )
+{
+  int index = self ? webvtt_find_region( self, value, len ) : WEBVTT_NO_REGION;
+  if( index == WEBVTT_NO_REGION ) {
+    return WEBVTT_BAD_REGION;
+  }
+  webvtt_release_region( &cue->settings.region );
+  webvtt_ref_region( self->regions[ index ] );
+  cue->settings.region = self->regions[ index ];
+  if( cue->flags & CUE_HAVE_REGION ) {
+    return WEBVTT_ALREADY_REGION;
   }
+  cue->flags |= CUE_HAVE_REGION;
+  return WEBVTT_SUCCESS;
+}
 
-  /**
-   * 5. Ignoring the trailing percent sign, interpret value as an integer, and
-   * let number be that number.
-   */
-  c = value;
-  number = webvtt_parse_int( &c, &digits );
+/**
+ * Find the value parser for a cue-setting keyword, dispatching on its length
+ * and first byte. Returns NULL for unknown keywords.
+ */
+static setting_fn
+find_setting( const char *key, webvtt_uint len )
+{
+  switch( len ) {
+    case 4:
+      if( key[0] == 'l' && !memcmp( key, "line", 4 ) ) {
+        return &set_line;
+      } else if( key[0] == 's' && !memcmp( key, "size", 4 ) ) {
+        return &set_size;
+      }
+      break;
+    case 5:
+      if( key[0] == 'a' && !memcmp( key, "align", 5 ) ) {
+        return &set_align;
+      }
+      break;
+    case 8:
+      if( key[0] == 'p' && !memcmp( key, "position", 8 ) ) {
+        return &set_position;
+      } else if( key[0] == 'v' && !memcmp( key, "vertical", 8 ) ) {
+        return &set_vertical;
+      }
+      break;
+  }
+  return 0;
+}
 
-  /**
-   * 6. If number is not in the range 0 <= number <= 100, then jump to the step
-   * labeled next setting.
-   */
-  if( number > 100 ) {
-    return WEBVTT_BAD_SIZE;
+/**
+ * Separate 'word' into key and value (delimited by ':'), and set the
+ * cue-setting they name.
+ */
+static webvtt_status
+set_setting_from_word( webvtt_cue *cue, const char *word, webvtt_uint len )
+{
+  const char *value = ( const char * )memchr( word, ':', len );
+  setting_fn set_value;
+  if( !value || value == word || value + 1 == word + len ) {
+    return WEBVTT_BAD_CUESETTING;
+  }
+  if( !( set_value = find_setting( word, ( webvtt_uint )( value - word ) ) ) ) {
+    return WEBVTT_BAD_CUESETTING;
   }
+  ++value;
+  return set_value( cue, value, ( webvtt_uint )( word + len - value ) );
+}
 
-  /* 7. Let cue's text track cue size be number */
-  cue->settings.size = (int)number;
-  if( cue->flags & CUE_HAVE_SIZE ) {
-    return WEBVTT_ALREADY_SIZE;
+WEBVTT_EXPORT webvtt_status
+webvtt_cue_set_align( webvtt_cue *cue, const char *value )
+{
+  if( !cue || !value ) {
+    return WEBVTT_INVALID_PARAM;
   }
-  cue->flags |= CUE_HAVE_SIZE;
-  return WEBVTT_SUCCESS;
+  return set_align( cue, value, ( webvtt_uint )strlen( value ) );
 }
 
 WEBVTT_EXPORT webvtt_status
-webvtt_cue_set_vertical( webvtt_cue *cue, const char *value )
+webvtt_cue_set_line( webvtt_cue *cue, const char *value )
 {
-  unsigned i;
-  static const char *values[] = {
-    "lr",
-    "rl",
-  };
+  if( !cue || !value ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  return set_line( cue, value, ( webvtt_uint )strlen( value ) );
+}
 
+WEBVTT_EXPORT webvtt_status
+webvtt_cue_set_position( webvtt_cue *cue, const char *value )
+{
   if( !cue || !value ) {
     return WEBVTT_INVALID_PARAM;
   }
+  return set_position( cue, value, ( webvtt_uint )strlen( value ) );
+}
 
-  for( i=0 ; i < sizeof(values)/sizeof(*values) ; ++i ) {
-    if( !strcmp( value, values[i] ) ) {
-      cue->settings.vertical = (webvtt_align_type)i+1;
-      if( cue->flags & CUE_HAVE_VERTICAL ) {
-        return WEBVTT_ALREADY_VERTICAL;
-      }
-      cue->flags |= CUE_HAVE_VERTICAL;
-      return WEBVTT_SUCCESS;
-    }
+WEBVTT_EXPORT webvtt_status
+webvtt_cue_set_size( webvtt_cue *cue, const char *value )
+{
+  if( !cue || !value ) {
+    return WEBVTT_INVALID_PARAM;
   }
-  return WEBVTT_BAD_VERTICAL;
+  return set_size( cue, value, ( webvtt_uint )strlen( value ) );
 }
 
-static struct
+WEBVTT_EXPORT webvtt_status
+webvtt_cue_set_vertical( webvtt_cue *cue, const char *value )
 {
-  const char *keyword;
-  webvtt_status (*setValue)( webvtt_cue *cue, const char *value );
-} cuesettings[] = {
-  { "align", &webvtt_cue_set_align },
-  { "line", &webvtt_cue_set_line },
-  { "position", &webvtt_cue_set_position },
-  { "size", &webvtt_cue_set_size },
-  { "vertical", &webvtt_cue_set_vertical },
-};
+  if( !cue || !value ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  return set_vertical( cue, value, ( webvtt_uint )strlen( value ) );
+}
 
 /**
  * Set a cuesetting from key-value pairs (as C strings)
@@ -432,16 +510,17 @@ WEBVTT_EXPORT webvtt_status
 webvtt_cue_set_setting( webvtt_cue *cue,
                         const char *key, const char *value )
 {
-  unsigned i;
+  setting_fn set_value;
   if( !key || !value ) {
     return WEBVTT_INVALID_PARAM;
   }
-  for( i=0 ; i<sizeof(cuesettings)/sizeof(*cuesettings) ; ++i ) {
-    if( !strcmp( key, cuesettings[i].keyword ) ) {
-      return cuesettings[i].setValue( cue, value );
-    }
+  if( !( set_value = find_setting( key, ( webvtt_uint )strlen( key ) ) ) ) {
+    return WEBVTT_BAD_CUESETTING;
+  }
+  if( !cue ) {
+    return WEBVTT_INVALID_PARAM;
   }
-  return WEBVTT_BAD_CUESETTING;
+  return set_value( cue, value, ( webvtt_uint )strlen( value ) );
 }
 
 WEBVTT_EXPORT webvtt_status
@@ -458,46 +537,46 @@ webvtt_cue_set_settings( webvtt_cue *cue, const webvtt_string *settings )
 WEBVTT_INTERN webvtt_status
 webvtt_cue_set_setting_from_string( webvtt_cue *cue, const char *word )
 {
-  char keyword[32] = "";
-  char *value;
-  int idx;
   if( !cue || !word ) {
     return WEBVTT_INVALID_PARAM;
   }
-
-  value = strchr( word, ':' );
-  if( !value || value == word || *(++value) == '\0' ) {
-    return WEBVTT_BAD_CUESETTING;
-  }
-
-  idx = ( value - word ) - 1;
-  if( idx > 31 ) {
-    return WEBVTT_BAD_CUESETTING;
-  }
-
-  memcpy( keyword, word, idx );
-  keyword[idx] = '\0';
-
-  return webvtt_cue_set_setting( cue, (const char *)keyword, value );
+  return set_setting_from_word( cue, word, ( webvtt_uint )strlen( word ) );
 }
 
 WEBVTT_EXPORT webvtt_status
 webvtt_cue_validate_set_settings( webvtt_parser self, webvtt_cue *cue,
                                   const webvtt_string *settings )
 {
-  int line = 1;
-  int column = 0;
-  int length;
-  const char *eol;
-  int position = 0;
-  webvtt_status s;
+  webvtt_status status;
+  const char *text;
+  webvtt_uint length;
   if( !cue || !settings ) {
     return WEBVTT_INVALID_PARAM;
   }
-  length = (int)webvtt_string_length( settings );
-  if( ( eol = strchr( webvtt_string_text( settings ), '\r' ) )
-      || ( eol = strchr( webvtt_string_text( settings ), '\n' ) ) ) {
-    length = (int)( eol - webvtt_string_text( settings ) );
+  text = webvtt_string_text( settings );
+  length = webvtt_string_length( settings );
+  if( !self ) {
+    return webvtt_cue_parse_settings( 0, cue, text, length );
+  }
+  PROFILE_PHASE( WEBVTT_PHASE_SETTINGS,
+                 status = webvtt_cue_parse_settings( self, cue, text, length ) );
+  return status;
+}
+
+WEBVTT_INTERN webvtt_status
+webvtt_cue_parse_settings( webvtt_parser self, webvtt_cue *cue,
+                           const char *text, webvtt_uint length )
+{
+  int line = 1;
+  int column = 0;
+  const char *end = text + length;
+  const char *eol;
+  const char *p = text;
+
+  /* Settings end at the end of the line, if there is one */
+  if( ( eol = ( const char * )memchr( text, '\r', length ) )
+      || ( eol = ( const char * )memchr( text, '\n', length ) ) ) {
+    length = ( webvtt_uint )( eol - text );
   }
 
   if( self ) {
@@ -509,28 +588,39 @@ webvtt_cue_validate_set_settings( webvtt_parser self, webvtt_cue *cue,
    * http://www.w3.org/html/wg/drafts/html/master/single-page.html#split-a-string-on-spaces
    * 4. Skip whitespace
    */
-  column += webvtt_string_skip_whitespace( settings, &position );
+  while( p < end && webvtt_isspace( *p ) ) {
+    ++p;
+    ++column;
+  }
 
-  while( position < length ) {
-    webvtt_string word;
-    const char *keyword;
-    const char *end;
-    int nwhite, ncol;
+  while( p < text + length ) {
+    const char *word = p;
+    const char *nul;
+    webvtt_uint word_len;
+    webvtt_status s;
+    int nwhite = 0, ncol;
     /* Collect word (sequence of non-space characters terminated by space) */
-    if( WEBVTT_FAILED( webvtt_string_collect_word( settings, &word,
-                       &position ) ) ) {
-      return WEBVTT_OUT_OF_MEMORY;
+    while( p < end && !webvtt_isspace( *p ) ) {
+      ++p;
     }
+    word_len = ( webvtt_uint )( p - word );
     /* skip trailing whitespace */
-    nwhite = webvtt_string_skip_whitespace( settings, &position );
-    /* Get the word text */
-    keyword = webvtt_string_text( &word );
-    /* Get pointer to end of the word. (for chcount()) */
-    end = keyword + webvtt_string_length( &word );
+    while( p < end && webvtt_isspace( *p ) ) {
+      ++p;
+      ++nwhite;
+    }
+    /* A NUL character ends the word as far as its value is concerned */
+    if( ( nul = ( const char * )memchr( word, '\0', word_len ) ) ) {
+      word_len = ( webvtt_uint )( nul - word );
+    }
     /* Get the column count that needs to be skipped. */
-    ncol = webvtt_utf8_chcount( keyword, end );
-    if( WEBVTT_FAILED( s = webvtt_cue_set_setting_from_string( cue,
-                       keyword ) ) ) {
+    ncol = webvtt_utf8_chcount( word, word + word_len );
+    if( word_len > 7 && !memcmp( word, "region:", 7 ) ) {
+      s = set_region( self, cue, word + 7, word_len - 7 );
+    } else {
+      s = set_setting_from_word( cue, word, word_len );
+    }
+    if( WEBVTT_FAILED( s ) ) {
       if( self ) {
         /* Figure out which error to emit */
         webvtt_error error;
@@ -544,7 +634,6 @@ webvtt_cue_validate_set_settings( webvtt_parser self, webvtt_cue *cue,
     }
     /* Move column pointer beyond word and trailing whitespace */
     column += ncol + nwhite;
-    webvtt_release_string( &word );
   }
 
   if( self ) {
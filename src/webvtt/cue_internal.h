@@ -28,6 +28,7 @@
 #ifndef __INTERN_CUE_H__
 # define __INTERN_CUE_H__
 # include <webvtt/cue.h>
+# include <webvtt/parser.h>
 
 /**
  * Private cue flags
@@ -38,9 +39,10 @@ enum {
   CUE_HAVE_POSITION = (1 << 2),
   CUE_HAVE_LINE = (1 << 3),
   CUE_HAVE_ALIGN = (1 << 4),
+  CUE_HAVE_REGION = (1 << 5),
 
   CUE_HAVE_SETTINGS = (CUE_HAVE_VERTICAL | CUE_HAVE_SIZE
-    | CUE_HAVE_POSITION | CUE_HAVE_LINE | CUE_HAVE_ALIGN),
+    | CUE_HAVE_POSITION | CUE_HAVE_LINE | CUE_HAVE_ALIGN | CUE_HAVE_REGION),
 
   CUE_HAVE_CUEPARAMS = 0x40000000,
   CUE_HAVE_ID = 0x80000000,
@@ -50,7 +52,22 @@ enum {
 WEBVTT_INTERN webvtt_bool
 cue_is_incomplete( const webvtt_cue *cue );
 
+WEBVTT_INTERN void
+webvtt_reset_cue( webvtt_cue *cue );
+
+WEBVTT_INTERN int
+webvtt_parse_percentage( const char *value, webvtt_uint len,
+                         webvtt_int64 *number );
+
 WEBVTT_INTERN webvtt_status
 webvtt_cue_set_setting_from_string( webvtt_cue *cue, const char *word );
 
+/**
+ * Parse the cue settings in the 'length' bytes at 'text', without copying
+ * them. Errors are reported through 'self' if it is non-NULL.
+ */
+WEBVTT_INTERN webvtt_status
+webvtt_cue_parse_settings( webvtt_parser self, webvtt_cue *cue,
+                           const char *text, webvtt_uint length );
+
 #endif
@@ -637,7 +637,9 @@ webvtt_cuetext_tokenizer( const char **position, webvtt_cuetext_token **token )
     } else if( token_state == END_TAG ) {
       status = webvtt_create_end_token( token, &result );
     } else if( token_state == TIME_STAMP_TAG ) {
-      webvtt_parse_timestamp( webvtt_string_text( &result ), 0, &time_stamp );
+      webvtt_parse_timestamp_n( webvtt_string_text( &result ),
+                                webvtt_string_length( &result ), 0,
+                                &time_stamp );
       status = webvtt_create_timestamp_token( token, time_stamp );
     } else {
       status = WEBVTT_INVALID_TOKEN_STATE;
@@ -671,6 +673,10 @@ webvtt_parse_cuetext( webvtt_parser self, webvtt_cue *cue,
   webvtt_node_kind kind;
   webvtt_stringlist *lang_stack;
   webvtt_string temp;
+  webvtt_uint max_nodes = self ? self->limits.max_nodes : 0;
+  webvtt_uint max_depth = self ? self->limits.max_depth : 0;
+  webvtt_uint nodes = 0, depth = 0;
+  webvtt_bool too_deep = 0;
 
   /**
    *  TODO: Use these parameters! 'finished' isn't really important
@@ -679,7 +685,6 @@ webvtt_parse_cuetext( webvtt_parser self, webvtt_cue *cue,
    * However, for the time being we can trick the compiler into not
    * warning us about unused variables by doing this.
    */
-  ( void )self;
   ( void )finished;
 
   if( !cue ) {
@@ -749,6 +754,7 @@ webvtt_parse_cuetext( webvtt_parser self, webvtt_cue *cue,
            * up the tree of nodes and continue parsing.
            */
           current_node = current_node->parent;
+          --depth;
 
           if( kind == WEBVTT_LANG ) {
             webvtt_stringlist_pop( lang_stack, &temp );
@@ -776,6 +782,27 @@ webvtt_parse_cuetext( webvtt_parser self, webvtt_cue *cue,
             continue;
           }
 
+          /**
+           * Ignore start tags nested deeper than the parser allows (see
+           * webvtt_set_limits), and skip the rest of the text once the cue
+           * has as many nodes as it may.
+           */
+          if( max_depth && depth >= max_depth
+              && !WEBVTT_IS_VALID_LEAF_NODE( temp_node->kind ) ) {
+            if( !too_deep ) {
+              WARNING_AT( WEBVTT_NESTING_TOO_DEEP, self->cuetext_line, 1 );
+              too_deep = 1;
+            }
+            webvtt_release_node( &temp_node );
+            continue;
+          }
+          if( max_nodes && nodes >= max_nodes ) {
+            WARNING_AT( WEBVTT_TOO_MANY_NODES, self->cuetext_line, 1 );
+            webvtt_release_node( &temp_node );
+            break;
+          }
+          ++nodes;
+
           webvtt_attach_node( current_node, temp_node );
 
           /**
@@ -796,6 +823,7 @@ webvtt_parse_cuetext( webvtt_parser self, webvtt_cue *cue,
           }
 
           current_node = temp_node;
+          ++depth;
           /* Release the node as attach internal node increases the count. */
           webvtt_release_node( &temp_node );
         }
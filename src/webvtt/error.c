@@ -57,6 +57,19 @@ static const char *errstr[] = {
   /* WEBVTT_ALIGN_BAD_VALUE */ "'align' cue-setting must have a value of either 'start', 'middle', or 'end'",
   /* WEBVTT_CUE_CONTAINS_SEPARATOR */ "cue-text line contains unescaped timestamp separator '-->'",
   /* WEBVTT_CUE_INCOMPLETE */ "cue contains cue-id, but is missing cuetimes or cue text",
+  /* WEBVTT_CUE_OUT_OF_ORDER */ "cue start-time is earlier than the start-time of the previous cue",
+  /* WEBVTT_INVALID_REGION_SETTING */ "unrecognized or malformed webvtt-region-setting",
+  /* WEBVTT_REGION_ALREADY_SET */ "'region' cue-setting already used",
+  /* WEBVTT_REGION_BAD_VALUE */ "'region' cue-setting must be the id of a region defined in the file header",
+  /* WEBVTT_INVALID_STYLE_RULE */ "malformed or unsupported STYLE rule",
+  /* WEBVTT_INVALID_UTF8 */ "malformed UTF-8 sequence",
+  /* WEBVTT_LINE_TOO_LONG */ "line is longer than the parser's limit, and was cut short",
+  /* WEBVTT_CUE_TEXT_TOO_LONG */ "cue text is longer than the parser's limit, and was cut short",
+  /* WEBVTT_TOO_MANY_CUES */ "more cues than the parser's limit; the rest were skipped",
+  /* WEBVTT_TOO_MANY_NODES */ "cue text has more nodes than the parser's limit; the rest was skipped",
+  /* WEBVTT_NESTING_TOO_DEEP */ "cue text tags are nested deeper than the parser's limit, and were ignored",
+  /* WEBVTT_INPUT_TOO_LONG */ "input is longer than the parser's limit; the rest was ignored",
+  /* WEBVTT_STATE_TOO_DEEP */ "parser state is nested deeper than its limit; parsing stopped",
 };
 
 /**
@@ -88,12 +101,14 @@ webvtt_error_for_status( webvtt_status status, webvtt_error *out )
     case WEBVTT_BAD_SIZE: *out = WEBVTT_SIZE_BAD_VALUE; break;
     case WEBVTT_BAD_POSITION: *out = WEBVTT_POSITION_BAD_VALUE; break;
     case WEBVTT_BAD_VERTICAL: *out = WEBVTT_VERTICAL_BAD_VALUE; break;
+    case WEBVTT_BAD_REGION: *out = WEBVTT_REGION_BAD_VALUE; break;
 
     case WEBVTT_ALREADY_ALIGN: *out = WEBVTT_ALIGN_ALREADY_SET; break;
     case WEBVTT_ALREADY_LINE: *out = WEBVTT_LINE_ALREADY_SET; break;
     case WEBVTT_ALREADY_SIZE: *out = WEBVTT_SIZE_ALREADY_SET; break;
     case WEBVTT_ALREADY_POSITION: *out = WEBVTT_POSITION_ALREADY_SET; break;
     case WEBVTT_ALREADY_VERTICAL: *out = WEBVTT_VERTICAL_ALREADY_SET; break;
+    case WEBVTT_ALREADY_REGION: *out = WEBVTT_REGION_ALREADY_SET; break;
 
     case WEBVTT_BAD_CUESETTING: *out = WEBVTT_INVALID_CUESETTING; break;
 
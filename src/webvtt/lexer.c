@@ -28,128 +28,81 @@
 #include "parser_internal.h"
 
 /**
- * There are probably enough jumps and stack pops here to fill up quite a few
- * caches but it may still
- * be much smaller than a gigantic table-based solution.
- *
- * TODO: Replace all char literals with hex values, just in case compiling on a
- * machine which uses an
- * incompatible character set
+ * webvtt_lex is driven by two tables: 'byte_class' maps each input byte to one
+ * of the few classes of byte the tokenizer cares about, and 'transitions'
+ * maps a (state, class) pair either to the next state, or to an action which
+ * finishes (or backs out of) a token.
  */
+enum
+webvtt_byte_class_t
+{
+  C_OTHER = 0, C_LF, C_CR, C_BLANK, C_W, C_E, C_B, C_V, C_T, C_BOM0, C_BOM1,
+  C_BOM2, C_COUNT
+};
 
-#define U_DIGIT case 0x30: case 0x31: case 0x32: case 0x33: case 0x34: \
-                case 0x35: case 0x36: case 0x37: case 0x38: case 0x39:
-#define U_WHITESPACE case 0x0D: case 0x0A: case 0x20: case 0x09:
-#define U_SPACE case 0x20:
-#define U_TAB case 0x09:
-#define U_CR case 0x0D:
-#define U_LF case 0x0A:
-
-#define U_DASH case 0x2D:
-#define U_PERIOD case 0x2E:
-#define U_GT case 0x3E:
-#define U_COLON case 0x3A:
-#define U_PERCENT case 0x25:
-
-#define U_0 case 0x30:
-#define U_1 case 0x31:
-#define U_2 case 0x32:
-#define U_3 case 0x33:
-#define U_4 case 0x34:
-#define U_5 case 0x35:
-#define U_6 case 0x36:
-#define U_7 case 0x37:
-#define U_8 case 0x38:
-#define U_9 case 0x39:
-
-#define U_a case 0x61:
-#define U_b case 0x62:
-#define U_c case 0x63:
-#define U_d case 0x64:
-#define U_e case 0x65:
-#define U_f case 0x66:
-#define U_g case 0x67:
-#define U_h case 0x68:
-#define U_i case 0x69:
-#define U_j case 0x6A:
-#define U_k case 0x6B:
-#define U_l case 0x6C:
-#define U_m case 0x6D:
-#define U_n case 0x6E:
-#define U_o case 0x6F:
-#define U_p case 0x70:
-#define U_q case 0x71:
-#define U_r case 0x72:
-#define U_s case 0x73:
-#define U_t case 0x74:
-#define U_u case 0x75:
-#define U_v case 0x76:
-#define U_w case 0x77:
-#define U_x case 0x78:
-#define U_y case 0x79:
-#define U_z case 0x7A:
-
-#define U_A case 0x41:
-#define U_B case 0x42:
-#define U_C case 0x43:
-#define U_D case 0x44:
-#define U_E case 0x45:
-#define U_F case 0x46:
-#define U_G case 0x47:
-#define U_H case 0x48:
-#define U_I case 0x49:
-#define U_J case 0x4A:
-#define U_K case 0x4B:
-#define U_L case 0x4C:
-#define U_M case 0x4D:
-#define U_N case 0x4E:
-#define U_O case 0x4F:
-#define U_P case 0x50:
-#define U_Q case 0x51:
-#define U_R case 0x52:
-#define U_S case 0x53:
-#define U_T case 0x54:
-#define U_U case 0x55:
-#define U_V case 0x56:
-#define U_W case 0x57:
-#define U_X case 0x58:
-#define U_Y case 0x59:
-#define U_Z case 0x5A:
-
-#define U_BOM0 case 0xEF:
-#define U_BOM1 case 0xBB:
-#define U_BOM2 case 0xBF:
-
-#define DEFAULT default:
-
-/**
- * Just for semantic clarity
- */
-#define OR
-#define AND
-
-#define IF_OVERFLOW(X) \
-  if( self->token_pos >= (sizeof(self->token) - 1 ) ) \
-  { \
-    RETURN(X) \
-  }
-
-#define BEGIN_STATE(state) case state: { switch(c) {
-#define END_STATE DEFAULT BACKUP return BADTOKEN; } } break;
-#define END_STATE_EX } } break;
-#define SET_STATE(X) self->tstate = X; break;
-#define RETURN(X) self->tstate = L_START; return X;
-#define SET_NEWLINE self->line++; self->column = 1; RETURN(NEWLINE)
-#define CONTINUE continue;
-#define BREAK break;
-
-#define BACKUP (*pos)--; \
-               --self->column; \
-               self->token[--self->token_pos] = 0; \
-               self->tstate = L_START;
-#define RESET self->column = 1; \
-              self->bytes = self->token_pos = 0; \
-              self->tstate = L_START;
+enum
+webvtt_lexer_action_t
+{
+  /* Values below A_BADTOKEN are lexer states */
+  A_BADTOKEN = 0x10, /* back up, return BADTOKEN */
+  A_NEWLINE, /* return NEWLINE */
+  A_BACKUP_NEWLINE, /* back up, return NEWLINE */
+  A_WEBVTT, /* return WEBVTT */
+  A_BOM, /* skip leading BOM, or return BOM */
+  A_WHITESPACE, /* collect run of whitespace */
+  A_BACKUP_WHITESPACE /* back up, return WHITESPACE */
+};
+
+static const unsigned char byte_class[ 256 ] = {
+  /* 0x00 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, C_BLANK, C_LF, 0, 0, C_CR, 0, 0,
+  /* 0x10 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x20 */ C_BLANK, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x30 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x40 */ 0, 0, C_B, 0, 0, C_E, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x50 */ 0, 0, 0, 0, C_T, 0, C_V, C_W, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x60 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x70 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x80 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x90 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0xA0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0xB0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, C_BOM1, 0, 0, 0, C_BOM2,
+  /* 0xC0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0xD0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0xE0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, C_BOM0,
+  /* 0xF0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+#define BAD A_BADTOKEN
+static const unsigned char transitions[ L_WHITESPACE + 1 ][ C_COUNT ] = {
+  /*                other  LF  CR  blank  W  E  B  V  T  BOM0 BOM1 BOM2 */
+  /* L_START */    { BAD, A_NEWLINE, L_NEWLINE0, A_WHITESPACE, L_WEBVTT0, BAD,
+                     BAD, BAD, BAD, L_BOM0, BAD, BAD },
+  /* L_BOM0 */     { BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, L_BOM1,
+                     BAD },
+  /* L_BOM1 */     { BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+                     A_BOM },
+  /* L_WEBVTT0 */  { BAD, BAD, BAD, BAD, BAD, L_WEBVTT1, BAD, BAD, BAD, BAD,
+                     BAD, BAD },
+  /* L_WEBVTT1 */  { BAD, BAD, BAD, BAD, BAD, BAD, L_WEBVTT2, BAD, BAD, BAD,
+                     BAD, BAD },
+  /* L_WEBVTT2 */  { BAD, BAD, BAD, BAD, BAD, BAD, BAD, L_WEBVTT3, BAD, BAD,
+                     BAD, BAD },
+  /* L_WEBVTT3 */  { BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, L_WEBVTT4, BAD,
+                     BAD, BAD },
+  /* L_WEBVTT4 */  { BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD, A_WEBVTT, BAD,
+                     BAD, BAD },
+  /* L_NEWLINE0 */ { A_BACKUP_NEWLINE, A_NEWLINE, A_BACKUP_NEWLINE,
+                     A_BACKUP_NEWLINE, A_BACKUP_NEWLINE, A_BACKUP_NEWLINE,
+                     A_BACKUP_NEWLINE, A_BACKUP_NEWLINE, A_BACKUP_NEWLINE,
+                     A_BACKUP_NEWLINE, A_BACKUP_NEWLINE, A_BACKUP_NEWLINE },
+  /* L_WHITESPACE */ { A_BACKUP_WHITESPACE, A_BACKUP_WHITESPACE,
+                     A_BACKUP_WHITESPACE, A_WHITESPACE, A_BACKUP_WHITESPACE,
+                     A_BACKUP_WHITESPACE, A_BACKUP_WHITESPACE,
+                     A_BACKUP_WHITESPACE, A_BACKUP_WHITESPACE,
+                     A_BACKUP_WHITESPACE, A_BACKUP_WHITESPACE,
+                     A_BACKUP_WHITESPACE }
+};
+#undef BAD
 
 #define CHECK_BROKEN_TIMESTAMP \
 if(self->token_pos == sizeof(self->token) - 1 ) \
@@ -281,64 +234,90 @@ WEBVTT_INTERN webvtt_token
 webvtt_lex( webvtt_parser self, const char *buffer, webvtt_uint *pos,
             webvtt_uint length, webvtt_bool finish )
 {
-  while( *pos < length ) {
-    unsigned char c = (unsigned char)buffer[(*pos)++];
-    self->token[ self->token_pos++ ] = c;
-    self->token[ self->token_pos ] = 0;
-    self->column++;
-    self->bytes++;
-    switch( self->tstate ) {
-        BEGIN_STATE(L_START)
-          U_W  { SET_STATE(L_WEBVTT0) }
-          U_BOM0 { SET_STATE(L_BOM0) }
-          U_LF { SET_NEWLINE }
-          U_CR { SET_STATE(L_NEWLINE0) }
-          U_SPACE OR U_TAB { SET_STATE(L_WHITESPACE) }
-        END_STATE
-
-        BEGIN_STATE(L_BOM0)
-          U_BOM1 { SET_STATE(L_BOM1) }
-        END_STATE
-
-        BEGIN_STATE(L_BOM1)
-          U_BOM2 {
-          if( self->bytes == 3 ) {
-            RESET
-            BREAK
-          }
-          RETURN(BOM)
-        }
-        END_STATE
-
-        BEGIN_STATE(L_WEBVTT0)
-          U_E { SET_STATE(L_WEBVTT1) }
-        END_STATE
-
-        BEGIN_STATE(L_WEBVTT1)
-          U_B { SET_STATE(L_WEBVTT2) }
-        END_STATE
+  /**
+   * Work on local copies of the position, token length and state, and
+   * bring 'column' and 'bytes' up to date only once the token is finished,
+   * rather than updating the parser for every byte.
+   */
+  const unsigned char *b = ( const unsigned char * )buffer;
+  webvtt_uint p = *pos;
+  webvtt_uint start = p;
+  webvtt_uint token_pos = self->token_pos;
+  unsigned char state = ( unsigned char )self->tstate;
+  webvtt_token token;
 
-        BEGIN_STATE(L_WEBVTT2)
-          U_V { SET_STATE(L_WEBVTT3) }
-        END_STATE
+  while( p < length ) {
+    unsigned char c = b[ p++ ];
+    unsigned char action;
+    self->token[ token_pos++ ] = c;
+    action = transitions[ state ][ byte_class[ c ] ];
+    if( action < A_BADTOKEN ) {
+      state = action;
+      continue;
+    }
+    switch( action ) {
+      case A_BADTOKEN:
+        /* Back up, but count the byte as read */
+        --p;
+        --token_pos;
+        self->bytes++;
+        token = BADTOKEN;
+        goto _finished;
 
-        BEGIN_STATE(L_WEBVTT3)
-          U_T { SET_STATE(L_WEBVTT4) }
-        END_STATE
+      case A_BACKUP_NEWLINE:
+        --p;
+        --token_pos;
+        self->bytes++;
+        /* fall through */
+      case A_NEWLINE:
+        self->bytes += p - start;
+        self->line++;
+        self->column = 1;
+        start = p;
+        token = NEWLINE;
+        goto _finished;
 
-        BEGIN_STATE(L_WEBVTT4)
-          U_T { RETURN(WEBVTT) }
-        END_STATE
+      case A_WEBVTT:
+        token = WEBVTT;
+        goto _finished;
 
-        BEGIN_STATE(L_NEWLINE0)
-          U_LF { SET_NEWLINE }
-        DEFAULT { BACKUP AND SET_NEWLINE }
-        END_STATE_EX
+      case A_BOM:
+        if( self->bytes + ( p - start ) == 3 ) {
+          /* Skip the byte order mark at the start of the file */
+          self->column = 1;
+          self->bytes = 0;
+          start = p;
+          token_pos = 0;
+          state = L_START;
+          continue;
+        }
+        token = BOM;
+        goto _finished;
 
-        BEGIN_STATE(L_WHITESPACE)
-          U_SPACE OR U_TAB { IF_OVERFLOW(WHITESPACE) SET_STATE(L_WHITESPACE) }
-        DEFAULT { BACKUP RETURN(WHITESPACE) }
-        END_STATE_EX
+      case A_WHITESPACE:
+        /**
+         * Collect the rest of the run of whitespace here, rather than a byte
+         * at a time through the table.
+         */
+        while( token_pos < ( sizeof( self->token ) - 1 ) ) {
+          if( p >= length || byte_class[ b[ p ] ] != C_BLANK ) {
+            break;
+          }
+          self->token[ token_pos++ ] = b[ p++ ];
+        }
+        if( token_pos >= ( sizeof( self->token ) - 1 ) ) {
+          token = WHITESPACE;
+          goto _finished;
+        }
+        state = L_WHITESPACE;
+        continue;
+
+      case A_BACKUP_WHITESPACE:
+        --p;
+        --token_pos;
+        self->bytes++;
+        token = WHITESPACE;
+        goto _finished;
     }
   }
 
@@ -346,16 +325,31 @@ webvtt_lex( webvtt_parser self, const char *buffer, webvtt_uint *pos,
    * If we got here, we've reached the end of the buffer.
    * We therefore can attempt to finish up
    */
-  if( finish && self->token_pos ) {
-    switch( self->tstate ) {
-      case L_WHITESPACE:
-        RETURN(WHITESPACE)
-      default:
-        RESET
-        return BADTOKEN;
+  self->column += p - start;
+  self->bytes += p - start;
+  self->token[ token_pos ] = 0;
+  self->token_pos = token_pos;
+  self->tstate = ( webvtt_lexer_state )state;
+  *pos = p;
+  if( finish && token_pos ) {
+    self->tstate = L_START;
+    if( state == L_WHITESPACE ) {
+      return WHITESPACE;
     }
+    self->column = 1;
+    self->bytes = self->token_pos = 0;
+    return BADTOKEN;
   }
-  return *pos == length || self->token_pos ? UNFINISHED : BADTOKEN;
+  return p == length || token_pos ? UNFINISHED : BADTOKEN;
+
+_finished:
+  self->column += p - start;
+  self->bytes += p - start;
+  self->token[ token_pos ] = 0;
+  self->token_pos = token_pos;
+  self->tstate = L_START;
+  *pos = p;
+  return token;
 }
 /**
  * token states
@@ -28,7 +28,11 @@
  #include <string.h>
  #include <stdlib.h>
  #include "node_internal.h"
+ #include "alloc_internal.h"
 
+ /**
+  * Shared by every thread, so its count is never changed
+  */
  static webvtt_node empty_node = {
   { 1 }, /* init ref count */
   0, /* parent */
@@ -39,7 +43,7 @@
 WEBVTT_EXPORT void
 webvtt_ref_node( webvtt_node *node )
 {
-  if( node ) {
+  if( node && node != &empty_node ) {
     webvtt_ref( &node->refs );
   }
 }
@@ -66,7 +70,8 @@ webvtt_create_node( webvtt_node **node, webvtt_node_kind kind,
     return WEBVTT_INVALID_PARAM;
   }
 
-  if( !( temp_node = (webvtt_node *)webvtt_alloc0(sizeof(*temp_node)) ) )
+  if( !( temp_node = (webvtt_node *)webvtt_alloc0_as( sizeof(*temp_node),
+                                                      WEBVTT_OBJECT_NODE ) ) )
   {
     return WEBVTT_OUT_OF_MEMORY;
   }
@@ -93,7 +98,8 @@ webvtt_create_internal_node( webvtt_node **node, webvtt_node *parent,
   }
 
   if ( !( node_data =
-         (webvtt_internal_node_data *)webvtt_alloc0( sizeof(*node_data) ) ) )
+         (webvtt_internal_node_data *)webvtt_alloc0_as( sizeof(*node_data),
+                                              WEBVTT_OBJECT_NODE_DATA ) ) )
   {
     return WEBVTT_OUT_OF_MEMORY;
   }
@@ -185,14 +191,28 @@ WEBVTT_EXPORT void
 webvtt_release_node( webvtt_node **node )
 {
   webvtt_uint i;
-  webvtt_node *n;
+  webvtt_node *n, *child, *dead;
 
   if( !node || !*node ) {
     return;
   }
   n = *node;
+  *node = 0;
 
-  if( webvtt_deref( &n->refs )  == 0 ) {
+  if( n == &empty_node || webvtt_deref( &n->refs ) != 0 ) {
+    return;
+  }
+
+  /**
+   * Nodes which are no longer referenced are linked through their 'parent'
+   * pointers and freed one at a time, so that releasing deeply nested cue
+   * text does not recurse once per level.
+   */
+  n->parent = 0;
+  dead = n;
+  while( dead ) {
+    n = dead;
+    dead = n->parent;
     if( n->kind == WEBVTT_TEXT ) {
         webvtt_release_string( &n->data.text );
     } else if( WEBVTT_IS_VALID_INTERNAL_NODE( n->kind ) &&
@@ -200,15 +220,20 @@ webvtt_release_node( webvtt_node **node )
       webvtt_release_stringlist( &n->data.internal_data->css_classes );
       webvtt_release_string( &n->data.internal_data->lang );
       webvtt_release_string( &n->data.internal_data->annotation );
+      webvtt_release_style( &n->data.internal_data->style );
       for( i = 0; i < n->data.internal_data->length; i++ ) {
-        webvtt_release_node( n->data.internal_data->children + i );
+        child = n->data.internal_data->children[ i ];
+        if( child && child != &empty_node &&
+            webvtt_deref( &child->refs ) == 0 ) {
+          child->parent = dead;
+          dead = child;
+        }
       }
       webvtt_free( n->data.internal_data->children );
       webvtt_free( n->data.internal_data );
     }
     webvtt_free( n );
   }
-  *node = 0;
 }
 
 WEBVTT_INTERN webvtt_status
@@ -223,7 +248,8 @@ webvtt_attach_node( webvtt_node *parent, webvtt_node *to_attach )
   nd = parent->data.internal_data;
 
   if( nd->alloc == 0 ) {
-    next = (webvtt_node **)webvtt_alloc0( sizeof( webvtt_node * ) * 8 );
+    next = (webvtt_node **)webvtt_alloc0_as( sizeof( webvtt_node * ) * 8,
+                                            WEBVTT_OBJECT_NODE_DATA );
 
     if( !next ) {
       return WEBVTT_OUT_OF_MEMORY;
@@ -235,7 +261,8 @@ webvtt_attach_node( webvtt_node *parent, webvtt_node *to_attach )
 
   if( nd->length + 1 >= ( nd->alloc / 3 ) * 2 ) {
 
-    next = (webvtt_node **)webvtt_alloc0( sizeof( *next ) * nd->alloc * 2 );
+    next = (webvtt_node **)webvtt_alloc0_as( sizeof( *next ) * nd->alloc * 2,
+                                            WEBVTT_OBJECT_NODE_DATA );
 
     if( !next ) {
       return WEBVTT_OUT_OF_MEMORY;
@@ -28,6 +28,8 @@
 #include "parser_internal.h"
 #include "cuetext_internal.h"
 #include "cue_internal.h"
+#include "region_internal.h"
+#include "utf8_internal.h"
 #include <string.h>
 
 #define _ERROR(X) do { if( skip_error == 0 ) { ERROR(X); } } while(0)
@@ -43,26 +45,30 @@ static const char replacement[] = { 0xEF, 0xBF, 0xBD };
 #define MSECS_PER_SECOND (1000)
 #define BUFFER (self->buffer + self->position)
 #define MALFORMED_TIME ((webvtt_timestamp_t)-1.0)
+/* Input parsed between two looks at the clock by webvtt_parse_chunk_budget */
+#define BUDGET_SLICE (0x1000)
 
 static webvtt_status find_bytes( const char *buffer, webvtt_uint len,
                                  const char *sbytes, webvtt_uint slen );
 
-WEBVTT_EXPORT webvtt_status
-webvtt_create_parser( webvtt_cue_fn on_read,
-                      webvtt_error_fn on_error, void *
-                      userdata,
-                      webvtt_parser *ppout )
+static webvtt_status
+create_parser( webvtt_cue_fn on_read, webvtt_error_fn on_error,
+               void *userdata, webvtt_bool validate, webvtt_parser *ppout )
 {
   webvtt_parser p;
-  if( !on_read || !on_error || !ppout ) {
-    return WEBVTT_INVALID_PARAM;
+  webvtt_alloc_stats *stats = 0, *previous;
+  if( webvtt_alloc_stats_enabled() &&
+      !( stats = webvtt_create_alloc_stats() ) ) {
+    return WEBVTT_OUT_OF_MEMORY;
   }
-
+  previous = webvtt_enter_alloc_stats( stats );
   if( !( p = ( webvtt_parser )webvtt_alloc0( sizeof * p ) ) ) {
+    webvtt_leave_alloc_stats( previous );
+    webvtt_release_alloc_stats( &stats );
     return WEBVTT_OUT_OF_MEMORY;
   }
+  p->alloc_stats = stats;
 
-  memset( p->astack, 0, sizeof( p->astack ) );
   p->stack = p->astack;
   p->top = p->stack;
   p->top->state = T_INITIAL;
@@ -71,13 +77,173 @@ webvtt_create_parser( webvtt_cue_fn on_read,
   p->read = on_read;
   p->error = on_error;
   p->column = p->line = 1;
+  p->utf8_column = p->utf8_line = 1;
   p->userdata = userdata;
   p->finished = 0;
+
+
+  p->validate = validate;
+  p->last_start = 0;
+  p->limits.max_line_bytes = WEBVTT_MAX_LINE;
+  webvtt_ref( &p->scratch_cue.refs );
+  webvtt_init_string( &p->scratch_cue.id );
+  webvtt_init_string( &p->scratch_cue.body );
+  webvtt_reset_cue( &p->scratch_cue );
+  webvtt_init_string( &p->style_text );
+  webvtt_leave_alloc_stats( previous );
   *ppout = p;
 
   return WEBVTT_SUCCESS;
 }
 
+WEBVTT_EXPORT webvtt_status
+webvtt_create_parser( webvtt_cue_fn on_read,
+                      webvtt_error_fn on_error, void *
+                      userdata,
+                      webvtt_parser *ppout )
+{
+  if( !on_read || !on_error || !ppout ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  return create_parser( on_read, on_error, userdata, 0, ppout );
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_create_validator( webvtt_error_fn on_error, void *userdata,
+                         webvtt_parser *ppout )
+{
+  if( !on_error || !ppout ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  return create_parser( 0, on_error, userdata, 1, ppout );
+}
+
+/**
+ * Helper to get a cue to fill in. A validator has no use for the cue once it
+ * has been checked, so it hands out its scratch cue rather than allocating a
+ * new one.
+ */
+static webvtt_status
+new_cue( webvtt_parser self, webvtt_cue **pcue )
+{
+  if( self->validate ) {
+    webvtt_reset_cue( &self->scratch_cue );
+    webvtt_ref_cue( &self->scratch_cue );
+    *pcue = &self->scratch_cue;
+    return WEBVTT_SUCCESS;
+  }
+  return webvtt_create_cue( pcue );
+}
+
+/**
+ * Helpers to reuse the storage of lines read in T_CUEREAD. 'take_line' fills
+ * 'line' with 'text', using the spare line buffer if there is one;
+ * 'recycle_line' keeps the storage of 'line' as the spare line buffer, if the
+ * buffer is free and the storage is not shared.
+ */
+static webvtt_status
+take_line( webvtt_parser self, webvtt_string *line, const char *text,
+           webvtt_uint length )
+{
+  if( self->spare_line.d ) {
+    line->d = self->spare_line.d;
+    self->spare_line.d = 0;
+    webvtt_string_clear( line );
+    return webvtt_string_append( line, text, length );
+  }
+  return webvtt_create_string_with_text( line, text, length );
+}
+
+static void
+recycle_line( webvtt_parser self, webvtt_string *line )
+{
+  if( !self->spare_line.d && webvtt_string_capacity( line )
+      && line->d->refs.value == 1 ) {
+    self->spare_line.d = line->d;
+    line->d = 0;
+  } else {
+    webvtt_release_string( line );
+  }
+}
+
+/**
+ * Read the line at '*ppos', for T_CUEREAD and for cue text alike. A line
+ * which ends in this chunk (or at the end of the input) is returned in
+ * '*pline' straight from 'buffer', with no copy. Only a line which runs past
+ * the end of the chunk is copied: its start is carried over in line_buffer,
+ * and the line is returned from there once its end arrives. So is a line
+ * holding NUL bytes, which are replaced with U+FFFD. Lines are cut short at
+ * max_line_bytes (on a character boundary), wherever the chunks end.
+ *
+ * Returns 1 if the line is complete, 0 if it goes on in the next chunk, or -1
+ * if memory runs out.
+ */
+static int
+read_line( webvtt_parser self, const char *buffer, webvtt_uint *ppos,
+           webvtt_uint len, webvtt_bool finish, const char **pline,
+           webvtt_uint *plength )
+{
+  webvtt_string *carry = &self->line_buffer;
+  webvtt_uint carried = webvtt_string_length( carry );
+  const char *s = buffer + *ppos;
+  const char *eol = webvtt_find_eol( s, buffer + len );
+  webvtt_uint n = (webvtt_uint)( eol - s );
+  webvtt_uint max = self->limits.max_line_bytes;
+  int complete = eol < buffer + len || finish;
+
+  /* Set the carry-over buffer up once, rather than at the first split line */
+  if( !carry->d && WEBVTT_FAILED( webvtt_create_string( 0x100, carry ) ) ) {
+    return -1;
+  }
+  *ppos += n;
+  if( self->line_cut ) {
+    n = 0;
+  } else if( max && carried + n > max ) {
+    /* Cut the line short, before the character which crosses the limit */
+    n = max - carried;
+    while( n && ( s[ n ] & 0xC0 ) == 0x80 ) {
+      --n;
+    }
+    if( !n && ( *s & 0xC0 ) == 0x80 ) {
+      /* The character started in an earlier chunk */
+      const char *text = webvtt_string_text( carry );
+      webvtt_uint k = carried;
+      while( k && ( text[ k - 1 ] & 0xC0 ) == 0x80 ) {
+        --k;
+      }
+      if( k && ( text[ k - 1 ] & 0xC0 ) == 0xC0 ) {
+        carried = k - 1;
+        webvtt_string_truncate( carry, carried );
+      }
+    }
+    WARNING_AT( WEBVTT_LINE_TOO_LONG, self->line, max + 1 );
+    self->line_cut = 1;
+  }
+  if( complete ) {
+    self->line_cut = 0;
+  }
+  if( complete && !carried && !memchr( s, 0, n ) ) {
+    *pline = s;
+    *plength = n;
+    return 1;
+  }
+
+  if( n && WEBVTT_FAILED( webvtt_string_append( carry, s, n ) ) ) {
+    return -1;
+  }
+  if( !complete ) {
+    return 0;
+  }
+  /* replace '\0' with u+fffd */
+  if( WEBVTT_FAILED( webvtt_string_replace_all( carry, "\0", 1, replacement,
+                                                3 ) ) ) {
+    return -1;
+  }
+  *pline = webvtt_string_text( carry );
+  *plength = webvtt_string_length( carry );
+  return 1;
+}
+
 /**
  * Helper to validate a cue and, if valid, notify the application that a cue has
  * been read.
@@ -94,8 +260,13 @@ finish_cue( webvtt_parser self, webvtt_cue **pcue )
     webvtt_cue *cue = *pcue;
     if( cue ) {
       if( webvtt_validate_cue( cue ) ) {
+        PROFILE_COUNT( cues_emitted );
+        /* The cue may be kept for long, so give back the slack in its text */
+        webvtt_string_shrink_to_fit( &cue->id );
+        webvtt_string_shrink_to_fit( &cue->body );
         self->read( self->userdata, cue );
       } else {
+        PROFILE_COUNT( cues_dropped );
         webvtt_release_cue( &cue );
       }
       *pcue = 0;
@@ -116,6 +287,9 @@ cleanup_stack( webvtt_parser self )
   while( st >= self->stack ) {
     switch( st->type ) {
       case V_CUE:
+        if( st->v.cue ) {
+          PROFILE_COUNT( cues_dropped );
+        }
         webvtt_release_cue( &st->v.cue );
         break;
       case V_TEXT:
@@ -151,11 +325,8 @@ cleanup_stack( webvtt_parser self )
   }
 }
 
-/**
- *
- */
-WEBVTT_EXPORT webvtt_status
-webvtt_finish_parsing( webvtt_parser self )
+static webvtt_status
+finish_parsing( webvtt_parser self )
 {
   webvtt_status status = WEBVTT_SUCCESS;
   const char buffer[] = "\0";
@@ -163,6 +334,9 @@ webvtt_finish_parsing( webvtt_parser self )
   webvtt_uint pos = 0;
 
   if( !self->finished ) {
+    if( WEBVTT_FAILED( status = webvtt_finish_utf8( self ) ) ) {
+      return status;
+    }
     self->finished = 1;
 
 retry:
@@ -174,6 +348,20 @@ retry:
       case M_WEBVTT:
         if( self->top->state == T_CUEREAD ) {
           SAFE_ASSERT( self->top != self->stack );
+          if( self->top->type == V_NONE ) {
+            /* The last line has no newline: take what was carried over */
+            const char *line;
+            webvtt_uint length;
+            if( read_line( self, buffer, &pos, len, 1, &line, &length ) < 0
+                || WEBVTT_FAILED( take_line( self, &self->top->v.text, line,
+                                             length ) ) ) {
+              ERROR( WEBVTT_ALLOCATION_FAILED );
+              cleanup_stack( self );
+              return WEBVTT_OUT_OF_MEMORY;
+            }
+            self->top->type = V_TEXT;
+            webvtt_string_clear( &self->line_buffer );
+          }
           --self->top;
           self->popped = 1;
         }
@@ -182,13 +370,13 @@ retry:
           webvtt_string text;
           webvtt_cue *cue;
           if( self->top->type == V_NONE ) {
-            webvtt_create_cue( &self->top->v.cue );
+            new_cue( self, &self->top->v.cue );
             self->top->type = V_CUE;
           }
           cue = self->top->v.cue;
           SAFE_ASSERT( self->popped && (self->top+1)->state == T_CUEREAD );
           SAFE_ASSERT( cue != 0 );
-          text.d = (self->top+1)->v.text.d;
+          text = (self->top+1)->v.text;
           (self->top+1)->v.text.d = 0;
           (self->top+1)->type = V_NONE;
           (self->top+1)->state = 0;
@@ -199,7 +387,8 @@ retry:
           }
           ++self->line;
           self->column = 1;
-          if( self->mode == M_CUETEXT ) {
+          if( self->mode == M_CUETEXT || self->mode == M_REGION
+              || self->mode == M_STYLE ) {
             goto retry;
           }
         }
@@ -210,6 +399,8 @@ retry:
        * application if possible.
        */
       case M_CUETEXT:
+      case M_REGION:
+      case M_STYLE:
         status = webvtt_proc_cuetext( self, buffer, &pos, len, self->finished );
         break;
       case M_SKIP_CUE:
@@ -222,14 +413,95 @@ retry:
   return status;
 }
 
+WEBVTT_EXPORT webvtt_status
+webvtt_finish_parsing( webvtt_parser self )
+{
+  webvtt_alloc_stats *previous = webvtt_enter_alloc_stats( self->alloc_stats );
+  webvtt_status status = finish_parsing( self );
+  webvtt_leave_alloc_stats( previous );
+  return status;
+}
+
 WEBVTT_EXPORT void
 webvtt_delete_parser( webvtt_parser self )
 {
   if( self ) {
+    webvtt_alloc_stats *stats = self->alloc_stats;
     cleanup_stack( self );
 
     webvtt_release_string( &self->line_buffer );
+    webvtt_release_string( &self->spare_line );
+    webvtt_release_string( &self->scratch_cue.id );
+    webvtt_release_string( &self->scratch_cue.body );
+    webvtt_reset_cue( &self->scratch_cue );
+    webvtt_clear_regions( self );
+    webvtt_free( self->regions );
+    webvtt_clear_styles( self, 1 );
+    webvtt_release_string( &self->style_text );
+    webvtt_free( self->errors );
     webvtt_free( self );
+    webvtt_release_alloc_stats( &stats );
+  }
+}
+
+WEBVTT_EXPORT void
+webvtt_reset_parser( webvtt_parser self )
+{
+  if( self ) {
+    /* Release anything left on the stack, and return to the inline stack */
+    cleanup_stack( self );
+    memset( self->astack, 0, sizeof( self->astack ) );
+    self->top = self->stack;
+
+    /**
+     * Forget the regions of the previous file, keeping the table's storage.
+     * Cues placed in them keep them.
+     */
+    webvtt_clear_regions( self );
+    webvtt_clear_styles( self, 0 );
+    webvtt_string_clear( &self->style_text );
+    self->seen_cue = 0;
+    self->top->state = T_INITIAL;
+
+    self->state = 0;
+    self->bytes = 0;
+    self->column = self->line = 1;
+    self->finished = 0;
+    self->cuetext_line = 0;
+    self->mode = M_WEBVTT;
+    self->popped = 0;
+
+    /* Forget collected errors, but keep the buffer and suppressed codes */
+    self->error_head = self->error_count = self->dropped_errors = 0;
+    memset( self->error_counts, 0, sizeof( self->error_counts ) );
+
+#if WEBVTT_PROFILING
+    /* Keep profiling on or off, but start counting again */
+    memset( &self->profiler.counts, 0, sizeof( self->profiler.counts ) );
+#endif
+
+    /* Keep the UTF-8 mode, but forget any partial sequence */
+    self->utf8_carry_len = 0;
+    self->utf8_column = self->utf8_line = 1;
+    self->utf8_cr = 0;
+
+    /* Empty the buffers, but keep their storage */
+    self->line_pos = 0;
+    if( self->line_buffer.d ) {
+      webvtt_string_clear( &self->line_buffer );
+    }
+
+    self->last_start = 0;
+    webvtt_reset_cue( &self->scratch_cue );
+
+    /* Keep the limits, but count against them again */
+    self->block_count = 0;
+    self->input_bytes = 0;
+    self->input_cut = self->line_cut = self->body_cut = 0;
+
+    self->tstate = L_START;
+    self->token_pos = 0;
+    self->token[ 0 ] = 0;
   }
 }
 
@@ -248,14 +520,9 @@ webvtt_delete_parser( webvtt_parser self )
 static int
 find_newline( const char *buffer, webvtt_uint *pos, webvtt_uint len )
 {
-  while( *pos < len ) {
-    if( buffer[ *pos ] == '\r' || buffer[ *pos ] == '\n' ) {
-      return 1;
-    } else {
-      ( *pos )++;
-    }
-  }
-  return -1;
+  const char *eol = webvtt_find_eol( buffer + *pos, buffer + len );
+  *pos = (webvtt_uint)( eol - buffer );
+  return *pos < len ? 1 : -1;
 }
 
 /**
@@ -302,14 +569,20 @@ do_push( webvtt_parser self, webvtt_uint token, webvtt_uint back,
          webvtt_uint line, webvtt_uint column )
 {
   if( STACK_SIZE + 1 >= self->stack_alloc ) {
-    webvtt_state *stack =
-        ( webvtt_state * )webvtt_alloc0( sizeof( webvtt_state ) *
-                                         ( self->stack_alloc << 1 ) ), *tmp;
+    webvtt_state *stack, *tmp;
+    if( self->stack_alloc >= MAX_STACK_FRAMES ) {
+      WARNING_AT( WEBVTT_STATE_TOO_DEEP, self->line, self->column );
+      return WEBVTT_PARSE_ERROR;
+    }
+    stack = ( webvtt_state * )webvtt_alloc0_as( sizeof( webvtt_state ) *
+                                                ( self->stack_alloc << 1 ),
+                                                WEBVTT_OBJECT_STACK );
     if( !stack ) {
       ERROR( WEBVTT_ALLOCATION_FAILED );
       return WEBVTT_OUT_OF_MEMORY;
     }
     memcpy( stack, self->stack, sizeof( webvtt_state ) * self->stack_alloc );
+    self->stack_alloc <<= 1;
     tmp = self->stack;
     self->stack = stack;
     self->top = stack + ( self->top - tmp );
@@ -340,18 +613,20 @@ do_pop( webvtt_parser self )
 
 #define PUSH0(S,V,T) \
 do { \
+    webvtt_status __s; \
     self->popped = 0; \
-    if( do_push(self,token,BACK+1,(S),(void*)(V),T,last_line, last_column) \
-      == WEBVTT_OUT_OF_MEMORY ) \
-      return WEBVTT_OUT_OF_MEMORY; \
+    __s = do_push(self,token,BACK+1,(S),(void*)(V),T,last_line, last_column); \
+    if( WEBVTT_FAILED( __s ) ) \
+      return __s; \
   } while(0)
 
 #define PUSH(S,B,V,T) \
 do { \
+  webvtt_status __s; \
   self->popped = 0; \
-  if( do_push(self,token,(B),(S),(void*)(V),T,last_line, last_column) \
-    == WEBVTT_OUT_OF_MEMORY ) \
-    return WEBVTT_OUT_OF_MEMORY; \
+  __s = do_push(self,token,(B),(S),(void*)(V),T,last_line, last_column); \
+  if( WEBVTT_FAILED( __s ) ) \
+    return __s; \
   } while(0)
 
 #define POP() \
@@ -378,7 +653,9 @@ webvtt_collect_timestamp( webvtt_parser self, webvtt_timestamp *result,
   int column = self->column;
   int line = self->line;
   int len;
-  int rv = webvtt_parse_timestamp( webvtt_string_text(input) + *position, &len, result );
+  int rv = webvtt_parse_timestamp_n( webvtt_string_text( input ) + *position,
+                                     webvtt_string_length( input ) - *position,
+                                     &len, result );
   if( !rv ) {
     if( BAD_TIMESTAMP(*result) ) {
       ERROR_AT( WEBVTT_EXPECTED_TIMESTAMP, line, column );
@@ -405,7 +682,8 @@ webvtt_collect_timings_and_settings( webvtt_parser self,
                                      webvtt_cue *cue )
 {
   webvtt_status s;
-  webvtt_string settings;
+  const char *remainder;
+  webvtt_uint length;
 
   /* 1. Let input be the string being parsed. */
   const webvtt_string *input = line;
@@ -482,11 +760,13 @@ webvtt_collect_timings_and_settings( webvtt_parser self,
 
   /**
    * 11. Let remainder be the trailing substring of input starting at position.
+   *
+   * The settings are parsed in place, so that no copy of remainder is made.
    */
-  webvtt_create_string_with_text( &settings,
-                                  webvtt_string_text( input ) + position, -1 );
-  webvtt_cue_validate_set_settings( self, cue, &settings );
-  webvtt_release_string( &settings );
+  remainder = webvtt_string_text( input ) + position;
+  length = ( webvtt_uint )strlen( remainder );
+  PROFILE_PHASE( WEBVTT_PHASE_SETTINGS,
+                 webvtt_cue_parse_settings( self, cue, remainder, length ) );
 
   return WEBVTT_SUCCESS;
 }
@@ -502,6 +782,21 @@ webvtt_proc_cueline( webvtt_parser self, webvtt_cue *cue,
   text = webvtt_string_text( line );
   /* backup the column */
   self->column = 1;
+  if( !( cue->flags & CUE_HAVE_ID ) ) {
+    /* The first line of a block: skip the block if there are too many */
+    webvtt_uint max = self->limits.max_cues;
+    self->body_cut = 0;
+    if( max && self->block_count >= max ) {
+      if( self->block_count == max ) {
+        WARNING_AT( WEBVTT_TOO_MANY_CUES, self->line, 1 );
+        ++self->block_count;
+      }
+      recycle_line( self, line );
+      self->mode = M_SKIP_CUE;
+      return WEBVTT_SUCCESS;
+    }
+    ++self->block_count;
+  }
   if( find_bytes( text, length, separator, sizeof( separator ) )
       == WEBVTT_SUCCESS) {
     /* It's not a cue id, we found '-->'. It can't be a second
@@ -509,16 +804,61 @@ webvtt_proc_cueline( webvtt_parser self, webvtt_cue *cue,
        a different state. */
     int v;
     self->cuetext_line = self->line + 1;
-    if( ( v = webvtt_collect_timings_and_settings( self,
-                                                   line, cue ) ) < 0 ) {
+    self->seen_cue = 1;
+    PROFILE_PHASE( WEBVTT_PHASE_TIMINGS,
+                   v = webvtt_collect_timings_and_settings( self, line,
+                                                            cue ) );
+    if( v < 0 ) {
         if( v == WEBVTT_PARSE_ERROR ) {
+          webvtt_release_string( line );
           return WEBVTT_PARSE_ERROR;
         }
         self->mode = M_SKIP_CUE;
       } else {
         cue->flags |= CUE_HAVE_CUEPARAMS;
         self->mode = M_CUETEXT;
+        if( self->validate ) {
+          if( cue->from < self->last_start ) {
+            WARNING_AT( WEBVTT_CUE_OUT_OF_ORDER, self->line, 1 );
+          }
+          self->last_start = cue->from;
+        }
       }
+  } else if( !self->seen_cue && !( cue->flags & CUE_HAVE_ID )
+             && webvtt_is_region_header( text, length ) ) {
+    /**
+     * A REGION block in the header. Its settings are read line by line, as
+     * cue text would be. The header line is kept as the cue's id, in case
+     * the next line shows the block to be a cue.
+     */
+    if( ( !self->validate
+          && WEBVTT_FAILED( webvtt_string_append( &cue->id, text, length ) ) )
+        || WEBVTT_FAILED( webvtt_begin_region( self ) ) ) {
+      webvtt_release_string( line );
+      ERROR( WEBVTT_ALLOCATION_FAILED );
+      return WEBVTT_OUT_OF_MEMORY;
+    }
+    recycle_line( self, line );
+    self->block_line = self->line;
+    self->mode = M_REGION;
+    return WEBVTT_SUCCESS;
+  } else if( !self->seen_cue && !( cue->flags & CUE_HAVE_ID )
+             && webvtt_is_style_header( text, length ) ) {
+    /**
+     * A STYLE block in the header. Its text is collected, and compiled once
+     * the block ends. As with REGION, the header line is kept as the cue's id.
+     */
+    if( !self->validate
+        && WEBVTT_FAILED( webvtt_string_append( &cue->id, text, length ) ) ) {
+      webvtt_release_string( line );
+      ERROR( WEBVTT_ALLOCATION_FAILED );
+      return WEBVTT_OUT_OF_MEMORY;
+    }
+    recycle_line( self, line );
+    self->block_line = self->line;
+    self->style_line = self->line + 1;
+    self->mode = M_STYLE;
+    return WEBVTT_SUCCESS;
   } else {
     /* It is a cue-id */
     if( cue && cue->flags & CUE_HAVE_ID ) {
@@ -527,7 +867,7 @@ webvtt_proc_cueline( webvtt_parser self, webvtt_cue *cue,
        * have one. It seems to be cuetext, which is occurring
        * before cue-params
        */
-      webvtt_release_string( line );
+      recycle_line( self, line );
       ERROR( WEBVTT_CUE_INCOMPLETE );
       self->mode = M_SKIP_CUE;
       return WEBVTT_SUCCESS;
@@ -537,22 +877,22 @@ webvtt_proc_cueline( webvtt_parser self, webvtt_cue *cue,
       webvtt_token token = UNFINISHED;
       self->column += length;
       self->cuetext_line = self->line;
-      if( WEBVTT_FAILED( webvtt_string_append( &cue->id, text,
-                                               length ) ) ) {
+      if( !self->validate && WEBVTT_FAILED( webvtt_string_append( &cue->id,
+                                                                  text,
+                                                                  length ) ) ) {
         webvtt_release_string( line );
         ERROR( WEBVTT_ALLOCATION_FAILED );
         return WEBVTT_OUT_OF_MEMORY;
       }
       cue->flags |= CUE_HAVE_ID;
+      recycle_line( self, line );
 
       /* Read cue-params line */
       PUSH0( T_CUEREAD, 0, V_NONE );
-      webvtt_init_string( &SP->v.text );
-      SP->type = V_TEXT;
     }
   }
 
-  webvtt_release_string( line );
+  recycle_line( self, line );
   return WEBVTT_SUCCESS;
 }
 
@@ -576,34 +916,30 @@ parse_webvtt( webvtt_parser self, const char *buffer, webvtt_uint *ppos,
      * want to read text instead.
      */
     if( SP->state == T_CUEREAD ) {
-      DIE_IF( SP->type != V_TEXT );
-      if( SP->flags == 0 ) {
-        int v;
-        if( ( v = webvtt_string_getline( &SP->v.text, buffer, &pos, len, 0,
-                                         finish ) ) ) {
-          if( v < 0 ) {
-            webvtt_release_string( &SP->v.text );
-            SP->type = V_NONE;
-            POP();
-            ERROR( WEBVTT_ALLOCATION_FAILED );
-            status = WEBVTT_OUT_OF_MEMORY;
-            goto _finish;
-          }
-          /* replace '\0' with u+fffd */
-          if( WEBVTT_FAILED( status = webvtt_string_replace_all( &SP->v.text,
-                                                                 "\0", 1,
-                                                                 replacement,
-                                                                 3 ) ) ) {
-            webvtt_release_string( &SP->v.text );
-            SP->type = V_NONE;
-            POP();
-            ERROR( WEBVTT_ALLOCATION_FAILED );
-            goto _finish;
+      /**
+       * The frame has no text until the whole line is read, and then it
+       * waits for the newline.
+       */
+      if( SP->type == V_NONE ) {
+        const char *line;
+        webvtt_uint length;
+        int v = read_line( self, buffer, &pos, len, finish, &line, &length );
+        if( v > 0 ) {
+          if( WEBVTT_FAILED( take_line( self, &SP->v.text, line, length ) ) ) {
+            v = -1;
+          } else {
+            SP->type = V_TEXT;
+            webvtt_string_clear( &self->line_buffer );
           }
-          SP->flags = 1;
+        }
+        if( v < 0 ) {
+          POP();
+          ERROR( WEBVTT_ALLOCATION_FAILED );
+          status = WEBVTT_OUT_OF_MEMORY;
+          goto _finish;
         }
       }
-      if( SP->flags ) {
+      if( SP->type == V_TEXT ) {
         webvtt_token token = webvtt_lex_newline( self, buffer, &pos, len,
                                                  self->finished );
         if( token == NEWLINE ) {
@@ -637,6 +973,7 @@ parse_webvtt( webvtt_parser self, const char *buffer, webvtt_uint *ppos,
       }
     }
 _recheck:
+    PROFILE_COUNT( transitions[ SP->state ] );
     switch( SP->state ) {
       default:
         /* Should never happen */
@@ -758,24 +1095,27 @@ _recheck:
         }
         if( token != NEWLINE ) {
           webvtt_cue *cue = 0;
-          webvtt_string tk = { 0 };
-          if( WEBVTT_FAILED( status = webvtt_create_cue( &cue ) ) ) {
+          if( WEBVTT_FAILED( status = new_cue( self, &cue ) ) ) {
             if( status == WEBVTT_OUT_OF_MEMORY ) {
               ERROR( WEBVTT_ALLOCATION_FAILED );
             }
             goto _finish;
           }
-          if( WEBVTT_FAILED( status = webvtt_create_string_with_text( &tk,
-            self->token, self->token_pos ) ) ) {
-            if( status == WEBVTT_OUT_OF_MEMORY ) {
-              ERROR( WEBVTT_ALLOCATION_FAILED );
-            }
+          /**
+           * The token just read starts the line. If it is all in this chunk,
+           * read the line from its start; otherwise carry it over.
+           */
+          if( self->token_pos <= pos ) {
+            pos -= self->token_pos;
+          } else if( WEBVTT_FAILED( status = webvtt_string_append(
+                                      &self->line_buffer, self->token,
+                                      self->token_pos ) ) ) {
+            ERROR( WEBVTT_ALLOCATION_FAILED );
             webvtt_release_cue( &cue );
             goto _finish;
           }
           PUSH0( T_CUE, cue, V_CUE );
-          PUSH0( T_CUEREAD, 0, V_TEXT );
-          SP->v.text.d = tk.d;
+          PUSH0( T_CUEREAD, 0, V_NONE );
         }
         break;
 
@@ -792,14 +1132,14 @@ _recheck:
          */
         cue = SP->v.cue;
         st = FRAMEUP( 1 );
-        text.d = st->v.text.d;
+        text = st->v.text;
 
         st->type = V_NONE;
         st->v.cue = NULL;
 
         /* FIXME: guard inconsistent state */
         if (!cue) {
-          ERROR( WEBVTT_PARSE_ERROR );
+          ERROR( WEBVTT_ALLOCATION_FAILED );
           status = WEBVTT_PARSE_ERROR;
           goto _finish;
         }
@@ -829,6 +1169,43 @@ _finish:
   return status;
 }
 
+/**
+ * Add a line to the text of a block (a cue's body, or the text of a STYLE
+ * block), with a newline 'before' and/or 'after' it. Text beyond
+ * max_body_bytes is dropped, cut on a character boundary.
+ */
+static webvtt_status
+append_text( webvtt_parser self, webvtt_string *text, const char *line,
+             webvtt_uint length, webvtt_bool before, webvtt_bool after )
+{
+  webvtt_uint max = self->limits.max_body_bytes;
+  webvtt_uint used = webvtt_string_length( text );
+  if( self->body_cut ) {
+    return WEBVTT_SUCCESS;
+  }
+  if( max && used + before + length + after > max ) {
+    webvtt_uint room = used + before < max ? max - used - before : 0;
+    if( length > room ) {
+      length = room;
+      while( length && ( line[ length ] & 0xC0 ) == 0x80 ) {
+        --length;
+      }
+    }
+    if( !length ) {
+      before = 0;
+    }
+    after = 0;
+    WARNING_AT( WEBVTT_CUE_TEXT_TOO_LONG, self->line - 1, length + 1 );
+    self->body_cut = 1;
+  }
+  if( ( before && WEBVTT_FAILED( webvtt_string_putc( text, '\n' ) ) )
+      || WEBVTT_FAILED( webvtt_string_append( text, line, length ) )
+      || ( after && WEBVTT_FAILED( webvtt_string_putc( text, '\n' ) ) ) ) {
+    return WEBVTT_OUT_OF_MEMORY;
+  }
+  return WEBVTT_SUCCESS;
+}
+
 WEBVTT_INTERN webvtt_status
 webvtt_read_cuetext( webvtt_parser self, const char *b,
                      webvtt_uint *ppos, webvtt_uint len, webvtt_bool finish )
@@ -836,93 +1213,121 @@ webvtt_read_cuetext( webvtt_parser self, const char *b,
   webvtt_status status = WEBVTT_SUCCESS;
   webvtt_uint pos = *ppos;
   int finished = 0;
-  int flags = 0;
   webvtt_cue *cue;
 
   /* Ensure that we have a cue to work with */
   SAFE_ASSERT( self->top->type = V_CUE );
   cue = self->top->v.cue;
 
-  /**
-   * Hack to support lines spanning multiple buffers.
-   *
-   * TODO: Do this some better way. This is not good!
-   */
-  if( self->line_buffer.d != 0 && self->line_buffer.d->text[
-      self->line_buffer.d->length - 1 ] == '\n' ) {
-    flags = 1;
-  }
-
   do {
-    if( !flags ) {
-      int v;
-      if( ( v = webvtt_string_getline( &self->line_buffer, b, &pos, len,
-                                       &self->truncate, finish ) ) ) {
-        if( v < 0 || WEBVTT_FAILED( webvtt_string_putc( &self->line_buffer,
-                                                        '\n' ) ) ) {
-          ERROR( WEBVTT_ALLOCATION_FAILED );
-          status = WEBVTT_OUT_OF_MEMORY;
-          goto _finish;
-        }
-        /* replace '\0' with u+fffd */
-        if( WEBVTT_FAILED( status =
-                           webvtt_string_replace_all( &self->line_buffer,
-                                                      "\0", 1, replacement,
-                                                      3 ) ) ) {
-          ERROR( WEBVTT_ALLOCATION_FAILED );
-          goto _finish;
-        }
+    const char *line;
+    webvtt_uint length;
+    webvtt_token token;
+    if( self->tstate == L_NEWLINE0 ) {
+      /**
+       * The last chunk ended with the CR after this line, which was kept in
+       * line_buffer until we know whether an LF follows.
+       */
+      line = webvtt_string_text( &self->line_buffer );
+      length = webvtt_string_length( &self->line_buffer );
+    } else {
+      int v = read_line( self, b, &pos, len, finish, &line, &length );
+      if( v < 0 ) {
+        ERROR( WEBVTT_ALLOCATION_FAILED );
+        status = WEBVTT_OUT_OF_MEMORY;
+        goto _finish;
+      } else if( !v ) {
+        break;
+      }
+    }
 
-        flags = 1;
+    token = webvtt_lex_newline( self, b, &pos, len, finish );
+    if( token != NEWLINE ) {
+      if( !webvtt_string_length( &self->line_buffer ) &&
+          WEBVTT_FAILED( webvtt_string_append( &self->line_buffer, line,
+                                               length ) ) ) {
+        ERROR( WEBVTT_ALLOCATION_FAILED );
+        status = WEBVTT_OUT_OF_MEMORY;
       }
+      break;
     }
-    if( flags ) {
-      webvtt_token token = webvtt_lex_newline( self, b, &pos, len, finish );
-      if( token == NEWLINE ) {
-        self->token_pos = 0;
-        self->line++;
+    self->token_pos = 0;
+    self->line++;
 
-        /* Remove the '\n' that we appended to determine that we're in state 1
-         */
-        self->line_buffer.d->text[ --self->line_buffer.d->length ] = 0;
-        /**
-         * We've encountered a line without any cuetext on it, i.e. there is no
-         * newline character and len is 0 or there is and len is 1, therefore,
-         * the cue text is finished.
-         */
-        if( self->line_buffer.d->length == 0 ) {
-          webvtt_release_string( &self->line_buffer );
-          finished = 1;
-        } else if( find_bytes( webvtt_string_text( &self->line_buffer ),
-                   webvtt_string_length( &self->line_buffer ), separator,
-                   sizeof( separator ) ) == WEBVTT_SUCCESS ) {
-          /**
-           * Line contains cue-times separator, and thus we treat it as a
-           * separate cue. Trick program into thinking that T_CUEREAD had read
-           * this line.
-           */
-          do_push( self, 0, 0, T_CUEREAD, 0, V_NONE, self->line, self->column );
-          webvtt_copy_string( &SP->v.text, &self->line_buffer );
-          webvtt_release_string( &self->line_buffer );
-          SP->type = V_TEXT;
-          POP();
-          finished = 1;
-        } else {
-          /**
-           * If it's not the end of a cue, simply append it to the cue's payload
-           * text.
-           */
-          if( webvtt_string_length( &cue->body ) &&
-              WEBVTT_FAILED( webvtt_string_putc( &cue->body, '\n' ) ) ) {
-            status = WEBVTT_OUT_OF_MEMORY;
-            goto _finish;
-          }
-          webvtt_string_append_string( &cue->body, &self->line_buffer );
-          webvtt_release_string( &self->line_buffer );
-          flags = 0;
-        }
+    /**
+     * We've encountered a line without any cuetext on it, i.e. there is no
+     * newline character and len is 0 or there is and len is 1, therefore,
+     * the cue text is finished.
+     */
+    if( length == 0 ) {
+      finished = 1;
+    } else if( ( self->mode == M_REGION || self->mode == M_STYLE )
+               && self->line - 1 == self->block_line + 1
+               && find_bytes( line, length, separator,
+                              sizeof( separator ) ) == WEBVTT_SUCCESS ) {
+      /**
+       * Cue timings right after the header: the block is a cue, and its
+       * header line (already in cue->id) is the cue's id. No settings have
+       * been read into the region, so finishing it only releases it; no
+       * style text has been collected yet.
+       */
+      webvtt_string timings;
+      if( self->mode == M_REGION ) {
+        webvtt_finish_region( self );
+      }
+      webvtt_init_string( &timings );
+      if( WEBVTT_FAILED( status = take_line( self, &timings, line,
+                                             length ) ) ) {
+        ERROR( WEBVTT_ALLOCATION_FAILED );
+        goto _finish;
+      }
+      cue->flags |= CUE_HAVE_ID;
+      self->mode = M_WEBVTT;
+      --self->line;
+      status = webvtt_proc_cueline( self, cue, &timings );
+      ++self->line;
+      if( WEBVTT_FAILED( status ) ) {
+        webvtt_release_string( &timings );
+        goto _finish;
+      }
+    } else if( find_bytes( line, length, separator,
+                           sizeof( separator ) ) == WEBVTT_SUCCESS ) {
+      /**
+       * Line contains cue-times separator, and thus we treat it as a
+       * separate cue. Trick program into thinking that T_CUEREAD had read
+       * this line.
+       */
+      if( WEBVTT_FAILED( status = do_push( self, 0, 0, T_CUEREAD, 0, V_NONE,
+                                           self->line, self->column ) ) ) {
+        goto _finish;
+      }
+      if( WEBVTT_FAILED( status = take_line( self, &SP->v.text, line,
+                                             length ) ) ) {
+        ERROR( WEBVTT_ALLOCATION_FAILED );
+        goto _finish;
+      }
+      SP->type = V_TEXT;
+      POP();
+      finished = 1;
+    } else if( self->mode == M_REGION ) {
+      webvtt_region_parse_settings( self, self->line - 1, line, length );
+    } else if( self->mode == M_STYLE ) {
+      if( WEBVTT_FAILED( status = append_text( self, &self->style_text, line,
+                                               length, 0, 1 ) ) ) {
+        goto _finish;
+      }
+    } else if( !self->validate && self->mode != M_SKIP_CUE ) {
+      /**
+       * If it's not the end of a cue, simply append it to the cue's payload
+       * text.
+       */
+      if( WEBVTT_FAILED( status = append_text(
+                           self, &cue->body, line, length,
+                           webvtt_string_length( &cue->body ) != 0, 0 ) ) ) {
+        goto _finish;
       }
     }
+    webvtt_string_clear( &self->line_buffer );
   } while( pos < len && !finished );
 _finish:
   *ppos = pos;
@@ -946,26 +1351,48 @@ webvtt_proc_cuetext( webvtt_parser self, const char *b,
 {
   webvtt_status status;
   webvtt_cue *cue;
-  SAFE_ASSERT( ( self->mode == M_CUETEXT || self->mode == M_SKIP_CUE )
+  SAFE_ASSERT( ( self->mode == M_CUETEXT || self->mode == M_SKIP_CUE
+                 || self->mode == M_REGION || self->mode == M_STYLE )
                && self->top->type == V_CUE );
   cue = self->top->v.cue;
   SAFE_ASSERT( cue != 0 );
-  status  = webvtt_read_cuetext( self, b, ppos, len, finish );
+  PROFILE_PHASE( WEBVTT_PHASE_READ_CUETEXT,
+                 status = webvtt_read_cuetext( self, b, ppos, len, finish ) );
 
   if( status == WEBVTT_SUCCESS ) {
-    if( self->mode != M_SKIP_CUE ) {
+    if( self->mode == M_REGION ) {
+      /* The block held a region, not a cue */
+      webvtt_finish_region( self );
+      webvtt_release_cue( &cue );
+    } else if( self->mode == M_STYLE ) {
+      /* The block held style rules, not a cue */
+      status = webvtt_compile_style( self );
+      webvtt_string_clear( &self->style_text );
+      webvtt_release_cue( &cue );
+    } else if( self->mode != M_SKIP_CUE && !self->validate ) {
       /**
        * Once we've successfully read the cuetext into line_buffer, call the
        * cuetext parser from cuetext.c
        */
-      status = webvtt_parse_cuetext( self, cue, &cue->body,
-                                     self->finished );
+      PROFILE_PHASE( WEBVTT_PHASE_PARSE_CUETEXT,
+                     status = webvtt_parse_cuetext( self, cue, &cue->body,
+                                                    self->finished ) );
+      if( self->styles.nrules
+          && WEBVTT_FAILED( webvtt_resolve_styles( self, cue->node_head ) ) ) {
+        /* The cue is still returned, with some nodes unstyled */
+        WARNING_AT( WEBVTT_ALLOCATION_FAILED, self->line, 1 );
+      }
 
       /**
        * return the cue to the user, if possible.
        */
       finish_cue( self, &cue );
     } else {
+      if( self->mode == M_SKIP_CUE ) {
+        PROFILE_COUNT( cues_dropped );
+      } else if( self->validate ) {
+        PROFILE_COUNT( cues_emitted );
+      }
       webvtt_release_cue( &cue );
     }
 
@@ -982,7 +1409,7 @@ webvtt_proc_cuetext( webvtt_parser self, const char *b,
        * If we found '-->', we need to create another cue and remain
        * in T_CUE state
        */
-      webvtt_create_cue( &self->top->v.cue );
+      new_cue( self, &self->top->v.cue );
       self->top->type = V_CUE;
       self->top->state = T_CUE;
     }
@@ -991,18 +1418,228 @@ webvtt_proc_cuetext( webvtt_parser self, const char *b,
   return status;
 }
 
+WEBVTT_EXPORT webvtt_status
+webvtt_collect_errors( webvtt_parser self, webvtt_uint capacity )
+{
+  webvtt_error_info *errors = 0;
+  if( !self ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  if( capacity ) {
+    webvtt_alloc_stats *previous =
+      webvtt_enter_alloc_stats( self->alloc_stats );
+    errors = ( webvtt_error_info * )webvtt_alloc( capacity * sizeof * errors );
+    webvtt_leave_alloc_stats( previous );
+    if( !errors ) {
+      return WEBVTT_OUT_OF_MEMORY;
+    }
+  }
+  webvtt_free( self->errors );
+  self->errors = errors;
+  self->error_capacity = capacity;
+  self->error_head = self->error_count = 0;
+  return WEBVTT_SUCCESS;
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_suppress_error( webvtt_parser self, webvtt_error error,
+                       webvtt_bool suppress )
+{
+  if( !self || (webvtt_uint)error >= MAX_ERROR_CODES ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  if( suppress ) {
+    self->suppressed |= ERROR_BIT( error );
+  } else {
+    self->suppressed &= ~ERROR_BIT( error );
+  }
+  return WEBVTT_SUCCESS;
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_set_limits( webvtt_parser self, const webvtt_limits *limits )
+{
+  if( !self || !limits ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  self->limits = *limits;
+  return WEBVTT_SUCCESS;
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_get_limits( webvtt_parser self, webvtt_limits *out )
+{
+  if( !self || !out ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  *out = self->limits;
+  return WEBVTT_SUCCESS;
+}
+
+WEBVTT_INTERN void
+webvtt_collect_error( webvtt_parser self, webvtt_uint line, webvtt_uint column,
+                      webvtt_error error )
+{
+  webvtt_error_info *info;
+  if( self->error_count == self->error_capacity ) {
+    ++self->dropped_errors;
+    return;
+  }
+  info = self->errors + ( self->error_head + self->error_count )
+                        % self->error_capacity;
+  info->line = line;
+  info->column = column;
+  info->error = error;
+  ++self->error_count;
+}
+
+WEBVTT_EXPORT webvtt_uint
+webvtt_drain_errors( webvtt_parser self, webvtt_error_info *out,
+                     webvtt_uint max )
+{
+  webvtt_uint n, i;
+  if( !self || !out ) {
+    return 0;
+  }
+  n = self->error_count < max ? self->error_count : max;
+  for( i = 0; i < n; ++i ) {
+    out[ i ] = self->errors[ self->error_head ];
+    if( ++self->error_head == self->error_capacity ) {
+      self->error_head = 0;
+    }
+  }
+  self->error_count -= n;
+  return n;
+}
+
+WEBVTT_EXPORT webvtt_uint
+webvtt_error_count( webvtt_parser self, webvtt_error error )
+{
+  if( !self || (webvtt_uint)error >= MAX_ERROR_CODES ) {
+    return 0;
+  }
+  return self->error_counts[ error ];
+}
+
+WEBVTT_EXPORT webvtt_uint
+webvtt_dropped_errors( webvtt_parser self )
+{
+  return self ? self->dropped_errors : 0;
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_get_parser_stats( webvtt_parser self, webvtt_parser_stats *out )
+{
+  if( !self || !out ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  webvtt_get_alloc_stats( self->alloc_stats, out );
+  return self->alloc_stats ? WEBVTT_SUCCESS : WEBVTT_NOT_SUPPORTED;
+}
+
 WEBVTT_EXPORT webvtt_status
 webvtt_parse_chunk( webvtt_parser self, const void *buffer, webvtt_uint len )
 {
+  webvtt_alloc_stats *previous;
   webvtt_status status;
-  webvtt_uint pos = 0;
+  webvtt_uint64 max = self->limits.max_total_bytes;
+  webvtt_bool cut = 0;
+
+  if( self->input_cut ) {
+    return WEBVTT_PARSE_ERROR;
+  }
+  if( max && self->input_bytes + len > max ) {
+    /* Parse up to the limit, then finish; ignore any input after that */
+    len = (webvtt_uint)( max - self->input_bytes );
+    cut = self->input_cut = 1;
+  }
+  self->input_bytes += len;
+
+  previous = webvtt_enter_alloc_stats( self->alloc_stats );
+  PROFILE_ADD( bytes, len );
+  if( self->utf8_mode != WEBVTT_UTF8_TRUST ) {
+    status = webvtt_parse_utf8( self, ( const char * )buffer, len );
+  } else {
+    status = webvtt_parse_input( self, ( const char * )buffer, len );
+  }
+  if( cut ) {
+    WARNING_AT( WEBVTT_INPUT_TOO_LONG, self->line, self->column );
+    finish_parsing( self );
+    status = WEBVTT_PARSE_ERROR;
+  }
+  webvtt_leave_alloc_stats( previous );
+  return status;
+}
+
+/**
+ * How much of the 'len' bytes at 'b' to parse within a budget of 'max' bytes
+ * (0 for all of them): up to the last line break within the budget, or the
+ * whole budget if there is none. A CR followed by an LF only ends a line with
+ * the LF.
+ */
+static webvtt_uint
+budget_end( const char *b, webvtt_uint len, webvtt_uint max )
+{
+  webvtt_uint end;
+  if( !max || max >= len ) {
+    return len;
+  }
+  for( end = max; end > 0; --end ) {
+    if( b[ end - 1 ] == '\n'
+        || ( b[ end - 1 ] == '\r' && b[ end ] != '\n' ) ) {
+      return end;
+    }
+  }
+  return max;
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_parse_chunk_budget( webvtt_parser self, const void *buffer,
+                           webvtt_uint len, const webvtt_parse_budget *budget,
+                           webvtt_uint *consumed )
+{
   const char *b = ( const char * )buffer;
+  webvtt_status status = WEBVTT_SUCCESS;
+  webvtt_uint pos = 0, end;
+  webvtt_uint64 start = 0;
+
+  if( !self || !budget || !consumed || ( len && !buffer ) ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  if( budget->max_nanoseconds ) {
+    start = webvtt_profile_clock();
+  }
+
+  end = budget_end( b, len, budget->max_bytes );
+  while( pos < end ) {
+    webvtt_uint n = end - pos;
+    if( budget->max_nanoseconds && n > BUDGET_SLICE ) {
+      n = budget_end( b + pos, len - pos, BUDGET_SLICE );
+    }
+    status = webvtt_parse_chunk( self, b + pos, n );
+    pos += n;
+    if( WEBVTT_FAILED( status ) || ( budget->max_nanoseconds &&
+        webvtt_profile_clock() - start >= budget->max_nanoseconds ) ) {
+      break;
+    }
+  }
+  *consumed = pos;
+  return status;
+}
+
+WEBVTT_INTERN webvtt_status
+webvtt_parse_input( webvtt_parser self, const char *b, webvtt_uint len )
+{
+  webvtt_status status;
+  webvtt_uint pos = 0;
 
   while( pos < len ) {
     switch( self->mode ) {
       case M_WEBVTT:
-        if( WEBVTT_FAILED( status = parse_webvtt( self, b, &pos, len,
-                                                  self->finished ) ) ) {
+        PROFILE_PHASE( WEBVTT_PHASE_PARSE,
+                       status = parse_webvtt( self, b, &pos, len,
+                                              self->finished ) );
+        if( WEBVTT_FAILED( status ) ) {
           return status;
         }
         break;
@@ -1027,8 +1664,13 @@ webvtt_parse_chunk( webvtt_parser self, const void *buffer, webvtt_uint len )
         break;
 
       case M_SKIP_CUE:
+      case M_REGION:
+      case M_STYLE:
         if( WEBVTT_FAILED( status = webvtt_proc_cuetext( self, b, &pos, len,
                                                          self->finished ) ) ) {
+          if( status == WEBVTT_UNFINISHED ) {
+            return WEBVTT_SUCCESS;
+          }
           return status;
         }
         break;
@@ -1217,6 +1859,126 @@ not_timestamp:
   return 0;
 }
 
+/**
+ * The fast path below reads timestamps a word at a time, and relies on the
+ * first byte of the input being the low byte of the word.
+ */
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+# if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#   define TIMESTAMP_FAST_PATH 1
+# endif
+#elif defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM) \
+   || defined(_M_ARM64)
+# define TIMESTAMP_FAST_PATH 1
+#endif
+
+#if defined(TIMESTAMP_FAST_PATH)
+# define BYTES_64(x) ( (webvtt_uint64)(x) * 0x0101010101010101ULL )
+
+/**
+ * Check that each byte of 'w' selected by 'digits' is an ASCII digit, and that
+ * the remaining bytes equal those of 'separators'. If so, return the digits'
+ * values (and zeros in place of the separators), otherwise return all ones.
+ */
+static webvtt_uint64
+swar_digits( webvtt_uint64 w, webvtt_uint64 digits, webvtt_uint64 separators )
+{
+  /* Put '0' in place of each separator, so that all bytes should be digits */
+  webvtt_uint64 d = ( w & digits ) | ( BYTES_64( '0' ) & ~digits );
+  if( ( w & ~digits ) != separators
+      || ( d & BYTES_64( 0xF0 ) ) != BYTES_64( 0x30 )
+      || ( ( d + BYTES_64( 0x06 ) ) & BYTES_64( 0xF0 ) ) != BYTES_64( 0x30 ) ) {
+    return ~(webvtt_uint64)0;
+  }
+  return d - BYTES_64( '0' );
+}
+
+/**
+ * Turn each pair of digit values in bytes i, i+1 into a two-digit number in
+ * byte i
+ */
+#define SWAR_PAIRS(d) ( (d) * 10 + ( (d) >> 8 ) )
+#define BYTE_AT(w, i) ( (webvtt_uint)( ( (w) >> ( (i) * 8 ) ) & 0xFF ) )
+#endif
+
+/**
+ * webvtt_parse_timestamp_n
+ *
+ * Like webvtt_parse_timestamp, but 'len' gives the number of bytes available
+ * at 'b', which allows well-formed timestamps in the common HH:MM:SS.mmm and
+ * MM:SS.mmm shapes to be parsed a word at a time. Anything else is left to
+ * webvtt_parse_timestamp, so 'b' must still be NUL-terminated at or after
+ * 'len' bytes.
+ */
+WEBVTT_INTERN int
+webvtt_parse_timestamp_n( const char *b, webvtt_uint len, int *tokenLength,
+                          webvtt_timestamp *result )
+{
+#if defined(TIMESTAMP_FAST_PATH)
+  /* ':' at byte 2, and ':' (long form) or '.' (short form) at byte 5 */
+  static const webvtt_uint64 digit_mask = 0xFFFF00FFFF00FFFFULL;
+  static const webvtt_uint64 long_separators = 0x00003A00003A0000ULL;
+  static const webvtt_uint64 short_separators = 0x00002E00003A0000ULL;
+  if( len >= 9 ) {
+    webvtt_uint64 w, d, pairs;
+    webvtt_uint ms;
+    memcpy( &w, b, sizeof( w ) );
+    if( b[ 5 ] == ':' ) {
+      /* HH:MM:SS followed by .mmm */
+      webvtt_uint32 f;
+      webvtt_uint64 frac;
+      if( len < 12
+          || ( d = swar_digits( w, digit_mask, long_separators ) )
+             == ~(webvtt_uint64)0
+          || ( len > 12 && webvtt_isdigit( b[ 12 ] ) ) ) {
+        goto slow_path;
+      }
+      /* '.' and three digits, padded with '0's */
+      memcpy( &f, b + 8, sizeof( f ) );
+      if( ( frac = swar_digits( f | 0x3030303000000000ULL,
+                                0xFFFFFFFFFFFFFF00ULL, '.' ) )
+          == ~(webvtt_uint64)0 ) {
+        goto slow_path;
+      }
+      pairs = SWAR_PAIRS( d );
+      if( BYTE_AT( pairs, 3 ) > 59 || BYTE_AT( pairs, 6 ) > 59 ) {
+        goto slow_path;
+      }
+      ms = BYTE_AT( frac, 1 ) * 100 + BYTE_AT( frac, 2 ) * 10
+           + BYTE_AT( frac, 3 );
+      *result = ( webvtt_timestamp )BYTE_AT( pairs, 0 ) * MSECS_PER_HOUR
+                + BYTE_AT( pairs, 3 ) * MSECS_PER_MINUTE
+                + BYTE_AT( pairs, 6 ) * MSECS_PER_SECOND + ms;
+      if( tokenLength ) {
+        *tokenLength = 12;
+      }
+      return 1;
+    } else {
+      /* MM:SS.mm followed by the last digit of the milliseconds */
+      if( ( d = swar_digits( w, digit_mask, short_separators ) )
+          == ~(webvtt_uint64)0
+          || !webvtt_isdigit( b[ 8 ] )
+          || ( len > 9 && webvtt_isdigit( b[ 9 ] ) ) ) {
+        goto slow_path;
+      }
+      pairs = SWAR_PAIRS( d );
+      if( BYTE_AT( pairs, 0 ) > 59 || BYTE_AT( pairs, 3 ) > 59 ) {
+        goto slow_path;
+      }
+      ms = BYTE_AT( pairs, 6 ) * 10 + ( b[ 8 ] - '0' );
+      *result = ( webvtt_timestamp )BYTE_AT( pairs, 0 ) * MSECS_PER_MINUTE
+                + BYTE_AT( pairs, 3 ) * MSECS_PER_SECOND + ms;
+      if( tokenLength ) {
+        *tokenLength = 9;
+      }
+      return 1;
+    }
+  }
+slow_path:
+#endif
+  return webvtt_parse_timestamp( b, tokenLength, result );
+}
+
 WEBVTT_INTERN webvtt_bool
 token_in_list( webvtt_token token, const webvtt_token list[] )
 {
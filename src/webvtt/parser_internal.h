@@ -29,6 +29,9 @@
 # define __INTERN_PARSER_H__
 # include <webvtt/parser.h>
 # include "string_internal.h"
+# include "style_internal.h"
+# include "alloc_internal.h"
+# include "profile_internal.h"
 # ifndef NDEBUG
 #   define NDEBUG
 # endif
@@ -42,6 +45,18 @@ static void break_on_assert();
 #   endif
 # endif
 
+/**
+ * Error codes are counted (and suppressed) with one slot (or bit) per code
+ */
+#define MAX_ERROR_CODES (64)
+
+/**
+ * The state machine needs only a few stack frames. A stack this deep means
+ * something has gone wrong: it is not grown any further, and parsing stops
+ * with WEBVTT_STATE_TOO_DEEP.
+ */
+#define MAX_STACK_FRAMES (0x100)
+
 typedef enum
 webvtt_token_t {
   BADTOKEN = -2,
@@ -69,6 +84,8 @@ webvtt_parse_mode_t {
   M_WEBVTT = 0,
   M_CUETEXT,
   M_SKIP_CUE,
+  M_REGION, /* Read the settings of a REGION block */
+  M_STYLE, /* Collect the rules of a STYLE block */
 } webvtt_parse_mode;
 
 
@@ -187,18 +204,112 @@ webvtt_parser_t {
   webvtt_parse_mode mode;
 
   webvtt_state *top; /* Top parse state */
-  webvtt_state astack[0x100];
+  webvtt_state astack[0x10];
   webvtt_state *stack; /* dynamically allocated stack, if 'astack' fills up */
   webvtt_uint stack_alloc; /* item capacity in 'stack' */
   webvtt_bool popped;
 
   /**
-   * line (cue payload also stored here)
+   * The start of a line which runs past the end of the last chunk (see
+   * read_line in parser.c). Lines which end in the chunk they start in are
+   * read straight from the caller's buffer.
    */
-  int truncate;
   webvtt_uint line_pos;
   webvtt_string line_buffer;
 
+  /**
+   * A spare line for T_CUEREAD, reused from cue to cue (NULL when it is in
+   * use)
+   */
+  webvtt_string spare_line;
+
+  /**
+   * validation-only mode (see webvtt_create_validator). 'scratch_cue' stands
+   * in for every cue, and only the start time of the previous cue is kept, for
+   * the ordering check.
+   */
+  webvtt_bool validate;
+  webvtt_cue scratch_cue;
+  webvtt_timestamp last_start;
+
+  /**
+   * regions defined in the header (see webvtt_get_region), each holding a
+   * reference, and whether the header has ended, ie. a cue has been seen.
+   * While a REGION block is read, the region is built in 'new_region'.
+   * 'block_line' is the line of a REGION or STYLE block's header, which
+   * becomes the id of a cue if the next line holds cue timings.
+   */
+  webvtt_region **regions;
+  webvtt_uint region_count;
+  webvtt_uint region_alloc;
+  webvtt_region *new_region;
+  webvtt_bool seen_cue;
+  webvtt_uint block_line;
+
+  /**
+   * style sheet compiled from STYLE blocks in the header (see
+   * webvtt_get_node_style). While a STYLE block is read, its text is collected in
+   * 'style_text', and 'style_line' is the line it starts on.
+   */
+  webvtt_style_sheet styles;
+  webvtt_string style_text;
+  webvtt_uint style_line;
+
+  /**
+   * error collection (see webvtt_collect_errors). 'errors' is a ring of
+   * 'error_capacity' entries, of which 'error_count' starting at 'error_head'
+   * are in use. 'error_counts' and 'suppressed' are indexed by error code.
+   */
+  webvtt_error_info *errors;
+  webvtt_uint error_capacity;
+  webvtt_uint error_head;
+  webvtt_uint error_count;
+  webvtt_uint dropped_errors;
+  webvtt_uint64 suppressed;
+  webvtt_uint error_counts[MAX_ERROR_CODES];
+
+  /**
+   * UTF-8 checking (see webvtt_set_utf8_mode). 'utf8_carry' holds the start
+   * of a sequence cut off at the end of a chunk, which is kept from the parser
+   * until the rest of it arrives. 'utf8_line' and 'utf8_column' are the
+   * position of the next byte of input, and 'utf8_cr' is set if the byte
+   * before it was '\r'.
+   */
+  webvtt_utf8_mode utf8_mode;
+  char utf8_carry[4];
+  webvtt_uint utf8_carry_len;
+  webvtt_uint utf8_line;
+  webvtt_uint utf8_column;
+  webvtt_bool utf8_cr;
+
+  /**
+   * limits on the input (see webvtt_set_limits). 'block_count' is the number
+   * of blocks begun and 'input_bytes' the bytes of input taken; 'input_cut'
+   * is set once the input has been cut off at max_total_bytes. 'line_cut'
+   * and 'body_cut' are set once the current line, or the text of the current
+   * block, has been cut short.
+   */
+  webvtt_limits limits;
+  webvtt_uint block_count;
+  webvtt_uint64 input_bytes;
+  webvtt_bool input_cut;
+  webvtt_bool line_cut;
+  webvtt_bool body_cut;
+
+  /**
+   * memory allocated on behalf of this parser (see webvtt_get_parser_stats),
+   * or 0 if allocation stats are off. Public entry points that allocate make
+   * it current while they run.
+   */
+  webvtt_alloc_stats *alloc_stats;
+
+#if WEBVTT_PROFILING
+  /**
+   * phase timing and counts (see webvtt_set_profiling)
+   */
+  webvtt_profiler profiler;
+#endif
+
   /**
    * tokenizer
    */
@@ -248,6 +359,10 @@ WEBVTT_INTERN int
 webvtt_parse_timestamp( const char *b, int *tokenLength,
                         webvtt_timestamp *result );
 
+WEBVTT_INTERN int
+webvtt_parse_timestamp_n( const char *b, webvtt_uint len, int *tokenLength,
+                          webvtt_timestamp *result );
+
 WEBVTT_INTERN webvtt_status
 do_push( webvtt_parser self, webvtt_uint token, webvtt_uint back,
          webvtt_uint state, void *data, webvtt_state_value_type type,
@@ -319,6 +434,18 @@ find_token( webvtt_token search_for, const webvtt_token token_list[] );
 WEBVTT_INTERN webvtt_int64
 webvtt_parse_int( const char **pb, int *pdigits );
 
+/**
+ * Parse a chunk of input which has already been through the UTF-8 check, if
+ * any (this is webvtt_parse_chunk without it)
+ */
+WEBVTT_INTERN webvtt_status
+webvtt_parse_input( webvtt_parser self, const char *buffer, webvtt_uint len );
+
+/* Append an error to the collection buffer, or count it as dropped */
+WEBVTT_INTERN void
+webvtt_collect_error( webvtt_parser self, webvtt_uint line, webvtt_uint column,
+                      webvtt_error error );
+
 #define BAD_TIMESTAMP(ts) ( ( ts ) == 0xFFFFFFFFFFFFFFFF )
 
 #ifdef FATAL_ASSERTION
@@ -355,7 +482,12 @@ if( !(condition) ) { \
 #  endif
 #endif
 
-#define __ERROR_AT_OR(errno, line, column, __or) \
+#define ERROR_BIT(errno) ( (webvtt_uint64)1 << (errno) )
+
+/**
+ * Report an error to the application, running '__or' if it wants to abort.
+ */
+#define REPORT_ERROR_AT_OR(errno, line, column, __or) \
 do \
 { \
   if( !self->error \
@@ -364,6 +496,27 @@ do \
   } \
 } while(0)
 
+/**
+ * Count the error, then (unless it is suppressed) either collect it or report
+ * it to the application, running '__or' if the application wants to abort.
+ * Codes past MAX_ERROR_CODES are neither counted nor suppressible.
+ */
+#define __ERROR_AT_OR(errno, line, column, __or) \
+do \
+{ \
+  webvtt_error __err = (errno); \
+  webvtt_bool __known = (webvtt_uint)__err < MAX_ERROR_CODES; \
+  if( __known ) { \
+    ++self->error_counts[ __err ]; \
+  } \
+  if( __known && ( self->suppressed & ERROR_BIT( __err ) ) ) { \
+  } else if( self->error_capacity ) { \
+    webvtt_collect_error( self, (line), (column), __err ); \
+  } else { \
+    REPORT_ERROR_AT_OR( __err, line, column, __or ); \
+  } \
+} while(0)
+
 #define ERROR_AT_OR(errno, line, column, ret) \
   __ERROR_AT_OR(errno,line,column,return (ret);)
 
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "parser_internal.h"
+#include <string.h>
+#if defined(_WIN32)
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+
+static const char *const state_names[] = {
+  "T_INITIAL",
+  "T_TAG",
+  "T_TAGCOMMENT",
+  "T_EOL",
+  "T_BODY",
+  "T_CUEREAD",
+  "T_CUE",
+  "T_CUEID",
+  "T_CUEPARAMS",
+  "T_CUETEXT",
+  "T_TIMESTAMP",
+  "T_COMMENT",
+  "T_FROM",
+  "T_SEP_LEFT",
+  "T_SEP",
+  "T_SEP_RIGHT",
+  "T_UNTIL",
+  "T_PRECUESETTING",
+  "T_CUESETTING",
+  "T_CUESETTING_DELIMITER",
+  "T_CUESETTING_VALUE",
+  "T_SKIP_SETTING"
+};
+
+/* Every state has a name, and a place in webvtt_profile::transitions */
+typedef char check_state_names[ sizeof( state_names ) / sizeof( *state_names )
+                                == T_SKIP_SETTING + 1 ? 1 : -1 ];
+typedef char check_parse_states[ T_SKIP_SETTING < WEBVTT_PARSE_STATES
+                                 ? 1 : -1 ];
+
+WEBVTT_EXPORT const char *
+webvtt_parse_state_name( webvtt_uint state )
+{
+  if( state >= sizeof( state_names ) / sizeof( *state_names ) ) {
+    return 0;
+  }
+  return state_names[ state ];
+}
+
+WEBVTT_INTERN webvtt_uint64
+webvtt_profile_clock( void )
+{
+#if defined(_WIN32)
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER now;
+  if( !frequency.QuadPart ) {
+    QueryPerformanceFrequency( &frequency );
+  }
+  QueryPerformanceCounter( &now );
+  return ( webvtt_uint64 )( now.QuadPart / frequency.QuadPart ) * 1000000000u
+         + ( webvtt_uint64 )( now.QuadPart % frequency.QuadPart ) * 1000000000u
+           / frequency.QuadPart;
+#else
+  struct timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return ( webvtt_uint64 )now.tv_sec * 1000000000u + now.tv_nsec;
+#endif
+}
+
+#if WEBVTT_PROFILING
+WEBVTT_EXPORT webvtt_status
+webvtt_set_profiling( webvtt_parser self, webvtt_bool enable )
+{
+  if( !self ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  self->profiler.enabled = enable ? 1 : 0;
+  return WEBVTT_SUCCESS;
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_get_profile( webvtt_parser self, webvtt_profile *out )
+{
+  if( !self || !out ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  *out = self->profiler.counts;
+  out->lines = self->line - 1;
+  return WEBVTT_SUCCESS;
+}
+#else
+WEBVTT_EXPORT webvtt_status
+webvtt_set_profiling( webvtt_parser self, webvtt_bool enable )
+{
+  (void)enable;
+  return self ? WEBVTT_NOT_SUPPORTED : WEBVTT_INVALID_PARAM;
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_get_profile( webvtt_parser self, webvtt_profile *out )
+{
+  if( !self || !out ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  memset( out, 0, sizeof( *out ) );
+  return WEBVTT_NOT_SUPPORTED;
+}
+#endif
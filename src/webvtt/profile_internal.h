@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __INTERN_PROFILE_H__
+# define __INTERN_PROFILE_H__
+# include <webvtt/parser.h>
+
+# ifndef WEBVTT_PROFILING
+#   define WEBVTT_PROFILING 1
+# endif
+
+/**
+ * Monotonic time, in nanoseconds. Built with or without WEBVTT_PROFILING,
+ * as parse budgets need it too.
+ */
+WEBVTT_INTERN webvtt_uint64 webvtt_profile_clock( void );
+
+# if WEBVTT_PROFILING
+/**
+ * A parser's profile (see webvtt_set_profiling). The phase macros below
+ * expect it as 'self->profiler'.
+ */
+typedef struct
+webvtt_profiler_t {
+  webvtt_bool enabled;
+  webvtt_profile counts;
+} webvtt_profiler;
+
+static WEBVTT_INLINE webvtt_uint64
+webvtt_profile_begin( webvtt_profiler *p )
+{
+  return p->enabled ? webvtt_profile_clock() : 0;
+}
+
+static WEBVTT_INLINE void
+webvtt_profile_end( webvtt_profiler *p, webvtt_phase phase,
+                    webvtt_uint64 start )
+{
+  if( p->enabled ) {
+    p->counts.nanoseconds[ phase ] += webvtt_profile_clock() - start;
+  }
+  ++p->counts.calls[ phase ];
+}
+
+/**
+ * Run 'Statement' as 'Phase' of parsing
+ */
+#   define PROFILE_PHASE(Phase,Statement) do { \
+      webvtt_uint64 _start = webvtt_profile_begin( &self->profiler ); \
+      Statement; \
+      webvtt_profile_end( &self->profiler, Phase, _start ); \
+    } while( 0 )
+#   define PROFILE_ADD(Counter,N) ( self->profiler.counts.Counter += (N) )
+# else
+#   define PROFILE_PHASE(Phase,Statement) do { Statement; } while( 0 )
+#   define PROFILE_ADD(Counter,N) ( (void)0 )
+# endif
+
+# define PROFILE_COUNT(Counter) PROFILE_ADD(Counter,1)
+
+#endif
@@ -0,0 +1,317 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <string.h>
+#include "parser_internal.h"
+#include "cue_internal.h"
+#include "region_internal.h"
+
+#define REGION_TABLE_MIN (4)
+
+static const char arrow[] = "-->";
+
+WEBVTT_INTERN webvtt_bool
+webvtt_is_region_header( const char *text, webvtt_uint length )
+{
+  return length >= 6 && !memcmp( text, "REGION", 6 )
+         && ( length == 6 || webvtt_isspace( text[ 6 ] ) );
+}
+
+WEBVTT_INTERN webvtt_status
+webvtt_begin_region( webvtt_parser self )
+{
+  webvtt_region *region;
+  /* Make room in the table first, so that finishing the region cannot fail */
+  if( self->region_count == self->region_alloc ) {
+    webvtt_uint alloc = self->region_alloc ? self->region_alloc * 2
+                                           : REGION_TABLE_MIN;
+    webvtt_region **regions =
+      ( webvtt_region ** )webvtt_alloc( alloc * sizeof * regions );
+    if( !regions ) {
+      return WEBVTT_OUT_OF_MEMORY;
+    }
+    if( self->region_count ) {
+      memcpy( regions, self->regions,
+              self->region_count * sizeof * regions );
+    }
+    webvtt_free( self->regions );
+    self->regions = regions;
+    self->region_alloc = alloc;
+  }
+  if( !( region = ( webvtt_region * )webvtt_alloc0( sizeof * region ) ) ) {
+    return WEBVTT_OUT_OF_MEMORY;
+  }
+
+  /**
+   * Defaults from http://dev.w3.org/html5/webvtt/#webvtt-region
+   */
+  webvtt_ref( &region->refs );
+  webvtt_init_string( &region->id );
+  region->width = 100;
+  region->lines = 3;
+  region->region_anchor_x = 0;
+  region->region_anchor_y = 100;
+  region->viewport_anchor_x = 0;
+  region->viewport_anchor_y = 100;
+  region->scroll = WEBVTT_SCROLL_NONE;
+  self->new_region = region;
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Parse an anchor, "x%,y%"
+ */
+static int
+parse_anchor( const char *value, webvtt_uint len, webvtt_uint *x,
+              webvtt_uint *y )
+{
+  const char *comma = ( const char * )memchr( value, ',', len );
+  webvtt_int64 nx, ny;
+  if( !comma
+      || !webvtt_parse_percentage( value, ( webvtt_uint )( comma - value ),
+                                   &nx )
+      || !webvtt_parse_percentage( comma + 1,
+                                   ( webvtt_uint )( value + len - comma - 1 ),
+                                   &ny ) ) {
+    return 0;
+  }
+  *x = ( webvtt_uint )nx;
+  *y = ( webvtt_uint )ny;
+  return 1;
+}
+
+/**
+ * Set a region setting from 'word', "key:value". Returns 0 if the setting is
+ * not recognized or its value is malformed, and -1 if out of memory.
+ */
+static int
+set_region_setting( webvtt_region *region, const char *word, webvtt_uint len )
+{
+  const char *value = ( const char * )memchr( word, ':', len );
+  webvtt_uint key_len, value_len;
+  webvtt_int64 number;
+  if( !value || value == word || value + 1 == word + len ) {
+    return 0;
+  }
+  key_len = ( webvtt_uint )( value - word );
+  ++value;
+  value_len = ( webvtt_uint )( word + len - value );
+
+  switch( key_len ) {
+    case 2:
+      if( !memcmp( word, "id", 2 ) ) {
+        webvtt_uint i;
+        /* An id containing "-->" could not be told from cue timings */
+        for( i = 0; i + 3 <= value_len; ++i ) {
+          if( !memcmp( value + i, arrow, 3 ) ) {
+            return 0;
+          }
+        }
+        webvtt_release_string( &region->id );
+        if( WEBVTT_FAILED( webvtt_create_string_with_text( &region->id, value,
+                                                           value_len ) ) ) {
+          return -1;
+        }
+        return 1;
+      }
+      break;
+
+    case 5:
+      if( !memcmp( word, "width", 5 ) ) {
+        if( !webvtt_parse_percentage( value, value_len, &number ) ) {
+          return 0;
+        }
+        region->width = ( webvtt_uint )number;
+        return 1;
+      } else if( !memcmp( word, "lines", 5 ) ) {
+        webvtt_uint i, lines = 0;
+        /* A whole number of lines, without a sign */
+        if( value_len > 9 ) {
+          return 0;
+        }
+        for( i = 0; i < value_len; ++i ) {
+          if( !webvtt_isdigit( value[ i ] ) ) {
+            return 0;
+          }
+          lines = lines * 10 + ( value[ i ] - '0' );
+        }
+        region->lines = lines;
+        return 1;
+      }
+      break;
+
+    case 6:
+      if( !memcmp( word, "scroll", 6 ) ) {
+        if( value_len != 2 || memcmp( value, "up", 2 ) ) {
+          return 0;
+        }
+        region->scroll = WEBVTT_SCROLL_UP;
+        return 1;
+      }
+      break;
+
+    case 12:
+      if( !memcmp( word, "regionanchor", 12 ) ) {
+        return parse_anchor( value, value_len, &region->region_anchor_x,
+                             &region->region_anchor_y );
+      }
+      break;
+
+    case 14:
+      if( !memcmp( word, "viewportanchor", 14 ) ) {
+        return parse_anchor( value, value_len, &region->viewport_anchor_x,
+                             &region->viewport_anchor_y );
+      }
+      break;
+  }
+  return 0;
+}
+
+WEBVTT_INTERN void
+webvtt_region_parse_settings( webvtt_parser self, webvtt_uint line,
+                              const char *text, webvtt_uint length )
+{
+  webvtt_region *region = self->new_region;
+  const char *end = text + length;
+  const char *p = text;
+  int column = 1;
+
+  while( p < end && webvtt_isspace( *p ) ) {
+    ++p;
+    ++column;
+  }
+
+  while( p < end ) {
+    const char *word = p;
+    int nwhite = 0, ncol, v;
+    while( p < end && !webvtt_isspace( *p ) ) {
+      ++p;
+    }
+    ncol = webvtt_utf8_chcount( word, p );
+    if( ( v = set_region_setting( region, word,
+                                  ( webvtt_uint )( p - word ) ) ) <= 0 ) {
+      WARNING_AT( v < 0 ? WEBVTT_ALLOCATION_FAILED
+                        : WEBVTT_INVALID_REGION_SETTING, line, column );
+    }
+    while( p < end && webvtt_isspace( *p ) ) {
+      ++p;
+      ++nwhite;
+    }
+    column += ncol + nwhite;
+  }
+}
+
+WEBVTT_INTERN void
+webvtt_finish_region( webvtt_parser self )
+{
+  webvtt_region *region = self->new_region;
+  int index;
+  self->new_region = 0;
+  if( !region ) {
+    return;
+  } else if( webvtt_string_length( &region->id ) == 0 ) {
+    webvtt_release_region( ( const webvtt_region ** )&region );
+    return;
+  }
+
+  index = webvtt_find_region( self, webvtt_string_text( &region->id ),
+                              webvtt_string_length( &region->id ) );
+  if( index != WEBVTT_NO_REGION ) {
+    /**
+     * A later definition replaces an earlier one with the same id. No cue
+     * can hold the earlier one yet, as regions are only defined in the
+     * header.
+     */
+    webvtt_release_region( ( const webvtt_region ** )&self->regions[ index ] );
+    self->regions[ index ] = region;
+  } else {
+    self->regions[ self->region_count++ ] = region;
+  }
+}
+
+WEBVTT_INTERN int
+webvtt_find_region( webvtt_parser self, const char *id, webvtt_uint length )
+{
+  webvtt_uint i;
+  for( i = 0; i < self->region_count; ++i ) {
+    const webvtt_string *rid = &self->regions[ i ]->id;
+    if( webvtt_string_length( rid ) == length
+        && !memcmp( webvtt_string_text( rid ), id, length ) ) {
+      return ( int )i;
+    }
+  }
+  return WEBVTT_NO_REGION;
+}
+
+WEBVTT_INTERN void
+webvtt_clear_regions( webvtt_parser self )
+{
+  webvtt_uint i;
+  for( i = 0; i < self->region_count; ++i ) {
+    webvtt_release_region( ( const webvtt_region ** )&self->regions[ i ] );
+  }
+  /* A REGION block may have been being read */
+  webvtt_release_region( ( const webvtt_region ** )&self->new_region );
+  self->region_count = 0;
+}
+
+WEBVTT_EXPORT const webvtt_region *
+webvtt_get_region( webvtt_parser self, int index )
+{
+  if( !self || index < 0 || ( webvtt_uint )index >= self->region_count ) {
+    return 0;
+  }
+  return self->regions[ index ];
+}
+
+WEBVTT_EXPORT webvtt_uint
+webvtt_region_count( webvtt_parser self )
+{
+  return self ? self->region_count : 0;
+}
+
+WEBVTT_EXPORT void
+webvtt_ref_region( const webvtt_region *region )
+{
+  if( region ) {
+    webvtt_ref( &( ( webvtt_region * )region )->refs );
+  }
+}
+
+WEBVTT_EXPORT void
+webvtt_release_region( const webvtt_region **pregion )
+{
+  if( pregion && *pregion ) {
+    webvtt_region *region = ( webvtt_region * )*pregion;
+    *pregion = 0;
+    if( webvtt_deref( &region->refs ) == 0 ) {
+      webvtt_release_string( &region->id );
+      webvtt_free( region );
+    }
+  }
+}
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __INTERN_REGION_H__
+# define __INTERN_REGION_H__
+# include <webvtt/region.h>
+# include <webvtt/parser.h>
+
+/**
+ * Return non-zero if a line starts a REGION block: it is "REGION", possibly
+ * followed by whitespace and other text.
+ */
+WEBVTT_INTERN webvtt_bool
+webvtt_is_region_header( const char *text, webvtt_uint length );
+
+/**
+ * Create the parser's 'new_region' with default settings, which the lines of
+ * a REGION block then fill in, and make room for it in the region table.
+ */
+WEBVTT_INTERN webvtt_status
+webvtt_begin_region( webvtt_parser self );
+
+/**
+ * Parse one line of region settings into the region begun by
+ * webvtt_begin_region, reporting errors on line 'line'.
+ */
+WEBVTT_INTERN void
+webvtt_region_parse_settings( webvtt_parser self, webvtt_uint line,
+                              const char *text, webvtt_uint length );
+
+/**
+ * Add the region begun by webvtt_begin_region to the table, replacing any
+ * region with the same id. Regions without an id are discarded.
+ */
+WEBVTT_INTERN void
+webvtt_finish_region( webvtt_parser self );
+
+/**
+ * Return the index of the region whose id is the 'length' bytes at 'id', or
+ * WEBVTT_NO_REGION.
+ */
+WEBVTT_INTERN int
+webvtt_find_region( webvtt_parser self, const char *id, webvtt_uint length );
+
+/**
+ * Empty the region table, keeping its storage, and release any region being
+ * read. Cues keep the regions they are placed in.
+ */
+WEBVTT_INTERN void
+webvtt_clear_regions( webvtt_parser self );
+
+#endif
@@ -0,0 +1,602 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "parser_internal.h"
+#include "cuetext_internal.h"
+#include "cue_internal.h"
+#include "srt_internal.h"
+#include <string.h>
+
+/* SubRip readers do not collect errors: report every one to the callback */
+#undef __ERROR_AT_OR
+#define __ERROR_AT_OR(errno, line, column, __or) \
+  REPORT_ERROR_AT_OR(errno, line, column, __or)
+
+/* UTF8 encoding of U+FFFD REPLACEMENT CHAR */
+static const char replacement[] = { 0xEF, 0xBF, 0xBD };
+
+typedef enum
+webvtt_srt_state_t {
+  SRT_INDEX = 0, /* Expecting the numeric index of a block */
+  SRT_TIMING, /* Expecting the 'start --> end' line */
+  SRT_TEXT, /* Reading subtitle text until a blank line */
+  SRT_SKIP /* Skipping a broken block until a blank line */
+} webvtt_srt_state;
+
+struct
+webvtt_srt_reader_t {
+  webvtt_uint line;
+  webvtt_uint column;
+  webvtt_cue_fn read;
+  webvtt_error_fn error;
+  void *userdata;
+  webvtt_bool finished;
+
+  webvtt_srt_state state;
+  webvtt_cue *cue; /* cue being built */
+
+  /**
+   * line currently being read. It is reused for every line, so its capacity
+   * is bounded by the longest line (and WEBVTT_MAX_LINE).
+   */
+  int truncate;
+  webvtt_bool skip_lf; /* previous chunk ended in the middle of a CRLF */
+  webvtt_string line_buffer;
+};
+
+static const struct {
+  const char *name;
+  const char *rgb;
+} srt_colors[] = {
+  { "white", "ffffff" },
+  { "lime", "00ff00" },
+  { "cyan", "00ffff" },
+  { "red", "ff0000" },
+  { "yellow", "ffff00" },
+  { "magenta", "ff00ff" },
+  { "blue", "0000ff" },
+  { "black", "000000" },
+};
+
+static webvtt_bool
+equal_nocase( const char *text, webvtt_uint len, const char *lower )
+{
+  webvtt_uint i;
+  for( i = 0; i < len; ++i ) {
+    char c = text[ i ];
+    if( c >= 'A' && c <= 'Z' ) {
+      c = c - 'A' + 'a';
+    }
+    if( c != lower[ i ] ) {
+      return 0;
+    }
+  }
+  return lower[ len ] == '\0';
+}
+
+WEBVTT_INTERN const char *
+webvtt_srt_color_class( const char *value, webvtt_uint len )
+{
+  unsigned i;
+  if( !value ) {
+    return 0;
+  }
+  for( i = 0; i < sizeof( srt_colors ) / sizeof( *srt_colors ); ++i ) {
+    if( equal_nocase( value, len, srt_colors[ i ].name ) ||
+        ( len == 7 && *value == '#' &&
+          equal_nocase( value + 1, 6, srt_colors[ i ].rgb ) ) ) {
+      return srt_colors[ i ].name;
+    }
+  }
+  return 0;
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_create_srt_reader( webvtt_cue_fn on_read, webvtt_error_fn on_error,
+                          void *userdata, webvtt_srt_reader *ppout )
+{
+  webvtt_srt_reader p;
+  if( !on_read || !on_error || !ppout ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+
+  if( !( p = ( webvtt_srt_reader )webvtt_alloc0( sizeof * p ) ) ) {
+    return WEBVTT_OUT_OF_MEMORY;
+  }
+
+  if( WEBVTT_FAILED( webvtt_create_string( 0x100, &p->line_buffer ) ) ) {
+    webvtt_free( p );
+    return WEBVTT_OUT_OF_MEMORY;
+  }
+
+  p->read = on_read;
+  p->error = on_error;
+  p->userdata = userdata;
+  p->column = p->line = 1;
+  p->state = SRT_INDEX;
+  *ppout = p;
+
+  return WEBVTT_SUCCESS;
+}
+
+WEBVTT_EXPORT void
+webvtt_delete_srt_reader( webvtt_srt_reader self )
+{
+  if( self ) {
+    webvtt_release_cue( &self->cue );
+    webvtt_release_string( &self->line_buffer );
+    webvtt_free( self );
+  }
+}
+
+static int
+is_blank( const char *text, webvtt_uint length )
+{
+  webvtt_uint i;
+  for( i = 0; i < length; ++i ) {
+    if( !webvtt_isspace( text[ i ] ) ) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static int
+has_separator( const char *text, webvtt_uint length )
+{
+  const char *end = text + length;
+  while( ( text = ( const char * )memchr( text, '-', end - text ) ) ) {
+    if( end - text >= 3 && text[ 1 ] == '-' && text[ 2 ] == '>' ) {
+      return 1;
+    }
+    ++text;
+  }
+  return 0;
+}
+
+static webvtt_uint
+skip_whitespace( const char *text, webvtt_uint length, webvtt_uint pos )
+{
+  while( pos < length && webvtt_isspace( text[ pos ] ) ) {
+    ++pos;
+  }
+  return pos;
+}
+
+/**
+ * Collect a SubRip timestamp. SubRip uses ',' where WebVTT uses '.', so the
+ * candidate characters are copied into a small buffer with the separator
+ * swapped, and handed to the WebVTT timestamp parser.
+ */
+static webvtt_status
+srt_collect_timestamp( webvtt_srt_reader self, const char *text,
+                       webvtt_uint length, webvtt_uint *pos,
+                       webvtt_timestamp *result )
+{
+  char ts[ 32 ];
+  webvtt_uint n = 0;
+  webvtt_uint column = *pos + 1;
+  int len = 0;
+
+  while( *pos + n < length && n < sizeof( ts ) - 1 ) {
+    char c = text[ *pos + n ];
+    if( c == ',' ) {
+      c = '.';
+    } else if( !webvtt_isdigit( c ) && c != ':' && c != '.' ) {
+      break;
+    }
+    ts[ n++ ] = c;
+  }
+  ts[ n ] = '\0';
+
+  if( !webvtt_parse_timestamp_n( ts, n, &len, result ) ) {
+    if( BAD_TIMESTAMP( *result ) ) {
+      ERROR_AT( WEBVTT_EXPECTED_TIMESTAMP, self->line, column );
+      return WEBVTT_BAD_CUE;
+    } else {
+      /* Time is malformed, but still usable. */
+      ERROR_AT_OR( WEBVTT_MALFORMED_TIMESTAMP, self->line, column,
+                   WEBVTT_BAD_CUE );
+    }
+  }
+
+  *pos += len;
+  return WEBVTT_SUCCESS;
+}
+
+static webvtt_status
+srt_collect_timings( webvtt_srt_reader self, const char *text,
+                     webvtt_uint length, webvtt_cue *cue )
+{
+  webvtt_status s;
+  webvtt_uint pos = skip_whitespace( text, length, 0 );
+
+  if( WEBVTT_FAILED( s = srt_collect_timestamp( self, text, length, &pos,
+                                                &cue->from ) ) ) {
+    return s;
+  }
+
+  pos = skip_whitespace( text, length, pos );
+  if( length - pos < 3 || memcmp( text + pos, "-->", 3 ) != 0 ) {
+    ERROR_AT( WEBVTT_EXPECTED_CUETIME_SEPARATOR, self->line, pos + 1 );
+    return WEBVTT_BAD_CUE;
+  }
+  pos = skip_whitespace( text, length, pos + 3 );
+
+  /**
+   * Anything following the end time (such as the 'X1: Y1:' display
+   * coordinates some tools emit) has no WebVTT equivalent and is ignored.
+   */
+  return srt_collect_timestamp( self, text, length, &pos, &cue->until );
+}
+
+/**
+ * Find the value of a 'color' attribute in the body of a <font> tag.
+ */
+static const char *
+font_color( const char *attrs, webvtt_uint length, webvtt_uint *value_len )
+{
+  webvtt_uint i = 0;
+  while( i + 5 <= length ) {
+    if( equal_nocase( attrs + i, 5, "color" ) ) {
+      webvtt_uint start, end;
+      char quote = 0;
+      i = skip_whitespace( attrs, length, i + 5 );
+      if( i >= length || attrs[ i ] != '=' ) {
+        continue;
+      }
+      i = skip_whitespace( attrs, length, i + 1 );
+      if( i < length && ( attrs[ i ] == '"' || attrs[ i ] == '\'' ) ) {
+        quote = attrs[ i++ ];
+      }
+      start = end = i;
+      while( end < length && ( quote ? attrs[ end ] != quote
+                                     : !webvtt_isspace( attrs[ end ] ) ) ) {
+        ++end;
+      }
+      *value_len = end - start;
+      return attrs + start;
+    }
+    ++i;
+  }
+  return 0;
+}
+
+/**
+ * Translate a SubRip markup tag into WebVTT cue text. Tags without a WebVTT
+ * equivalent are dropped.
+ */
+static webvtt_status
+append_tag( webvtt_string *body, const char *tag, webvtt_uint length )
+{
+  webvtt_bool closing = 0;
+  webvtt_uint name = 0;
+
+  if( length && *tag == '/' ) {
+    closing = 1;
+    ++tag;
+    --length;
+  }
+  while( name < length && webvtt_isalpha( tag[ name ] ) ) {
+    ++name;
+  }
+
+  if( name == 1 && ( equal_nocase( tag, 1, "b" ) ||
+                     equal_nocase( tag, 1, "i" ) ||
+                     equal_nocase( tag, 1, "u" ) ) ) {
+    char out[ 4 ];
+    webvtt_uint n = 0;
+    out[ n++ ] = '<';
+    if( closing ) {
+      out[ n++ ] = '/';
+    }
+    out[ n++ ] = ( char )( tag[ 0 ] | 0x20 );
+    out[ n++ ] = '>';
+    return webvtt_string_append( body, out, n );
+  }
+
+  if( equal_nocase( tag, name, "font" ) ) {
+    const char *color;
+    const char *cls = 0;
+    webvtt_uint color_len = 0;
+    webvtt_status status;
+    if( closing ) {
+      return webvtt_string_append( body, "</c>", 4 );
+    }
+    if( ( color = font_color( tag + name, length - name, &color_len ) ) ) {
+      cls = webvtt_srt_color_class( color, color_len );
+    }
+    if( !cls ) {
+      return webvtt_string_append( body, "<c>", 3 );
+    }
+    if( WEBVTT_FAILED( status = webvtt_string_append( body, "<c.", 3 ) ) ||
+        WEBVTT_FAILED( status = webvtt_string_append( body, cls, -1 ) ) ) {
+      return status;
+    }
+    return webvtt_string_putc( body, '>' );
+  }
+
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Append a line of SubRip text to the cue body as WebVTT cue text: markup is
+ * translated, SSA-style override blocks ('{\an8}') are removed and characters
+ * which are special to the cue text parser are escaped.
+ */
+static webvtt_status
+append_text( webvtt_string *body, const char *text, webvtt_uint length )
+{
+  webvtt_status status = WEBVTT_SUCCESS;
+  webvtt_uint i = 0;
+
+  while( i < length && !WEBVTT_FAILED( status ) ) {
+    webvtt_uint run = i;
+    const char *end;
+    while( run < length && text[ run ] != '<' && text[ run ] != '>'
+           && text[ run ] != '&' && text[ run ] != '{' ) {
+      ++run;
+    }
+    if( run > i ) {
+      status = webvtt_string_append( body, text + i, run - i );
+      i = run;
+      continue;
+    }
+
+    switch( text[ i ] ) {
+      case '<':
+        if( ( end = ( const char * )memchr( text + i, '>', length - i ) ) ) {
+          status = append_tag( body, text + i + 1,
+                               ( webvtt_uint )( end - text ) - i - 1 );
+          i = ( webvtt_uint )( end - text ) + 1;
+        } else {
+          status = webvtt_string_append( body, "&lt;", 4 );
+          ++i;
+        }
+        break;
+      case '>':
+        status = webvtt_string_append( body, "&gt;", 4 );
+        ++i;
+        break;
+      case '&':
+        status = webvtt_string_append( body, "&amp;", 5 );
+        ++i;
+        break;
+      default:
+        if( i + 1 < length && text[ i + 1 ] == '\\' &&
+            ( end = ( const char * )memchr( text + i, '}', length - i ) ) ) {
+          i = ( webvtt_uint )( end - text ) + 1;
+        } else {
+          status = webvtt_string_putc( body, text[ i++ ] );
+        }
+        break;
+    }
+  }
+  return status;
+}
+
+/**
+ * Validate a cue and, if valid, build its node tree and hand it to the
+ * application.
+ */
+static webvtt_status
+finish_cue( webvtt_srt_reader self )
+{
+  webvtt_cue *cue = self->cue;
+  webvtt_status status = WEBVTT_SUCCESS;
+  self->cue = 0;
+  if( cue ) {
+    if( webvtt_validate_cue( cue ) ) {
+      status = webvtt_parse_cuetext( 0, cue, &cue->body, 1 );
+      self->read( self->userdata, cue );
+    } else {
+      webvtt_release_cue( &cue );
+    }
+  }
+  return status;
+}
+
+static webvtt_status
+srt_proc_line( webvtt_srt_reader self, const char *text, webvtt_uint length )
+{
+  webvtt_status status;
+  webvtt_bool blank = is_blank( text, length );
+
+  switch( self->state ) {
+    case SRT_INDEX:
+      if( blank ) {
+        break;
+      }
+      if( WEBVTT_FAILED( status = webvtt_create_cue( &self->cue ) ) ) {
+        if( status == WEBVTT_OUT_OF_MEMORY ) {
+          ERROR( WEBVTT_ALLOCATION_FAILED );
+        }
+        return status;
+      }
+      if( !has_separator( text, length ) ) {
+        /* The index of the block becomes the cue-id */
+        webvtt_uint start = skip_whitespace( text, length, 0 );
+        while( length > start && webvtt_isspace( text[ length - 1 ] ) ) {
+          --length;
+        }
+        if( WEBVTT_FAILED( webvtt_string_append( &self->cue->id, text + start,
+                                                 length - start ) ) ) {
+          ERROR( WEBVTT_ALLOCATION_FAILED );
+          return WEBVTT_OUT_OF_MEMORY;
+        }
+        self->cue->flags |= CUE_HAVE_ID;
+        self->state = SRT_TIMING;
+        break;
+      }
+      /**
+       * Some files omit the index, in which case the timing line starts the
+       * block.
+       */
+      /* fall through */
+    case SRT_TIMING:
+      if( blank || !has_separator( text, length ) ) {
+        webvtt_release_cue( &self->cue );
+        self->state = blank ? SRT_INDEX : SRT_SKIP;
+        ERROR( WEBVTT_CUE_INCOMPLETE );
+        break;
+      }
+      if( WEBVTT_FAILED( status = srt_collect_timings( self, text, length,
+                                                       self->cue ) ) ) {
+        webvtt_release_cue( &self->cue );
+        if( status == WEBVTT_PARSE_ERROR ) {
+          return status;
+        }
+        self->state = SRT_SKIP;
+        break;
+      }
+      self->cue->flags |= CUE_HAVE_CUEPARAMS;
+      self->state = SRT_TEXT;
+      break;
+
+    case SRT_TEXT:
+      if( blank ) {
+        self->state = SRT_INDEX;
+        return finish_cue( self );
+      }
+      if( ( webvtt_string_length( &self->cue->body ) &&
+            WEBVTT_FAILED( webvtt_string_putc( &self->cue->body, '\n' ) ) ) ||
+          WEBVTT_FAILED( append_text( &self->cue->body, text, length ) ) ) {
+        ERROR( WEBVTT_ALLOCATION_FAILED );
+        return WEBVTT_OUT_OF_MEMORY;
+      }
+      break;
+
+    case SRT_SKIP:
+      if( blank ) {
+        self->state = SRT_INDEX;
+      }
+      break;
+  }
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Process the line collected in line_buffer, then empty the buffer (keeping
+ * its storage) for the next one.
+ */
+static webvtt_status
+proc_line_buffer( webvtt_srt_reader self )
+{
+  webvtt_status status;
+  const char *text;
+  webvtt_uint length;
+
+  /* replace '\0' with u+fffd */
+  if( WEBVTT_FAILED( webvtt_string_replace_all( &self->line_buffer, "\0", 1,
+                                                replacement, 3 ) ) ) {
+    ERROR( WEBVTT_ALLOCATION_FAILED );
+    return WEBVTT_OUT_OF_MEMORY;
+  }
+
+  text = webvtt_string_text( &self->line_buffer );
+  length = webvtt_string_length( &self->line_buffer );
+  if( self->line == 1 && length >= 3 && !memcmp( text, "\xEF\xBB\xBF", 3 ) ) {
+    /* Skip the byte order mark */
+    text += 3;
+    length -= 3;
+  }
+  self->column = 1;
+  status = srt_proc_line( self, text, length );
+
+  webvtt_string_clear( &self->line_buffer );
+  self->truncate = 0;
+  ++self->line;
+  return status;
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_srt_parse_chunk( webvtt_srt_reader self, const void *buffer,
+                        webvtt_uint len )
+{
+  webvtt_status status;
+  webvtt_uint pos = 0;
+  const char *b = ( const char * )buffer;
+
+  if( !self || ( !buffer && len ) ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+
+  while( pos < len ) {
+    int v;
+    if( self->skip_lf ) {
+      self->skip_lf = 0;
+      if( b[ pos ] == '\n' ) {
+        ++pos;
+        continue;
+      }
+    }
+
+    if( ( v = webvtt_string_getline( &self->line_buffer, b, &pos, len,
+                                     &self->truncate, 0 ) ) < 0 ) {
+      ERROR( WEBVTT_ALLOCATION_FAILED );
+      return WEBVTT_OUT_OF_MEMORY;
+    } else if( v == 0 ) {
+      /* The rest of the line is in the next chunk */
+      break;
+    }
+
+    /* Consume the end-of-line sequence */
+    if( b[ pos++ ] == '\r' ) {
+      if( pos == len ) {
+        self->skip_lf = 1;
+      } else if( b[ pos ] == '\n' ) {
+        ++pos;
+      }
+    }
+
+    if( WEBVTT_FAILED( status = proc_line_buffer( self ) ) ) {
+      return status;
+    }
+  }
+
+  return WEBVTT_SUCCESS;
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_srt_finish_parsing( webvtt_srt_reader self )
+{
+  webvtt_status status = WEBVTT_SUCCESS;
+  if( !self ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+
+  if( !self->finished ) {
+    self->finished = 1;
+    if( webvtt_string_length( &self->line_buffer ) &&
+        WEBVTT_FAILED( status = proc_line_buffer( self ) ) ) {
+      return status;
+    }
+    /* The final block does not need to be followed by a blank line */
+    status = srt_proc_line( self, "", 0 );
+  }
+  return status;
+}
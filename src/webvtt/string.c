@@ -26,8 +26,13 @@
  */
 
 #include "string_internal.h"
+#include "alloc_internal.h"
 #include <stdlib.h>
 #include <string.h>
+#if defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+# define UTF8_SSE2 1
+#endif
 
 /* TODO: Use libc implementation if we have one */
 
@@ -64,20 +69,84 @@ memmem(const void *l, size_t l_len, const void *s, size_t s_len)
   return NULL;
 }
 
+/**
+ * Every empty string shares this, on every thread, so its count is never
+ * changed (see REF_DATA and RELEASE_DATA). It is kept above 1, so that the
+ * data is never taken to be unshared and written to.
+ */
 static webvtt_string_data empty_string = {
-  { 1 }, /* init refcount */
+  { 2 }, /* init refcount */
   0, /* length */
   0, /* capacity */
   empty_string.array, /* text */
   { '\0' } /* array */
 };
 
+/**
+ * Marks a string whose text is kept in the string itself (see
+ * WEBVTT_SMALL_STRING). Like empty_string, it is never counted.
+ */
+static webvtt_string_data small_string = {
+  { 2 }, /* init refcount */
+  WEBVTT_SMALL_STRING, /* capacity */
+  0, /* length */
+  small_string.array, /* text */
+  { '\0' } /* array */
+};
+
+#define IS_SMALL(S) ( (S)->d == &small_string )
+#define IS_STATIC(D) ( (D) == &empty_string || (D) == &small_string )
+
+#define REF_DATA(D) do { \
+    if( !IS_STATIC( D ) ) { \
+      webvtt_ref( &(D)->refs ); \
+    } \
+  } while( 0 )
+#define RELEASE_DATA(D) do { \
+    if( !IS_STATIC( D ) && webvtt_deref( &(D)->refs ) == 0 ) { \
+      webvtt_free( (D) ); \
+    } \
+  } while( 0 )
+
+/**
+ * Replace the contents of 'str' (which must not hold a reference) with the
+ * 'length' bytes of 'text', kept in the string itself
+ */
+static void
+make_small( webvtt_string *str, const char *text, webvtt_uint length )
+{
+  str->d = &small_string;
+  str->small_length = ( webvtt_uint8 )length;
+  memmove( str->small, text, length );
+  str->small[ length ] = 0;
+}
+
+/**
+ * The text of a string which is not shared, to be written to
+ */
+static char *
+writable_text( webvtt_string *str )
+{
+  return IS_SMALL( str ) ? str->small : str->d->text;
+}
+
+static void
+set_length( webvtt_string *str, webvtt_uint length )
+{
+  if( IS_SMALL( str ) ) {
+    str->small_length = ( webvtt_uint8 )length;
+    str->small[ length ] = 0;
+  } else {
+    str->d->length = length;
+    str->d->text[ length ] = 0;
+  }
+}
+
 WEBVTT_EXPORT void
 webvtt_init_string( webvtt_string *result )
 {
   if( result ) {
     result->d = &empty_string;
-    webvtt_ref( &result->d->refs );
   }
 }
 
@@ -98,8 +167,14 @@ webvtt_create_string( webvtt_uint32 alloc, webvtt_string *result )
     return WEBVTT_INVALID_PARAM;
   }
 
-  d = ( webvtt_string_data * )webvtt_alloc( sizeof( webvtt_string_data ) +
-                                            ( alloc * sizeof( char ) ) );
+  if( alloc <= WEBVTT_SMALL_STRING ) {
+    make_small( result, "", 0 );
+    return WEBVTT_SUCCESS;
+  }
+
+  d = ( webvtt_string_data * )webvtt_alloc_as( sizeof( webvtt_string_data ) +
+                                               ( alloc * sizeof( char ) ),
+                                               WEBVTT_OBJECT_STRING );
 
   if( !d ) {
     return WEBVTT_OUT_OF_MEMORY;
@@ -155,7 +230,7 @@ WEBVTT_EXPORT void
 webvtt_ref_string( webvtt_string *str )
 {
   if( str ) {
-    webvtt_ref( &str->d->refs );
+    REF_DATA( str->d );
   }
 }
 
@@ -168,58 +243,175 @@ webvtt_release_string( webvtt_string *str )
   if( str ) {
     webvtt_string_data *d = str->d;
     str->d = 0;
-    if( d && webvtt_deref( &d->refs ) == 0 ) {
-      webvtt_free( d );
+    if( d ) {
+      RELEASE_DATA( d );
     }
   }
 }
 
+/**
+ * The capacity of string data holding 'alloc' bytes, once it is rounded up to
+ * a whole 16-byte unit of the allocator
+ */
+#define ROUND_ALLOC(alloc) ( ( webvtt_uint )( \
+    ( ( sizeof( webvtt_string_data ) + (alloc) + 15 ) & ~( size_t )15 ) \
+    - sizeof( webvtt_string_data ) ) )
+
+/**
+ * Move the text of 'str' to new data with room for exactly 'alloc' bytes, or
+ * into the string itself if that is enough, and release the old data.
+ */
+static webvtt_status
+reallocate( webvtt_string *str, webvtt_uint alloc )
+{
+  webvtt_uint length = webvtt_string_length( str );
+  webvtt_string_data *d = str->d, *p;
+
+  if( alloc < length ) {
+    alloc = length;
+  }
+  if( length <= WEBVTT_SMALL_STRING && alloc <= WEBVTT_SMALL_STRING ) {
+    make_small( str, webvtt_string_text( str ), length );
+    RELEASE_DATA( d );
+    return WEBVTT_SUCCESS;
+  }
+
+  p = ( webvtt_string_data * )webvtt_alloc_as( sizeof( webvtt_string_data ) +
+                                               ( sizeof( char ) * alloc ),
+                                               WEBVTT_OBJECT_STRING );
+  if( !p ) {
+    return WEBVTT_OUT_OF_MEMORY;
+  }
+
+  p->refs.value = 1;
+  p->alloc = alloc;
+  p->length = length;
+  p->text = p->array;
+  memcpy( p->text, webvtt_string_text( str ), sizeof( char ) * length );
+  p->text[ length ] = 0;
+  str->d = p;
+  RELEASE_DATA( d );
+
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Whether the text of 'str' may be written to in place
+ */
+static webvtt_bool
+is_unshared( const webvtt_string *str )
+{
+  return IS_SMALL( str ) || ( str->d != &empty_string
+                              && str->d->refs.value == 1 );
+}
+
 /**
  * "Detach" a shared string, so that it's safely mutable
  */
 WEBVTT_EXPORT webvtt_status
 webvtt_string_detach( /* in, out */ webvtt_string *str )
 {
-  webvtt_string_data *d, *q;
+  webvtt_uint length;
 
   if( !str ) {
     return WEBVTT_INVALID_PARAM;
   }
 
-  q = str->d;
+  if( is_unshared( str ) ) {
+    return WEBVTT_SUCCESS;
+  }
+
+  /* A short copy needs no allocation */
+  length = webvtt_string_length( str );
+  return reallocate( str, length <= WEBVTT_SMALL_STRING ? length
+                                                         : str->d->alloc );
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_string_reserve( webvtt_string *str, webvtt_uint capacity )
+{
+  if( !str || !str->d ) {
+    return WEBVTT_INVALID_PARAM;
+  }
 
-  if( q->refs.value == 1 ) {
+  if( is_unshared( str ) && capacity <= webvtt_string_capacity( str ) ) {
     return WEBVTT_SUCCESS;
   }
 
-  d = ( webvtt_string_data * )webvtt_alloc( sizeof( webvtt_string_data ) +
-                                           ( sizeof( char ) * str->d->alloc ) );
+  if( capacity < webvtt_string_length( str ) ) {
+    capacity = webvtt_string_length( str );
+  }
+  return reallocate( str, capacity );
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_string_shrink_to_fit( webvtt_string *str )
+{
+  webvtt_uint length;
 
-  d->refs.value = 1;
-  d->text = d->array;
-  d->alloc = q->alloc;
-  d->length = q->length;
-  memcpy( d->text, q->text, q->length );
+  if( !str || !str->d ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+
+  /**
+   * Shared text is left to the other holders, and slack which would only be
+   * lost to rounding by the allocator is not worth a copy
+   */
+  length = webvtt_string_length( str );
+  if( IS_SMALL( str ) || str->d == &empty_string || str->d->refs.value != 1
+      || ( length > WEBVTT_SMALL_STRING
+           && ROUND_ALLOC( length ) == ROUND_ALLOC( str->d->alloc ) ) ) {
+    return WEBVTT_SUCCESS;
+  }
 
-  str->d = d;
+  return reallocate( str, length );
+}
 
-  if( webvtt_deref( &q->refs ) == 0 ) {
-    webvtt_free( q );
+/**
+ * Empty a string. If the string data is not shared, its storage is kept so
+ * that the string can be refilled without allocating.
+ */
+WEBVTT_INTERN void
+webvtt_string_clear( webvtt_string *str )
+{
+  if( str ) {
+    webvtt_string_data *d = str->d;
+    if( d && IS_SMALL( str ) ) {
+      set_length( str, 0 );
+    } else if( d && d != &empty_string && d->refs.value == 1 ) {
+      d->length = 0;
+      d->text[ 0 ] = 0;
+    } else {
+      webvtt_release_string( str );
+      webvtt_init_string( str );
+    }
   }
+}
 
-  return WEBVTT_SUCCESS;
+/**
+ * Shorten a string which is not shared to its first 'length' bytes
+ */
+WEBVTT_INTERN void
+webvtt_string_truncate( webvtt_string *str, webvtt_uint length )
+{
+  if( str && str->d && length < webvtt_string_length( str ) ) {
+    set_length( str, length );
+  }
 }
 
 WEBVTT_EXPORT void
 webvtt_copy_string( webvtt_string *left, const webvtt_string *right )
 {
   if( left ) {
-    if( right && right->d ) {
+    if( right && right->d && IS_SMALL( right ) ) {
+      *left = *right;
+      return;
+    } else if( right && right->d ) {
       left->d = right->d;
     } else {
       left->d = &empty_string;
     }
-    webvtt_ref( &left->d->refs );
+    REF_DATA( left->d );
   }
 }
 
@@ -231,7 +423,7 @@ webvtt_string_text(const webvtt_string *str)
     return 0;
   }
 
-  return str->d->text;
+  return IS_SMALL( str ) ? str->small : str->d->text;
 }
 
 WEBVTT_EXPORT webvtt_uint32
@@ -242,7 +434,7 @@ webvtt_string_length(const webvtt_string *str)
     return 0;
   }
 
-  return str->d->length;
+  return IS_SMALL( str ) ? str->small_length : str->d->length;
 }
 
 WEBVTT_EXPORT webvtt_uint32
@@ -257,66 +449,68 @@ webvtt_string_capacity(const webvtt_string *str)
 }
 
 /**
- * Reallocate string.
- * Grow to at least 'need' characters. Power of 2 growth.
+ * Make room to append 'need' more characters, and make sure that the text is
+ * not shared. Past WEBVTT_SMALL_STRING the capacity doubles up to a page, and
+ * grows by half beyond that, so that appending is amortised O(1) while large
+ * text leaves at most a third of its data unused. The first allocation is
+ * exact, as most text is only ever set once.
  */
 static webvtt_status
 grow( webvtt_string *str, webvtt_uint need )
 {
   static const webvtt_uint page = 0x1000;
-  webvtt_uint32 n;
-  webvtt_string_data *p, *d;
-  webvtt_uint32 grow;
+  webvtt_uint length, capacity, alloc;
 
   if( !str )
   {
     return WEBVTT_INVALID_PARAM;
   }
 
-  if( ( str->d->length + need ) <= str->d->alloc )
+  length = webvtt_string_length( str );
+  capacity = webvtt_string_capacity( str );
+  if( length + need <= capacity && is_unshared( str ) )
   {
     return WEBVTT_SUCCESS;
   }
 
-  p = d = str->d;
-  grow = sizeof( *d ) + ( sizeof( char ) * ( d->length + need ) );
-
-  if( grow < page ) {
-    n = page;
-    do {
-      n = n / 2;
-    } while( n > grow );
-    if( n < 1 << 6 ) {
-      n = 1 << 6;
-    } else {
-      n = n * 2;
+  alloc = length + need;
+  if( alloc > WEBVTT_SMALL_STRING ) {
+    webvtt_uint next = capacity < page ? capacity * 2 : capacity + capacity / 2;
+    if( alloc < next ) {
+      alloc = next;
     }
-  } else {
-    n = page;
-    do {
-      n = n * 2;
-    } while ( n < grow );
+    alloc = ROUND_ALLOC( alloc );
   }
 
-  p = ( webvtt_string_data * )webvtt_alloc( n );
-
-  if( !p ) {
-    return WEBVTT_OUT_OF_MEMORY;
-  }
+  return reallocate( str, alloc );
+}
 
-  p->refs.value = 1;
-  p->alloc = ( n - sizeof( *p ) ) / sizeof( char );
-  p->length = d->length;
-  p->text = p->array;
-  memcpy( p->text, d->text, sizeof( char ) * p->length );
-  p->text[ p->length ] = 0;
-  str->d = p;
+/**
+ * Scan for CR or LF a word at a time: a byte of 'w' equal to CR or LF becomes
+ * zero when xor'd with a word of CRs or LFs, and HAS_ZERO_BYTE detects that.
+ * Most lines are long enough for this to skip over nearly all of their bytes.
+ */
+#define ONES_64 ( (webvtt_uint64)0x0101010101010101ULL )
+#define HIGHS_64 ( (webvtt_uint64)0x8080808080808080ULL )
+#define HAS_ZERO_BYTE(w) ( ( (w) - ONES_64 ) & ~(w) & HIGHS_64 )
 
-  if( webvtt_deref( &d->refs ) == 0 ) {
-    webvtt_free( d );
+WEBVTT_INTERN const char *
+webvtt_find_eol( const char *begin, const char *end )
+{
+  const char *p = begin;
+  const webvtt_uint64 cr = ONES_64 * 0x0D, lf = ONES_64 * 0x0A;
+  while( end - p >= 8 ) {
+    webvtt_uint64 w;
+    memcpy( &w, p, sizeof( w ) );
+    if( HAS_ZERO_BYTE( w ^ cr ) | HAS_ZERO_BYTE( w ^ lf ) ) {
+      break;
+    }
+    p += 8;
   }
-
-  return WEBVTT_SUCCESS;
+  while( p < end && *p != '\r' && *p != '\n' ) {
+    ++p;
+  }
+  return p;
 }
 
 WEBVTT_EXPORT int
@@ -326,7 +520,7 @@ webvtt_string_getline( webvtt_string *src, const char *buffer,
 {
   int ret = 0;
   webvtt_string *str = src;
-  webvtt_string_data *d = 0;
+  webvtt_uint length;
   const char *s = buffer + *pos;
   const char *p = s;
   const char *n;
@@ -340,44 +534,39 @@ webvtt_string_getline( webvtt_string *src, const char *buffer,
   }
 
   /* This had better be a valid string_data, or else NULL. */
-  d = str->d;
   if( !str->d ) {
     if(WEBVTT_FAILED(webvtt_create_string( 0x100, str ))) {
       return -1;
     }
-    d = str->d;
   }
   if( len < 0 ) {
     len = strlen( buffer );
   }
   n = buffer + len;
 
-  while( p < n && *p != '\r' && *p != '\n' ) {
-    ++p;
-  }
+  p = webvtt_find_eol( s, n );
 
   if( p < n || finish ) {
     ret = 1; /* indicate that we found EOL */
   }
   len = (webvtt_uint)( p - s );
   *pos += len;
-  if( d->length + len + 1 >= d->alloc ) {
-    if( truncate && d->alloc >= WEBVTT_MAX_LINE ) {
+  length = webvtt_string_length( str );
+  if( length + len + 1 >= webvtt_string_capacity( str ) ) {
+    if( truncate && webvtt_string_capacity( str ) >= WEBVTT_MAX_LINE ) {
       /* truncate. */
       (*truncate)++;
     } else {
       if( grow( str, len + 1 ) == WEBVTT_OUT_OF_MEMORY ) {
         ret = -1;
       }
-      d = str->d;
     }
   }
 
   /* Copy everything in */
-  if( len && ret >= 0 && d->length + len < d->alloc ) {
-    memcpy( d->text + d->length, s, len );
-    d->length += len;
-    d->text[ d->length ] = 0;
+  if( len && ret >= 0 && length + len < webvtt_string_capacity( str ) ) {
+    memcpy( writable_text( str ) + length, s, len );
+    set_length( str, length + len );
   }
 
   return ret;
@@ -398,8 +587,9 @@ webvtt_string_putc( webvtt_string *str, char to_append )
 
   if( !WEBVTT_FAILED( result = grow( str, 1 ) ) )
   {
-    str->d->text[ str->d->length++ ] = to_append;
-    str->d->text[ str->d->length ] = 0;
+    webvtt_uint length = webvtt_string_length( str );
+    writable_text( str )[ length ] = to_append;
+    set_length( str, length + 1 );
   }
 
   return result;
@@ -417,7 +607,7 @@ webvtt_string_is_equal( const webvtt_string *str, const char *to_compare,
     len = strlen( to_compare );
   }
 
-  if( str->d->length != (unsigned)len ) {
+  if( webvtt_string_length( str ) != (unsigned)len ) {
     return 0;
   }
 
@@ -444,11 +634,11 @@ webvtt_string_append( webvtt_string *str, const char *buffer, int len )
     return WEBVTT_SUCCESS;
   }
 
-  if( !WEBVTT_FAILED( result = grow( str, str->d->length + len ) ) ) {
-    memcpy( str->d->text + str->d->length, buffer, len );
-    str->d->length += len;
+  if( !WEBVTT_FAILED( result = grow( str, len ) ) ) {
+    webvtt_uint length = webvtt_string_length( str );
+    memcpy( writable_text( str ) + length, buffer, len );
     /* null-terminate string */
-    str->d->text[ str->d->length ] = 0;
+    set_length( str, length + len );
   }
 
   return result;
@@ -457,11 +647,18 @@ webvtt_string_append( webvtt_string *str, const char *buffer, int len )
 WEBVTT_EXPORT webvtt_status
  webvtt_string_append_string( webvtt_string *str, const webvtt_string *other )
 {
+  webvtt_string text;
+  webvtt_status status;
   if( !str || !other ) {
     return WEBVTT_INVALID_PARAM;
   }
 
-  return webvtt_string_append( str, other->d->text, other->d->length );
+  /* Hold on to the text, in case 'other' is 'str' and has to grow */
+  webvtt_copy_string( &text, other );
+  status = webvtt_string_append( str, webvtt_string_text( &text ),
+                                 webvtt_string_length( &text ) );
+  webvtt_release_string( &text );
+  return status;
 }
 
 WEBVTT_EXPORT webvtt_status
@@ -482,22 +679,22 @@ webvtt_string_replace( webvtt_string *str, const char *search, int search_len,
     replace_len = ( int )strlen( replace );
   }
 
-  if( ( p = (char *)memmem( str->d->text, str->d->length, search,
+  if( ( p = (char *)memmem( webvtt_string_text( str ),
+                            webvtt_string_length( str ), search,
                             search_len ) ) ) {
     const char *end;
-    size_t pos = p - str->d->text;
+    size_t pos = p - webvtt_string_text( str );
+    webvtt_uint length = webvtt_string_length( str );
     if( WEBVTT_FAILED( status = grow( str, replace_len ) ) ) {
       return status;
     }
-    p = str->d->text + pos;
-    end = str->d->text + str->d->length - 1; /* Don't worry about the NULL
-                                              * byte. */
+    p = writable_text( str ) + pos;
+    end = p - pos + length - 1; /* Don't worry about the NULL byte. */
     if( search_len != replace_len ) {
       memmove( p + replace_len, p + search_len, end - p );
     }
     memcpy( p, replace, replace_len );
-    str->d->length = ( str->d->length - search_len ) + replace_len;
-    str->d->text[ str->d->length ] = 0;
+    set_length( str, ( length - search_len ) + replace_len );
     status = ( webvtt_status )1;
   }
   return status;
@@ -543,7 +740,8 @@ webvtt_create_stringlist( webvtt_stringlist **result )
     return WEBVTT_INVALID_PARAM;
   }
 
-  list = ( webvtt_stringlist * )webvtt_alloc0( sizeof( *list ) );
+  list = ( webvtt_stringlist * )webvtt_alloc0_as( sizeof( *list ),
+                                                  WEBVTT_OBJECT_STRINGLIST );
 
   if( !list ) {
     return WEBVTT_OUT_OF_MEMORY;
@@ -609,8 +807,9 @@ webvtt_stringlist_push( webvtt_stringlist *list, webvtt_string *str )
     webvtt_string *arr, *old;
 
     list->alloc = list->alloc == 0 ? 8 : list->alloc * 2;
-    arr = ( webvtt_string * )webvtt_alloc0( sizeof( webvtt_string ) *
-                                            list->alloc );
+    arr = ( webvtt_string * )webvtt_alloc0_as( sizeof( webvtt_string ) *
+                                               list->alloc,
+                                               WEBVTT_OBJECT_STRINGLIST );
 
     if( !arr ) {
       return WEBVTT_OUT_OF_MEMORY;
@@ -623,8 +822,7 @@ webvtt_stringlist_push( webvtt_stringlist *list, webvtt_string *str )
     webvtt_free( old );
   }
 
-  list->items[list->length].d = str->d;
-  webvtt_ref_string( list->items + list->length++ );
+  webvtt_copy_string( list->items + list->length++, str );
 
   return WEBVTT_SUCCESS;
 }
@@ -879,3 +1077,264 @@ webvtt_utf8_length( const char *utf8 )
   }
   return -1;
 }
+
+/* Returned by decode_utf8 for a malformed sequence */
+#define UTF8_MALFORMED (0xFFFFFFFFU)
+
+/**
+ * Decode the character at '*pp', moving '*pp' past it, or return
+ * UTF8_MALFORMED. Overlong sequences, surrogates and values above U+10FFFF
+ * use up their whole sequence, a truncated sequence uses up the bytes it has,
+ * and a run of stray trail bytes is a single malformed sequence.
+ */
+static webvtt_uint32
+decode_utf8( const unsigned char **pp, const unsigned char *end )
+{
+  const unsigned char *p = *pp;
+  webvtt_uint32 uc = *p++, min;
+  int need;
+  if( uc < 0x80 ) {
+    *pp = p;
+    return uc;
+  } else if( ( uc & 0xE0 ) == 0xC0 ) {
+    uc &= 0x1F;
+    need = 1;
+    min = 0x80;
+  } else if( ( uc & 0xF0 ) == 0xE0 ) {
+    uc &= 0x0F;
+    need = 2;
+    min = 0x800;
+  } else if( ( uc & 0xF8 ) == 0xF0 ) {
+    uc &= 0x07;
+    need = 3;
+    min = 0x10000;
+  } else {
+    if( ( uc & 0xC0 ) == 0x80 ) {
+      while( p < end && ( *p & 0xC0 ) == 0x80 ) {
+        ++p;
+      }
+    }
+    *pp = p;
+    return UTF8_MALFORMED;
+  }
+  while( need && p < end && ( *p & 0xC0 ) == 0x80 ) {
+    uc = ( uc << 6 ) | ( *p++ & 0x3F );
+    --need;
+  }
+  *pp = p;
+  if( need || uc < min || ( uc >= 0xD800 && uc <= 0xDFFF ) || uc >= 0x110000 ) {
+    return UTF8_MALFORMED;
+  }
+  return uc;
+}
+
+/**
+ * The character a decoded value stands for: malformed sequences and
+ * non-characters are U+FFFD, as in webvtt_utf8_to_utf16
+ */
+static webvtt_uint32
+displayable( webvtt_uint32 uc )
+{
+  if( uc == UTF8_MALFORMED || UTF_IS_NONCHAR( uc ) ) {
+    return 0xFFFD;
+  }
+  return uc;
+}
+
+/**
+ * Length of the run of ASCII at 'p', in whole blocks of 16 bytes, looking at
+ * no more than 'max' bytes
+ */
+static size_t
+ascii_run( const unsigned char *p, size_t max )
+{
+  size_t n = 0;
+#if UTF8_SSE2
+  while( max - n >= 16
+         && !_mm_movemask_epi8( _mm_loadu_si128( ( const __m128i * )( p + n ) ) ) ) {
+    n += 16;
+  }
+#else
+  while( max - n >= 16 ) {
+    webvtt_uint64 a, b;
+    memcpy( &a, p + n, 8 );
+    memcpy( &b, p + n + 8, 8 );
+    if( ( a | b ) & 0x8080808080808080ULL ) {
+      break;
+    }
+    n += 16;
+  }
+#endif
+  return n;
+}
+
+WEBVTT_EXPORT webvtt_uint32
+webvtt_utf8_decode( const char **begin, const char *end )
+{
+  const unsigned char *p;
+  webvtt_uint32 uc;
+  if( !begin || !*begin || !end || *begin >= end ) {
+    return 0;
+  }
+  p = ( const unsigned char * )*begin;
+  uc = displayable( decode_utf8( &p, ( const unsigned char * )end ) );
+  *begin = ( const char * )p;
+  return uc;
+}
+
+WEBVTT_EXPORT webvtt_uint
+webvtt_utf8_to_utf16_buffer( const char *utf8, const char *end,
+                             webvtt_uint16 *out, webvtt_uint capacity,
+                             const char **next )
+{
+  const unsigned char *p = ( const unsigned char * )utf8;
+  const unsigned char *e = ( const unsigned char * )end;
+  webvtt_uint n = 0;
+
+  if( p && out && e ) {
+    while( p < e && n < capacity ) {
+      /* Copy ASCII a block at a time */
+      size_t run = ascii_run( p, ( size_t )( e - p ) < capacity - n
+                                 ? ( size_t )( e - p ) : capacity - n );
+      size_t i = 0;
+#if UTF8_SSE2
+      const __m128i zero = _mm_setzero_si128();
+      for( ; i < run; i += 16 ) {
+        __m128i v = _mm_loadu_si128( ( const __m128i * )( p + i ) );
+        _mm_storeu_si128( ( __m128i * )( out + n + i ),
+                          _mm_unpacklo_epi8( v, zero ) );
+        _mm_storeu_si128( ( __m128i * )( out + n + i + 8 ),
+                          _mm_unpackhi_epi8( v, zero ) );
+      }
+#else
+      for( ; i < run; ++i ) {
+        out[ n + i ] = p[ i ];
+      }
+#endif
+      p += run;
+      n += ( webvtt_uint )run;
+
+      /* Then one character at a time, until the next block of ASCII */
+      while( p < e && n < capacity ) {
+        const unsigned char *start = p;
+        webvtt_uint32 uc = displayable( decode_utf8( &p, e ) );
+        if( uc < 0x10000 ) {
+          out[ n++ ] = ( webvtt_uint16 )uc;
+          if( uc < 0x80 ) {
+            break;
+          }
+        } else if( capacity - n >= 2 ) {
+          out[ n++ ] = UTF_HIGH_SURROGATE( uc );
+          out[ n++ ] = UTF_LOW_SURROGATE( uc );
+        } else {
+          /* No room for the surrogate pair */
+          p = start;
+          capacity = n;
+        }
+      }
+    }
+  }
+  if( next ) {
+    *next = ( const char * )p;
+  }
+  return n;
+}
+
+WEBVTT_EXPORT webvtt_uint
+webvtt_utf8_to_utf32_buffer( const char *utf8, const char *end,
+                             webvtt_uint32 *out, webvtt_uint capacity,
+                             const char **next )
+{
+  const unsigned char *p = ( const unsigned char * )utf8;
+  const unsigned char *e = ( const unsigned char * )end;
+  webvtt_uint n = 0;
+
+  if( p && out && e ) {
+    while( p < e && n < capacity ) {
+      size_t run = ascii_run( p, ( size_t )( e - p ) < capacity - n
+                                 ? ( size_t )( e - p ) : capacity - n );
+      size_t i = 0;
+#if UTF8_SSE2
+      const __m128i zero = _mm_setzero_si128();
+      for( ; i < run; i += 16 ) {
+        __m128i v = _mm_loadu_si128( ( const __m128i * )( p + i ) );
+        __m128i lo = _mm_unpacklo_epi8( v, zero );
+        __m128i hi = _mm_unpackhi_epi8( v, zero );
+        _mm_storeu_si128( ( __m128i * )( out + n + i ),
+                          _mm_unpacklo_epi16( lo, zero ) );
+        _mm_storeu_si128( ( __m128i * )( out + n + i + 4 ),
+                          _mm_unpackhi_epi16( lo, zero ) );
+        _mm_storeu_si128( ( __m128i * )( out + n + i + 8 ),
+                          _mm_unpacklo_epi16( hi, zero ) );
+        _mm_storeu_si128( ( __m128i * )( out + n + i + 12 ),
+                          _mm_unpackhi_epi16( hi, zero ) );
+      }
+#else
+      for( ; i < run; ++i ) {
+        out[ n + i ] = p[ i ];
+      }
+#endif
+      p += run;
+      n += ( webvtt_uint )run;
+
+      while( p < e && n < capacity ) {
+        webvtt_uint32 uc = displayable( decode_utf8( &p, e ) );
+        out[ n++ ] = uc;
+        if( uc < 0x80 ) {
+          break;
+        }
+      }
+    }
+  }
+  if( next ) {
+    *next = ( const char * )p;
+  }
+  return n;
+}
+
+WEBVTT_EXPORT webvtt_uint
+webvtt_utf8_utf16_length( const char *utf8, const char *end )
+{
+  const unsigned char *p = ( const unsigned char * )utf8;
+  const unsigned char *e = ( const unsigned char * )end;
+  webvtt_uint n = 0;
+  if( !p || !e ) {
+    return 0;
+  }
+  while( p < e ) {
+    size_t run = ascii_run( p, ( size_t )( e - p ) );
+    p += run;
+    n += ( webvtt_uint )run;
+    while( p < e ) {
+      webvtt_uint32 uc = displayable( decode_utf8( &p, e ) );
+      n += uc < 0x10000 ? 1 : 2;
+      if( uc < 0x80 ) {
+        break;
+      }
+    }
+  }
+  return n;
+}
+
+WEBVTT_EXPORT const char *
+webvtt_utf8_validate( const char *utf8, const char *end )
+{
+  const unsigned char *p = ( const unsigned char * )utf8;
+  const unsigned char *e = ( const unsigned char * )end;
+  if( !p || !e ) {
+    return end;
+  }
+  while( p < e ) {
+    p += ascii_run( p, ( size_t )( e - p ) );
+    while( p < e ) {
+      const unsigned char *start = p;
+      webvtt_uint32 uc = decode_utf8( &p, e );
+      if( uc == UTF8_MALFORMED ) {
+        return ( const char * )start;
+      } else if( uc < 0x80 ) {
+        break;
+      }
+    }
+  }
+  return end;
+}
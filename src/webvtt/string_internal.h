@@ -69,6 +69,19 @@ webvtt_string_data_t {
   char array[1];
 };
 
+WEBVTT_INTERN void
+webvtt_string_clear( webvtt_string *str );
+
+WEBVTT_INTERN void
+webvtt_string_truncate( webvtt_string *str, webvtt_uint length );
+
+/**
+ * Return a pointer to the first CR or LF character in [begin, end), or 'end'
+ * if there is none.
+ */
+WEBVTT_INTERN const char *
+webvtt_find_eol( const char *begin, const char *end );
+
 static __WEBVTT_STRING_INLINE  int
 webvtt_isalpha( char ch )
 {
@@ -0,0 +1,735 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <string.h>
+#include "parser_internal.h"
+#include "style_internal.h"
+
+/**
+ * A small subset of CSS: each rule is a list of '::cue' selectors and a block
+ * of declarations. Supported selectors are
+ *
+ *   ::cue                 the cue as a whole (its head node)
+ *   ::cue(compound)       nodes matching 'compound', which is an optional
+ *                         tag name (c, i, b, u, ruby, rt, v, lang or *)
+ *                         followed by any of '.class', '[voice="name"]'
+ *                         (or '[voice=name]') and ':lang(tag)'
+ *
+ * Rules with other selectors are dropped, as CSS does with rules it cannot
+ * parse.
+ */
+
+#define STYLE_TABLE_MIN (8)
+
+static const struct
+{
+  const char *name;
+  webvtt_uint len;
+  webvtt_node_kind kind;
+} tag_names[] = {
+  { "c", 1, WEBVTT_CLASS },
+  { "i", 1, WEBVTT_ITALIC },
+  { "b", 1, WEBVTT_BOLD },
+  { "u", 1, WEBVTT_UNDERLINE },
+  { "ruby", 4, WEBVTT_RUBY },
+  { "rt", 2, WEBVTT_RUBY_TEXT },
+  { "v", 1, WEBVTT_VOICE },
+  { "lang", 4, WEBVTT_LANG },
+};
+
+WEBVTT_INTERN webvtt_bool
+webvtt_is_style_header( const char *text, webvtt_uint length )
+{
+  return length >= 5 && !memcmp( text, "STYLE", 5 )
+         && ( length == 5 || webvtt_isspace( text[ 5 ] ) );
+}
+
+/**
+ * Make room for 'need' items of 'size' bytes in '*parray'
+ */
+static webvtt_status
+grow( void **parray, webvtt_uint *palloc, webvtt_uint need, webvtt_uint size )
+{
+  webvtt_uint alloc = *palloc ? *palloc : STYLE_TABLE_MIN;
+  void *array;
+  if( need <= *palloc ) {
+    return WEBVTT_SUCCESS;
+  }
+  while( alloc < need ) {
+    alloc *= 2;
+  }
+  if( !( array = webvtt_alloc( alloc * size ) ) ) {
+    return WEBVTT_OUT_OF_MEMORY;
+  }
+  if( *palloc ) {
+    memcpy( array, *parray, *palloc * size );
+  }
+  webvtt_free( *parray );
+  *parray = array;
+  *palloc = alloc;
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Find the id of a symbol, or -1
+ */
+static int
+find_symbol( const webvtt_style_sheet *sheet, const char *text,
+             webvtt_uint len )
+{
+  webvtt_uint i;
+  for( i = 0; i < sheet->nsymbols; ++i ) {
+    if( webvtt_string_length( sheet->symbols + i ) == len
+        && !memcmp( webvtt_string_text( sheet->symbols + i ), text, len ) ) {
+      return ( int )i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Find or add a symbol. Returns -1 if there is no room for it.
+ */
+static int
+intern_symbol( webvtt_style_sheet *sheet, const char *text, webvtt_uint len )
+{
+  int id = find_symbol( sheet, text, len );
+  if( id >= 0 ) {
+    return id;
+  }
+  if( sheet->nsymbols == MAX_STYLE_SYMBOLS
+      || WEBVTT_FAILED( webvtt_create_string_with_text( sheet->symbols
+                                                        + sheet->nsymbols,
+                                                        text, len ) ) ) {
+    return -1;
+  }
+  return ( int )sheet->nsymbols++;
+}
+
+static webvtt_bool
+is_ident_char( char c )
+{
+  return webvtt_isalphanum( c ) || c == '-' || c == '_' || ( c & 0x80 );
+}
+
+static const char *
+skip_space( const char *p, const char *end )
+{
+  while( p < end && webvtt_isspace( *p ) ) {
+    ++p;
+  }
+  return p;
+}
+
+static const char *
+scan_ident( const char *p, const char *end )
+{
+  while( p < end && is_ident_char( *p ) ) {
+    ++p;
+  }
+  return p;
+}
+
+/**
+ * Compile one selector, 'p' to 'end' with surrounding whitespace removed.
+ * Returns 0 if it is malformed or unsupported.
+ */
+static int
+compile_selector( webvtt_style_sheet *sheet, const char *p, const char *end,
+                  webvtt_style_rule *rule )
+{
+  const char *word;
+  int id;
+
+  rule->kind = WEBVTT_HEAD_NODE;
+  rule->classes = 0;
+  rule->voice = rule->lang = -1;
+
+  if( end - p < 5 || memcmp( p, "::cue", 5 ) ) {
+    return 0;
+  }
+  p += 5;
+  if( p == end ) {
+    return 1;
+  }
+  if( *p != '(' || end[ -1 ] != ')' ) {
+    return 0;
+  }
+  p = skip_space( p + 1, --end );
+  while( end > p && webvtt_isspace( end[ -1 ] ) ) {
+    --end;
+  }
+  if( p == end ) {
+    return 0;
+  }
+
+  /* Tag name */
+  rule->kind = STYLE_ANY_KIND;
+  if( *p == '*' ) {
+    ++p;
+  } else if( ( word = scan_ident( p, end ) ) != p ) {
+    webvtt_uint i, len = ( webvtt_uint )( word - p );
+    for( i = 0; i < sizeof( tag_names ) / sizeof( *tag_names ); ++i ) {
+      if( tag_names[ i ].len == len && !memcmp( tag_names[ i ].name, p, len ) ) {
+        rule->kind = tag_names[ i ].kind;
+        break;
+      }
+    }
+    if( rule->kind == STYLE_ANY_KIND ) {
+      return 0;
+    }
+    p = word;
+  }
+
+  while( p < end ) {
+    if( *p == '.' ) {
+      word = scan_ident( ++p, end );
+      if( word == p
+          || ( id = intern_symbol( sheet, p, ( webvtt_uint )( word - p ) ) )
+             < 0 ) {
+        return 0;
+      }
+      rule->classes |= ( webvtt_uint64 )1 << id;
+      p = word;
+    } else if( *p == '[' ) {
+      /* [voice="name"], [voice='name'] or [voice=name] */
+      const char *value;
+      p = skip_space( p + 1, end );
+      if( end - p < 5 || memcmp( p, "voice", 5 ) ) {
+        return 0;
+      }
+      p = skip_space( p + 5, end );
+      if( p == end || *p++ != '=' ) {
+        return 0;
+      }
+      p = skip_space( p, end );
+      if( p < end && ( *p == '"' || *p == '\'' ) ) {
+        char quote = *p++;
+        value = p;
+        while( p < end && *p != quote ) {
+          ++p;
+        }
+        if( p == end ) {
+          return 0;
+        }
+        word = p++;
+      } else {
+        value = p;
+        word = p = scan_ident( p, end );
+      }
+      p = skip_space( p, end );
+      if( p == end || *p++ != ']' || word == value ) {
+        return 0;
+      }
+      if( rule->kind == STYLE_ANY_KIND ) {
+        rule->kind = WEBVTT_VOICE;
+      }
+      if( rule->kind != WEBVTT_VOICE
+          || ( rule->voice = intern_symbol( sheet, value,
+                                            ( webvtt_uint )( word - value ) ) )
+             < 0 ) {
+        return 0;
+      }
+    } else if( end - p > 6 && !memcmp( p, ":lang(", 6 ) ) {
+      p = skip_space( p + 6, end );
+      word = scan_ident( p, end );
+      if( word == p || ( rule->lang = intern_symbol( sheet, p,
+                                                     ( webvtt_uint )( word
+                                                                      - p ) ) )
+                       < 0 ) {
+        return 0;
+      }
+      p = skip_space( word, end );
+      if( p == end || *p++ != ')' ) {
+        return 0;
+      }
+    } else {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * Find 'c' in 'p' to 'end', skipping over quoted strings. Returns 'end' if it
+ * is not found.
+ */
+static const char *
+find_char( const char *p, const char *end, char c )
+{
+  while( p < end && *p != c ) {
+    if( *p == '"' || *p == '\'' ) {
+      char quote = *p++;
+      while( p < end && *p != quote ) {
+        ++p;
+      }
+      if( p == end ) {
+        break;
+      }
+    }
+    ++p;
+  }
+  return p;
+}
+
+/**
+ * Add the declarations of a block ('p' to 'end') to the style sheet
+ */
+static webvtt_status
+compile_declarations( webvtt_style_sheet *sheet, const char *p,
+                      const char *end )
+{
+  while( p < end ) {
+    const char *semi = find_char( p, end, ';' );
+    const char *colon = find_char( p, semi, ':' );
+    const char *name_end = colon, *value = colon + 1, *value_end = semi;
+    p = skip_space( p, colon );
+    while( name_end > p && webvtt_isspace( name_end[ -1 ] ) ) {
+      --name_end;
+    }
+    if( colon < semi ) {
+      value = skip_space( value, semi );
+      while( value_end > value && webvtt_isspace( value_end[ -1 ] ) ) {
+        --value_end;
+      }
+    }
+    /* Declarations without a name or value are ignored, as in CSS */
+    if( colon < semi && name_end > p && value_end > value ) {
+      webvtt_declaration *decl;
+      if( WEBVTT_FAILED( grow( ( void ** )&sheet->declarations,
+                               &sheet->declarations_alloc,
+                               sheet->ndeclarations + 1,
+                               sizeof *sheet->declarations ) ) ) {
+        return WEBVTT_OUT_OF_MEMORY;
+      }
+      decl = sheet->declarations + sheet->ndeclarations;
+      if( WEBVTT_FAILED( webvtt_create_string_with_text( &decl->property, p,
+                                                         ( int )( name_end
+                                                                  - p ) ) ) ) {
+        return WEBVTT_OUT_OF_MEMORY;
+      }
+      if( WEBVTT_FAILED( webvtt_create_string_with_text( &decl->value, value,
+                                                         ( int )( value_end
+                                                                  - value ) ) ) ) {
+        webvtt_release_string( &decl->property );
+        return WEBVTT_OUT_OF_MEMORY;
+      }
+      ++sheet->ndeclarations;
+    }
+    p = semi + ( semi < end );
+  }
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Report an error at 'p' in the STYLE block
+ */
+static int
+style_error( webvtt_parser self, const char *text, const char *p,
+             webvtt_error error )
+{
+  webvtt_uint line = self->style_line;
+  const char *line_start = text;
+  const char *c;
+  for( c = text; c < p; ++c ) {
+    if( *c == '\n' ) {
+      ++line;
+      line_start = c + 1;
+    }
+  }
+  ERROR_AT_OR( error, line, ( webvtt_uint )( p - line_start ) + 1, -1 );
+  return 0;
+}
+
+/**
+ * Skip whitespace and comments
+ */
+static const char *
+skip_space_and_comments( const char *p, const char *end )
+{
+  for( ;; ) {
+    p = skip_space( p, end );
+    if( end - p >= 2 && p[ 0 ] == '/' && p[ 1 ] == '*' ) {
+      for( p += 2; p < end && !( p[ 0 ] == '*' && p + 1 < end && p[ 1 ] == '/' );
+           ++p ) {
+      }
+      p = p < end ? p + 2 : end;
+    } else {
+      return p;
+    }
+  }
+}
+
+WEBVTT_INTERN webvtt_status
+webvtt_compile_style( webvtt_parser self )
+{
+  webvtt_style_sheet *sheet = &self->styles;
+  const char *text = webvtt_string_text( &self->style_text );
+  const char *end = text + webvtt_string_length( &self->style_text );
+  const char *p = text;
+
+  while( ( p = skip_space_and_comments( p, end ) ) < end ) {
+    const char *open = find_char( p, end, '{' );
+    const char *close = find_char( open, end, '}' );
+    const char *selector = p;
+    webvtt_uint first_rule = sheet->nrules;
+    webvtt_uint first_declaration = sheet->ndeclarations;
+    webvtt_uint i;
+    int ok = 1;
+
+    if( open == end ) {
+      if( style_error( self, text, p, WEBVTT_INVALID_STYLE_RULE ) < 0 ) {
+        return WEBVTT_PARSE_ERROR;
+      }
+      break;
+    }
+
+    /* Compile each selector in the comma-separated list */
+    while( ok && selector < open ) {
+      const char *comma = find_char( selector, open, ',' );
+      const char *selector_end = comma;
+      selector = skip_space_and_comments( selector, comma );
+      while( selector_end > selector && webvtt_isspace( selector_end[ -1 ] ) ) {
+        --selector_end;
+      }
+      if( WEBVTT_FAILED( grow( ( void ** )&sheet->rules, &sheet->rules_alloc,
+                               sheet->nrules + 1, sizeof *sheet->rules ) ) ) {
+        ERROR_AT( WEBVTT_ALLOCATION_FAILED, self->style_line, 1 );
+        return WEBVTT_OUT_OF_MEMORY;
+      }
+      if( !( ok = compile_selector( sheet, selector, selector_end,
+                                    sheet->rules + sheet->nrules ) ) ) {
+        break;
+      }
+      ++sheet->nrules;
+      selector = comma + 1;
+    }
+
+    if( !ok || selector == p ) {
+      /* Drop the whole rule */
+      sheet->nrules = first_rule;
+      if( style_error( self, text, p, WEBVTT_INVALID_STYLE_RULE ) < 0 ) {
+        return WEBVTT_PARSE_ERROR;
+      }
+    } else if( WEBVTT_FAILED( compile_declarations( sheet, open + 1,
+                                                    close ) ) ) {
+      sheet->nrules = first_rule;
+      ERROR_AT( WEBVTT_ALLOCATION_FAILED, self->style_line, 1 );
+      return WEBVTT_OUT_OF_MEMORY;
+    }
+
+    for( i = first_rule; i < sheet->nrules; ++i ) {
+      sheet->rules[ i ].first = first_declaration;
+      sheet->rules[ i ].count = sheet->ndeclarations - first_declaration;
+    }
+    p = close + ( close < end );
+  }
+  return WEBVTT_SUCCESS;
+}
+
+static int
+rule_matches( const webvtt_style_rule *rule, const webvtt_resolved_style *node )
+{
+  if( rule->kind == STYLE_ANY_KIND ) {
+    if( node->kind == WEBVTT_HEAD_NODE ) {
+      return 0;
+    }
+  } else if( rule->kind != node->kind ) {
+    return 0;
+  }
+  return ( rule->classes & ~node->classes ) == 0
+         && ( rule->voice < 0 || rule->voice == node->voice )
+         && ( rule->lang < 0 || rule->lang == node->lang );
+}
+
+static webvtt_uint
+hash_style( const webvtt_resolved_style *key )
+{
+  webvtt_uint h = ( webvtt_uint )key->classes
+                  ^ ( webvtt_uint )( key->classes >> 32 );
+  h = ( h ^ ( webvtt_uint )key->kind ) * 0x9E3779B1u;
+  h = ( h ^ ( webvtt_uint )key->voice ) * 0x9E3779B1u;
+  h = ( h ^ ( webvtt_uint )key->lang ) * 0x9E3779B1u;
+  return h ^ ( h >> 16 );
+}
+
+/**
+ * Make room in the hash for one more style, keeping it at most half full
+ */
+static webvtt_status
+grow_buckets( webvtt_style_sheet *sheet )
+{
+  webvtt_uint n, i, *buckets;
+  if( ( sheet->nresolved + 1 ) * 2 <= sheet->nbuckets ) {
+    return WEBVTT_SUCCESS;
+  }
+  n = sheet->nbuckets ? sheet->nbuckets * 2 : STYLE_TABLE_MIN * 2;
+  if( !( buckets = ( webvtt_uint * )webvtt_alloc0( n * sizeof *buckets ) ) ) {
+    return WEBVTT_OUT_OF_MEMORY;
+  }
+  for( i = 0; i < sheet->nresolved; ++i ) {
+    webvtt_uint b = hash_style( sheet->resolved + i ) & ( n - 1 );
+    while( buckets[ b ] ) {
+      b = ( b + 1 ) & ( n - 1 );
+    }
+    buckets[ b ] = i + 1;
+  }
+  webvtt_free( sheet->buckets );
+  sheet->buckets = buckets;
+  sheet->nbuckets = n;
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Find the style for nodes like 'key', adding it to the table if this is the
+ * first such node. '*pstyle' is NULL if no rule applies to them.
+ */
+static webvtt_status
+find_style( webvtt_style_sheet *sheet, const webvtt_resolved_style *key,
+            const webvtt_style **pstyle )
+{
+  webvtt_resolved_style *resolved;
+  webvtt_style *style = 0;
+  webvtt_uint i, b, n = 0;
+
+  if( WEBVTT_FAILED( grow_buckets( sheet ) ) ) {
+    return WEBVTT_OUT_OF_MEMORY;
+  }
+  for( b = hash_style( key ) & ( sheet->nbuckets - 1 ); sheet->buckets[ b ];
+       b = ( b + 1 ) & ( sheet->nbuckets - 1 ) ) {
+    resolved = sheet->resolved + sheet->buckets[ b ] - 1;
+    if( resolved->kind == key->kind && resolved->classes == key->classes
+        && resolved->voice == key->voice && resolved->lang == key->lang ) {
+      *pstyle = resolved->style;
+      return WEBVTT_SUCCESS;
+    }
+  }
+
+  if( WEBVTT_FAILED( grow( ( void ** )&sheet->resolved, &sheet->resolved_alloc,
+                           sheet->nresolved + 1, sizeof *sheet->resolved ) ) ) {
+    return WEBVTT_OUT_OF_MEMORY;
+  }
+
+  for( i = 0; i < sheet->nrules; ++i ) {
+    if( rule_matches( sheet->rules + i, key ) ) {
+      n += sheet->rules[ i ].count;
+    }
+  }
+  if( n ) {
+    webvtt_declaration *decl;
+    /* The declarations follow the style in the same block */
+    if( !( style = ( webvtt_style * )webvtt_alloc( sizeof *style
+                                                   + n * sizeof *decl ) ) ) {
+      return WEBVTT_OUT_OF_MEMORY;
+    }
+    style->refs.value = 1;
+    style->declarations = decl = ( webvtt_declaration * )( style + 1 );
+    style->count = n;
+    for( i = 0; i < sheet->nrules; ++i ) {
+      const webvtt_style_rule *rule = sheet->rules + i;
+      webvtt_uint j;
+      if( !rule_matches( rule, key ) ) {
+        continue;
+      }
+      for( j = 0; j < rule->count; ++j, ++decl ) {
+        webvtt_copy_string( &decl->property,
+                            &sheet->declarations[ rule->first + j ].property );
+        webvtt_copy_string( &decl->value,
+                            &sheet->declarations[ rule->first + j ].value );
+      }
+    }
+  }
+
+  resolved = sheet->resolved + sheet->nresolved++;
+  *resolved = *key;
+  resolved->style = style;
+  sheet->buckets[ b ] = sheet->nresolved;
+  *pstyle = style;
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Set the style of 'node', whose parent's language is 'lang', and store the
+ * language its children inherit in '*plang'
+ */
+static webvtt_status
+resolve_node( webvtt_style_sheet *sheet, webvtt_node *node, int lang,
+              int *plang )
+{
+  webvtt_internal_node_data *data = node->data.internal_data;
+  webvtt_resolved_style key;
+  webvtt_status status;
+  webvtt_uint i;
+
+  key.kind = node->kind;
+  key.classes = 0;
+  key.voice = -1;
+  if( data->css_classes ) {
+    for( i = 0; i < data->css_classes->length; ++i ) {
+      const webvtt_string *name = data->css_classes->items + i;
+      int id = find_symbol( sheet, webvtt_string_text( name ),
+                            webvtt_string_length( name ) );
+      if( id >= 0 ) {
+        key.classes |= ( webvtt_uint64 )1 << id;
+      }
+    }
+  }
+  if( node->kind == WEBVTT_VOICE ) {
+    key.voice = find_symbol( sheet, webvtt_string_text( &data->annotation ),
+                             webvtt_string_length( &data->annotation ) );
+  } else if( node->kind == WEBVTT_LANG ) {
+    lang = find_symbol( sheet, webvtt_string_text( &data->lang ),
+                        webvtt_string_length( &data->lang ) );
+  }
+  key.lang = *plang = lang;
+
+  webvtt_release_style( &data->style );
+  if( WEBVTT_FAILED( status = find_style( sheet, &key, &data->style ) ) ) {
+    return status;
+  }
+  webvtt_ref_style( data->style );
+  return WEBVTT_SUCCESS;
+}
+
+WEBVTT_INTERN webvtt_status
+webvtt_resolve_styles( webvtt_parser self, webvtt_node *head )
+{
+  webvtt_style_sheet *sheet = &self->styles;
+  webvtt_node *node = head;
+  webvtt_uint depth = 0;
+  int lang = -1;
+
+  if( !sheet->nrules ) {
+    return WEBVTT_SUCCESS;
+  }
+  /* Walk the tree depth first, resolving each internal node before its
+     children */
+  for( ;; ) {
+    if( node && !WEBVTT_IS_LEAF( node->kind ) && node->data.internal_data ) {
+      webvtt_style_frame *frame;
+      if( WEBVTT_FAILED( resolve_node( sheet, node, lang, &lang ) )
+          || WEBVTT_FAILED( grow( ( void ** )&sheet->walk, &sheet->walk_alloc,
+                                  depth + 1, sizeof *sheet->walk ) ) ) {
+        return WEBVTT_OUT_OF_MEMORY;
+      }
+      frame = sheet->walk + depth++;
+      frame->node = node;
+      frame->lang = lang;
+      frame->next = 0;
+    }
+    for( node = 0; depth && !node; ) {
+      webvtt_style_frame *frame = sheet->walk + depth - 1;
+      webvtt_internal_node_data *data = frame->node->data.internal_data;
+      if( frame->next < data->length ) {
+        node = data->children[ frame->next++ ];
+        lang = frame->lang;
+      } else {
+        --depth;
+      }
+    }
+    if( !node ) {
+      return WEBVTT_SUCCESS;
+    }
+  }
+}
+
+WEBVTT_INTERN void
+webvtt_clear_styles( webvtt_parser self, webvtt_bool release )
+{
+  webvtt_style_sheet *sheet = &self->styles;
+  webvtt_uint i;
+  for( i = 0; i < sheet->nsymbols; ++i ) {
+    webvtt_release_string( sheet->symbols + i );
+  }
+  for( i = 0; i < sheet->ndeclarations; ++i ) {
+    webvtt_release_string( &sheet->declarations[ i ].property );
+    webvtt_release_string( &sheet->declarations[ i ].value );
+  }
+  for( i = 0; i < sheet->nresolved; ++i ) {
+    webvtt_release_style( ( const webvtt_style ** )&sheet->resolved[ i ].style );
+  }
+  if( sheet->nresolved ) {
+    memset( sheet->buckets, 0, sheet->nbuckets * sizeof *sheet->buckets );
+  }
+  sheet->nsymbols = sheet->nrules = sheet->ndeclarations = 0;
+  sheet->nresolved = 0;
+  if( release ) {
+    webvtt_free( sheet->rules );
+    webvtt_free( sheet->declarations );
+    webvtt_free( sheet->resolved );
+    sheet->rules = 0;
+    sheet->declarations = 0;
+    sheet->resolved = 0;
+    sheet->rules_alloc = sheet->declarations_alloc = 0;
+    sheet->resolved_alloc = 0;
+    webvtt_free( sheet->buckets );
+    webvtt_free( sheet->walk );
+    sheet->buckets = 0;
+    sheet->walk = 0;
+    sheet->nbuckets = sheet->walk_alloc = 0;
+  }
+}
+
+WEBVTT_EXPORT webvtt_uint
+webvtt_get_node_style( const webvtt_node *node,
+                       const webvtt_declaration **pdeclarations )
+{
+  const webvtt_style *style;
+  if( !node || !pdeclarations || WEBVTT_IS_LEAF( node->kind )
+      || !node->data.internal_data
+      || !( style = node->data.internal_data->style ) ) {
+    return 0;
+  }
+  *pdeclarations = style->declarations;
+  return style->count;
+}
+
+WEBVTT_EXPORT void
+webvtt_ref_style( const webvtt_style *style )
+{
+  if( style ) {
+    webvtt_ref( &( ( webvtt_style * )style )->refs );
+  }
+}
+
+WEBVTT_EXPORT void
+webvtt_release_style( const webvtt_style **pstyle )
+{
+  if( pstyle && *pstyle ) {
+    webvtt_style *style = ( webvtt_style * )*pstyle;
+    *pstyle = 0;
+    if( webvtt_deref( &style->refs ) == 0 ) {
+      webvtt_uint i;
+      for( i = 0; i < style->count; ++i ) {
+        webvtt_release_string( &style->declarations[ i ].property );
+        webvtt_release_string( &style->declarations[ i ].value );
+      }
+      webvtt_free( style );
+    }
+  }
+}
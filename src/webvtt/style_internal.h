@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __INTERN_STYLE_H__
+# define __INTERN_STYLE_H__
+# include <webvtt/style.h>
+# include <webvtt/parser.h>
+
+/**
+ * Class names, voices and languages named by selectors are interned, and
+ * the classes a selector requires are a bitset of their ids.
+ */
+#define MAX_STYLE_SYMBOLS (64)
+
+/**
+ * A compiled selector, and the declarations of its rule. 'kind' is a node
+ * kind, or STYLE_ANY_KIND for any node in the cue text. 'voice' and 'lang'
+ * are symbol ids, or -1 if the selector does not care.
+ */
+#define STYLE_ANY_KIND (-1)
+
+typedef struct
+webvtt_style_rule_t {
+  int kind;
+  webvtt_uint64 classes;
+  int voice;
+  int lang;
+  webvtt_uint first;
+  webvtt_uint count;
+} webvtt_style_rule;
+
+/**
+ * The style of nodes of one kind, with one set of classes, voice and language
+ * (as symbol ids, so that nodes which only differ in names which no selector
+ * uses share a style). 'style' is NULL if no rule applies to them.
+ */
+typedef struct
+webvtt_resolved_style_t {
+  int kind;
+  webvtt_uint64 classes;
+  int voice;
+  int lang;
+  webvtt_style *style;
+} webvtt_resolved_style;
+
+/**
+ * A node whose children are being resolved, and the language they inherit
+ */
+typedef struct
+webvtt_style_frame_t {
+  webvtt_node *node;
+  int lang;
+  webvtt_uint next;
+} webvtt_style_frame;
+
+typedef struct
+webvtt_style_sheet_t {
+  webvtt_string symbols[ MAX_STYLE_SYMBOLS ];
+  webvtt_uint nsymbols;
+
+  webvtt_style_rule *rules;
+  webvtt_uint nrules;
+  webvtt_uint rules_alloc;
+
+  webvtt_declaration *declarations;
+  webvtt_uint ndeclarations;
+  webvtt_uint declarations_alloc;
+
+  webvtt_resolved_style *resolved;
+  webvtt_uint nresolved;
+  webvtt_uint resolved_alloc;
+
+  /**
+   * Open-addressed hash of 'resolved' by key. Each bucket holds an index
+   * into 'resolved' plus one, or 0 if it is empty.
+   */
+  webvtt_uint *buckets;
+  webvtt_uint nbuckets;
+
+  /**
+   * Stack of nodes being walked by webvtt_resolve_styles, so that deeply
+   * nested cue text cannot exhaust the C stack
+   */
+  webvtt_style_frame *walk;
+  webvtt_uint walk_alloc;
+} webvtt_style_sheet;
+
+/**
+ * Return non-zero if a line starts a STYLE block: it is "STYLE", possibly
+ * followed by whitespace and other text.
+ */
+WEBVTT_INTERN webvtt_bool
+webvtt_is_style_header( const char *text, webvtt_uint length );
+
+/**
+ * Compile the STYLE block collected in the parser's 'style_text', whose first
+ * line is 'style_line', adding its rules to the parser's style sheet.
+ * Returns WEBVTT_PARSE_ERROR if the application asked to stop after an error.
+ */
+WEBVTT_INTERN webvtt_status
+webvtt_compile_style( webvtt_parser self );
+
+/**
+ * Set the style of every node in the tree under 'head'
+ */
+WEBVTT_INTERN webvtt_status
+webvtt_resolve_styles( webvtt_parser self, webvtt_node *head );
+
+/**
+ * Empty the style sheet, releasing its references to resolved styles. If
+ * 'release' is non-zero, its storage is freed as well.
+ */
+WEBVTT_INTERN void
+webvtt_clear_styles( webvtt_parser self, webvtt_bool release );
+
+#endif
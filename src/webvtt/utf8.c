@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <string.h>
+#include "parser_internal.h"
+#include "utf8_internal.h"
+
+/* UTF8 encoding of U+FFFD REPLACEMENT CHAR */
+static const char replacement[] = { 0xEF, 0xBF, 0xBD };
+
+WEBVTT_EXPORT webvtt_status
+webvtt_set_utf8_mode( webvtt_parser self, webvtt_utf8_mode mode )
+{
+  if( !self || (int)mode < (int)WEBVTT_UTF8_TRUST
+      || (int)mode > (int)WEBVTT_UTF8_REPAIR ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  self->utf8_mode = mode;
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Move the input position past the 'len' bytes at 'b'. Words with no byte
+ * below 0x0E, and so no '\r' or '\n', are skipped eight bytes at a time.
+ */
+static void
+advance( webvtt_parser self, const char *b, webvtt_uint len )
+{
+  const char *e = b + len;
+  while( b < e ) {
+    if( e - b >= 8 ) {
+      webvtt_uint64 w;
+      memcpy( &w, b, 8 );
+      if( !( ( w - 0x0E0E0E0E0E0E0E0EULL ) & ~w & 0x8080808080808080ULL ) ) {
+        self->utf8_column += 8;
+        self->utf8_cr = 0;
+        b += 8;
+        continue;
+      }
+    }
+    if( *b == '\r' ) {
+      ++self->utf8_line;
+      self->utf8_column = 1;
+      self->utf8_cr = 1;
+    } else if( *b == '\n' ) {
+      if( !self->utf8_cr ) {
+        ++self->utf8_line;
+      }
+      self->utf8_column = 1;
+      self->utf8_cr = 0;
+    } else {
+      ++self->utf8_column;
+      self->utf8_cr = 0;
+    }
+    ++b;
+  }
+}
+
+/**
+ * Return non-zero if the malformed sequence at 'p' is only malformed because
+ * 'end' cuts it off
+ */
+static webvtt_bool
+is_cut_off( const char *p, const char *end )
+{
+  int n = webvtt_utf8_length( p );
+  if( n < 2 || n > 4 || end - p >= n ) {
+    return 0;
+  }
+  while( ++p < end ) {
+    if( ( *p & 0xC0 ) != 0x80 ) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * Check the input from 'b' to 'end', and parse it. Unless 'at_end', a
+ * sequence cut off by 'end' is held back in 'utf8_carry'.
+ */
+static webvtt_status
+check( webvtt_parser self, const char *b, const char *end, webvtt_bool at_end )
+{
+  webvtt_status status;
+  while( b < end ) {
+    const char *bad = webvtt_utf8_validate( b, end );
+    const char *next = bad;
+    if( bad != b ) {
+      advance( self, b, (webvtt_uint)( bad - b ) );
+      if( WEBVTT_FAILED( status = webvtt_parse_input( self, b,
+                                                      (webvtt_uint)( bad - b ) ) ) ) {
+        return status;
+      }
+    }
+    if( bad == end ) {
+      break;
+    }
+    if( !at_end && is_cut_off( bad, end ) ) {
+      self->utf8_carry_len = (webvtt_uint)( end - bad );
+      memcpy( self->utf8_carry, bad, self->utf8_carry_len );
+      break;
+    }
+
+    webvtt_utf8_decode( &next, end );
+    if( self->utf8_mode == WEBVTT_UTF8_REPAIR ) {
+      WARNING_AT( WEBVTT_INVALID_UTF8, self->utf8_line, self->utf8_column );
+      status = webvtt_parse_input( self, replacement, sizeof( replacement ) );
+    } else {
+      ERROR_AT( WEBVTT_INVALID_UTF8, self->utf8_line, self->utf8_column );
+      status = webvtt_parse_input( self, bad, (webvtt_uint)( next - bad ) );
+    }
+    if( WEBVTT_FAILED( status ) ) {
+      return status;
+    }
+    /* A malformed sequence is all bytes above 0x7F, so never a newline */
+    self->utf8_column += (webvtt_uint)( next - bad );
+    self->utf8_cr = 0;
+    b = next;
+  }
+  return WEBVTT_SUCCESS;
+}
+
+WEBVTT_INTERN webvtt_status
+webvtt_parse_utf8( webvtt_parser self, const char *buffer, webvtt_uint len )
+{
+  const char *b = buffer;
+  const char *end = buffer + len;
+  webvtt_status status;
+
+  if( self->utf8_carry_len ) {
+    /**
+     * Finish the sequence held back from the last chunk with the trail bytes
+     * at the start of this one, and check it on its own
+     */
+    char seq[ 4 ];
+    webvtt_uint n = self->utf8_carry_len;
+    webvtt_uint need = (webvtt_uint)webvtt_utf8_length( self->utf8_carry );
+    memcpy( seq, self->utf8_carry, n );
+    if( need > sizeof( seq ) ) {
+      need = sizeof( seq );
+    }
+    while( n < need && b < end && ( *b & 0xC0 ) == 0x80 ) {
+      seq[ n++ ] = *b++;
+    }
+    self->utf8_carry_len = 0;
+    if( WEBVTT_FAILED( status = check( self, seq, seq + n, b < end ) ) ) {
+      return status;
+    }
+  }
+  return check( self, b, end, 0 );
+}
+
+WEBVTT_INTERN webvtt_status
+webvtt_finish_utf8( webvtt_parser self )
+{
+  char seq[ 4 ];
+  webvtt_uint n = self->utf8_carry_len;
+  if( !n ) {
+    return WEBVTT_SUCCESS;
+  }
+  memcpy( seq, self->utf8_carry, n );
+  self->utf8_carry_len = 0;
+  return check( self, seq, seq + n, 1 );
+}
@@ -0,0 +1,433 @@
+/**
+ * Copyright (c) 2013 Mozilla Foundation and Contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *  - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <webvtt/writer.h>
+#include "string_internal.h"
+#include "srt_internal.h"
+#include <string.h>
+
+#define MSECS_PER_HOUR (3600000)
+#define MSECS_PER_MINUTE (60000)
+#define MSECS_PER_SECOND (1000)
+
+struct
+webvtt_writer_t {
+  webvtt_output_format format;
+  webvtt_write_fn write;
+  void *userdata;
+  webvtt_uint count; /* number of cues written */
+
+  /**
+   * Output staging buffer. Handed to 'write' when full, so memory use does not
+   * grow with the amount of output.
+   */
+  webvtt_uint length;
+  char buffer[0x1000];
+};
+
+#define PUT(Text,Len) \
+do { \
+  if( WEBVTT_FAILED( status = writer_put( self, (Text), (Len) ) ) ) { \
+    return status; \
+  } \
+} while(0)
+
+static webvtt_status
+writer_flush( webvtt_writer self )
+{
+  if( self->length ) {
+    int rv = self->write( self->userdata, self->buffer, self->length );
+    self->length = 0;
+    if( rv < 0 ) {
+      return WEBVTT_UNSUCCESSFUL;
+    }
+  }
+  return WEBVTT_SUCCESS;
+}
+
+static webvtt_status
+writer_put( webvtt_writer self, const char *text, webvtt_uint len )
+{
+  webvtt_status status;
+  while( len ) {
+    webvtt_uint n = sizeof( self->buffer ) - self->length;
+    if( n == 0 ) {
+      if( WEBVTT_FAILED( status = writer_flush( self ) ) ) {
+        return status;
+      }
+      continue;
+    }
+    if( n > len ) {
+      n = len;
+    }
+    memcpy( self->buffer + self->length, text, n );
+    self->length += n;
+    text += n;
+    len -= n;
+  }
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Write the decimal representation of 'value', zero padded to 'width' digits,
+ * into 'out'. Returns the number of bytes written.
+ */
+static webvtt_uint
+format_uint( char *out, webvtt_uint64 value, webvtt_uint width )
+{
+  char tmp[ 20 ];
+  webvtt_uint n = 0, i;
+  do {
+    tmp[ n++ ] = ( char )( '0' + ( value % 10 ) );
+    value /= 10;
+  } while( value );
+  while( n < width ) {
+    tmp[ n++ ] = '0';
+  }
+  for( i = 0; i < n; ++i ) {
+    out[ i ] = tmp[ n - i - 1 ];
+  }
+  return n;
+}
+
+static webvtt_uint
+format_timestamp( char *out, webvtt_timestamp ts, char decimal )
+{
+  webvtt_uint n = format_uint( out, ts / MSECS_PER_HOUR, 2 );
+  out[ n++ ] = ':';
+  n += format_uint( out + n, ( ts % MSECS_PER_HOUR ) / MSECS_PER_MINUTE, 2 );
+  out[ n++ ] = ':';
+  n += format_uint( out + n, ( ts % MSECS_PER_MINUTE ) / MSECS_PER_SECOND, 2 );
+  out[ n++ ] = decimal;
+  n += format_uint( out + n, ts % MSECS_PER_SECOND, 3 );
+  return n;
+}
+
+static webvtt_status
+write_timings( webvtt_writer self, const webvtt_cue *cue, char decimal )
+{
+  webvtt_status status;
+  char line[ 64 ];
+  webvtt_uint n = format_timestamp( line, cue->from, decimal );
+  memcpy( line + n, " --> ", 5 );
+  n += 5;
+  n += format_timestamp( line + n, cue->until, decimal );
+  PUT( line, n );
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Write the cue-settings which differ from their default values.
+ */
+static webvtt_status
+write_vtt_settings( webvtt_writer self, const webvtt_cue *cue )
+{
+  static const char *aligns[] = { "start", "middle", "end", "left", "right" };
+  webvtt_status status;
+  char setting[ 32 ];
+  webvtt_uint n;
+
+  if( cue->settings.vertical == WEBVTT_VERTICAL_LR ) {
+    PUT( " vertical:lr", 12 );
+  } else if( cue->settings.vertical == WEBVTT_VERTICAL_RL ) {
+    PUT( " vertical:rl", 12 );
+  }
+  if( cue->settings.line != ( int )WEBVTT_AUTO ) {
+    int line = cue->settings.line;
+    memcpy( setting, " line:", 6 );
+    n = 6;
+    if( line < 0 ) {
+      setting[ n++ ] = '-';
+      line = -line;
+    }
+    n += format_uint( setting + n, ( webvtt_uint64 )line, 1 );
+    if( !cue->snap_to_lines ) {
+      setting[ n++ ] = '%';
+    }
+    PUT( setting, n );
+  }
+  if( cue->settings.position != 50 ) {
+    memcpy( setting, " position:", 10 );
+    n = 10 + format_uint( setting + 10, cue->settings.position, 1 );
+    setting[ n++ ] = '%';
+    PUT( setting, n );
+  }
+  if( cue->settings.size != 100 ) {
+    memcpy( setting, " size:", 6 );
+    n = 6 + format_uint( setting + 6, cue->settings.size, 1 );
+    setting[ n++ ] = '%';
+    PUT( setting, n );
+  }
+  if( cue->settings.align != WEBVTT_ALIGN_MIDDLE &&
+      ( unsigned )cue->settings.align < sizeof( aligns ) / sizeof( *aligns ) ) {
+    PUT( " align:", 7 );
+    PUT( aligns[ cue->settings.align ],
+         ( webvtt_uint )strlen( aligns[ cue->settings.align ] ) );
+  }
+  return WEBVTT_SUCCESS;
+}
+
+static webvtt_status
+write_vtt_cue( webvtt_writer self, const webvtt_cue *cue )
+{
+  webvtt_status status;
+  if( webvtt_string_length( &cue->id ) ) {
+    PUT( webvtt_string_text( &cue->id ), webvtt_string_length( &cue->id ) );
+    PUT( "\n", 1 );
+  }
+  if( WEBVTT_FAILED( status = write_timings( self, cue, '.' ) ) ||
+      WEBVTT_FAILED( status = write_vtt_settings( self, cue ) ) ) {
+    return status;
+  }
+  PUT( "\n", 1 );
+  if( webvtt_string_length( &cue->body ) ) {
+    PUT( webvtt_string_text( &cue->body ), webvtt_string_length( &cue->body ) );
+    PUT( "\n", 1 );
+  }
+  PUT( "\n", 1 );
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Return the SubRip colour for a class node, if one of its classes is a
+ * WebVTT default colour class.
+ */
+static const char *
+node_color( const webvtt_node *node )
+{
+  const webvtt_stringlist *classes = node->data.internal_data->css_classes;
+  webvtt_uint i;
+  if( classes ) {
+    for( i = 0; i < classes->length; ++i ) {
+      const char *color = webvtt_srt_color_class(
+        webvtt_string_text( classes->items + i ),
+        webvtt_string_length( classes->items + i ) );
+      if( color ) {
+        return color;
+      }
+    }
+  }
+  return 0;
+}
+
+static webvtt_status
+write_srt_node( webvtt_writer self, const webvtt_node *node )
+{
+  webvtt_status status;
+  const char *open = 0, *close = 0;
+  const char *color = 0;
+  webvtt_uint i;
+
+  switch( node->kind ) {
+    case WEBVTT_TEXT:
+      PUT( webvtt_string_text( &node->data.text ),
+           webvtt_string_length( &node->data.text ) );
+      return WEBVTT_SUCCESS;
+    case WEBVTT_BOLD:
+      open = "<b>";
+      close = "</b>";
+      break;
+    case WEBVTT_ITALIC:
+      open = "<i>";
+      close = "</i>";
+      break;
+    case WEBVTT_UNDERLINE:
+      open = "<u>";
+      close = "</u>";
+      break;
+    case WEBVTT_CLASS:
+      if( node->data.internal_data && ( color = node_color( node ) ) ) {
+        close = "</font>";
+      }
+      break;
+    default:
+      break;
+  }
+
+  if( !WEBVTT_IS_VALID_INTERNAL_NODE( node->kind ) ||
+      !node->data.internal_data ) {
+    /* Timestamps have no SubRip equivalent */
+    return WEBVTT_SUCCESS;
+  }
+
+  if( open ) {
+    PUT( open, ( webvtt_uint )strlen( open ) );
+  } else if( color ) {
+    PUT( "<font color=\"", 13 );
+    PUT( color, ( webvtt_uint )strlen( color ) );
+    PUT( "\">", 2 );
+  }
+  for( i = 0; i < node->data.internal_data->length; ++i ) {
+    if( WEBVTT_FAILED( status = write_srt_node( self,
+                         node->data.internal_data->children[ i ] ) ) ) {
+      return status;
+    }
+  }
+  if( close ) {
+    PUT( close, ( webvtt_uint )strlen( close ) );
+  }
+  return WEBVTT_SUCCESS;
+}
+
+/**
+ * Write WebVTT cue text as plain text, for cues which have no node tree:
+ * tags are removed and the basic character references are decoded.
+ */
+static webvtt_status
+write_srt_body( webvtt_writer self, const webvtt_string *body )
+{
+  static const struct {
+    const char *ref;
+    webvtt_uint len;
+    char ch;
+  } refs[] = {
+    { "&amp;", 5, '&' }, { "&lt;", 4, '<' }, { "&gt;", 4, '>' }
+  };
+  webvtt_status status;
+  const char *p = webvtt_string_text( body );
+  const char *end = p + webvtt_string_length( body );
+
+  while( p < end ) {
+    const char *run = p;
+    unsigned i;
+    while( run < end && *run != '<' && *run != '&' ) {
+      ++run;
+    }
+    if( run > p ) {
+      PUT( p, ( webvtt_uint )( run - p ) );
+      p = run;
+      continue;
+    }
+    if( *p == '<' ) {
+      const char *gt = ( const char * )memchr( p, '>', end - p );
+      p = gt ? gt + 1 : end;
+      continue;
+    }
+    for( i = 0; i < sizeof( refs ) / sizeof( *refs ); ++i ) {
+      if( ( webvtt_uint )( end - p ) >= refs[ i ].len &&
+          !memcmp( p, refs[ i ].ref, refs[ i ].len ) ) {
+        break;
+      }
+    }
+    if( i < sizeof( refs ) / sizeof( *refs ) ) {
+      PUT( &refs[ i ].ch, 1 );
+      p += refs[ i ].len;
+    } else {
+      PUT( p++, 1 );
+    }
+  }
+  return WEBVTT_SUCCESS;
+}
+
+static webvtt_status
+write_srt_cue( webvtt_writer self, const webvtt_cue *cue )
+{
+  webvtt_status status;
+  char index[ 24 ];
+  webvtt_uint n = format_uint( index, self->count + 1, 1 );
+  index[ n++ ] = '\n';
+  PUT( index, n );
+  if( WEBVTT_FAILED( status = write_timings( self, cue, ',' ) ) ) {
+    return status;
+  }
+  PUT( "\n", 1 );
+  if( cue->node_head ) {
+    status = write_srt_node( self, cue->node_head );
+  } else {
+    status = write_srt_body( self, &cue->body );
+  }
+  if( WEBVTT_FAILED( status ) ) {
+    return status;
+  }
+  PUT( "\n\n", 2 );
+  return WEBVTT_SUCCESS;
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_create_writer( webvtt_output_format format, webvtt_write_fn on_write,
+                      void *userdata, webvtt_writer *ppout )
+{
+  webvtt_writer p;
+  if( !on_write || !ppout ||
+      ( format != WEBVTT_FORMAT_VTT && format != WEBVTT_FORMAT_SRT ) ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+
+  if( !( p = ( webvtt_writer )webvtt_alloc( sizeof * p ) ) ) {
+    return WEBVTT_OUT_OF_MEMORY;
+  }
+
+  p->format = format;
+  p->write = on_write;
+  p->userdata = userdata;
+  p->count = 0;
+  p->length = 0;
+  if( format == WEBVTT_FORMAT_VTT ) {
+    memcpy( p->buffer, "WEBVTT\n\n", 8 );
+    p->length = 8;
+  }
+  *ppout = p;
+
+  return WEBVTT_SUCCESS;
+}
+
+WEBVTT_EXPORT void
+webvtt_delete_writer( webvtt_writer self )
+{
+  if( self ) {
+    writer_flush( self );
+    webvtt_free( self );
+  }
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_writer_write_cue( webvtt_writer self, const webvtt_cue *cue )
+{
+  webvtt_status status;
+  if( !self || !cue ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+
+  if( self->format == WEBVTT_FORMAT_SRT ) {
+    status = write_srt_cue( self, cue );
+  } else {
+    status = write_vtt_cue( self, cue );
+  }
+  if( !WEBVTT_FAILED( status ) ) {
+    ++self->count;
+  }
+  return status;
+}
+
+WEBVTT_EXPORT webvtt_status
+webvtt_writer_flush( webvtt_writer self )
+{
+  if( !self ) {
+    return WEBVTT_INVALID_PARAM;
+  }
+  return writer_flush( self );
+}
@@ -27,6 +27,7 @@
 
 #include <webvttxx/abstract_parser>
 #include <webvttxx/cue>
+#include "drain_errors.h"
 
 namespace WebVTT
 {
@@ -53,12 +54,111 @@ AbstractParser::finishParsing()
   return webvtt_finish_parsing( parser );
 }
 
+void
+AbstractParser::reset()
+{
+  webvtt_reset_parser( parser );
+}
+
+::webvtt_status
+AbstractParser::collectErrors( uint capacity )
+{
+  return webvtt_collect_errors( parser, capacity );
+}
+
+void
+AbstractParser::suppressError( ::webvtt_error error, bool suppress )
+{
+  webvtt_suppress_error( parser, error, suppress ? 1 : 0 );
+}
+
+::webvtt_status
+AbstractParser::setUtf8Mode( ::webvtt_utf8_mode mode )
+{
+  return webvtt_set_utf8_mode( parser, mode );
+}
+
+::webvtt_status
+AbstractParser::setLimits( const ::webvtt_limits &limits )
+{
+  return webvtt_set_limits( parser, &limits );
+}
+
+::webvtt_limits
+AbstractParser::limits() const
+{
+  ::webvtt_limits result;
+  webvtt_get_limits( parser, &result );
+  return result;
+}
+
+uint
+AbstractParser::drainErrors( std::vector<Error> &errors )
+{
+  return WebVTT::drainErrors( parser, errors );
+}
+
+uint
+AbstractParser::errorCount( ::webvtt_error error ) const
+{
+  return webvtt_error_count( parser, error );
+}
+
+uint
+AbstractParser::droppedErrors() const
+{
+  return webvtt_dropped_errors( parser );
+}
+
+::webvtt_parser_stats
+AbstractParser::stats() const
+{
+  ::webvtt_parser_stats result;
+  webvtt_get_parser_stats( parser, &result );
+  return result;
+}
+
+::webvtt_status
+AbstractParser::setProfiling( bool enable )
+{
+  return webvtt_set_profiling( parser, enable ? 1 : 0 );
+}
+
+::webvtt_profile
+AbstractParser::profile() const
+{
+  ::webvtt_profile result;
+  webvtt_get_profile( parser, &result );
+  return result;
+}
+
+uint
+AbstractParser::regionCount() const
+{
+  return webvtt_region_count( parser );
+}
+
+const ::webvtt_region *
+AbstractParser::region( int index ) const
+{
+  return webvtt_get_region( parser, index );
+}
+
 ::webvtt_status
 AbstractParser::parseChunk( const void *chunk, webvtt_uint length )
 {
   return webvtt_parse_chunk( parser, chunk, length );
 }
 
+::webvtt_status
+AbstractParser::parseChunk( const void *chunk, webvtt_uint length,
+                            const ::webvtt_parse_budget &budget,
+                            webvtt_uint &consumed )
+{
+  return webvtt_parse_chunk_budget( parser, chunk, length, &budget,
+                                    &consumed );
+}
+
 void WEBVTT_CALLBACK
 AbstractParser::__parsedCue( void *userdata, webvtt_cue *pcue )
 {
@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2013 Mozilla Foundation and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  - Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <webvttxx/cue_reader>
+#include "drain_errors.h"
+
+namespace WebVTT
+{
+
+CueReader::CueReader( uint capacity )
+  : parser( 0 ), ring( capacity ? capacity : 1 ), head( 0 ), count( 0 ),
+    droppedCue( false )
+{
+  if( WEBVTT_FAILED( webvtt_create_parser( &__parsedCue, &__reportError,
+                                           this, &parser ) ) ) {
+    /**
+     * TODO: Throw error
+     */
+    return;
+  }
+  webvtt_collect_errors( parser, DefaultErrorCapacity );
+}
+
+CueReader::~CueReader()
+{
+  reset();
+  webvtt_delete_parser( parser );
+}
+
+::webvtt_status
+CueReader::feed( const void *chunk, uint length )
+{
+  return checkDropped( webvtt_parse_chunk( parser, chunk, length ) );
+}
+
+::webvtt_status
+CueReader::finish()
+{
+  return checkDropped( webvtt_finish_parsing( parser ) );
+}
+
+::webvtt_status
+CueReader::checkDropped( ::webvtt_status status )
+{
+  if( droppedCue ) {
+    droppedCue = false;
+    return WEBVTT_OUT_OF_MEMORY;
+  }
+  return status;
+}
+
+bool
+CueReader::next( Cue &cue )
+{
+  webvtt_cue *pcue;
+  if( !count ) {
+    return false;
+  }
+  pcue = ring[ head ];
+  head = head + 1 == ring.size() ? 0 : head + 1;
+  --count;
+
+  /* The ring's reference is handed to 'cue' */
+  webvtt_release_cue( &cue.cue );
+  cue.cue = pcue;
+  return true;
+}
+
+uint
+CueReader::drainErrors( std::vector<Error> &errors )
+{
+  return WebVTT::drainErrors( parser, errors );
+}
+
+void
+CueReader::reset()
+{
+  while( count ) {
+    webvtt_release_cue( &ring[ head ] );
+    head = head + 1 == ring.size() ? 0 : head + 1;
+    --count;
+  }
+  head = 0;
+  droppedCue = false;
+  webvtt_reset_parser( parser );
+}
+
+/**
+ * Called from the parser's callback, so it must not throw: an exception
+ * cannot unwind through the C parser. A cue which there is no room for is
+ * dropped, and feed() or finish() reports WEBVTT_OUT_OF_MEMORY.
+ */
+bool
+CueReader::push( webvtt_cue *cue ) noexcept
+{
+  if( count == ring.size() ) {
+    /* Unroll the ring into a larger one */
+    try {
+      std::vector<webvtt_cue *> larger( ring.size() * 2 );
+      for( uint i = 0; i < count; ++i ) {
+        larger[ i ] = ring[ ( head + i ) % ring.size() ];
+      }
+      ring.swap( larger );
+      head = 0;
+    } catch( ... ) {
+      return false;
+    }
+  }
+  ring[ ( head + count ) % ring.size() ] = cue;
+  ++count;
+  return true;
+}
+
+void WEBVTT_CALLBACK
+CueReader::__parsedCue( void *userdata, webvtt_cue *cue )
+{
+  /* The ring keeps the reference the parser gives us */
+  CueReader *self = reinterpret_cast<CueReader *>( userdata );
+  if( !self->push( cue ) ) {
+    webvtt_release_cue( &cue );
+    self->droppedCue = true;
+  }
+}
+
+int WEBVTT_CALLBACK
+CueReader::__reportError( void *, webvtt_uint, webvtt_uint, webvtt_error )
+{
+  /* Only reached if collection could not be enabled; keep going */
+  return 0;
+}
+
+}
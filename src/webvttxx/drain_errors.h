@@ -0,0 +1,57 @@
+//
+// Copyright (c) 2013 Mozilla Foundation and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  - Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __WEBVTTXX_DRAIN_ERRORS_H__
+# define __WEBVTTXX_DRAIN_ERRORS_H__
+# include <webvtt/parser.h>
+# include <webvttxx/error>
+# include <vector>
+
+namespace WebVTT
+{
+
+// Move the errors 'parser' has collected (see webvtt_collect_errors) to the
+// end of 'errors' a batch at a time, returning how many there were. Shared by
+// AbstractParser and CueReader.
+inline uint drainErrors( ::webvtt_parser parser, std::vector<Error> &errors )
+{
+  enum { BatchSize = 64 };
+  webvtt_error_info batch[ BatchSize ];
+  uint total = 0, n;
+  while( ( n = webvtt_drain_errors( parser, batch, BatchSize ) ) ) {
+    for( uint i = 0; i < n; ++i ) {
+      errors.push_back( Error( batch[ i ].line, batch[ i ].column,
+                               batch[ i ].error ) );
+    }
+    total += n;
+  }
+  return total;
+}
+
+}
+
+#endif
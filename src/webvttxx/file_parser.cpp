@@ -26,13 +26,69 @@
 //
 
 #include <stdlib.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <webvttxx/file_parser>
+#include "spsc_queue.h"
 
 namespace WebVTT
 {
 
-FileParser::FileParser( const char *fPath )
- : filePath( fPath )
+namespace
+{
+  // Counts the buffers one side of parseReadAhead has queued for the other,
+  // so that the other side sleeps until there is one. cancel() wakes a
+  // waiter for good.
+  class Semaphore
+  {
+  public:
+    explicit Semaphore( size_t initial = 0 )
+      : count( initial ), cancelled( false ) { }
+
+    void post()
+    {
+      {
+        std::lock_guard<std::mutex> lock( mutex );
+        ++count;
+      }
+      ready.notify_one();
+    }
+
+    // Returns false if cancelled
+    bool wait()
+    {
+      std::unique_lock<std::mutex> lock( mutex );
+      ready.wait( lock, [this]() { return count || cancelled; } );
+      if( cancelled ) {
+        return false;
+      }
+      --count;
+      return true;
+    }
+
+    void cancel()
+    {
+      {
+        std::lock_guard<std::mutex> lock( mutex );
+        cancelled = true;
+      }
+      ready.notify_all();
+    }
+
+  private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    size_t count;
+    bool cancelled;
+  };
+}
+
+FileParser::FileParser( const char *fPath, uint size, bool ahead )
+ : filePath( fPath ),
+   bufferSize( size ? size : (uint)DefaultBufferSize ),
+   readAhead( ahead )
 {
   reader.open( fPath, std::ios::in | std::ios::binary );
 
@@ -48,23 +104,99 @@ FileParser::~FileParser()
   }
 }
 
+/**
+ * Read the next buffer of the file, returning true if it is the last one
+ * (because the file ended or could not be read)
+ */
+bool
+FileParser::read( char *buffer, uint &length )
+{
+  reader.read( buffer, bufferSize );
+  length = (uint)reader.gcount();
+  return !reader.good();
+}
+
+/**
+ * Parse the file while a reader thread fills the next buffers. Buffers go to
+ * the parser through 'full' and come back through 'empty'; each queue has a
+ * semaphore counting what is in it, which the side with nothing to do sleeps
+ * on.
+ */
+::webvtt_status
+FileParser::parseReadAhead()
+{
+  struct Chunk
+  {
+    char *data;
+    uint length;
+    bool final;
+  };
+
+  std::vector<char> storage( (size_t)bufferSize * ReadAheadBuffers );
+  SpscQueue<char *> empty( ReadAheadBuffers );
+  SpscQueue<Chunk> full( ReadAheadBuffers );
+  Semaphore emptyCount( ReadAheadBuffers ), fullCount;
+  ::webvtt_status status = WEBVTT_SUCCESS;
+  Chunk chunk;
+
+  for( size_t i = 0; i < ReadAheadBuffers; ++i ) {
+    empty.push( &storage[ i * bufferSize ] );
+  }
+
+  // The queues never fail: there are only ReadAheadBuffers buffers, and each
+  // pop follows a wait on the semaphore counting the queue
+  std::thread thread( [&]() {
+    Chunk next;
+    do {
+      if( !emptyCount.wait() ) {
+        return;
+      }
+      empty.pop( next.data );
+      next.final = read( next.data, next.length );
+      full.push( next );
+      fullCount.post();
+    } while( !next.final );
+  } );
+
+  try {
+    do {
+      fullCount.wait();
+      full.pop( chunk );
+      status = parseChunk( chunk.data, chunk.length );
+      empty.push( chunk.data );
+      emptyCount.post();
+    } while( !chunk.final && !WEBVTT_FAILED(status) );
+  } catch( ... ) {
+    emptyCount.cancel();
+    thread.join();
+    throw;
+  }
+
+  emptyCount.cancel();
+  thread.join();
+  return status;
+}
+
 bool
 FileParser::parse()
 {
-  bool final = false;
   ::webvtt_status status;
   ::webvtt_status finishStatus;
-  char buffer[0x1000];
   if( !reader.good() ) {
     return false;
   }
 
-  do {
-    reader.read( buffer, sizeof buffer );
-    uint len = (uint)reader.gcount();
-    final = reader.eof();
-    status = parseChunk( buffer, len );
-  } while( !final && !WEBVTT_FAILED(status) );
+  if( readAhead ) {
+    status = parseReadAhead();
+  } else {
+    std::vector<char> buffer( bufferSize );
+    bool final;
+    do {
+      uint len;
+      final = read( &buffer[ 0 ], len );
+      status = parseChunk( &buffer[ 0 ], len );
+    } while( !final && !WEBVTT_FAILED(status) );
+  }
   if( status == WEBVTT_UNFINISHED ) {
     status = WEBVTT_SUCCESS;
   }
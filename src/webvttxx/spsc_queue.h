@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2013 Mozilla Foundation and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  - Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __WEBVTTXX_SPSC_QUEUE_H__
+# define __WEBVTTXX_SPSC_QUEUE_H__
+# include <atomic>
+# include <cstddef>
+# include <vector>
+
+namespace WebVTT
+{
+
+// A bounded, lock-free queue for exactly one producer thread and one consumer
+// thread. push() and pop() never block; they return false when the queue is
+// full or empty, and the caller decides how to wait.
+template<typename T>
+class SpscQueue
+{
+public:
+  // 'capacity' is rounded up to a power of two
+  explicit SpscQueue( size_t capacity )
+    : head( 0 ), tail( 0 )
+  {
+    size_t size = 1;
+    while( size < capacity ) {
+      size *= 2;
+    }
+    items.resize( size );
+    mask = size - 1;
+  }
+
+  // Producer only
+  bool push( const T &item )
+  {
+    size_t t = tail.load( std::memory_order_relaxed );
+    if( t - head.load( std::memory_order_acquire ) == items.size() ) {
+      return false;
+    }
+    items[ t & mask ] = item;
+    tail.store( t + 1, std::memory_order_release );
+    return true;
+  }
+
+  // Consumer only
+  bool pop( T &item )
+  {
+    size_t h = head.load( std::memory_order_relaxed );
+    if( h == tail.load( std::memory_order_acquire ) ) {
+      return false;
+    }
+    item = items[ h & mask ];
+    head.store( h + 1, std::memory_order_release );
+    return true;
+  }
+
+  size_t capacity() const { return items.size(); }
+
+private:
+  SpscQueue( const SpscQueue & );
+  SpscQueue &operator=( const SpscQueue & );
+
+  std::vector<T> items;
+  size_t mask;
+
+  // Written by the consumer and the producer respectively; kept on separate
+  // cache lines so that the two threads do not contend for them
+  alignas( 64 ) std::atomic<size_t> head;
+  alignas( 64 ) std::atomic<size_t> tail;
+};
+
+}
+
+#endif
@@ -0,0 +1,196 @@
+#include "benchmark"
+#include <webvtt/util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/resource.h>
+
+using namespace bench;
+
+static void usage()
+{
+  std::printf( "Usage: webvtt_bench [--min-time=<seconds>] [--json[=<file>]] "
+               "[filter...]\n"
+               "\n"
+               "Runs every benchmark whose name contains one of the filters "
+               "(all of them if\nno filter is given). With --json, results "
+               "are written as JSON to <file>, or\nto stdout in place of the "
+               "table.\n" );
+}
+
+static bool selected( const char *name, const std::vector<const char *> &f )
+{
+  if( f.empty() ) {
+    return true;
+  }
+  for( size_t i = 0; i < f.size(); ++i ) {
+    if( std::strstr( name, f[ i ] ) ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Count allocations, and the bytes they hold, ahead of each block
+ */
+static const size_t header = 16;
+
+static void *WEBVTT_CALLBACK countingAlloc( void *, webvtt_uint nb )
+{
+  char *p = (char *)std::malloc( nb + header );
+  if( !p ) {
+    return 0;
+  }
+  AllocationStats &stats = allocationStats();
+  int64_t live = stats.live.fetch_add( nb ) + nb;
+  int64_t peak = stats.peak.load();
+  while( live > peak && !stats.peak.compare_exchange_weak( peak, live ) ) {
+  }
+  stats.count.fetch_add( 1 );
+  *(webvtt_uint *)p = nb;
+  return p + header;
+}
+
+static void WEBVTT_CALLBACK countingFree( void *, void *ptr )
+{
+  char *p = (char *)ptr - header;
+  allocationStats().live.fetch_sub( *(webvtt_uint *)p );
+  std::free( p );
+}
+
+static long maxRssKb()
+{
+  struct rusage usage;
+  if( getrusage( RUSAGE_SELF, &usage ) ) {
+    return 0;
+  }
+  return usage.ru_maxrss;
+}
+
+struct Result
+{
+  const char *name;
+  uint64_t iterations;
+  double nsPerIteration;
+  double bytesPerSecond;
+  double itemsPerSecond;
+  const char *itemLabel;
+  double allocationsPerIteration;
+  double allocationsPerItem;
+  int64_t peakHeapBytes;
+  long maxRssKb;
+};
+
+static void writeJson( std::FILE *out, double minTime,
+                       const std::vector<Result> &results )
+{
+  std::fprintf( out, "{\n  \"min_time\": %g,\n  \"benchmarks\": [", minTime );
+  for( size_t i = 0; i < results.size(); ++i ) {
+    const Result &r = results[ i ];
+    std::fprintf( out, "%s\n    {\"name\": \"%s\", \"iterations\": %llu, "
+                  "\"ns_per_iteration\": %.1f, \"bytes_per_second\": %.0f, "
+                  "\"items_per_second\": %.0f, \"item_label\": \"%s\", "
+                  "\"allocations_per_iteration\": %.2f, "
+                  "\"allocations_per_item\": %.3f, "
+                  "\"peak_heap_bytes\": %lld, \"max_rss_kb\": %ld}",
+                  i ? "," : "", r.name, (unsigned long long)r.iterations,
+                  r.nsPerIteration, r.bytesPerSecond, r.itemsPerSecond,
+                  r.itemLabel, r.allocationsPerIteration,
+                  r.allocationsPerItem, (long long)r.peakHeapBytes,
+                  r.maxRssKb );
+  }
+  std::fprintf( out, "\n  ]\n}\n" );
+}
+
+int main( int argc, char **argv )
+{
+  double minTime = 0.5;
+  std::vector<const char *> filters;
+  const char *json = 0;
+
+  /* Before anything is allocated */
+  webvtt_set_allocator( &countingAlloc, &countingFree, 0 );
+
+  for( int i = 1; i < argc; ++i ) {
+    if( !std::strncmp( argv[ i ], "--min-time=", 11 ) ) {
+      minTime = std::atof( argv[ i ] + 11 );
+    } else if( !std::strcmp( argv[ i ], "--json" ) ) {
+      json = "-";
+    } else if( !std::strncmp( argv[ i ], "--json=", 7 ) ) {
+      json = argv[ i ] + 7;
+    } else if( !std::strcmp( argv[ i ], "--help" ) ) {
+      usage();
+      return 0;
+    } else {
+      filters.push_back( argv[ i ] );
+    }
+  }
+
+  const bool table = !json || std::strcmp( json, "-" );
+  if( table ) {
+    std::printf( "%-32s %12s %14s %12s %12s %10s %16s\n", "benchmark",
+                 "iterations", "ns/iter", "MB/s", "allocs/iter", "heap KB",
+                 "items/s" );
+  }
+  std::vector<Result> results;
+  const std::vector<Benchmark> &benchmarks = registry();
+  for( size_t i = 0; i < benchmarks.size(); ++i ) {
+    if( !selected( benchmarks[ i ].name, filters ) ) {
+      continue;
+    }
+    State state( minTime );
+    benchmarks[ i ].function( state );
+
+    double iterations = (double)state.iterationCount();
+    double secs = state.seconds();
+    if( iterations == 0 || secs <= 0 ) {
+      continue;
+    }
+    Result r;
+    r.name = benchmarks[ i ].name;
+    r.iterations = state.iterationCount();
+    r.nsPerIteration = secs * 1e9 / iterations;
+    r.bytesPerSecond = state.bytesPerIteration() * iterations / secs;
+    r.itemsPerSecond = state.itemsPerIteration() * iterations / secs;
+    r.itemLabel = state.itemLabel();
+    r.allocationsPerIteration = state.allocationCount() / iterations;
+    r.allocationsPerItem = state.itemsPerIteration()
+                           ? r.allocationsPerIteration
+                             / state.itemsPerIteration()
+                           : 0;
+    r.peakHeapBytes = state.peakHeapBytes();
+    r.maxRssKb = maxRssKb();
+    results.push_back( r );
+    if( !table ) {
+      continue;
+    }
+
+    std::printf( "%-32s %12llu %14.0f", r.name,
+                 (unsigned long long)r.iterations, r.nsPerIteration );
+    if( state.bytesPerIteration() ) {
+      std::printf( " %12.1f", r.bytesPerSecond / ( 1024.0 * 1024.0 ) );
+    } else {
+      std::printf( " %12s", "-" );
+    }
+    std::printf( " %12.1f %10.1f", r.allocationsPerIteration,
+                 r.peakHeapBytes / 1024.0 );
+    if( state.itemsPerIteration() ) {
+      std::printf( " %10.0f %s", r.itemsPerSecond, r.itemLabel );
+    }
+    std::printf( "\n" );
+  }
+
+  if( json ) {
+    std::FILE *out = table ? std::fopen( json, "w" ) : stdout;
+    if( !out ) {
+      std::fprintf( stderr, "webvtt_bench: cannot write %s\n", json );
+      return 1;
+    }
+    writeJson( out, minTime, results );
+    if( out != stdout ) {
+      std::fclose( out );
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,186 @@
+#include "benchmark"
+#include "corpus"
+#include <webvtt/parser.h>
+#include <webvttxx/file_parser>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+extern "C" {
+#include <webvtt/parser_internal.h>
+#include <webvtt/cuetext_internal.h>
+}
+
+using namespace bench;
+
+/**
+ * webvtt_parse_chunk, the cue text parser on its own, and FileParser over
+ * generated documents, one knob of CorpusOptions at a time. The Profiled
+ * variants time each phase (see webvtt_set_profiling), to show what that
+ * costs.
+ */
+
+namespace
+{
+  enum Kind { Plain, Markup, Escapes, Crlf, LongLines, Nuls, KindCount };
+
+  CorpusOptions options( Kind kind )
+  {
+    CorpusOptions o;
+    switch( kind ) {
+      case Markup: o.markup = 0.5; break;
+      case Escapes: o.escapes = 0.3; break;
+      case Crlf: o.crlf = true; break;
+      case LongLines: o.longLines = 0.05; break;
+      case Nuls: o.nuls = 0.2; break;
+      default: break;
+    }
+    return o;
+  }
+
+  const std::string &corpus( Kind kind )
+  {
+    static std::string docs[ KindCount ];
+    if( docs[ kind ].empty() ) {
+      docs[ kind ] = generate( options( kind ) );
+    }
+    return docs[ kind ];
+  }
+
+  void WEBVTT_CALLBACK collectCue( void *userdata, webvtt_cue *cue )
+  {
+    static_cast<std::vector<webvtt_cue *> *>( userdata )->push_back( cue );
+  }
+
+  void WEBVTT_CALLBACK releaseCue( void *, webvtt_cue *cue )
+  {
+    webvtt_release_cue( &cue );
+  }
+
+  /**
+   * The text of every cue in a document
+   */
+  const std::vector<std::string> &bodies( Kind kind )
+  {
+    static std::vector<std::string> lists[ KindCount ];
+    std::vector<std::string> &list = lists[ kind ];
+    if( list.empty() ) {
+      std::vector<webvtt_cue *> cues;
+      webvtt_parser parser;
+      webvtt_create_parser( &collectCue, &ignoreError, &cues, &parser );
+      const std::string &doc = corpus( kind );
+      webvtt_parse_chunk( parser, doc.data(), (webvtt_uint)doc.size() );
+      webvtt_finish_parsing( parser );
+      webvtt_delete_parser( parser );
+      for( size_t i = 0; i < cues.size(); ++i ) {
+        list.push_back( std::string( webvtt_string_text( &cues[ i ]->body ),
+                                     webvtt_string_length( &cues[ i ]->body ) ) );
+        webvtt_release_cue( &cues[ i ] );
+      }
+    }
+    return list;
+  }
+
+  void parseChunks( State &state, Kind kind, bool profile = false,
+                    webvtt_uint size = chunkSize )
+  {
+    const std::string &doc = corpus( kind );
+    while( state.keepRunning() ) {
+      webvtt_parser parser;
+      webvtt_create_parser( &releaseCue, &ignoreError, 0, &parser );
+      webvtt_set_profiling( parser, profile );
+      feed( doc, [&]( const char *b, webvtt_uint n ) {
+        webvtt_parse_chunk( parser, b, n );
+      }, size );
+      webvtt_finish_parsing( parser );
+      webvtt_delete_parser( parser );
+    }
+    state.setBytes( doc.size() );
+    state.setItems( options( kind ).cues, "cues/s" );
+  }
+
+  /**
+   * Each body is parsed into a new cue, as the parser does
+   */
+  void parseCuetext( State &state, Kind kind )
+  {
+    const std::vector<std::string> &list = bodies( kind );
+    std::vector<webvtt_string> payloads( list.size() );
+    uint64_t bytes = 0;
+    for( size_t i = 0; i < list.size(); ++i ) {
+      webvtt_create_string_with_text( &payloads[ i ], list[ i ].data(),
+                                      (int)list[ i ].size() );
+      bytes += list[ i ].size();
+    }
+    webvtt_parser parser;
+    webvtt_create_parser( &releaseCue, &ignoreError, 0, &parser );
+    while( state.keepRunning() ) {
+      for( size_t i = 0; i < payloads.size(); ++i ) {
+        webvtt_cue *cue;
+        webvtt_create_cue( &cue );
+        webvtt_parse_cuetext( parser, cue, &payloads[ i ], 1 );
+        webvtt_release_cue( &cue );
+      }
+    }
+    webvtt_delete_parser( parser );
+    for( size_t i = 0; i < payloads.size(); ++i ) {
+      webvtt_release_string( &payloads[ i ] );
+    }
+    state.setBytes( bytes );
+    state.setItems( list.size(), "cues/s" );
+  }
+
+  class CountingParser : public WebVTT::FileParser
+  {
+  public:
+    explicit CountingParser( const char *path )
+      : FileParser( path ), cues( 0 ) { }
+    virtual bool reportError( const WebVTT::Error & ) { return true; }
+    virtual void parsedCue( WebVTT::Cue & ) { ++cues; }
+    unsigned cues;
+  };
+
+  void parseFile( State &state, Kind kind )
+  {
+    const std::string &doc = corpus( kind );
+    const char *dir = std::getenv( "TMPDIR" );
+    std::string path = std::string( dir ? dir : "/tmp" )
+                       + "/webvtt_bench_corpus.vtt";
+    std::FILE *f = std::fopen( path.c_str(), "wb" );
+    if( !f ) {
+      return;
+    }
+    std::fwrite( doc.data(), 1, doc.size(), f );
+    std::fclose( f );
+    while( state.keepRunning() ) {
+      CountingParser parser( path.c_str() );
+      parser.parse();
+      doNotOptimize( parser.cues );
+    }
+    std::remove( path.c_str() );
+    state.setBytes( doc.size() );
+    state.setItems( options( kind ).cues, "cues/s" );
+  }
+}
+
+BENCHMARK(CorpusChunksPlain) { parseChunks( state, Plain ); }
+BENCHMARK(CorpusChunksMarkup) { parseChunks( state, Markup ); }
+BENCHMARK(CorpusChunksEscapes) { parseChunks( state, Escapes ); }
+BENCHMARK(CorpusChunksCrlf) { parseChunks( state, Crlf ); }
+BENCHMARK(CorpusChunksLongLines) { parseChunks( state, LongLines ); }
+BENCHMARK(CorpusChunksNuls) { parseChunks( state, Nuls ); }
+BENCHMARK(CorpusPacketsPlain)
+{
+  parseChunks( state, Plain, false, packetSize );
+}
+BENCHMARK(CorpusPacketsCrlf)
+{
+  parseChunks( state, Crlf, false, packetSize );
+}
+BENCHMARK(CorpusChunksPlainProfiled) { parseChunks( state, Plain, true ); }
+BENCHMARK(CorpusChunksMarkupProfiled) { parseChunks( state, Markup, true ); }
+BENCHMARK(CorpusCuetextPlain) { parseCuetext( state, Plain ); }
+BENCHMARK(CorpusCuetextMarkup) { parseCuetext( state, Markup ); }
+BENCHMARK(CorpusCuetextEscapes) { parseCuetext( state, Escapes ); }
+BENCHMARK(CorpusFilePlain) { parseFile( state, Plain ); }
+BENCHMARK(CorpusFileMarkup) { parseFile( state, Markup ); }
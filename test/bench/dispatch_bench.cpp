@@ -0,0 +1,111 @@
+#include "benchmark"
+#include "corpus"
+#include <webvttxx/abstract_parser>
+#include <webvttxx/parser>
+
+using namespace bench;
+
+/**
+ * A cue-dense document (one short cue per line pair, every cue with a
+ * setting error) parsed through AbstractParser's virtual callbacks, through
+ * the statically bound Parser<Handler>, and through a Parser<Handler> with no
+ * reportError.
+ */
+
+static const int denseCueCount = 50000;
+
+static const std::string &denseDocument()
+{
+  static std::string doc;
+  if( doc.empty() ) {
+    doc = "WEBVTT\n\n";
+    for( int i = 0; i < denseCueCount; ++i ) {
+      unsigned from = i * 10;
+      doc += timestamp( from, '.' ) + " --> " + timestamp( from + 10, '.' )
+             + " align:x\nw\n\n";
+    }
+  }
+  return doc;
+}
+
+namespace
+{
+  class VirtualCounter : public WebVTT::AbstractParser
+  {
+  public:
+    VirtualCounter() : cues( 0 ), errors( 0 ) { }
+    virtual bool reportError( const WebVTT::Error & ) { ++errors; return true; }
+    virtual void parsedCue( WebVTT::Cue &cue )
+    {
+      cues += cue.bodyView().length();
+    }
+    void parse( const std::string &doc )
+    {
+      feed( doc, [this]( const char *b, webvtt_uint n ) {
+        parseChunk( b, n );
+      } );
+      finishParsing();
+    }
+    unsigned cues, errors;
+  };
+
+  class StaticCounter : public WebVTT::Parser<StaticCounter>
+  {
+  public:
+    StaticCounter() : cues( 0 ), errors( 0 ) { }
+    bool reportError( const WebVTT::Error & ) { ++errors; return true; }
+    void parsedCue( WebVTT::Cue &cue ) { cues += cue.bodyView().length(); }
+    unsigned cues, errors;
+  };
+
+  class StaticCueCounter : public WebVTT::Parser<StaticCueCounter>
+  {
+  public:
+    StaticCueCounter() : cues( 0 ) { }
+    void parsedCue( WebVTT::Cue &cue ) { cues += cue.bodyView().length(); }
+    unsigned cues;
+  };
+}
+
+template<typename Counter>
+static unsigned parseStatic( const std::string &doc )
+{
+  Counter parser;
+  feed( doc, [&]( const char *b, webvtt_uint n ) {
+    parser.parseChunk( b, n );
+  } );
+  parser.finishParsing();
+  return parser.cues;
+}
+
+BENCHMARK(DispatchVirtual)
+{
+  const std::string &doc = denseDocument();
+  while( state.keepRunning() ) {
+    VirtualCounter parser;
+    parser.parse( doc );
+    bench::doNotOptimize( parser.cues );
+  }
+  state.setBytes( doc.size() );
+  state.setItems( denseCueCount, "cues/s" );
+}
+
+BENCHMARK(DispatchStatic)
+{
+  const std::string &doc = denseDocument();
+  while( state.keepRunning() ) {
+    bench::doNotOptimize( parseStatic<StaticCounter>( doc ) );
+  }
+  state.setBytes( doc.size() );
+  state.setItems( denseCueCount, "cues/s" );
+}
+
+BENCHMARK(DispatchStaticNoErrors)
+{
+  const std::string &doc = denseDocument();
+  while( state.keepRunning() ) {
+    bench::doNotOptimize( parseStatic<StaticCueCounter>( doc ) );
+  }
+  state.setBytes( doc.size() );
+  state.setItems( denseCueCount, "cues/s" );
+}
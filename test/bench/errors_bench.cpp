@@ -0,0 +1,84 @@
+#include "benchmark"
+#include "corpus"
+#include <webvtt/parser.h>
+
+using namespace bench;
+
+/**
+ * A document in which every cue has recoverable errors, reported through the
+ * error callback, collected and drained after each chunk, or suppressed.
+ */
+
+static const std::string &noisyDocument()
+{
+  static std::string doc;
+  if( doc.empty() ) {
+    doc = "WEBVTT\n\n";
+    for( int i = 0; i < cueCount; ++i ) {
+      unsigned from = i * 2500;
+      doc += timestamp( from, '.' ) + " --> " + timestamp( from + 2000, '.' )
+             + " align:top size:x line:y position:z vertical:up\n"
+               "Some text\n\n";
+    }
+  }
+  return doc;
+}
+
+static int WEBVTT_CALLBACK countError( void *userdata, webvtt_uint,
+                                       webvtt_uint, webvtt_error )
+{
+  ++*reinterpret_cast<unsigned *>( userdata );
+  return 0;
+}
+
+static const webvtt_error settingErrors[] = {
+  WEBVTT_ALIGN_BAD_VALUE, WEBVTT_SIZE_BAD_VALUE, WEBVTT_LINE_BAD_VALUE,
+  WEBVTT_POSITION_BAD_VALUE, WEBVTT_VERTICAL_BAD_VALUE
+};
+
+enum Mode { CALLBACK, COLLECT, SUPPRESS };
+
+static void parseNoisy( State &state, Mode mode )
+{
+  const std::string &doc = noisyDocument();
+  webvtt_error_info errors[ 0x100 ];
+  while( state.keepRunning() ) {
+    unsigned count = 0;
+    webvtt_parser parser;
+    webvtt_create_validator( &countError, &count, &parser );
+    if( mode != CALLBACK ) {
+      webvtt_collect_errors( parser, 0x100 );
+    }
+    if( mode == SUPPRESS ) {
+      for( size_t i = 0; i < sizeof( settingErrors ) / sizeof( *settingErrors );
+           ++i ) {
+        webvtt_suppress_error( parser, settingErrors[ i ], 1 );
+      }
+    }
+    feed( doc, [&]( const char *b, webvtt_uint n ) {
+      webvtt_parse_chunk( parser, b, n );
+      count += webvtt_drain_errors( parser, errors, 0x100 );
+    } );
+    webvtt_finish_parsing( parser );
+    count += webvtt_drain_errors( parser, errors, 0x100 );
+    webvtt_delete_parser( parser );
+    bench::doNotOptimize( count );
+  }
+  state.setBytes( doc.size() );
+  state.setItems( cueCount * 5, "errors/s" );
+}
+
+BENCHMARK(ErrorsCallback)
+{
+  parseNoisy( state, CALLBACK );
+}
+
+BENCHMARK(ErrorsCollect)
+{
+  parseNoisy( state, COLLECT );
+}
+
+BENCHMARK(ErrorsSuppressed)
+{
+  parseNoisy( state, SUPPRESS );
+}
@@ -0,0 +1,113 @@
+#include "benchmark"
+#include "corpus"
+#include <webvttxx/file_parser>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace bench;
+
+/**
+ * FileParser on a large file, reading synchronously or with the read-ahead
+ * thread. The "Cold" variants ask the kernel to drop the file's pages before
+ * each iteration (posix_fadvise), so that reads wait on the disk; this has no
+ * effect on a tmpfs, so set TMPDIR to a disk-backed directory.
+ */
+
+static const int fileRepeats = 64;
+static const webvtt_uint fileBufferSize = 0x10000;
+
+namespace
+{
+  class CountingParser : public WebVTT::FileParser
+  {
+  public:
+    CountingParser( const char *path, bool readAhead )
+      : FileParser( path, fileBufferSize, readAhead ), cues( 0 ) { }
+    virtual bool reportError( const WebVTT::Error & ) { return true; }
+    virtual void parsedCue( WebVTT::Cue & ) { ++cues; }
+    unsigned cues;
+  };
+
+  struct TempFile
+  {
+    TempFile() : size( 0 )
+    {
+      const char *dir = std::getenv( "TMPDIR" );
+      path = std::string( dir ? dir : "/tmp" ) + "/webvtt_bench_file.vtt";
+      std::FILE *f = std::fopen( path.c_str(), "wb" );
+      const std::string &doc = document( false );
+      if( f ) {
+        std::fwrite( doc.data(), 1, doc.size(), f );
+        for( int i = 1; i < fileRepeats; ++i ) {
+          /* Skip the "WEBVTT\n\n" header */
+          std::fwrite( doc.data() + 8, 1, doc.size() - 8, f );
+        }
+        size = std::ftell( f );
+        std::fclose( f );
+      }
+    }
+    ~TempFile() { std::remove( path.c_str() ); }
+
+    std::string path;
+    long size;
+  };
+}
+
+static const TempFile &tempFile()
+{
+  static TempFile file;
+  return file;
+}
+
+static void dropCache( const std::string &path )
+{
+#if defined(POSIX_FADV_DONTNEED)
+  int fd = open( path.c_str(), O_RDONLY );
+  if( fd >= 0 ) {
+    fdatasync( fd );
+    posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+    close( fd );
+  }
+#else
+  (void)path;
+#endif
+}
+
+static void parseFile( State &state, bool readAhead, bool cold )
+{
+  const TempFile &file = tempFile();
+  while( state.keepRunning() ) {
+    if( cold ) {
+      state.pause();
+      dropCache( file.path );
+      state.resume();
+    }
+    CountingParser parser( file.path.c_str(), readAhead );
+    parser.parse();
+    bench::doNotOptimize( parser.cues );
+  }
+  state.setBytes( file.size );
+  state.setItems( cueCount * fileRepeats, "cues/s" );
+}
+
+BENCHMARK(FileSyncWarm)
+{
+  parseFile( state, false, false );
+}
+
+BENCHMARK(FileReadAheadWarm)
+{
+  parseFile( state, true, false );
+}
+
+BENCHMARK(FileSyncCold)
+{
+  parseFile( state, false, true );
+}
+
+BENCHMARK(FileReadAheadCold)
+{
+  parseFile( state, true, true );
+}
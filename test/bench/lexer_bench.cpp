@@ -0,0 +1,79 @@
+#include "benchmark"
+#include "corpus"
+#include <string>
+extern "C" {
+#include <webvtt/parser_internal.h>
+}
+
+using namespace bench;
+
+/**
+ * File-level tokenizer (webvtt_lex) and end-of-line scanning
+ * (webvtt_string_getline) in isolation.
+ */
+
+static void WEBVTT_CALLBACK ignoreCue( void *, webvtt_cue *cue )
+{
+  webvtt_release_cue( &cue );
+}
+
+/**
+ * Every kind of token webvtt_lex recognizes, with some bytes it does not.
+ */
+static const std::string &tokens()
+{
+  static std::string text;
+  if( text.empty() ) {
+    for( int i = 0; i < 4096; ++i ) {
+      text += "WEBVTT \t    \r\n\r\n\xEF\xBB\xBF" "a\n"
+              "                                \n\rWEBVTx\t\t\n";
+    }
+  }
+  return text;
+}
+
+BENCHMARK(Lex)
+{
+  const std::string &text = tokens();
+  webvtt_parser parser;
+  webvtt_create_parser( &ignoreCue, &ignoreError, 0, &parser );
+  size_t count = 0;
+  while( state.keepRunning() ) {
+    webvtt_uint pos = 0, len = (webvtt_uint)text.size();
+    count = 0;
+    while( pos < len ) {
+      webvtt_token token = webvtt_lex( parser, text.data(), &pos, len, 1 );
+      if( token == BADTOKEN ) {
+        ++pos;
+      }
+      parser->token_pos = 0;
+      ++count;
+    }
+    bench::doNotOptimize( count );
+  }
+  webvtt_delete_parser( parser );
+  state.setBytes( text.size() );
+  state.setItems( count, "tokens/s" );
+}
+
+BENCHMARK(GetLine)
+{
+  const std::string &doc = document( false );
+  size_t count = 0;
+  webvtt_string line;
+  webvtt_create_string( 0x100, &line );
+  while( state.keepRunning() ) {
+    webvtt_uint pos = 0, len = (webvtt_uint)doc.size();
+    count = 0;
+    while( pos < len ) {
+      line.d->length = 0;
+      webvtt_string_getline( &line, doc.data(), &pos, len, 0, 1 );
+      ++pos;
+      ++count;
+    }
+    bench::doNotOptimize( count );
+  }
+  webvtt_release_string( &line );
+  state.setBytes( doc.size() );
+  state.setItems( count, "lines/s" );
+}
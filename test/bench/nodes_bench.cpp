@@ -0,0 +1,114 @@
+#include "benchmark"
+#include "corpus"
+#include <webvttxx/abstract_parser>
+#include <webvttxx/cue>
+#include <vector>
+
+using namespace bench;
+
+/**
+ * Walking the node trees of every cue in the corpus, as a renderer would on
+ * each frame: with Node::operator[] (which refs and releases each node), with
+ * borrowed child ranges, and with the pre-order NodeWalk.
+ */
+
+namespace
+{
+  class CueCollector : public WebVTT::AbstractParser
+  {
+  public:
+    virtual bool reportError( const WebVTT::Error & ) { return true; }
+    virtual void parsedCue( WebVTT::Cue &cue ) { cues.push_back( cue ); }
+
+    void parse( const std::string &doc )
+    {
+      feed( doc, [this]( const char *b, webvtt_uint n ) {
+        parseChunk( b, n );
+      } );
+      finishParsing();
+    }
+
+    std::vector<WebVTT::Cue> cues;
+  };
+}
+
+static const std::vector<WebVTT::Cue> &corpusCues()
+{
+  static CueCollector collector;
+  if( collector.cues.empty() ) {
+    collector.parse( document( false ) );
+  }
+  return collector.cues;
+}
+
+static size_t textIndexed( const WebVTT::Node &node )
+{
+  size_t n = node.text().length();
+  for( int i = 0; i < node.childCount(); ++i ) {
+    n += textIndexed( node[ i ] );
+  }
+  return n;
+}
+
+static size_t textRange( WebVTT::NodeRef node )
+{
+  size_t n = node.textView().length();
+  for( WebVTT::NodeRef child : node.children() ) {
+    n += textRange( child );
+  }
+  return n;
+}
+
+static size_t nodeCount()
+{
+  const std::vector<WebVTT::Cue> &cues = corpusCues();
+  size_t n = 0;
+  for( size_t i = 0; i < cues.size(); ++i ) {
+    for( WebVTT::NodeRef node : cues[ i ].nodes() ) {
+      ++n;
+      bench::doNotOptimize( node );
+    }
+  }
+  return n;
+}
+
+BENCHMARK(NodesIndexed)
+{
+  const std::vector<WebVTT::Cue> &cues = corpusCues();
+  while( state.keepRunning() ) {
+    size_t n = 0;
+    for( size_t i = 0; i < cues.size(); ++i ) {
+      n += textIndexed( cues[ i ].nodeHead() );
+    }
+    bench::doNotOptimize( n );
+  }
+  state.setItems( nodeCount(), "nodes/s" );
+}
+
+BENCHMARK(NodesRange)
+{
+  const std::vector<WebVTT::Cue> &cues = corpusCues();
+  while( state.keepRunning() ) {
+    size_t n = 0;
+    for( size_t i = 0; i < cues.size(); ++i ) {
+      n += textRange( cues[ i ].nodeHead().ref() );
+    }
+    bench::doNotOptimize( n );
+  }
+  state.setItems( nodeCount(), "nodes/s" );
+}
+
+BENCHMARK(NodesWalk)
+{
+  const std::vector<WebVTT::Cue> &cues = corpusCues();
+  while( state.keepRunning() ) {
+    size_t n = 0;
+    for( size_t i = 0; i < cues.size(); ++i ) {
+      for( WebVTT::NodeRef node : cues[ i ].nodes() ) {
+        n += node.textView().length();
+      }
+    }
+    bench::doNotOptimize( n );
+  }
+  state.setItems( nodeCount(), "nodes/s" );
+}
@@ -0,0 +1,67 @@
+#include "benchmark"
+#include "corpus"
+#include <webvtt/parser.h>
+#include <string>
+
+using namespace bench;
+
+/**
+ * Many small files, with a parser created for each file compared with one
+ * parser reset between files.
+ */
+
+static const int fileCount = 1000;
+
+static const std::string &smallFile()
+{
+  static std::string file;
+  if( file.empty() ) {
+    file = "WEBVTT\n\n"
+           "1\n00:00:01.000 --> 00:00:02.000\nHello <b>world</b>\n\n"
+           "2\n00:00:02.000 --> 00:00:03.000 align:start\nGoodbye\n";
+  }
+  return file;
+}
+
+static void WEBVTT_CALLBACK countCue( void *userdata, webvtt_cue *cue )
+{
+  ++*reinterpret_cast<int *>( userdata );
+  webvtt_release_cue( &cue );
+}
+
+BENCHMARK(SmallFilesCreate)
+{
+  const std::string &file = smallFile();
+  while( state.keepRunning() ) {
+    int count = 0;
+    for( int i = 0; i < fileCount; ++i ) {
+      webvtt_parser parser;
+      webvtt_create_parser( &countCue, &ignoreError, &count, &parser );
+      webvtt_parse_chunk( parser, file.data(), (webvtt_uint)file.size() );
+      webvtt_finish_parsing( parser );
+      webvtt_delete_parser( parser );
+    }
+    bench::doNotOptimize( count );
+  }
+  state.setBytes( file.size() * fileCount );
+  state.setItems( fileCount, "files/s" );
+}
+
+BENCHMARK(SmallFilesReset)
+{
+  const std::string &file = smallFile();
+  int count = 0;
+  webvtt_parser parser;
+  webvtt_create_parser( &countCue, &ignoreError, &count, &parser );
+  while( state.keepRunning() ) {
+    for( int i = 0; i < fileCount; ++i ) {
+      webvtt_reset_parser( parser );
+      webvtt_parse_chunk( parser, file.data(), (webvtt_uint)file.size() );
+      webvtt_finish_parsing( parser );
+    }
+    bench::doNotOptimize( count );
+  }
+  webvtt_delete_parser( parser );
+  state.setBytes( file.size() * fileCount );
+  state.setItems( fileCount, "files/s" );
+}
@@ -0,0 +1,105 @@
+#include "benchmark"
+#include "corpus"
+#include <webvtt/parser.h>
+#include <webvtt/srt.h>
+#include <webvtt/writer.h>
+#include <string>
+#include <vector>
+
+using namespace bench;
+
+/**
+ * SubRip reading and writing, compared with the native WebVTT parse of the
+ * same cues.
+ */
+
+static void WEBVTT_CALLBACK countCue( void *userdata, webvtt_cue *cue )
+{
+  ++*reinterpret_cast<int *>( userdata );
+  webvtt_release_cue( &cue );
+}
+
+static void WEBVTT_CALLBACK keepCue( void *userdata, webvtt_cue *cue )
+{
+  reinterpret_cast<std::vector<webvtt_cue *> *>( userdata )->push_back( cue );
+}
+
+static int WEBVTT_CALLBACK discard( void *userdata, const char *,
+                                    webvtt_uint len )
+{
+  *reinterpret_cast<size_t *>( userdata ) += len;
+  return 0;
+}
+
+BENCHMARK(VttParse)
+{
+  const std::string &doc = document( false );
+  while( state.keepRunning() ) {
+    int count = 0;
+    webvtt_parser parser;
+    webvtt_create_parser( &countCue, &ignoreError, &count, &parser );
+    feed( doc, [&]( const char *b, webvtt_uint n ) {
+      webvtt_parse_chunk( parser, b, n );
+    } );
+    webvtt_finish_parsing( parser );
+    webvtt_delete_parser( parser );
+    bench::doNotOptimize( count );
+  }
+  state.setBytes( doc.size() );
+  state.setItems( cueCount, "cues/s" );
+}
+
+BENCHMARK(SrtRead)
+{
+  const std::string &doc = document( true );
+  while( state.keepRunning() ) {
+    int count = 0;
+    webvtt_srt_reader reader;
+    webvtt_create_srt_reader( &countCue, &ignoreError, &count, &reader );
+    feed( doc, [&]( const char *b, webvtt_uint n ) {
+      webvtt_srt_parse_chunk( reader, b, n );
+    } );
+    webvtt_srt_finish_parsing( reader );
+    webvtt_delete_srt_reader( reader );
+    bench::doNotOptimize( count );
+  }
+  state.setBytes( doc.size() );
+  state.setItems( cueCount, "cues/s" );
+}
+
+static void write( bench::State &state, webvtt_output_format format )
+{
+  std::vector<webvtt_cue *> cues;
+  webvtt_parser parser;
+  webvtt_create_parser( &keepCue, &ignoreError, &cues, &parser );
+  webvtt_parse_chunk( parser, document( false ).data(),
+                      (webvtt_uint)document( false ).size() );
+  webvtt_finish_parsing( parser );
+  webvtt_delete_parser( parser );
+
+  size_t written = 0;
+  while( state.keepRunning() ) {
+    webvtt_writer writer;
+    written = 0;
+    webvtt_create_writer( format, &discard, &written, &writer );
+    for( size_t i = 0; i < cues.size(); ++i ) {
+      webvtt_writer_write_cue( writer, cues[ i ] );
+    }
+    webvtt_delete_writer( writer );
+  }
+  state.setBytes( written );
+  state.setItems( cues.size(), "cues/s" );
+  for( size_t i = 0; i < cues.size(); ++i ) {
+    webvtt_release_cue( &cues[ i ] );
+  }
+}
+
+BENCHMARK(VttWrite)
+{
+  write( state, WEBVTT_FORMAT_VTT );
+}
+
+BENCHMARK(SrtWrite)
+{
+  write( state, WEBVTT_FORMAT_SRT );
+}
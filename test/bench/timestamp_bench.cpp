@@ -0,0 +1,61 @@
+#include "benchmark"
+#include "corpus"
+#include <string>
+#include <vector>
+extern "C" {
+#include <webvtt/parser_internal.h>
+}
+
+using namespace bench;
+
+/**
+ * Timestamp parsing: the general parser, and the word-at-a-time path taken by
+ * webvtt_parse_timestamp_n for the usual fixed-width forms.
+ */
+
+static const std::vector<std::string> &timestamps()
+{
+  static std::vector<std::string> list;
+  if( list.empty() ) {
+    for( int i = 0; i < 4096; ++i ) {
+      unsigned ms = i * 7919u;
+      std::string ts = timestamp( ms, '.' );
+      /* Mix HH:MM:SS.mmm and MM:SS.mmm */
+      list.push_back( i % 2 ? ts : ts.substr( 3 ) );
+    }
+  }
+  return list;
+}
+
+BENCHMARK(TimestampSlow)
+{
+  const std::vector<std::string> &list = timestamps();
+  webvtt_timestamp sum = 0;
+  while( state.keepRunning() ) {
+    for( size_t i = 0; i < list.size(); ++i ) {
+      webvtt_timestamp ts;
+      int len;
+      webvtt_parse_timestamp( list[ i ].c_str(), &len, &ts );
+      sum += ts;
+    }
+    bench::doNotOptimize( sum );
+  }
+  state.setItems( list.size(), "stamps/s" );
+}
+
+BENCHMARK(TimestampFast)
+{
+  const std::vector<std::string> &list = timestamps();
+  webvtt_timestamp sum = 0;
+  while( state.keepRunning() ) {
+    for( size_t i = 0; i < list.size(); ++i ) {
+      webvtt_timestamp ts;
+      int len;
+      webvtt_parse_timestamp_n( list[ i ].c_str(),
+                                (webvtt_uint)list[ i ].size(), &len, &ts );
+      sum += ts;
+    }
+    bench::doNotOptimize( sum );
+  }
+  state.setItems( list.size(), "stamps/s" );
+}
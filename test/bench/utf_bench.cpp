@@ -0,0 +1,196 @@
+#include "benchmark"
+#include "corpus"
+#include <webvtt/parser.h>
+#include <webvttxx/string>
+#include <string>
+#include <vector>
+
+using namespace bench;
+
+/**
+ * Reading cue-sized strings as UTF-16 or code points, in ASCII, CJK and emoji
+ * text: a character at a time with webvtt_skip_utf8 from the start (as
+ * String::utf16At does), with a CodePointIndex, with the code point
+ * iterator, and with the bulk conversions.
+ *
+ * Also checking UTF-8 on its own, and the cost of each webvtt_utf8_mode when
+ * parsing the corpus.
+ */
+
+namespace
+{
+  enum Script { Ascii, Cjk, Emoji };
+
+  const std::vector<WebVTT::String> &lines( Script script )
+  {
+    static std::vector<WebVTT::String> cache[ 3 ];
+    std::vector<WebVTT::String> &list = cache[ script ];
+    if( list.empty() ) {
+      static const char *const words[ 3 ][ 4 ] = {
+        { "Hello", "there,", "how", "are you?" },
+        { "\xE4\xBD\xA0\xE5\xA5\xBD", "\xE4\xB8\x96\xE7\x95\x8C\xEF\xBC\x8C",
+          "\xE5\x97\xA8", "\xE5\xAD\x97\xE5\xB9\x95\xE3\x80\x82" },
+        { "\xF0\x9F\x98\x80\xF0\x9F\x98\x81", "\xF0\x9F\x8E\x89",
+          "\xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD", "\xE2\x9D\xA4\xEF\xB8\x8F" }
+      };
+      for( int i = 0; i < 2000; ++i ) {
+        std::string line;
+        for( int w = 0; line.size() < 64; ++w ) {
+          if( w ) {
+            line += ' ';
+          }
+          line += words[ script ][ ( i + w ) % 4 ];
+        }
+        list.push_back( WebVTT::String( line.data(), (int)line.size() ) );
+      }
+    }
+    return list;
+  }
+
+  uint64_t totalBytes( const std::vector<WebVTT::String> &list )
+  {
+    uint64_t n = 0;
+    for( size_t i = 0; i < list.size(); ++i ) {
+      n += list[ i ].length();
+    }
+    return n;
+  }
+
+  void scan( State &state, Script script )
+  {
+    const std::vector<WebVTT::String> &list = lines( script );
+    uint32_t sum = 0;
+    while( state.keepRunning() ) {
+      for( size_t i = 0; i < list.size(); ++i ) {
+        const char *text = list[ i ].utf8();
+        const char *end = text + list[ i ].length();
+        int count = webvtt_utf8_chcount( text, end );
+        for( int ch = 0; ch < count; ++ch ) {
+          const char *p = text;
+          webvtt_uint16 high;
+          if( webvtt_skip_utf8( &p, end, ch ) ) {
+            sum += webvtt_utf8_to_utf16( p, end, &high );
+          }
+        }
+      }
+    }
+    doNotOptimize( sum );
+    state.setBytes( totalBytes( list ) );
+  }
+
+  void utf16At( State &state, Script script )
+  {
+    const std::vector<WebVTT::String> &list = lines( script );
+    uint32_t sum = 0;
+    while( state.keepRunning() ) {
+      for( size_t i = 0; i < list.size(); ++i ) {
+        WebVTT::CodePointIndex index( list[ i ].view() );
+        int count = (int)index.charCount();
+        for( int ch = 0; ch < count; ++ch ) {
+          sum += index.utf16At( ch );
+        }
+      }
+    }
+    doNotOptimize( sum );
+    state.setBytes( totalBytes( list ) );
+  }
+
+  void codePoints( State &state, Script script )
+  {
+    const std::vector<WebVTT::String> &list = lines( script );
+    uint32_t sum = 0;
+    while( state.keepRunning() ) {
+      for( size_t i = 0; i < list.size(); ++i ) {
+        for( uint32_t ch : list[ i ].codePoints() ) {
+          sum += ch;
+        }
+      }
+    }
+    doNotOptimize( sum );
+    state.setBytes( totalBytes( list ) );
+  }
+
+  void copyUtf16( State &state, Script script )
+  {
+    const std::vector<WebVTT::String> &list = lines( script );
+    webvtt_uint16 out[ 256 ];
+    uint32_t sum = 0;
+    while( state.keepRunning() ) {
+      for( size_t i = 0; i < list.size(); ++i ) {
+        sum += list[ i ].copyUtf16( out, 256 );
+        doNotOptimize( out );
+      }
+    }
+    doNotOptimize( sum );
+    state.setBytes( totalBytes( list ) );
+  }
+
+  void copyUtf32( State &state, Script script )
+  {
+    const std::vector<WebVTT::String> &list = lines( script );
+    webvtt_uint32 out[ 256 ];
+    uint32_t sum = 0;
+    while( state.keepRunning() ) {
+      for( size_t i = 0; i < list.size(); ++i ) {
+        sum += list[ i ].copyUtf32( out, 256 );
+        doNotOptimize( out );
+      }
+    }
+    doNotOptimize( sum );
+    state.setBytes( totalBytes( list ) );
+  }
+}
+
+BENCHMARK(UtfScanAscii) { scan( state, Ascii ); }
+BENCHMARK(UtfScanCjk) { scan( state, Cjk ); }
+BENCHMARK(UtfScanEmoji) { scan( state, Emoji ); }
+BENCHMARK(Utf16AtAscii) { utf16At( state, Ascii ); }
+BENCHMARK(Utf16AtCjk) { utf16At( state, Cjk ); }
+BENCHMARK(Utf16AtEmoji) { utf16At( state, Emoji ); }
+BENCHMARK(UtfCodePointsAscii) { codePoints( state, Ascii ); }
+BENCHMARK(UtfCodePointsCjk) { codePoints( state, Cjk ); }
+BENCHMARK(UtfCodePointsEmoji) { codePoints( state, Emoji ); }
+BENCHMARK(UtfCopy16Ascii) { copyUtf16( state, Ascii ); }
+BENCHMARK(UtfCopy16Cjk) { copyUtf16( state, Cjk ); }
+BENCHMARK(UtfCopy16Emoji) { copyUtf16( state, Emoji ); }
+BENCHMARK(UtfCopy32Ascii) { copyUtf32( state, Ascii ); }
+BENCHMARK(UtfCopy32Cjk) { copyUtf32( state, Cjk ); }
+BENCHMARK(UtfCopy32Emoji) { copyUtf32( state, Emoji ); }
+
+BENCHMARK(UtfValidate)
+{
+  const std::string &doc = document( false );
+  size_t n = 0;
+  while( state.keepRunning() ) {
+    n += webvtt_utf8_validate( doc.data(), doc.data() + doc.size() )
+         - doc.data();
+  }
+  doNotOptimize( n );
+  state.setBytes( doc.size() );
+}
+
+static void WEBVTT_CALLBACK releaseCue( void *, webvtt_cue *cue )
+{
+  webvtt_release_cue( &cue );
+}
+
+static void parseWithMode( State &state, webvtt_utf8_mode mode )
+{
+  const std::string &doc = document( false );
+  while( state.keepRunning() ) {
+    webvtt_parser parser;
+    webvtt_create_parser( &releaseCue, &ignoreError, 0, &parser );
+    webvtt_set_utf8_mode( parser, mode );
+    feed( doc, [&]( const char *b, webvtt_uint n ) {
+      webvtt_parse_chunk( parser, b, n );
+    } );
+    webvtt_finish_parsing( parser );
+    webvtt_delete_parser( parser );
+  }
+  state.setBytes( doc.size() );
+  state.setItems( cueCount, "cues/s" );
+}
+
+BENCHMARK(VttParseUtf8Trust) { parseWithMode( state, WEBVTT_UTF8_TRUST ); }
+BENCHMARK(VttParseUtf8Validate) { parseWithMode( state, WEBVTT_UTF8_VALIDATE ); }
+BENCHMARK(VttParseUtf8Repair) { parseWithMode( state, WEBVTT_UTF8_REPAIR ); }
@@ -0,0 +1,34 @@
+#include "benchmark"
+#include "corpus"
+#include <webvtt/parser.h>
+
+using namespace bench;
+
+/**
+ * Validation-only parsing, to compare with VttParse over the same document.
+ */
+
+static int WEBVTT_CALLBACK countError( void *userdata, webvtt_uint,
+                                       webvtt_uint, webvtt_error )
+{
+  ++*reinterpret_cast<int *>( userdata );
+  return 0;
+}
+
+BENCHMARK(VttValidate)
+{
+  const std::string &doc = document( false );
+  while( state.keepRunning() ) {
+    int errors = 0;
+    webvtt_parser validator;
+    webvtt_create_validator( &countError, &errors, &validator );
+    feed( doc, [&]( const char *b, webvtt_uint n ) {
+      webvtt_parse_chunk( validator, b, n );
+    } );
+    webvtt_finish_parsing( validator );
+    webvtt_delete_parser( validator );
+    bench::doNotOptimize( errors );
+  }
+  state.setBytes( doc.size() );
+  state.setItems( cueCount, "cues/s" );
+}
@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <webvtt/parser.h>
+#include <webvttxx/abstract_parser>
+#include <string>
+#include <vector>
+
+class CollectErrorsTest : public ::testing::Test
+{
+public:
+  virtual void SetUp()
+  {
+    reported = 0;
+    ASSERT_EQ( WEBVTT_SUCCESS,
+               webvtt_create_parser( &read, &error, this, &parser ) );
+  }
+
+  virtual void TearDown()
+  {
+    webvtt_delete_parser( parser );
+  }
+
+  void parse( const std::string &text )
+  {
+    webvtt_parse_chunk( parser, text.data(), (webvtt_uint)text.size() );
+    webvtt_finish_parsing( parser );
+  }
+
+  std::vector<webvtt_error_info> drain( webvtt_uint max = 0x100 )
+  {
+    std::vector<webvtt_error_info> errors( max );
+    errors.resize( webvtt_drain_errors( parser, &errors[ 0 ], max ) );
+    return errors;
+  }
+
+  webvtt_parser parser;
+  int reported;
+
+private:
+  static void WEBVTT_CALLBACK read( void *, webvtt_cue *cue )
+  {
+    webvtt_release_cue( &cue );
+  }
+
+  static int WEBVTT_CALLBACK error( void *userdata, webvtt_uint, webvtt_uint,
+                                    webvtt_error )
+  {
+    ++( (CollectErrorsTest *)userdata )->reported;
+    return 0;
+  }
+};
+
+static const char document[] =
+  "WEBVTT\n\n"
+  "00:01.000 --> 00:02.000 align:bad\n"
+  "One\n\n"
+  "00:02.000 --> 00:03.000 size:x line:y\n"
+  "Two\n\n"
+  "00:03.000 --> 00:04.000 align:bad\n"
+  "Three\n";
+
+TEST_F(CollectErrorsTest, CollectsInsteadOfReporting)
+{
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_collect_errors( parser, 16 ) );
+  parse( document );
+  EXPECT_EQ( 0, reported );
+
+  std::vector<webvtt_error_info> errors = drain();
+  ASSERT_EQ( 4U, errors.size() );
+  EXPECT_EQ( WEBVTT_ALIGN_BAD_VALUE, errors[ 0 ].error );
+  EXPECT_EQ( 3U, errors[ 0 ].line );
+  EXPECT_EQ( 25U, errors[ 0 ].column );
+  EXPECT_EQ( WEBVTT_SIZE_BAD_VALUE, errors[ 1 ].error );
+  EXPECT_EQ( WEBVTT_LINE_BAD_VALUE, errors[ 2 ].error );
+  EXPECT_EQ( WEBVTT_ALIGN_BAD_VALUE, errors[ 3 ].error );
+  EXPECT_EQ( 9U, errors[ 3 ].line );
+
+  /* Drained errors are gone */
+  EXPECT_EQ( 0U, drain().size() );
+  EXPECT_EQ( 0U, webvtt_dropped_errors( parser ) );
+}
+
+TEST_F(CollectErrorsTest, DrainsInParts)
+{
+  webvtt_collect_errors( parser, 3 );
+  parse( document );
+  EXPECT_EQ( 2U, drain( 2 ).size() );
+  std::vector<webvtt_error_info> rest = drain();
+  ASSERT_EQ( 1U, rest.size() );
+  EXPECT_EQ( WEBVTT_LINE_BAD_VALUE, rest[ 0 ].error );
+}
+
+/**
+ * Errors arriving while the buffer is full are dropped and counted
+ */
+TEST_F(CollectErrorsTest, CountsDropped)
+{
+  webvtt_collect_errors( parser, 2 );
+  parse( document );
+  EXPECT_EQ( 2U, webvtt_dropped_errors( parser ) );
+  std::vector<webvtt_error_info> errors = drain();
+  ASSERT_EQ( 2U, errors.size() );
+  EXPECT_EQ( WEBVTT_ALIGN_BAD_VALUE, errors[ 0 ].error );
+  EXPECT_EQ( WEBVTT_SIZE_BAD_VALUE, errors[ 1 ].error );
+  EXPECT_EQ( 2U, webvtt_error_count( parser, WEBVTT_ALIGN_BAD_VALUE ) );
+}
+
+TEST_F(CollectErrorsTest, Suppressed)
+{
+  webvtt_collect_errors( parser, 16 );
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_suppress_error( parser, WEBVTT_ALIGN_BAD_VALUE, 1 ) );
+  parse( document );
+  std::vector<webvtt_error_info> errors = drain();
+  ASSERT_EQ( 2U, errors.size() );
+  EXPECT_EQ( WEBVTT_SIZE_BAD_VALUE, errors[ 0 ].error );
+  EXPECT_EQ( WEBVTT_LINE_BAD_VALUE, errors[ 1 ].error );
+
+  /* Suppressed errors are still counted */
+  EXPECT_EQ( 2U, webvtt_error_count( parser, WEBVTT_ALIGN_BAD_VALUE ) );
+  EXPECT_EQ( 1U, webvtt_error_count( parser, WEBVTT_SIZE_BAD_VALUE ) );
+  EXPECT_EQ( 0U, webvtt_error_count( parser, WEBVTT_MALFORMED_TAG ) );
+}
+
+/**
+ * Suppressed errors are not reported to the callback either
+ */
+TEST_F(CollectErrorsTest, SuppressedWithCallback)
+{
+  webvtt_suppress_error( parser, WEBVTT_ALIGN_BAD_VALUE, 1 );
+  parse( document );
+  EXPECT_EQ( 2, reported );
+
+  webvtt_reset_parser( parser );
+  webvtt_suppress_error( parser, WEBVTT_ALIGN_BAD_VALUE, 0 );
+  parse( document );
+  EXPECT_EQ( 6, reported );
+}
+
+TEST_F(CollectErrorsTest, StopCollecting)
+{
+  webvtt_collect_errors( parser, 16 );
+  parse( document );
+  webvtt_reset_parser( parser );
+  EXPECT_EQ( 0U, drain().size() );
+  EXPECT_EQ( 0U, webvtt_error_count( parser, WEBVTT_ALIGN_BAD_VALUE ) );
+
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_collect_errors( parser, 0 ) );
+  parse( document );
+  EXPECT_EQ( 4, reported );
+}
+
+TEST_F(CollectErrorsTest, InvalidParams)
+{
+  webvtt_error_info info;
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_collect_errors( 0, 16 ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM,
+             webvtt_suppress_error( 0, WEBVTT_ALIGN_BAD_VALUE, 1 ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM,
+             webvtt_suppress_error( parser, (webvtt_error)64, 1 ) );
+  EXPECT_EQ( 0U, webvtt_drain_errors( 0, &info, 1 ) );
+  EXPECT_EQ( 0U, webvtt_error_count( 0, WEBVTT_ALIGN_BAD_VALUE ) );
+  EXPECT_EQ( 0U, webvtt_dropped_errors( 0 ) );
+}
+
+namespace
+{
+  class StringParser : public WebVTT::AbstractParser
+  {
+  public:
+    StringParser() : reported( 0 ) { }
+
+    virtual bool reportError( const WebVTT::Error & )
+    {
+      ++reported;
+      return true;
+    }
+
+    virtual void parsedCue( WebVTT::Cue & ) { }
+
+    void parse( const char *text, webvtt_uint length )
+    {
+      parseChunk( text, length );
+      finishParsing();
+    }
+
+    int reported;
+  };
+}
+
+TEST(CollectErrorsXX, DrainErrors)
+{
+  StringParser parser;
+  std::vector<WebVTT::Error> errors;
+  ASSERT_EQ( WEBVTT_SUCCESS, parser.collectErrors( 16 ) );
+  parser.suppressError( WEBVTT_SIZE_BAD_VALUE );
+  parser.parse( document, sizeof( document ) - 1 );
+  EXPECT_EQ( 0, parser.reported );
+  EXPECT_EQ( 3U, parser.drainErrors( errors ) );
+  ASSERT_EQ( 3U, errors.size() );
+  EXPECT_EQ( WEBVTT_ALIGN_BAD_VALUE, errors[ 0 ].error() );
+  EXPECT_EQ( WEBVTT_LINE_BAD_VALUE, errors[ 1 ].error() );
+  EXPECT_EQ( 1U, parser.errorCount( WEBVTT_SIZE_BAD_VALUE ) );
+  EXPECT_EQ( 0U, parser.droppedErrors() );
+}
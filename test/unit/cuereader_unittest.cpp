@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <webvttxx/cue_reader>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace WebVTT;
+
+// A reader owns its parser and the cues in its ring
+static_assert( !std::is_copy_constructible<CueReader>::value
+               && !std::is_copy_assignable<CueReader>::value,
+               "CueReader is not copyable" );
+
+static const char document[] =
+  "WEBVTT\n\n"
+  "00:00.000 --> 00:01.000\nOne\n\n"
+  "00:01.000 --> 00:02.000 align:bad\nTwo\n\n"
+  "00:02.000 --> 00:03.000\nThree\n\n"
+  "00:03.000 --> 00:04.000\nFour\n";
+
+static std::string body( const Cue &cue )
+{
+  return std::string( cue.bodyView().data(), cue.bodyView().length() );
+}
+
+TEST(CueReader, NextAfterEachChunk)
+{
+  CueReader reader;
+  Cue cue;
+  std::vector<std::string> bodies;
+  EXPECT_TRUE( cue.isNull() );
+  EXPECT_FALSE( reader.next( cue ) );
+
+  for( size_t i = 0; i < sizeof( document ) - 1; ++i ) {
+    reader.feed( document + i, 1 );
+    while( reader.next( cue ) ) {
+      bodies.push_back( body( cue ) );
+    }
+  }
+  /* The last cue is only complete once the input is finished */
+  EXPECT_EQ( 3U, bodies.size() );
+  reader.finish();
+  ASSERT_TRUE( reader.next( cue ) );
+  EXPECT_EQ( "Four", body( cue ) );
+  EXPECT_FALSE( reader.hasCues() );
+
+  ASSERT_EQ( 3U, bodies.size() );
+  EXPECT_EQ( "One", bodies[ 0 ] );
+  EXPECT_EQ( "Three", bodies[ 2 ] );
+}
+
+/**
+ * A chunk completing more cues than the ring holds grows it, and the cues
+ * still come out in order
+ */
+TEST(CueReader, RangeForGrowsRing)
+{
+  CueReader reader( 2 );
+  reader.feed( document, sizeof( document ) - 1 );
+  reader.finish();
+  EXPECT_EQ( 4U, reader.pendingCues() );
+
+  std::vector<std::string> bodies;
+  for( Cue &cue : reader ) {
+    bodies.push_back( body( cue ) );
+  }
+  ASSERT_EQ( 4U, bodies.size() );
+  EXPECT_EQ( "One", bodies[ 0 ] );
+  EXPECT_EQ( "Two", bodies[ 1 ] );
+  EXPECT_EQ( "Four", bodies[ 3 ] );
+  EXPECT_FALSE( reader.hasCues() );
+}
+
+/**
+ * Cues outlive the reader they came from
+ */
+TEST(CueReader, CuesOutliveReader)
+{
+  std::vector<Cue> cues;
+  {
+    CueReader reader( 1 );
+    reader.feed( document, sizeof( document ) - 1 );
+    reader.finish();
+    Cue cue;
+    while( reader.next( cue ) ) {
+      cues.push_back( cue );
+    }
+  }
+  ASSERT_EQ( 4U, cues.size() );
+  EXPECT_EQ( "Two", body( cues[ 1 ] ) );
+}
+
+/**
+ * Everything the reader returns for 'text', fed in chunks of 'chunkSize'
+ */
+static std::string readAll( const std::string &text, size_t chunkSize )
+{
+  CueReader reader;
+  std::ostringstream out;
+  Cue cue;
+  std::vector<Error> errors;
+  for( size_t i = 0; i < text.size(); i += chunkSize ) {
+    reader.feed( text.data() + i, std::min( chunkSize, text.size() - i ) );
+  }
+  reader.finish();
+  while( reader.next( cue ) ) {
+    out << std::string( cue.idView().data(), cue.idView().length() ) << "|"
+        << cue.startTime().value() << "|" << cue.endTime().value() << "|"
+        << body( cue ) << "\n";
+  }
+  reader.drainErrors( errors );
+  for( size_t i = 0; i < errors.size(); ++i ) {
+    out << errors[ i ].error() << "@" << errors[ i ].line() << ":"
+        << errors[ i ].column() << "\n";
+  }
+  return out.str();
+}
+
+/**
+ * Lines split between chunks, wherever the split falls (in a line, between
+ * CR and LF, in a token starting a line) read the same as lines which are not
+ */
+TEST(CueReader, ChunkSizes)
+{
+  std::string text( "WEBVTT\r\n\r\n"
+                    "first\r\n00:00.000 --> 00:01.000 align:start\r\n"
+                    "One\r\n\r\n"
+                    "  spaced id\r00:01.000 --> 00:02.000\rTwo\rlines\r\r"
+                    "00:02.000 --> 00:03.000\nThree\n"
+                    "00:03.000 --> 00:04.000 line:0\nFour\n\n"
+                    "00:04.000 --> 00:05.000\n" );
+  text += std::string( "NUL \0 byte\n", 10 ) + std::string( 300, 'x' );
+  text += "\n\n";
+  const std::string whole = readAll( text, text.size() );
+  EXPECT_NE( std::string::npos, whole.find( "  spaced id|1000|2000|Two\nlines" ) );
+  EXPECT_NE( std::string::npos, whole.find( "NUL \xEF\xBF\xBD byte" ) );
+  for( size_t chunkSize = 1; chunkSize < 64; ++chunkSize ) {
+    EXPECT_EQ( whole, readAll( text, chunkSize ) ) << chunkSize;
+  }
+}
+
+TEST(CueReader, Errors)
+{
+  CueReader reader;
+  std::vector<Error> errors;
+  reader.feed( document, sizeof( document ) - 1 );
+  reader.finish();
+  EXPECT_EQ( 1U, reader.drainErrors( errors ) );
+  ASSERT_EQ( 1U, errors.size() );
+  EXPECT_EQ( WEBVTT_ALIGN_BAD_VALUE, errors[ 0 ].error() );
+  EXPECT_EQ( 6U, errors[ 0 ].line() );
+}
+
+/**
+ * Pending cues are released by reset, and the reader can be used again
+ */
+TEST(CueReader, Reset)
+{
+  CueReader reader( 2 );
+  reader.feed( document, sizeof( document ) - 1 );
+  EXPECT_EQ( 3U, reader.pendingCues() );
+  reader.reset();
+  EXPECT_FALSE( reader.hasCues() );
+
+  reader.feed( document, 40 );
+  reader.finish();
+  Cue cue;
+  ASSERT_TRUE( reader.next( cue ) );
+  EXPECT_EQ( "One", body( cue ) );
+}
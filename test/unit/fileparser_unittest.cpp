@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <webvttxx/file_parser>
+#include <webvttxx/cue>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "webvttxx/spsc_queue.h"
+
+using namespace WebVTT;
+
+namespace
+{
+  class BodyParser : public FileParser
+  {
+  public:
+    BodyParser( const char *path, uint bufferSize, bool readAhead )
+      : FileParser( path, bufferSize, readAhead ), errors( 0 ),
+        stopOnError( false ) { }
+
+    virtual bool reportError( const Error & )
+    {
+      ++errors;
+      return !stopOnError;
+    }
+
+    virtual void parsedCue( Cue &cue )
+    {
+      bodies.push_back( std::string( cue.bodyView().data(),
+                                     cue.bodyView().length() ) );
+    }
+
+    std::vector<std::string> bodies;
+    int errors;
+    bool stopOnError;
+  };
+}
+
+class FileParserTest : public ::testing::Test
+{
+public:
+  virtual void SetUp()
+  {
+    path = ::testing::TempDir() + "webvtt_fileparser_unittest.vtt";
+    std::ofstream out( path.c_str(), std::ios::out | std::ios::binary );
+    out << "WEBVTT\n\n";
+    for( int i = 0; i < 500; ++i ) {
+      char cue[ 128 ];
+      std::snprintf( cue, sizeof( cue ),
+                     "00:%02d.000 --> 00:%02d.500 align:bogus\n"
+                     "Cue number %d\n<b>bold</b>\n\n", i % 60, i % 60, i );
+      out << cue;
+    }
+  }
+
+  virtual void TearDown()
+  {
+    std::remove( path.c_str() );
+  }
+
+  std::string path;
+};
+
+/**
+ * Every buffer size gives the same cues and errors, with or without the
+ * reader thread
+ */
+TEST_F(FileParserTest, ReadAheadMatchesSynchronous)
+{
+  BodyParser expected( path.c_str(), FileParser::DefaultBufferSize, false );
+  ASSERT_TRUE( expected.parse() );
+  ASSERT_EQ( 500U, expected.bodies.size() );
+  EXPECT_EQ( "Cue number 499\n<b>bold</b>", expected.bodies.back() );
+  EXPECT_EQ( 500, expected.errors );
+
+  const uint sizes[] = { 1, 7, 100, 0x10000 };
+  for( size_t i = 0; i < sizeof( sizes ) / sizeof( *sizes ); ++i ) {
+    for( int ahead = 0; ahead < 2; ++ahead ) {
+      BodyParser parser( path.c_str(), sizes[ i ], ahead != 0 );
+      ASSERT_TRUE( parser.parse() );
+      EXPECT_EQ( expected.bodies, parser.bodies )
+        << "buffer size " << sizes[ i ] << ", read ahead " << ahead;
+      EXPECT_EQ( expected.errors, parser.errors );
+    }
+  }
+}
+
+/**
+ * A parse error stops parsing early, waking the reader thread, which may be
+ * waiting for a buffer
+ */
+TEST_F(FileParserTest, ReadAheadStops)
+{
+  {
+    std::ofstream out( path.c_str(), std::ios::out | std::ios::binary );
+    out << "WEBVTT\n\n00:00.000 --> 00:01.000\nA\n\n"
+           "00:0x.000 --> 00:02.000\nB\n\n";
+    for( int i = 0; i < 500; ++i ) {
+      out << "00:03.000 --> 00:04.000\nC\n\n";
+    }
+  }
+  const uint sizes[] = { 1, 0x1000 };
+  for( size_t i = 0; i < sizeof( sizes ) / sizeof( *sizes ); ++i ) {
+    BodyParser parser( path.c_str(), sizes[ i ], true );
+    parser.stopOnError = true;
+    EXPECT_FALSE( parser.parse() );
+    EXPECT_EQ( 1, parser.errors );
+    ASSERT_EQ( 1U, parser.bodies.size() );
+    EXPECT_EQ( "A", parser.bodies[ 0 ] );
+  }
+}
+
+TEST_F(FileParserTest, MissingFile)
+{
+  BodyParser parser( ( path + ".missing" ).c_str(), 0x1000, true );
+  EXPECT_FALSE( parser.parse() );
+}
+
+TEST(SpscQueue, FullAndEmpty)
+{
+  SpscQueue<int> queue( 3 );
+  int value;
+  EXPECT_EQ( 4U, queue.capacity() );
+  EXPECT_FALSE( queue.pop( value ) );
+  for( int i = 0; i < 4; ++i ) {
+    EXPECT_TRUE( queue.push( i ) );
+  }
+  EXPECT_FALSE( queue.push( 4 ) );
+  for( int i = 0; i < 4; ++i ) {
+    ASSERT_TRUE( queue.pop( value ) );
+    EXPECT_EQ( i, value );
+  }
+  EXPECT_FALSE( queue.pop( value ) );
+}
+
+TEST(SpscQueue, AcrossThreads)
+{
+  const int count = 100000;
+  SpscQueue<int> queue( 8 );
+  std::thread producer( [&]() {
+    for( int i = 0; i < count; ++i ) {
+      while( !queue.push( i ) ) {
+        std::this_thread::yield();
+      }
+    }
+  } );
+  int expected = 0, value;
+  while( expected < count ) {
+    if( queue.pop( value ) ) {
+      ASSERT_EQ( expected, value );
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+}
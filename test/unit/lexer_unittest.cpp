@@ -32,6 +32,18 @@ public:
     return self->tstate;
   }
 
+  webvtt_uint column() const {
+    return self->column;
+  }
+
+  std::string token() const {
+    return std::string( self->token, self->token_pos );
+  }
+
+  void resetToken() {
+    self->token_pos = 0;
+  }
+
 private:
   static int WEBVTT_CALLBACK dummyerr( void *userdata, webvtt_uint
                                        line, webvtt_uint col,
@@ -171,3 +183,63 @@ TEST_F(Lexer,LexWEBVTT)
   EXPECT_EQ( L_START, lexerState() );
 }
 
+
+/**
+ * Test that a run of spaces and tabs is returned as a single WHITESPACE token,
+ * leaving the following byte unread
+ */
+TEST_F(Lexer,LexWhitespace)
+{
+  webvtt_uint pos = 0;
+  EXPECT_EQ( WHITESPACE, lex( " \t  \tx", pos ) );
+  EXPECT_EQ( 5, pos );
+  EXPECT_EQ( 6, column() );
+  EXPECT_EQ( " \t  \t", token() );
+  EXPECT_EQ( L_START, lexerState() );
+}
+
+/**
+ * Test that a run of whitespace split across buffers is returned as a single
+ * token
+ */
+TEST_F(Lexer,LexWhitespaceSplit)
+{
+  webvtt_uint pos = 0;
+  EXPECT_EQ( UNFINISHED, lex( "  ", pos, false ) );
+  EXPECT_EQ( 2, pos );
+  EXPECT_EQ( L_WHITESPACE, lexerState() );
+  pos = 0;
+  EXPECT_EQ( WHITESPACE, lex( "\t\n", pos ) );
+  EXPECT_EQ( 1, pos );
+  EXPECT_EQ( "  \t", token() );
+  EXPECT_EQ( 4, column() );
+}
+
+/**
+ * Test that a run of whitespace longer than the token buffer is returned as
+ * several tokens
+ */
+TEST_F(Lexer,LexLongWhitespace)
+{
+  const std::string spaces( 300, ' ' );
+  webvtt_uint pos = 0;
+  EXPECT_EQ( WHITESPACE, lex( spaces, pos ) );
+  EXPECT_EQ( 255, pos );
+  resetToken();
+  EXPECT_EQ( WHITESPACE, lex( spaces, pos ) );
+  EXPECT_EQ( 300, pos );
+  EXPECT_EQ( 301, column() );
+}
+
+/**
+ * Test that bytes which begin no token are left unread, and do not move the
+ * column
+ */
+TEST_F(Lexer,LexBadToken)
+{
+  webvtt_uint pos = 0;
+  EXPECT_EQ( BADTOKEN, lex( "WEBx", pos ) );
+  EXPECT_EQ( 3, pos );
+  EXPECT_EQ( 4, column() );
+  EXPECT_EQ( L_START, lexerState() );
+}
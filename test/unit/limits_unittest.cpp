@@ -0,0 +1,296 @@
+#include "chunkparser_testfixture"
+#include <webvttxx/abstract_parser>
+extern "C" {
+#include "webvtt/parser_internal.h"
+}
+
+class LimitsTest : public ChunkParserTest
+{
+public:
+  LimitsTest() { abort = true; }
+
+  virtual void SetUp()
+  {
+    ASSERT_NO_FATAL_FAILURE( ChunkParserTest::SetUp() );
+    ASSERT_EQ( WEBVTT_SUCCESS, webvtt_get_limits( parser, &limits ) );
+  }
+
+  void setLimits()
+  {
+    ASSERT_EQ( WEBVTT_SUCCESS, webvtt_set_limits( parser, &limits ) );
+  }
+
+  std::string body( size_t i ) const
+  {
+    return webvtt_string_text( &cues[ i ]->body );
+  }
+
+  const webvtt_node *child( const webvtt_node *node, webvtt_uint i ) const
+  {
+    return node->data.internal_data->children[ i ];
+  }
+
+  webvtt_uint childCount( const webvtt_node *node ) const
+  {
+    return node->data.internal_data->length;
+  }
+
+  webvtt_limits limits;
+};
+
+/**
+ * By default, only lines are limited
+ */
+TEST_F(LimitsTest, Defaults)
+{
+  EXPECT_EQ( 0x10000u, limits.max_line_bytes );
+  EXPECT_EQ( 0u, limits.max_body_bytes );
+  EXPECT_EQ( 0u, limits.max_cues );
+  EXPECT_EQ( 0u, limits.max_nodes );
+  EXPECT_EQ( 0u, limits.max_depth );
+  EXPECT_EQ( 0u, limits.max_total_bytes );
+}
+
+/**
+ * The rest of a long line is skipped, wherever the chunks end, and the limit
+ * is reported once
+ */
+TEST_F(LimitsTest, LineTooLong)
+{
+  limits.max_line_bytes = 24;
+  setLimits();
+  std::string doc = "WEBVTT\n\n00:01.000 --> 00:02.000\n"
+                    "abcdefghijklmnopqrstuvwxyz\nshort\n";
+  for( size_t chunkSize = 1; chunkSize <= doc.size(); chunkSize += 7 ) {
+    clear();
+    webvtt_reset_parser( parser );
+    parse( doc, chunkSize );
+    ASSERT_EQ( 1u, cues.size() ) << chunkSize;
+    EXPECT_EQ( "abcdefghijklmnopqrstuvwx\nshort", body( 0 ) ) << chunkSize;
+    ASSERT_EQ( 1u, errors.size() ) << chunkSize;
+    EXPECT_EQ( WEBVTT_LINE_TOO_LONG, errors[ 0 ].error );
+    EXPECT_EQ( 4u, errors[ 0 ].line );
+    EXPECT_EQ( 25u, errors[ 0 ].column );
+  }
+}
+
+/**
+ * Lines are cut before the character which crosses the limit, even if it
+ * is split between chunks
+ */
+TEST_F(LimitsTest, LineCutOnCharacter)
+{
+  limits.max_line_bytes = 24;
+  setLimits();
+  std::string doc = "WEBVTT\n\n00:01.000 --> 00:02.000\n"
+                    "abcdefghijklmnopqrstuv\xE2\x82\xAC\n";
+  parse( doc );
+  ASSERT_EQ( 1u, cues.size() );
+  EXPECT_EQ( "abcdefghijklmnopqrstuv", body( 0 ) );
+
+  clear();
+  webvtt_reset_parser( parser );
+  webvtt_parse_chunk( parser, doc.data(), (webvtt_uint)doc.size() - 3 );
+  webvtt_parse_chunk( parser, doc.data() + doc.size() - 3, 3 );
+  webvtt_finish_parsing( parser );
+  ASSERT_EQ( 1u, cues.size() );
+  EXPECT_EQ( "abcdefghijklmnopqrstuv", body( 0 ) );
+}
+
+TEST_F(LimitsTest, CueTextTooLong)
+{
+  limits.max_body_bytes = 8;
+  setLimits();
+  parse( "WEBVTT\n\n00:01.000 --> 00:02.000\n12345\n6789\nabc\n\n"
+         "00:02.000 --> 00:03.000\nfits\n" );
+  ASSERT_EQ( 2u, cues.size() );
+  EXPECT_EQ( "12345\n67", body( 0 ) );
+  EXPECT_EQ( "fits", body( 1 ) );
+  ASSERT_EQ( 1u, errors.size() );
+  EXPECT_EQ( WEBVTT_CUE_TEXT_TOO_LONG, errors[ 0 ].error );
+  EXPECT_EQ( 5u, errors[ 0 ].line );
+}
+
+/**
+ * Blocks after the first 'max_cues' are skipped, REGION blocks included
+ */
+TEST_F(LimitsTest, TooManyCues)
+{
+  limits.max_cues = 2;
+  setLimits();
+  parse( "WEBVTT\n\nREGION\nid:r\n\n"
+         "00:01.000 --> 00:02.000\nOne\n\n"
+         "00:02.000 --> 00:03.000\nTwo\n\n"
+         "00:03.000 --> 00:04.000\nThree\n" );
+  ASSERT_EQ( 1u, cues.size() );
+  EXPECT_EQ( "One", body( 0 ) );
+  EXPECT_EQ( 1u, webvtt_region_count( parser ) );
+  ASSERT_EQ( 1u, errors.size() );
+  EXPECT_EQ( WEBVTT_TOO_MANY_CUES, errors[ 0 ].error );
+  EXPECT_EQ( 9u, errors[ 0 ].line );
+}
+
+/**
+ * The text after the node which reaches the limit is skipped
+ */
+TEST_F(LimitsTest, TooManyNodes)
+{
+  limits.max_nodes = 3;
+  setLimits();
+  parse( "WEBVTT\n\n00:01.000 --> 00:02.000\n<b>a</b><i>b</i>c\n" );
+  ASSERT_EQ( 1u, cues.size() );
+  const webvtt_node *head = cues[ 0 ]->node_head;
+  ASSERT_EQ( 2u, childCount( head ) );
+  EXPECT_EQ( WEBVTT_BOLD, child( head, 0 )->kind );
+  EXPECT_EQ( WEBVTT_ITALIC, child( head, 1 )->kind );
+  EXPECT_EQ( 0u, childCount( child( head, 1 ) ) );
+  ASSERT_EQ( 1u, errors.size() );
+  EXPECT_EQ( WEBVTT_TOO_MANY_NODES, errors[ 0 ].error );
+  EXPECT_EQ( 4u, errors[ 0 ].line );
+}
+
+/**
+ * Start tags nested too deep are ignored, and their text goes to the
+ * enclosing node
+ */
+TEST_F(LimitsTest, NestingTooDeep)
+{
+  limits.max_depth = 1;
+  setLimits();
+  parse( "WEBVTT\n\n00:01.000 --> 00:02.000\n<b><i>x</i><u>y</u></b>z\n" );
+  ASSERT_EQ( 1u, cues.size() );
+  const webvtt_node *head = cues[ 0 ]->node_head;
+  ASSERT_EQ( 2u, childCount( head ) );
+  const webvtt_node *bold = child( head, 0 );
+  ASSERT_EQ( WEBVTT_BOLD, bold->kind );
+  ASSERT_EQ( 2u, childCount( bold ) );
+  EXPECT_EQ( WEBVTT_TEXT, child( bold, 0 )->kind );
+  EXPECT_EQ( WEBVTT_TEXT, child( bold, 1 )->kind );
+  EXPECT_EQ( WEBVTT_TEXT, child( head, 1 )->kind );
+  ASSERT_EQ( 1u, errors.size() );
+  EXPECT_EQ( WEBVTT_NESTING_TOO_DEEP, errors[ 0 ].error );
+}
+
+/**
+ * Input past the limit is ignored, and the parser finishes as if the input
+ * had ended there
+ */
+TEST_F(LimitsTest, InputTooLong)
+{
+  std::string doc = "WEBVTT\n\n00:01.000 --> 00:02.000\nOne\n\n"
+                    "00:02.000 --> 00:03.000\nTwo and more\n";
+  limits.max_total_bytes = doc.size() - 10;
+  setLimits();
+  EXPECT_EQ( WEBVTT_PARSE_ERROR, parse( doc, 16 ) );
+  webvtt_finish_parsing( parser );
+  ASSERT_EQ( 2u, cues.size() );
+  EXPECT_EQ( "Two", body( 1 ) );
+  ASSERT_EQ( 1u, errors.size() );
+  EXPECT_EQ( WEBVTT_INPUT_TOO_LONG, errors[ 0 ].error );
+
+  /* Later chunks are ignored */
+  EXPECT_EQ( WEBVTT_PARSE_ERROR, webvtt_parse_chunk( parser, "\n", 1 ) );
+  EXPECT_EQ( 2u, cues.size() );
+  EXPECT_EQ( 1u, errors.size() );
+
+  /* Until the parser is reset */
+  clear();
+  webvtt_reset_parser( parser );
+  EXPECT_EQ( WEBVTT_SUCCESS, parse( doc.substr( 0, 36 ) ) );
+  ASSERT_EQ( 1u, cues.size() );
+  EXPECT_EQ( "One", body( 0 ) );
+}
+
+/**
+ * The limits are kept by webvtt_reset_parser, and counted against afresh
+ */
+TEST_F(LimitsTest, KeptOnReset)
+{
+  std::string doc = "WEBVTT\n\n00:01.000 --> 00:02.000\nOne\n\n"
+                    "00:02.000 --> 00:03.000\nTwo\n";
+  limits.max_cues = 1;
+  limits.max_total_bytes = doc.size();
+  setLimits();
+  EXPECT_EQ( WEBVTT_SUCCESS, parse( doc ) );
+  webvtt_reset_parser( parser );
+  EXPECT_EQ( WEBVTT_SUCCESS, parse( doc ) );
+  EXPECT_EQ( 2u, cues.size() );
+  EXPECT_EQ( 2u, errors.size() );
+
+  webvtt_limits kept;
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_get_limits( parser, &kept ) );
+  EXPECT_EQ( 1u, kept.max_cues );
+}
+
+/**
+ * Limits never abort parsing, whatever on_error returns
+ */
+TEST_F(LimitsTest, NeverAbort)
+{
+  limits.max_line_bytes = 23;
+  limits.max_cues = 1;
+  setLimits();
+  EXPECT_EQ( WEBVTT_SUCCESS,
+             parse( "WEBVTT\n\n00:01.000 --> 00:02.000\nOne\n" +
+                    std::string( 30, 'x' ) + "\n\n"
+                    "00:02.000 --> 00:03.000\nTwo\n" ) );
+  ASSERT_EQ( 1u, cues.size() );
+  EXPECT_EQ( "One\n" + std::string( 23, 'x' ), body( 0 ) );
+  EXPECT_EQ( 2u, errors.size() );
+}
+
+/**
+ * The state stack stops growing at a fixed depth, and says so
+ */
+TEST_F(LimitsTest, StateTooDeep)
+{
+  webvtt_status status = WEBVTT_SUCCESS;
+  webvtt_uint frames = 0;
+  while( frames <= MAX_STACK_FRAMES && status == WEBVTT_SUCCESS ) {
+    status = do_push( parser, 0, 0, T_INITIAL, 0, V_NONE, 1, 1 );
+    ++frames;
+  }
+  EXPECT_EQ( WEBVTT_PARSE_ERROR, status );
+  EXPECT_EQ( (webvtt_uint)MAX_STACK_FRAMES, frames );
+  ASSERT_EQ( 1u, errors.size() );
+  EXPECT_EQ( WEBVTT_STATE_TOO_DEEP, errors[ 0 ].error );
+}
+
+namespace
+{
+  class StringParser : public WebVTT::AbstractParser
+  {
+  public:
+    virtual bool reportError( const WebVTT::Error & ) { return true; }
+    virtual void parsedCue( WebVTT::Cue & ) { ++count; }
+
+    void parse( const std::string &text )
+    {
+      parseChunk( text.data(), (webvtt_uint)text.size() );
+      finishParsing();
+    }
+
+    int count = 0;
+  };
+}
+
+TEST_F(LimitsTest, Wrapper)
+{
+  StringParser wrapped;
+  webvtt_limits l = wrapped.limits();
+  l.max_cues = 1;
+  EXPECT_EQ( WEBVTT_SUCCESS, wrapped.setLimits( l ) );
+  EXPECT_EQ( 1u, wrapped.limits().max_cues );
+  wrapped.parse( "WEBVTT\n\n00:01.000 --> 00:02.000\nOne\n\n"
+                 "00:02.000 --> 00:03.000\nTwo\n" );
+  EXPECT_EQ( 1, wrapped.count );
+  EXPECT_EQ( 1u, wrapped.errorCount( WEBVTT_TOO_MANY_CUES ) );
+}
+
+TEST_F(LimitsTest, InvalidParam)
+{
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_set_limits( 0, &limits ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_set_limits( parser, 0 ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_get_limits( 0, &limits ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_get_limits( parser, 0 ) );
+}
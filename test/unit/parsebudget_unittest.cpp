@@ -0,0 +1,224 @@
+#include "chunkparser_testfixture"
+#include <webvttxx/abstract_parser>
+#include <sstream>
+
+class ParseBudgetTest : public ChunkParserTest
+{
+public:
+  ParseBudgetTest() { abort = true; }
+
+  virtual void SetUp()
+  {
+    ASSERT_NO_FATAL_FAILURE( ChunkParserTest::SetUp() );
+    budget.max_bytes = 0;
+    budget.max_nanoseconds = 0;
+  }
+
+  /**
+   * Parse 'text' one budget at a time, resuming where each call stopped, and
+   * return how many calls it took
+   */
+  int parseInBudget( const std::string &text )
+  {
+    int calls = 0;
+    webvtt_uint pos = 0;
+    do {
+      webvtt_uint consumed = 0;
+      EXPECT_EQ( WEBVTT_SUCCESS,
+                 webvtt_parse_chunk_budget( parser, text.data() + pos,
+                                            (webvtt_uint)text.size() - pos,
+                                            &budget, &consumed ) );
+      EXPECT_LT( 0u, consumed );
+      if( !consumed ) {
+        break;
+      }
+      ends.push_back( pos += consumed );
+      ++calls;
+    } while( pos < text.size() );
+    webvtt_finish_parsing( parser );
+    return calls;
+  }
+
+  static std::string document( int count )
+  {
+    std::ostringstream doc;
+    doc << "WEBVTT\n\n";
+    for( int i = 0; i < count; ++i ) {
+      doc << "00:" << ( 10 + i % 50 ) << ".000 --> 01:00.000\n"
+          << "<b>Cue</b> " << i << "\nsecond line\n\n";
+    }
+    return doc.str();
+  }
+
+  /**
+   * Each cue as its times and text
+   */
+  std::vector<std::string> texts() const
+  {
+    std::vector<std::string> result;
+    for( size_t i = 0; i < cues.size(); ++i ) {
+      std::ostringstream text;
+      text << cues[ i ]->from << ' ' << cues[ i ]->until << ' '
+           << webvtt_string_text( &cues[ i ]->body );
+      result.push_back( text.str() );
+    }
+    return result;
+  }
+
+  webvtt_parse_budget budget;
+  std::vector<webvtt_uint> ends;
+};
+
+/**
+ * Without a budget, the whole chunk is parsed
+ */
+TEST_F(ParseBudgetTest, NoBudget)
+{
+  EXPECT_EQ( 1, parseInBudget( document( 3 ) ) );
+  EXPECT_EQ( 3u, cues.size() );
+}
+
+/**
+ * Each call stops after the last line break within the byte budget, and
+ * parsing the rest later gives the same cues as one call
+ */
+TEST_F(ParseBudgetTest, Bytes)
+{
+  std::string doc = document( 20 );
+  parseInBudget( doc );
+  std::vector<std::string> whole = texts();
+  ASSERT_EQ( 20u, whole.size() );
+
+  webvtt_reset_parser( parser );
+  clear();
+  ends.clear();
+  budget.max_bytes = 50;
+  EXPECT_LT( 10, parseInBudget( doc ) );
+  EXPECT_EQ( whole, texts() );
+  EXPECT_EQ( 0u, errors.size() );
+  webvtt_uint last = 0;
+  for( size_t i = 0; i < ends.size(); ++i ) {
+    EXPECT_GE( 50u, ends[ i ] - last );
+    EXPECT_EQ( '\n', doc[ ends[ i ] - 1 ] ) << i;
+    last = ends[ i ];
+  }
+}
+
+/**
+ * A line longer than the byte budget is split, and still parsed whole
+ */
+TEST_F(ParseBudgetTest, LongLine)
+{
+  std::string line( 100, 'x' );
+  budget.max_bytes = 16;
+  parseInBudget( "WEBVTT\n\n00:01.000 --> 00:02.000\n" + line + "\n" );
+  ASSERT_EQ( 1u, cues.size() );
+  EXPECT_EQ( "1000 2000 " + line, texts()[ 0 ] );
+  EXPECT_EQ( 8u, ends[ 0 ] );
+  EXPECT_EQ( 24u, ends[ 1 ] );
+}
+
+/**
+ * A CR followed by an LF only ends a line with the LF
+ */
+TEST_F(ParseBudgetTest, CarriageReturn)
+{
+  budget.max_bytes = 9;
+  std::string doc = "WEBVTT\r\n\r\n00:01.000 --> 00:02.000\r\nab\r\ncd\rx";
+  webvtt_uint consumed;
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_parse_chunk_budget( parser, doc.data(),
+                                        (webvtt_uint)doc.size(), &budget,
+                                        &consumed ) );
+  EXPECT_EQ( 8u, consumed );
+
+  std::string lone = "WEBVTT\r\rabcdefgh";
+  webvtt_parser other;
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_create_parser( &read, &error, this, &other ) );
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_parse_chunk_budget( other, lone.data(),
+                                        (webvtt_uint)lone.size(), &budget,
+                                        &consumed ) );
+  EXPECT_EQ( 8u, consumed );
+  webvtt_delete_parser( other );
+
+  webvtt_reset_parser( parser );
+  parseInBudget( doc );
+  ASSERT_EQ( 1u, cues.size() );
+  EXPECT_EQ( "1000 2000 ab\ncd\nx", texts()[ 0 ] );
+}
+
+/**
+ * Once the time budget is spent, a call stops after the slice it is
+ * parsing, at a line break
+ */
+TEST_F(ParseBudgetTest, Time)
+{
+  std::string doc = document( 1000 );
+  budget.max_nanoseconds = 1;
+  EXPECT_LT( 1, parseInBudget( doc ) );
+  EXPECT_EQ( 1000u, cues.size() );
+  EXPECT_EQ( 0u, errors.size() );
+  for( size_t i = 0; i < ends.size(); ++i ) {
+    EXPECT_EQ( '\n', doc[ ends[ i ] - 1 ] ) << i;
+  }
+}
+
+/**
+ * Parsing errors stop a call at once
+ */
+TEST_F(ParseBudgetTest, Failed)
+{
+  std::string doc = "XEBVTT\n\n" + document( 2 ).substr( 8 );
+  budget.max_bytes = 10;
+  webvtt_uint consumed, pos = 0;
+  webvtt_status status;
+  do {
+    status = webvtt_parse_chunk_budget( parser, doc.data() + pos,
+                                        (webvtt_uint)doc.size() - pos,
+                                        &budget, &consumed );
+    pos += consumed;
+  } while( status == WEBVTT_SUCCESS && pos < doc.size() );
+  EXPECT_TRUE( WEBVTT_FAILED( status ) );
+  EXPECT_GT( doc.size(), pos );
+}
+
+namespace
+{
+  class StringParser : public WebVTT::AbstractParser
+  {
+  public:
+    virtual bool reportError( const WebVTT::Error & ) { return true; }
+    virtual void parsedCue( WebVTT::Cue & ) { ++count; }
+
+    webvtt_uint parse( const std::string &text, webvtt_uint budget )
+    {
+      ::webvtt_parse_budget b = { budget, 0 };
+      webvtt_uint consumed = 0;
+      parseChunk( text.data(), (webvtt_uint)text.size(), b, consumed );
+      return consumed;
+    }
+
+    int count = 0;
+  };
+}
+
+TEST_F(ParseBudgetTest, Wrapper)
+{
+  StringParser wrapped;
+  EXPECT_EQ( 8u, wrapped.parse( document( 2 ), 10 ) );
+}
+
+TEST_F(ParseBudgetTest, InvalidParam)
+{
+  webvtt_uint consumed;
+  EXPECT_EQ( WEBVTT_INVALID_PARAM,
+             webvtt_parse_chunk_budget( 0, "x", 1, &budget, &consumed ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM,
+             webvtt_parse_chunk_budget( parser, 0, 1, &budget, &consumed ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM,
+             webvtt_parse_chunk_budget( parser, "x", 1, 0, &consumed ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM,
+             webvtt_parse_chunk_budget( parser, "x", 1, &budget, 0 ) );
+}
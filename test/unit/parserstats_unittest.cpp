@@ -0,0 +1,229 @@
+#include "chunkparser_testfixture"
+#include <thread>
+
+class ParserStatsTest : public ChunkParserTest
+{
+public:
+  ParserStatsTest() { abort = true; }
+
+  virtual void SetUp()
+  {
+    ASSERT_EQ( WEBVTT_SUCCESS, webvtt_set_alloc_stats( 1 ) );
+    ChunkParserTest::SetUp();
+  }
+
+  virtual void TearDown()
+  {
+    ChunkParserTest::TearDown();
+    EXPECT_EQ( WEBVTT_SUCCESS, webvtt_set_alloc_stats( 0 ) );
+  }
+
+  webvtt_parser_stats stats() const
+  {
+    webvtt_parser_stats s;
+    EXPECT_EQ( WEBVTT_SUCCESS, webvtt_get_parser_stats( parser, &s ) );
+    return s;
+  }
+
+  static const char *document()
+  {
+    return "WEBVTT\n\n"
+           "00:01.000 --> 00:02.000\nHello\n\n"
+           "00:02.000 --> 00:03.000\n<c.loud.red>Hello</c> <b>there</b>\n\n"
+           "00:03.000 --> 00:04.000\n<v Bob>Bye</v>\n";
+  }
+};
+
+/**
+ * The parser itself is counted from the start
+ */
+TEST_F(ParserStatsTest, CountsParser)
+{
+  webvtt_parser_stats s = stats();
+  EXPECT_LE( 1u, s.allocations );
+  EXPECT_LT( 0u, s.live_bytes );
+  EXPECT_EQ( s.live_bytes, s.objects[ WEBVTT_OBJECT_OTHER ].live_bytes );
+  EXPECT_EQ( 0u, s.objects[ WEBVTT_OBJECT_CUE ].allocations );
+}
+
+TEST_F(ParserStatsTest, BreakdownByKind)
+{
+  ASSERT_EQ( WEBVTT_SUCCESS, parse( document() ) );
+  ASSERT_EQ( 3u, cues.size() );
+  webvtt_parser_stats s = stats();
+
+  const webvtt_object_stats &cue = s.objects[ WEBVTT_OBJECT_CUE ];
+  EXPECT_EQ( 3u, cue.allocations );
+  EXPECT_EQ( 3 * sizeof( webvtt_cue ), cue.live_bytes );
+  EXPECT_LT( 0u, s.objects[ WEBVTT_OBJECT_STRING ].live_bytes );
+  EXPECT_LT( 0u, s.objects[ WEBVTT_OBJECT_NODE ].live_bytes );
+  EXPECT_LT( 0u, s.objects[ WEBVTT_OBJECT_NODE_DATA ].live_bytes );
+  EXPECT_LT( 0u, s.objects[ WEBVTT_OBJECT_STRINGLIST ].live_bytes );
+  EXPECT_EQ( 0u, s.objects[ WEBVTT_OBJECT_STACK ].allocations );
+
+  webvtt_uint64 allocations = 0, bytes = 0, live = 0;
+  for( int i = 0; i < WEBVTT_OBJECT_KINDS; ++i ) {
+    allocations += s.objects[ i ].allocations;
+    bytes += s.objects[ i ].bytes;
+    live += s.objects[ i ].live_bytes;
+    EXPECT_LE( s.objects[ i ].live_bytes, s.objects[ i ].bytes );
+  }
+  EXPECT_EQ( s.allocations, allocations );
+  EXPECT_EQ( s.bytes, bytes );
+  EXPECT_EQ( s.live_bytes, live );
+  EXPECT_LE( s.frees, s.allocations );
+  EXPECT_LE( s.live_bytes, s.peak_live_bytes );
+  EXPECT_LE( s.peak_live_bytes, s.bytes );
+}
+
+/**
+ * Cues released by the application after they were returned are taken off
+ * the parser's live bytes
+ */
+TEST_F(ParserStatsTest, ReleasedCues)
+{
+  ASSERT_EQ( WEBVTT_SUCCESS, parse( document() ) );
+  webvtt_parser_stats before = stats();
+  clear();
+  webvtt_parser_stats after = stats();
+
+  EXPECT_EQ( before.allocations, after.allocations );
+  EXPECT_LT( before.frees, after.frees );
+  EXPECT_EQ( 0u, after.objects[ WEBVTT_OBJECT_CUE ].live_bytes );
+  EXPECT_EQ( 0u, after.objects[ WEBVTT_OBJECT_NODE ].live_bytes );
+  EXPECT_EQ( 0u, after.objects[ WEBVTT_OBJECT_STRINGLIST ].live_bytes );
+  EXPECT_GT( before.live_bytes, after.live_bytes );
+  EXPECT_EQ( before.peak_live_bytes, after.peak_live_bytes );
+}
+
+/**
+ * Cues can be held past the parser's deletion
+ */
+TEST_F(ParserStatsTest, CuesOutliveParser)
+{
+  ASSERT_EQ( WEBVTT_SUCCESS, parse( document() ) );
+  webvtt_delete_parser( parser );
+  parser = 0;
+  ASSERT_EQ( 3u, cues.size() );
+  EXPECT_EQ( 3000u, cues[ 2 ]->from );
+}
+
+/**
+ * Memory allocated outside the parser's functions is not counted, nor is
+ * another parser's
+ */
+TEST_F(ParserStatsTest, PerParser)
+{
+  webvtt_parser other;
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_create_parser( &read, &error, this, &other ) );
+  webvtt_parser_stats before = stats();
+
+  webvtt_string str;
+  webvtt_create_string_with_text( &str, "outside", -1 );
+  std::string doc = document();
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_parse_chunk( other, doc.data(), (webvtt_uint)doc.size() ) );
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_finish_parsing( other ) );
+  webvtt_parser_stats after = stats();
+  webvtt_parser_stats others;
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_get_parser_stats( other, &others ) );
+
+  EXPECT_EQ( before.allocations, after.allocations );
+  EXPECT_EQ( before.live_bytes, after.live_bytes );
+  EXPECT_EQ( 3u, others.objects[ WEBVTT_OBJECT_CUE ].allocations );
+
+  webvtt_release_string( &str );
+  webvtt_delete_parser( other );
+}
+
+/**
+ * The counts are kept across webvtt_reset_parser, and reused storage is not
+ * counted again
+ */
+TEST_F(ParserStatsTest, KeptOnReset)
+{
+  ASSERT_EQ( WEBVTT_SUCCESS, parse( document() ) );
+  clear();
+  webvtt_parser_stats first = stats();
+  webvtt_reset_parser( parser );
+  ASSERT_EQ( WEBVTT_SUCCESS, parse( document() ) );
+  clear();
+  webvtt_parser_stats second = stats();
+
+  EXPECT_EQ( 3u, first.objects[ WEBVTT_OBJECT_CUE ].allocations );
+  EXPECT_EQ( 6u, second.objects[ WEBVTT_OBJECT_CUE ].allocations );
+  EXPECT_EQ( first.live_bytes, second.live_bytes );
+}
+
+/**
+ * Cues are returned holding no more memory for their text than it needs
+ */
+TEST_F(ParserStatsTest, CueTextFitted)
+{
+  std::string body( 300, 'x' );
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             parse( "WEBVTT\n\nthe-first-cue-has-a-long-id\n"
+                    "00:01.000 --> 00:02.000\n" + body + "\n" + body +
+                    "\n" ) );
+  ASSERT_EQ( 1u, cues.size() );
+  EXPECT_EQ( 601u, webvtt_string_length( &cues[ 0 ]->body ) );
+  EXPECT_GT( 601u + 16, webvtt_string_capacity( &cues[ 0 ]->body ) );
+  EXPECT_GT( webvtt_string_length( &cues[ 0 ]->id ) + 16,
+             webvtt_string_capacity( &cues[ 0 ]->id ) );
+}
+
+/**
+ * Cues may be released on another thread while their parser keeps
+ * allocating
+ */
+TEST_F(ParserStatsTest, ReleasedOnOtherThread)
+{
+  std::vector<webvtt_cue *> held;
+  for( int i = 0; i < 50; ++i ) {
+    ASSERT_EQ( WEBVTT_SUCCESS, parse( document() ) );
+    held.insert( held.end(), cues.begin(), cues.end() );
+    cues.clear();
+    webvtt_reset_parser( parser );
+  }
+  std::thread releaser( [&held]() {
+    for( size_t i = 0; i < held.size(); ++i ) {
+      webvtt_release_cue( &held[ i ] );
+    }
+  } );
+  for( int i = 0; i < 50; ++i ) {
+    ASSERT_EQ( WEBVTT_SUCCESS, parse( document() ) );
+    clear();
+    webvtt_reset_parser( parser );
+  }
+  releaser.join();
+  webvtt_parser_stats after = stats();
+  EXPECT_EQ( 300u, after.objects[ WEBVTT_OBJECT_CUE ].allocations );
+  EXPECT_EQ( 0u, after.objects[ WEBVTT_OBJECT_CUE ].live_bytes );
+  EXPECT_EQ( 0u, after.objects[ WEBVTT_OBJECT_NODE ].live_bytes );
+  EXPECT_EQ( 0u, after.objects[ WEBVTT_OBJECT_STRINGLIST ].live_bytes );
+}
+
+/**
+ * Stats are off unless asked for, and cannot be turned on while anything is
+ * allocated
+ */
+class ParserStatsOffTest : public ChunkParserTest
+{
+};
+
+TEST_F(ParserStatsOffTest, NotSupported)
+{
+  webvtt_parser_stats s;
+  EXPECT_EQ( WEBVTT_NOT_SUPPORTED, webvtt_get_parser_stats( parser, &s ) );
+  EXPECT_EQ( 0u, s.allocations );
+  EXPECT_EQ( WEBVTT_UNSUCCESSFUL, webvtt_set_alloc_stats( 1 ) );
+  EXPECT_EQ( WEBVTT_SUCCESS, webvtt_set_alloc_stats( 0 ) );
+}
+
+TEST_F(ParserStatsTest, InvalidParam)
+{
+  webvtt_parser_stats s;
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_get_parser_stats( 0, &s ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_get_parser_stats( parser, 0 ) );
+}
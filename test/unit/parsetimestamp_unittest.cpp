@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+extern "C" {
+#include "webvtt/parser_internal.h"
+}
+
+/**
+ * webvtt_parse_timestamp_n reads common timestamps a word at a time, and must
+ * give exactly the same results as webvtt_parse_timestamp for any input.
+ */
+class ParseTimestamp : public ::testing::Test
+{
+public:
+  void expectSame( const std::string &text )
+  {
+    webvtt_timestamp slow = 0, fast = 0;
+    int slowLen = -1, fastLen = -1;
+    int slowRv = webvtt_parse_timestamp( text.c_str(), &slowLen, &slow );
+    int fastRv = webvtt_parse_timestamp_n( text.c_str(),
+                                           (webvtt_uint)text.size(),
+                                           &fastLen, &fast );
+    EXPECT_EQ( slowRv, fastRv ) << "'" << text << "'";
+    EXPECT_EQ( slow, fast ) << "'" << text << "'";
+    EXPECT_EQ( slowLen, fastLen ) << "'" << text << "'";
+  }
+};
+
+TEST_F(ParseTimestamp, WellFormed)
+{
+  webvtt_timestamp ts;
+  int len;
+  EXPECT_EQ( 1, webvtt_parse_timestamp_n( "01:02:03.456", 12, &len, &ts ) );
+  EXPECT_EQ( 12, len );
+  EXPECT_EQ( 3723456U, ts );
+  EXPECT_EQ( 1, webvtt_parse_timestamp_n( "59:59.999 -->", 13, &len, &ts ) );
+  EXPECT_EQ( 9, len );
+  EXPECT_EQ( 3599999U, ts );
+  EXPECT_EQ( 1, webvtt_parse_timestamp_n( "99:00:00.000", 12, &len, &ts ) );
+  EXPECT_EQ( 356400000U, ts );
+}
+
+/**
+ * Every single-byte change to a set of timestamps, including truncations
+ */
+TEST_F(ParseTimestamp, SameAsSlowPath)
+{
+  static const char *const templates[] = {
+    "00:00:00.000", "12:34:56.789", "99:59:59.999", "00:00.000",
+    "59:59.999", "60:00.000", "00:60:00.000", "00:00:60.000",
+    "123:00:00.000", "1:00:00.000", "00:00:00.0000", "00:00.0000",
+    "00:00:00.000 --> 00:00:01.000", "00:00.000-->", "00:00:00.00",
+    "00:00:00,000", "00:0:00.000", "00:00:00:000"
+  };
+  static const char replacements[] = "0159:.,- ax\n";
+  for( size_t t = 0; t < sizeof( templates ) / sizeof( *templates ); ++t ) {
+    const std::string text = templates[ t ];
+    for( size_t n = 0; n <= text.size(); ++n ) {
+      expectSame( text.substr( 0, n ) );
+    }
+    for( size_t i = 0; i < text.size(); ++i ) {
+      for( size_t r = 0; r < sizeof( replacements ) - 1; ++r ) {
+        std::string changed = text;
+        changed[ i ] = replacements[ r ];
+        expectSame( changed );
+      }
+    }
+  }
+}
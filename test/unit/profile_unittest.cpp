@@ -0,0 +1,178 @@
+#include "chunkparser_testfixture"
+#include <webvttxx/abstract_parser>
+
+class ProfileTest : public ChunkParserTest
+{
+public:
+  virtual void SetUp()
+  {
+    ASSERT_NO_FATAL_FAILURE( ChunkParserTest::SetUp() );
+    webvtt_status status = webvtt_set_profiling( parser, 1 );
+    if( status == WEBVTT_NOT_SUPPORTED ) {
+      GTEST_SKIP();
+    }
+    ASSERT_EQ( WEBVTT_SUCCESS, status );
+  }
+
+  webvtt_profile profile() const
+  {
+    webvtt_profile p;
+    EXPECT_EQ( WEBVTT_SUCCESS, webvtt_get_profile( parser, &p ) );
+    return p;
+  }
+
+  static const char *document()
+  {
+    return "WEBVTT\n\n"
+           "00:01.000 --> 00:02.000 align:start\nHello\n\n"
+           "00:02.000 --> 00:03.000\n<b>Hello</b>\nthere\n\n"
+           "00:04.000 --> 00:03.000\nBackwards\n\n"
+           "00:05.000 -> 00:06.000\nNo separator\n";
+  }
+};
+
+TEST_F(ProfileTest, Counts)
+{
+  std::string doc = document();
+  parse( doc );
+  webvtt_profile p = profile();
+
+  EXPECT_EQ( doc.size(), p.bytes );
+  EXPECT_EQ( 14u, p.lines );
+  EXPECT_EQ( cues.size(), p.cues_emitted );
+  EXPECT_EQ( 2u, p.cues_emitted );
+  EXPECT_EQ( 2u, p.cues_dropped );
+  EXPECT_EQ( 3u, p.calls[ WEBVTT_PHASE_TIMINGS ] );
+  EXPECT_EQ( 3u, p.calls[ WEBVTT_PHASE_SETTINGS ] );
+  EXPECT_EQ( 3u, p.calls[ WEBVTT_PHASE_PARSE_CUETEXT ] );
+  EXPECT_LE( 3u, p.calls[ WEBVTT_PHASE_READ_CUETEXT ] );
+  EXPECT_LE( 1u, p.calls[ WEBVTT_PHASE_PARSE ] );
+}
+
+TEST_F(ProfileTest, Transitions)
+{
+  parse( document() );
+  webvtt_profile p = profile();
+  webvtt_uint64 total = 0;
+  for( webvtt_uint i = 0; i < WEBVTT_PARSE_STATES; ++i ) {
+    if( !webvtt_parse_state_name( i ) ) {
+      EXPECT_EQ( 0u, p.transitions[ i ] ) << i;
+    }
+    total += p.transitions[ i ];
+  }
+  EXPECT_LT( 0u, total );
+  EXPECT_LT( 0u, p.transitions[ 0 ] );
+  EXPECT_STREQ( "T_INITIAL", webvtt_parse_state_name( 0 ) );
+  EXPECT_EQ( 0, webvtt_parse_state_name( WEBVTT_PARSE_STATES ) );
+}
+
+/**
+ * Splitting the input differently changes how often the state machine is
+ * entered, but not what it counts
+ */
+TEST_F(ProfileTest, SmallChunks)
+{
+  std::string doc = document();
+  parse( doc, 3 );
+  webvtt_profile p = profile();
+  EXPECT_EQ( doc.size(), p.bytes );
+  EXPECT_EQ( 2u, p.cues_emitted );
+  EXPECT_EQ( 3u, p.calls[ WEBVTT_PHASE_TIMINGS ] );
+  EXPECT_LT( 3u, p.calls[ WEBVTT_PHASE_PARSE ] );
+}
+
+TEST_F(ProfileTest, Timing)
+{
+  std::string doc;
+  for( int i = 0; i < 200; ++i ) {
+    doc += i ? "" : "WEBVTT\n\n";
+    doc += "00:01.000 --> 00:02.000 align:start line:0\n<i>Hello</i>\n\n";
+  }
+  parse( doc );
+  webvtt_profile p = profile();
+  EXPECT_LT( 0u, p.nanoseconds[ WEBVTT_PHASE_PARSE ] );
+  EXPECT_LT( 0u, p.nanoseconds[ WEBVTT_PHASE_PARSE_CUETEXT ] );
+  EXPECT_LE( p.nanoseconds[ WEBVTT_PHASE_SETTINGS ],
+             p.nanoseconds[ WEBVTT_PHASE_TIMINGS ] );
+  EXPECT_LE( p.nanoseconds[ WEBVTT_PHASE_TIMINGS ],
+             p.nanoseconds[ WEBVTT_PHASE_PARSE ] );
+}
+
+/**
+ * With profiling off, only the times are left out
+ */
+TEST_F(ProfileTest, Disabled)
+{
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_set_profiling( parser, 0 ) );
+  parse( document() );
+  webvtt_profile p = profile();
+  for( int i = 0; i < WEBVTT_PHASES; ++i ) {
+    EXPECT_EQ( 0u, p.nanoseconds[ i ] ) << i;
+  }
+  EXPECT_EQ( 2u, p.cues_emitted );
+  EXPECT_EQ( 3u, p.calls[ WEBVTT_PHASE_TIMINGS ] );
+}
+
+TEST_F(ProfileTest, ClearedOnReset)
+{
+  parse( document() );
+  webvtt_reset_parser( parser );
+  webvtt_profile p = profile();
+  EXPECT_EQ( 0u, p.bytes );
+  EXPECT_EQ( 0u, p.lines );
+  EXPECT_EQ( 0u, p.cues_emitted );
+  EXPECT_EQ( 0u, p.calls[ WEBVTT_PHASE_PARSE ] );
+
+  parse( document() );
+  EXPECT_EQ( 2u, profile().cues_emitted );
+}
+
+TEST_F(ProfileTest, Validator)
+{
+  webvtt_parser validator;
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_create_validator( &error, this, &validator ) );
+  std::string doc = document();
+  webvtt_parse_chunk( validator, doc.data(), (webvtt_uint)doc.size() );
+  webvtt_finish_parsing( validator );
+  webvtt_profile p;
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_get_profile( validator, &p ) );
+  EXPECT_EQ( 3u, p.cues_emitted );
+  EXPECT_EQ( 1u, p.cues_dropped );
+  EXPECT_EQ( 0u, p.calls[ WEBVTT_PHASE_PARSE_CUETEXT ] );
+  webvtt_delete_parser( validator );
+}
+
+namespace
+{
+  class StringParser : public WebVTT::AbstractParser
+  {
+  public:
+    virtual bool reportError( const WebVTT::Error & ) { return true; }
+    virtual void parsedCue( WebVTT::Cue & ) { }
+
+    void parse( const std::string &text )
+    {
+      parseChunk( text.data(), (webvtt_uint)text.size() );
+      finishParsing();
+    }
+  };
+}
+
+TEST_F(ProfileTest, Wrapper)
+{
+  StringParser wrapped;
+  std::string doc = document();
+  EXPECT_EQ( WEBVTT_SUCCESS, wrapped.setProfiling() );
+  wrapped.parse( doc );
+  EXPECT_EQ( doc.size(), wrapped.profile().bytes );
+  EXPECT_EQ( 2u, wrapped.profile().cues_emitted );
+}
+
+TEST_F(ProfileTest, InvalidParam)
+{
+  webvtt_profile p;
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_get_profile( 0, &p ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_get_profile( parser, 0 ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_set_profiling( 0, 1 ) );
+}
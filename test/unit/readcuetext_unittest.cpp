@@ -38,7 +38,7 @@ public:
   }
 
   std::string cuetext() const {
-    return std::string( reinterpret_cast<const char *>( cue->body.d->text ) );
+    return std::string( webvtt_string_text( &cue->body ) );
   }
 
   webvtt_state_value_type uptype() const {
@@ -46,8 +46,7 @@ public:
   }
 
   std::string uptext() const {
-    return std::string( reinterpret_cast<const char *>(
-      (self->top+1)->v.text.d->text ) );
+    return std::string( webvtt_string_text( &(self->top+1)->v.text ) );
   }
 
 private:
@@ -249,3 +248,66 @@ TEST_F(ReadCuetext,FinishedOnCueTimesSeparator)
   EXPECT_EQ( "-->", uptext() );
 }
 
+
+/**
+ * A line split between buffers is joined up again
+ */
+TEST_F(ReadCuetext,MultiBuffersSplitLine)
+{
+  webvtt_uint pos = 0;
+  ASSERT_EQ( WEBVTT_UNFINISHED, read_cuetext( "Cue", pos, false ) );
+  EXPECT_EQ( 3, pos );
+  pos = 0;
+  ASSERT_EQ( WEBVTT_UNFINISHED, read_cuetext( "Te", pos, false ) );
+  pos = 0;
+  ASSERT_EQ( WEBVTT_SUCCESS, read_cuetext( "xt\nmore\n\n", pos ) );
+  EXPECT_EQ( 9, pos );
+  EXPECT_EQ( "CueText\nmore", cuetext() );
+}
+
+/**
+ * A CR at the end of a buffer may be followed by an LF in the next one, or by
+ * the next line
+ */
+TEST_F(ReadCuetext,MultiBuffersSplitCRLF)
+{
+  webvtt_uint pos = 0;
+  ASSERT_EQ( WEBVTT_UNFINISHED, read_cuetext( "CueText\r", pos, false ) );
+  pos = 0;
+  ASSERT_EQ( WEBVTT_UNFINISHED, read_cuetext( "\nmore\r", pos, false ) );
+  EXPECT_EQ( 6, pos );
+  pos = 0;
+  ASSERT_EQ( WEBVTT_SUCCESS, read_cuetext( "again\r\r", pos ) );
+  EXPECT_EQ( 7, pos );
+  EXPECT_EQ( "CueText\nmore\nagain", cuetext() );
+}
+
+/**
+ * NUL bytes are replaced with U+FFFD, in a line split between buffers or not
+ */
+TEST_F(ReadCuetext,NullBytes)
+{
+  webvtt_uint pos = 0;
+  ASSERT_EQ( WEBVTT_UNFINISHED,
+             read_cuetext( std::string( "a\0b\nc\0", 6 ), pos, false ) );
+  pos = 0;
+  ASSERT_EQ( WEBVTT_SUCCESS, read_cuetext( "d\n\n", pos ) );
+  EXPECT_EQ( "a\xEF\xBF\xBD" "b\nc\xEF\xBF\xBD" "d", cuetext() );
+}
+
+/**
+ * A line holding the cue-times separator is handed to T_CUEREAD whole, even
+ * when it is split between buffers
+ */
+TEST_F(ReadCuetext,MultiBuffersCueTimesSeparator)
+{
+  webvtt_uint pos = 0;
+  ASSERT_EQ( WEBVTT_UNFINISHED, read_cuetext( "CueText\n00:01.000 -", pos,
+                                              false ) );
+  pos = 0;
+  ASSERT_EQ( WEBVTT_SUCCESS, read_cuetext( "-> 00:02.000\n", pos ) );
+  EXPECT_EQ( 13, pos );
+  EXPECT_EQ( "CueText", cuetext() );
+  ASSERT_EQ( V_TEXT, uptype() );
+  EXPECT_EQ( "00:01.000 --> 00:02.000", uptext() );
+}
@@ -0,0 +1,259 @@
+#include "chunkparser_testfixture"
+
+class RegionTest : public ChunkParserTest
+{
+public:
+  std::string regionId( int index ) const
+  {
+    const webvtt_region *region = webvtt_get_region( parser, index );
+    return std::string( webvtt_string_text( &region->id ),
+                        webvtt_string_length( &region->id ) );
+  }
+};
+
+static const char document[] =
+  "WEBVTT\n\n"
+  "REGION\n"
+  "id:fred width:40% lines:3\n"
+  "regionanchor:0%,100% viewportanchor:10%,90% scroll:up\n\n"
+  "REGION\n"
+  "id:bill width:40% lines:3 regionanchor:100%,100%\n"
+  "viewportanchor:90%,90%\n\n"
+  "00:00.000 --> 00:20.000 region:fred align:left\n"
+  "Hi, my name is Fred\n\n"
+  "00:02.500 --> 00:22.500 region:bill align:right\n"
+  "Hi, I'm Bill\n\n"
+  "00:03.000 --> 00:04.000\n"
+  "Nobody\n";
+
+TEST_F(RegionTest, ParsesRegions)
+{
+  parse( document );
+  EXPECT_EQ( 0U, errors.size() );
+  ASSERT_EQ( 2U, webvtt_region_count( parser ) );
+
+  const webvtt_region *fred = webvtt_get_region( parser, 0 );
+  EXPECT_EQ( "fred", regionId( 0 ) );
+  EXPECT_EQ( 40U, fred->width );
+  EXPECT_EQ( 3U, fred->lines );
+  EXPECT_EQ( 0U, fred->region_anchor_x );
+  EXPECT_EQ( 100U, fred->region_anchor_y );
+  EXPECT_EQ( 10U, fred->viewport_anchor_x );
+  EXPECT_EQ( 90U, fred->viewport_anchor_y );
+  EXPECT_EQ( WEBVTT_SCROLL_UP, fred->scroll );
+
+  const webvtt_region *bill = webvtt_get_region( parser, 1 );
+  EXPECT_EQ( "bill", regionId( 1 ) );
+  EXPECT_EQ( 100U, bill->region_anchor_x );
+  EXPECT_EQ( 90U, bill->viewport_anchor_x );
+  EXPECT_EQ( WEBVTT_SCROLL_NONE, bill->scroll );
+
+  EXPECT_EQ( 0, webvtt_get_region( parser, 2 ) );
+  EXPECT_EQ( 0, webvtt_get_region( parser, WEBVTT_NO_REGION ) );
+}
+
+TEST_F(RegionTest, CuesHaveRegionIndex)
+{
+  parse( document );
+  ASSERT_EQ( 3U, cues.size() );
+  EXPECT_EQ( webvtt_get_region( parser, 0 ), cues[ 0 ]->settings.region );
+  EXPECT_EQ( WEBVTT_ALIGN_LEFT, cues[ 0 ]->settings.align );
+  EXPECT_EQ( webvtt_get_region( parser, 1 ), cues[ 1 ]->settings.region );
+  EXPECT_EQ( 0, cues[ 2 ]->settings.region );
+}
+
+TEST_F(RegionTest, AcrossChunks)
+{
+  parse( document, 1 );
+  EXPECT_EQ( 0U, errors.size() );
+  ASSERT_EQ( 2U, webvtt_region_count( parser ) );
+  EXPECT_EQ( "bill", regionId( 1 ) );
+  ASSERT_EQ( 3U, cues.size() );
+  EXPECT_EQ( webvtt_get_region( parser, 1 ), cues[ 1 ]->settings.region );
+}
+
+TEST_F(RegionTest, Defaults)
+{
+  parse( "WEBVTT\n\nREGION\nid:r\n\n00:00.000 --> 00:01.000 region:r\nText\n" );
+  ASSERT_EQ( 1U, webvtt_region_count( parser ) );
+  const webvtt_region *r = webvtt_get_region( parser, 0 );
+  EXPECT_EQ( 100U, r->width );
+  EXPECT_EQ( 3U, r->lines );
+  EXPECT_EQ( 0U, r->region_anchor_x );
+  EXPECT_EQ( 100U, r->region_anchor_y );
+  EXPECT_EQ( 0U, r->viewport_anchor_x );
+  EXPECT_EQ( 100U, r->viewport_anchor_y );
+  EXPECT_EQ( WEBVTT_SCROLL_NONE, r->scroll );
+}
+
+TEST_F(RegionTest, BadSettings)
+{
+  parse( "WEBVTT\n\n"
+         "REGION\n"
+         "id:r width:140% lines:-1 scroll:down\n"
+         "regionanchor:10% bogus:1 viewportanchor:1%,2%\n\n"
+         "00:00.000 --> 00:01.000\nText\n" );
+  ASSERT_EQ( 5U, errors.size() );
+  EXPECT_EQ( WEBVTT_INVALID_REGION_SETTING, errors[ 0 ].error );
+  EXPECT_EQ( 4U, errors[ 0 ].line );
+  EXPECT_EQ( 6U, errors[ 0 ].column );
+  EXPECT_EQ( 17U, errors[ 1 ].column );
+  EXPECT_EQ( 26U, errors[ 2 ].column );
+  EXPECT_EQ( 5U, errors[ 3 ].line );
+  EXPECT_EQ( 1U, errors[ 3 ].column );
+  EXPECT_EQ( 18U, errors[ 4 ].column );
+
+  ASSERT_EQ( 1U, webvtt_region_count( parser ) );
+  const webvtt_region *r = webvtt_get_region( parser, 0 );
+  EXPECT_EQ( 100U, r->width );
+  EXPECT_EQ( 1U, r->viewport_anchor_x );
+  EXPECT_EQ( 2U, r->viewport_anchor_y );
+}
+
+TEST_F(RegionTest, WithoutIdIsDiscarded)
+{
+  parse( "WEBVTT\n\nREGION\nwidth:50%\n\n00:00.000 --> 00:01.000\nText\n" );
+  EXPECT_EQ( 0U, errors.size() );
+  EXPECT_EQ( 0U, webvtt_region_count( parser ) );
+  EXPECT_EQ( 1U, cues.size() );
+}
+
+TEST_F(RegionTest, LaterDefinitionReplaces)
+{
+  parse( "WEBVTT\n\n"
+         "REGION\nid:a width:10%\n\n"
+         "REGION\nid:b\n\n"
+         "REGION\nid:a width:20%\n\n"
+         "00:00.000 --> 00:01.000 region:a\nText\n" );
+  ASSERT_EQ( 2U, webvtt_region_count( parser ) );
+  EXPECT_EQ( "a", regionId( 0 ) );
+  EXPECT_EQ( 20U, webvtt_get_region( parser, 0 )->width );
+  ASSERT_EQ( 1U, cues.size() );
+  EXPECT_EQ( webvtt_get_region( parser, 0 ), cues[ 0 ]->settings.region );
+}
+
+TEST_F(RegionTest, UnknownRegion)
+{
+  parse( "WEBVTT\n\nREGION\nid:a\n\n"
+         "00:00.000 --> 00:01.000 region:b region:a region:a\nText\n" );
+  ASSERT_EQ( 2U, errors.size() );
+  EXPECT_EQ( WEBVTT_REGION_BAD_VALUE, errors[ 0 ].error );
+  EXPECT_EQ( 25U, errors[ 0 ].column );
+  EXPECT_EQ( WEBVTT_REGION_ALREADY_SET, errors[ 1 ].error );
+  ASSERT_EQ( 1U, cues.size() );
+  EXPECT_EQ( webvtt_get_region( parser, 0 ), cues[ 0 ]->settings.region );
+}
+
+/**
+ * A REGION block after the first cue is not a region definition
+ */
+TEST_F(RegionTest, OnlyInHeader)
+{
+  parse( "WEBVTT\n\n"
+         "00:00.000 --> 00:01.000\nText\n\n"
+         "REGION\nid:a\n\n"
+         "00:01.000 --> 00:02.000 region:a\nText\n" );
+  EXPECT_EQ( 0U, webvtt_region_count( parser ) );
+  EXPECT_EQ( 2U, cues.size() );
+  ASSERT_EQ( 2U, errors.size() );
+  EXPECT_EQ( WEBVTT_CUE_INCOMPLETE, errors[ 0 ].error );
+  EXPECT_EQ( WEBVTT_REGION_BAD_VALUE, errors[ 1 ].error );
+}
+
+/**
+ * A block whose second line holds cue timings is a cue, even if its first
+ * line reads REGION; that line is the cue's id
+ */
+TEST_F(RegionTest, HeaderIsCueId)
+{
+  const std::string text =
+    "WEBVTT\n\nREGION\n00:00.000 --> 00:01.000 align:start\nhello\n\n"
+    "00:01.000 --> 00:02.000\nbye";
+  for( size_t chunkSize = 1; chunkSize <= text.size(); chunkSize *= 3 ) {
+    clear();
+    webvtt_reset_parser( parser );
+    parse( text, chunkSize );
+    EXPECT_EQ( 0U, errors.size() ) << chunkSize;
+    EXPECT_EQ( 0U, webvtt_region_count( parser ) );
+    ASSERT_EQ( 2U, cues.size() ) << chunkSize;
+    EXPECT_STREQ( "REGION", webvtt_string_text( &cues[ 0 ]->id ) );
+    EXPECT_EQ( 1000U, cues[ 0 ]->until );
+    EXPECT_EQ( WEBVTT_ALIGN_START, cues[ 0 ]->settings.align );
+    EXPECT_STREQ( "hello", webvtt_string_text( &cues[ 0 ]->body ) );
+    EXPECT_STREQ( "", webvtt_string_text( &cues[ 1 ]->id ) );
+  }
+
+  clear();
+  webvtt_reset_parser( parser );
+  parse( "WEBVTT\n\nREGION\n00:00.000 --> 00:01.000" );
+  ASSERT_EQ( 1U, cues.size() );
+  EXPECT_STREQ( "REGION", webvtt_string_text( &cues[ 0 ]->id ) );
+}
+
+TEST_F(RegionTest, ResetForgetsRegions)
+{
+  parse( document );
+  webvtt_reset_parser( parser );
+  clear();
+  EXPECT_EQ( 0U, webvtt_region_count( parser ) );
+  parse( "WEBVTT\n\nREGION\nid:x\n\n00:00.000 --> 00:01.000 region:x\nT\n" );
+  ASSERT_EQ( 1U, webvtt_region_count( parser ) );
+  EXPECT_EQ( "x", regionId( 0 ) );
+}
+
+/**
+ * A cue's region outlives the parser's table, when it is reset or deleted
+ */
+TEST_F(RegionTest, CueKeepsRegion)
+{
+  parse( document );
+  ASSERT_EQ( 3U, cues.size() );
+  webvtt_reset_parser( parser );
+  parse( "WEBVTT\n\nREGION\nid:x width:7%\n\n"
+         "00:00.000 --> 00:01.000 region:x\nT\n" );
+  ASSERT_EQ( 4U, cues.size() );
+  webvtt_delete_parser( parser );
+  parser = 0;
+
+  const webvtt_region *fred = cues[ 0 ]->settings.region;
+  ASSERT_TRUE( fred != 0 );
+  EXPECT_STREQ( "fred", webvtt_string_text( &fred->id ) );
+  EXPECT_EQ( 40U, fred->width );
+  EXPECT_STREQ( "bill", webvtt_string_text( &cues[ 1 ]->settings.region->id ) );
+  EXPECT_STREQ( "x", webvtt_string_text( &cues[ 3 ]->settings.region->id ) );
+  EXPECT_EQ( 7U, cues[ 3 ]->settings.region->width );
+
+  webvtt_ref_region( fred );
+  clear();
+  EXPECT_EQ( 90U, fred->viewport_anchor_y );
+  webvtt_release_region( &fred );
+  EXPECT_EQ( 0, fred );
+}
+
+/**
+ * A REGION block still being read when the parser is reset or deleted is
+ * released
+ */
+TEST_F(RegionTest, UnfinishedRegion)
+{
+  const char text[] = "WEBVTT\n\nREGION\nid:unfinished\nwidth:5";
+  webvtt_parse_chunk( parser, text, sizeof( text ) - 1 );
+  webvtt_reset_parser( parser );
+  EXPECT_EQ( 0U, webvtt_region_count( parser ) );
+  webvtt_parse_chunk( parser, text, sizeof( text ) - 1 );
+}
+
+TEST_F(RegionTest, Validator)
+{
+  webvtt_parser validator;
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_create_validator( &error, this, &validator ) );
+  const std::string text = std::string( document )
+    + "\n00:05.000 --> 00:06.000 region:nobody\nText\n";
+  webvtt_parse_chunk( validator, text.data(), (webvtt_uint)text.size() );
+  webvtt_finish_parsing( validator );
+  EXPECT_EQ( 2U, webvtt_region_count( validator ) );
+  webvtt_delete_parser( validator );
+  ASSERT_EQ( 1U, errors.size() );
+  EXPECT_EQ( WEBVTT_REGION_BAD_VALUE, errors[ 0 ].error );
+}
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <webvtt/parser.h>
+#include <string>
+#include <vector>
+extern "C" {
+#include "webvtt/parser_internal.h"
+}
+
+class ResetParserTest : public ::testing::Test
+{
+public:
+  struct Error
+  {
+    webvtt_uint line;
+    webvtt_uint column;
+    webvtt_error error;
+  };
+
+  virtual void SetUp()
+  {
+    count = 0;
+    ASSERT_EQ( WEBVTT_SUCCESS,
+               webvtt_create_parser( &read, &error, this, &parser ) );
+  }
+
+  virtual void TearDown()
+  {
+    webvtt_delete_parser( parser );
+    clear();
+  }
+
+  void clear()
+  {
+    for( size_t i = 0; i < cues.size(); ++i ) {
+      webvtt_release_cue( &cues[ i ] );
+    }
+    cues.clear();
+    errors.clear();
+  }
+
+  void parse( const std::string &text, bool finish = true )
+  {
+    webvtt_parse_chunk( parser, text.data(), (webvtt_uint)text.size() );
+    if( finish ) {
+      webvtt_finish_parsing( parser );
+    }
+  }
+
+  std::string id( size_t i ) const
+  {
+    return std::string( webvtt_string_text( &cues[ i ]->id ),
+                        webvtt_string_length( &cues[ i ]->id ) );
+  }
+
+  static int WEBVTT_CALLBACK countError( void *userdata, webvtt_uint,
+                                         webvtt_uint, webvtt_error )
+  {
+    ++( (ResetParserTest *)userdata )->count;
+    return 0;
+  }
+
+  webvtt_parser parser;
+  std::vector<webvtt_cue *> cues;
+  std::vector<Error> errors;
+  int count;
+
+private:
+  static void WEBVTT_CALLBACK read( void *userdata, webvtt_cue *cue )
+  {
+    ( (ResetParserTest *)userdata )->cues.push_back( cue );
+  }
+
+  static int WEBVTT_CALLBACK error( void *userdata, webvtt_uint line,
+                                    webvtt_uint col, webvtt_error error )
+  {
+    Error e = { line, col, error };
+    ( (ResetParserTest *)userdata )->errors.push_back( e );
+    return 0;
+  }
+};
+
+static const char document[] =
+  "WEBVTT\n\n"
+  "one\n"
+  "00:01.000 --> 00:02.000 align:start\n"
+  "First\n\n"
+  "two\n"
+  "00:02.000 --> 00:03.000 line:x\n"
+  "Second\n";
+
+/**
+ * A parser which has been reset parses a file exactly as a new one would
+ */
+TEST_F(ResetParserTest, ParsesAgain)
+{
+  parse( document );
+  ASSERT_EQ( 2U, cues.size() );
+  ASSERT_EQ( 1U, errors.size() );
+  clear();
+
+  webvtt_reset_parser( parser );
+  parse( document );
+  ASSERT_EQ( 2U, cues.size() );
+  EXPECT_EQ( "one", id( 0 ) );
+  EXPECT_EQ( "two", id( 1 ) );
+  ASSERT_EQ( 1U, errors.size() );
+  EXPECT_EQ( WEBVTT_LINE_BAD_VALUE, errors[ 0 ].error );
+  EXPECT_EQ( 8U, errors[ 0 ].line );
+}
+
+/**
+ * Input left over from an unfinished file does not leak into the next one
+ */
+TEST_F(ResetParserTest, DiscardsPartialInput)
+{
+  parse( "WEBVTT\n\nid\n00:01.000 --> 00:02.000\nUnfinished te", false );
+  webvtt_reset_parser( parser );
+  EXPECT_EQ( 0U, cues.size() );
+
+  parse( document );
+  ASSERT_EQ( 2U, cues.size() );
+  EXPECT_EQ( "one", id( 0 ) );
+  EXPECT_EQ( "First", std::string( webvtt_string_text( &cues[ 0 ]->body ) ) );
+  EXPECT_EQ( 1U, errors.size() );
+}
+
+/**
+ * A file which failed to parse does not affect the next one
+ */
+TEST_F(ResetParserTest, AfterParseError)
+{
+  parse( "NOT WEBVTT\n\n00:01.000 --> 00:02.000\nText\n" );
+  EXPECT_EQ( 0U, cues.size() );
+  ASSERT_EQ( 1U, errors.size() );
+  EXPECT_EQ( WEBVTT_MALFORMED_TAG, errors[ 0 ].error );
+  clear();
+
+  webvtt_reset_parser( parser );
+  parse( document );
+  EXPECT_EQ( 2U, cues.size() );
+  EXPECT_EQ( 1U, errors.size() );
+}
+
+TEST_F(ResetParserTest, Validator)
+{
+  webvtt_parser validator;
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_create_validator( &ResetParserTest::countError, this,
+                                      &validator ) );
+  webvtt_parse_chunk( validator, document, sizeof( document ) - 1 );
+  webvtt_finish_parsing( validator );
+  EXPECT_EQ( 1, count );
+
+  /* The ordering check starts over */
+  webvtt_reset_parser( validator );
+  webvtt_parse_chunk( validator, document, sizeof( document ) - 1 );
+  webvtt_finish_parsing( validator );
+  EXPECT_EQ( 2, count );
+  webvtt_delete_parser( validator );
+}
+
+/**
+ * The state stack moves to the heap when the inline frames fill, and keeps
+ * growing with every frame intact; a reset returns to the inline frames
+ */
+TEST_F(ResetParserTest, DeepStack)
+{
+  const webvtt_uint frames = 40;
+  for( webvtt_uint i = 1; i <= frames; ++i ) {
+    ASSERT_EQ( WEBVTT_SUCCESS,
+               do_push( parser, 0, 0, T_INITIAL, 0, V_NONE, i, 1 ) );
+  }
+  EXPECT_NE( parser->astack, parser->stack );
+  EXPECT_LT( frames, parser->stack_alloc );
+  for( webvtt_uint i = 1; i <= frames; ++i ) {
+    EXPECT_EQ( i, parser->stack[ i ].line ) << i;
+  }
+
+  webvtt_reset_parser( parser );
+  EXPECT_EQ( parser->astack, parser->stack );
+  parse( document );
+  EXPECT_EQ( 2U, cues.size() );
+}
+
+TEST_F(ResetParserTest, NullParser)
+{
+  webvtt_reset_parser( 0 );
+}
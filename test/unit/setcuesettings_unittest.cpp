@@ -24,6 +24,10 @@ public:
     return s;
   }
 
+  ::webvtt_status parse( const char *text, webvtt_uint length ) {
+    return ::webvtt_cue_parse_settings( 0, cue, text, length );
+  }
+
   ::webvtt_status set( const char *str ) {
     return ::webvtt_cue_set_setting_from_string( cue, str );
   }
@@ -244,3 +248,24 @@ TEST_F(SetCueSetting, NoWhitespace)
 }
 
 
+
+TEST_F(SetCueSetting, LongKeyword)
+{
+  EXPECT_EQ(WEBVTT_BAD_CUESETTING,
+            set("averyveryveryveryveryverylongkeyword:start"));
+  EXPECT_EQ(WEBVTT_BAD_CUESETTING, set("alignment:start"));
+}
+
+/**
+ * Settings are parsed in place, and only the given number of bytes is read
+ */
+TEST_F(SetCueSetting, InPlace)
+{
+  const char text[] = "align:end line:25% size:50%position:10%";
+  EXPECT_EQ(WEBVTT_SUCCESS, parse(text, 16));
+  EXPECT_EQ(WEBVTT_ALIGN_END, align());
+  EXPECT_EQ(2, line());
+  EXPECT_TRUE(snapToLines());
+  EXPECT_EQ(WEBVTT_SUCCESS, parse(text + 19, 8));
+  EXPECT_EQ(50, size());
+}
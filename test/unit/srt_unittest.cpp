@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+#include <webvtt/parser_internal.h>
+#include <webvtt/srt.h>
+#include <webvtt/writer.h>
+#include <string>
+#include <vector>
+
+class SrtTest : public ::testing::Test
+{
+public:
+  struct Error
+  {
+    webvtt_uint line;
+    webvtt_uint column;
+    webvtt_error error;
+  };
+
+  virtual void SetUp()
+  {
+    ASSERT_EQ( WEBVTT_SUCCESS,
+               webvtt_create_srt_reader( &read, &error, this, &reader ) );
+  }
+
+  virtual void TearDown()
+  {
+    webvtt_delete_srt_reader( reader );
+    for( size_t i = 0; i < cues.size(); ++i ) {
+      webvtt_release_cue( &cues[ i ] );
+    }
+  }
+
+  /* Feed 'text' to the reader in chunks of 'chunkSize' bytes */
+  void parse( const std::string &text, size_t chunkSize = 0x1000 )
+  {
+    for( size_t i = 0; i < text.size(); i += chunkSize ) {
+      size_t n = std::min( chunkSize, text.size() - i );
+      ASSERT_EQ( WEBVTT_SUCCESS,
+                 webvtt_srt_parse_chunk( reader, text.data() + i,
+                                         (webvtt_uint)n ) );
+    }
+    ASSERT_EQ( WEBVTT_SUCCESS, webvtt_srt_finish_parsing( reader ) );
+  }
+
+  std::string write( webvtt_output_format format )
+  {
+    std::string out;
+    webvtt_writer writer;
+    EXPECT_EQ( WEBVTT_SUCCESS,
+               webvtt_create_writer( format, &append, &out, &writer ) );
+    for( size_t i = 0; i < cues.size(); ++i ) {
+      EXPECT_EQ( WEBVTT_SUCCESS, webvtt_writer_write_cue( writer, cues[ i ] ) );
+    }
+    webvtt_delete_writer( writer );
+    return out;
+  }
+
+  static std::string text( const webvtt_string &str )
+  {
+    return std::string( webvtt_string_text( &str ),
+                        webvtt_string_length( &str ) );
+  }
+
+  webvtt_srt_reader reader;
+  std::vector<webvtt_cue *> cues;
+  std::vector<Error> errors;
+
+private:
+  static void WEBVTT_CALLBACK read( void *userdata, webvtt_cue *cue )
+  {
+    reinterpret_cast<SrtTest *>( userdata )->cues.push_back( cue );
+  }
+
+  static int WEBVTT_CALLBACK error( void *userdata, webvtt_uint line,
+                                    webvtt_uint col, webvtt_error err )
+  {
+    Error e = { line, col, err };
+    reinterpret_cast<SrtTest *>( userdata )->errors.push_back( e );
+    return 0;
+  }
+
+  static int WEBVTT_CALLBACK append( void *userdata, const char *buffer,
+                                     webvtt_uint len )
+  {
+    reinterpret_cast<std::string *>( userdata )->append( buffer, len );
+    return 0;
+  }
+};
+
+static const char basicSrt[] =
+  "1\r\n"
+  "00:00:01,000 --> 00:00:04,500\r\n"
+  "Hello <b>world</b>\r\n"
+  "second line\r\n"
+  "\r\n"
+  "2\r\n"
+  "01:02:03,004 --> 01:02:05,000\r\n"
+  "<font color=\"#FF0000\">red</font> & <i>italic</i>\r\n";
+
+TEST_F(SrtTest,ReadsCues)
+{
+  parse( basicSrt );
+  ASSERT_EQ( 2, cues.size() );
+  EXPECT_TRUE( errors.empty() );
+
+  EXPECT_EQ( "1", text( cues[ 0 ]->id ) );
+  EXPECT_EQ( 1000, cues[ 0 ]->from );
+  EXPECT_EQ( 4500, cues[ 0 ]->until );
+  EXPECT_EQ( "Hello <b>world</b>\nsecond line", text( cues[ 0 ]->body ) );
+
+  EXPECT_EQ( "2", text( cues[ 1 ]->id ) );
+  EXPECT_EQ( 3723004, cues[ 1 ]->from );
+  EXPECT_EQ( 3725000, cues[ 1 ]->until );
+  EXPECT_EQ( "<c.red>red</c> &amp; <i>italic</i>", text( cues[ 1 ]->body ) );
+}
+
+/**
+ * The cue text is parsed into a node tree, as with the WebVTT parser.
+ */
+TEST_F(SrtTest,BuildsNodeTree)
+{
+  parse( basicSrt );
+  ASSERT_EQ( 2, cues.size() );
+  ASSERT_TRUE( cues[ 0 ]->node_head != NULL );
+  webvtt_internal_node_data *head = cues[ 0 ]->node_head->data.internal_data;
+  ASSERT_EQ( 3, head->length );
+  EXPECT_EQ( WEBVTT_TEXT, head->children[ 0 ]->kind );
+  EXPECT_EQ( WEBVTT_BOLD, head->children[ 1 ]->kind );
+  EXPECT_EQ( WEBVTT_TEXT, head->children[ 2 ]->kind );
+}
+
+/**
+ * Splitting the input at every byte (including between CR and LF) must not
+ * change the result.
+ */
+TEST_F(SrtTest,ByteAtATime)
+{
+  parse( basicSrt, 1 );
+  ASSERT_EQ( 2, cues.size() );
+  EXPECT_TRUE( errors.empty() );
+  EXPECT_EQ( "Hello <b>world</b>\nsecond line", text( cues[ 0 ]->body ) );
+  EXPECT_EQ( "<c.red>red</c> &amp; <i>italic</i>", text( cues[ 1 ]->body ) );
+}
+
+TEST_F(SrtTest,DropsUnknownMarkup)
+{
+  parse( "1\n00:00:01,000 --> 00:00:02,000\n{\\an8}<span>top</span> 1 < 2\n" );
+  ASSERT_EQ( 1, cues.size() );
+  EXPECT_EQ( "top 1 &lt; 2", text( cues[ 0 ]->body ) );
+}
+
+TEST_F(SrtTest,MissingTimings)
+{
+  parse( "1\nHello\n\n2\n00:00:01,000 --> 00:00:02,000\nWorld\n" );
+  ASSERT_EQ( 1, cues.size() );
+  EXPECT_EQ( "2", text( cues[ 0 ]->id ) );
+  ASSERT_EQ( 1, errors.size() );
+  EXPECT_EQ( WEBVTT_CUE_INCOMPLETE, errors[ 0 ].error );
+  EXPECT_EQ( 2, errors[ 0 ].line );
+}
+
+TEST_F(SrtTest,BadTimestamp)
+{
+  parse( "1\n00:00:01,000 --> later\nHello\n\n"
+         "2\n00:00:01,000 --> 00:00:02,000\nWorld\n" );
+  ASSERT_EQ( 1, cues.size() );
+  EXPECT_EQ( "World", text( cues[ 0 ]->body ) );
+  ASSERT_EQ( 1, errors.size() );
+  EXPECT_EQ( WEBVTT_EXPECTED_TIMESTAMP, errors[ 0 ].error );
+  EXPECT_EQ( 2, errors[ 0 ].line );
+  EXPECT_EQ( 18, errors[ 0 ].column );
+}
+
+TEST_F(SrtTest,WriteSrt)
+{
+  parse( basicSrt );
+  EXPECT_EQ( "1\n"
+             "00:00:01,000 --> 00:00:04,500\n"
+             "Hello <b>world</b>\nsecond line\n"
+             "\n"
+             "2\n"
+             "01:02:03,004 --> 01:02:05,000\n"
+             "<font color=\"red\">red</font> & <i>italic</i>\n"
+             "\n", write( WEBVTT_FORMAT_SRT ) );
+}
+
+TEST_F(SrtTest,WriteVtt)
+{
+  parse( basicSrt );
+  EXPECT_EQ( "WEBVTT\n"
+             "\n"
+             "1\n"
+             "00:00:01.000 --> 00:00:04.500\n"
+             "Hello <b>world</b>\nsecond line\n"
+             "\n"
+             "2\n"
+             "01:02:03.004 --> 01:02:05.000\n"
+             "<c.red>red</c> &amp; <i>italic</i>\n"
+             "\n", write( WEBVTT_FORMAT_VTT ) );
+}
+
+/**
+ * Cues without a node tree are written with their markup removed.
+ */
+TEST_F(SrtTest,WriteSrtWithoutNodes)
+{
+  webvtt_cue *cue;
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_create_cue( &cue ) );
+  cue->from = 0;
+  cue->until = 61001;
+  webvtt_string_append( &cue->body, "<v Bob>a &lt;b&gt; &amp; c</v>", -1 );
+  cues.push_back( cue );
+  EXPECT_EQ( "1\n00:00:00,000 --> 00:01:01,001\na <b> & c\n\n",
+             write( WEBVTT_FORMAT_SRT ) );
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <webvttxx/parser>
+#include <string>
+#include <vector>
+
+using namespace WebVTT;
+
+static const char document[] =
+  "WEBVTT\n\n"
+  "00:00.000 --> 00:01.000 align:bad\nOne\n\n"
+  "00:01.000 --> 00:02.000 size:bad\nTwo\n";
+
+namespace
+{
+  class CollectingParser : public Parser<CollectingParser>
+  {
+  public:
+    CollectingParser() : stopOnError( false ) { }
+
+    void parsedCue( Cue &cue ) { cues.push_back( cue ); }
+
+    bool reportError( const Error &error )
+    {
+      errors.push_back( error );
+      return !stopOnError;
+    }
+
+    ::webvtt_status parse( const char *text )
+    {
+      ::webvtt_status status = parseChunk( text, (webvtt_uint)strlen( text ) );
+      if( WEBVTT_FAILED( status ) ) {
+        return status;
+      }
+      return finishParsing();
+    }
+
+    bool stopOnError;
+    std::vector<Cue> cues;
+    std::vector<Error> errors;
+  };
+
+  /**
+   * No reportError: errors are suppressed in the parser
+   */
+  class CueOnlyParser : public Parser<CueOnlyParser>
+  {
+  public:
+    void parsedCue( Cue &cue )
+    {
+      bodies.push_back( std::string( cue.bodyView().data(),
+                                     cue.bodyView().length() ) );
+    }
+
+    webvtt_uint errorCount( ::webvtt_error error ) const
+    {
+      return webvtt_error_count( parser, error );
+    }
+
+    std::vector<std::string> bodies;
+  };
+}
+
+TEST(StaticParser, CuesAndErrors)
+{
+  CollectingParser parser;
+  ASSERT_EQ( WEBVTT_SUCCESS, parser.parse( document ) );
+  ASSERT_EQ( 2U, parser.cues.size() );
+  EXPECT_TRUE( parser.cues[ 1 ].bodyView() == StringView( "Two" ) );
+  ASSERT_EQ( 2U, parser.errors.size() );
+  EXPECT_EQ( WEBVTT_ALIGN_BAD_VALUE, parser.errors[ 0 ].error() );
+  EXPECT_EQ( WEBVTT_SIZE_BAD_VALUE, parser.errors[ 1 ].error() );
+}
+
+/**
+ * Returning false from reportError stops the parser at errors which allow it
+ */
+TEST(StaticParser, ErrorStopsParsing)
+{
+  CollectingParser parser;
+  parser.stopOnError = true;
+  EXPECT_TRUE( WEBVTT_FAILED( parser.parse( "WEBVTT\n\n"
+                                            "00:00.000 --> 00:01.000\nOne\n\n"
+                                            "junk\n\n"
+                                            "00:02.000 --> 00:03.000\nTwo\n" ) ) );
+  ASSERT_EQ( 1U, parser.errors.size() );
+  EXPECT_EQ( WEBVTT_CUE_INCOMPLETE, parser.errors[ 0 ].error() );
+  EXPECT_EQ( 1U, parser.cues.size() );
+}
+
+TEST(StaticParser, WithoutReportError)
+{
+  CueOnlyParser parser;
+  parser.parseChunk( document, sizeof( document ) - 1 );
+  parser.finishParsing();
+  ASSERT_EQ( 2U, parser.bodies.size() );
+  EXPECT_EQ( "One", parser.bodies[ 0 ] );
+  /* Suppressed errors are still counted */
+  EXPECT_EQ( 1U, parser.errorCount( WEBVTT_ALIGN_BAD_VALUE ) );
+
+  parser.reset();
+  parser.parseChunk( document, 40 );
+  parser.finishParsing();
+  EXPECT_EQ( 3U, parser.bodies.size() );
+}
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 #include <webvttxx/string>
+#include <thread>
+#include <vector>
+extern "C" {
+#include "webvtt/string_internal.h"
+}
 
 using namespace WebVTT;
 
@@ -308,7 +313,7 @@ TEST(String,UTF32RequiresSurrogate)
 TEST(String,IsEmpty)
 {
   const char ne[] = "Not empty!";
-  webvtt_string str = { 0 };
+  webvtt_string str;
   webvtt_init_string( &str );
   ASSERT_TRUE( webvtt_string_is_empty( &str ) );
   webvtt_release_string( &str );
@@ -333,6 +338,218 @@ TEST(String,IsEmptyCXX)
   ASSERT_FALSE( str.isEmpty() );
 }
 
+/**
+ * Assigning a String releases the text it held, and moving one leaves the
+ * source empty without touching the text's reference count
+ */
+TEST(String,AssignAndMoveCXX)
+{
+  /* Too long to be kept in the string itself, so that it is shared */
+  const char *text = "Hello, this is shared";
+  webvtt_string raw;
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_create_string_with_text( &raw, text, -1 ) );
+  {
+    String a( &raw ), b( "World" );
+    EXPECT_EQ( 2L, (long)raw.d->refs.value );
+    a = b;
+    EXPECT_EQ( 1L, (long)raw.d->refs.value );
+    a = String( &raw );
+    EXPECT_EQ( 2L, (long)raw.d->refs.value );
+
+    String c( std::move( a ) );
+    EXPECT_EQ( 2L, (long)raw.d->refs.value );
+    EXPECT_TRUE( a.isEmpty() );
+    EXPECT_STREQ( "", a.utf8() );
+    EXPECT_STREQ( text, c.utf8() );
+
+    b = std::move( c );
+    EXPECT_EQ( 2L, (long)raw.d->refs.value );
+    EXPECT_STREQ( text, b.utf8() );
+
+    swap( a, b );
+    EXPECT_STREQ( text, a.utf8() );
+    a = a;
+    EXPECT_EQ( 2L, (long)raw.d->refs.value );
+  }
+  EXPECT_EQ( 1L, (long)raw.d->refs.value );
+  webvtt_release_string( &raw );
+}
+
+TEST(String,ViewCXX)
+{
+  String str( "Hello World" );
+  StringView view = str.view();
+  EXPECT_EQ( str.utf8(), view.data() );
+  EXPECT_EQ( 11U, view.length() );
+  EXPECT_TRUE( view == StringView( "Hello World" ) );
+  EXPECT_TRUE( view != StringView( "Hello" ) );
+  EXPECT_EQ( 'W', view[ 6 ] );
+  EXPECT_EQ( view.data() + 11, view.end() );
+
+  EXPECT_TRUE( String().view().isEmpty() );
+  EXPECT_STREQ( "", String().view().data() );
+}
+
+/**
+ * Korean, an emoji (a surrogate pair in UTF16) and ASCII, long enough to take
+ * the block-at-a-time ASCII path
+ */
+static const char UTF8Mixed[] =
+  "\xEC\x95\x88\xEB\x85\x95 \xF0\x9F\x98\x80 0123456789abcdefghijklmnop"
+  "\xED\x95\x98 end";
+
+TEST(String,UTF8ToUTF16Buffer)
+{
+  const char *end = UTF8Mixed + sizeof( UTF8Mixed ) - 1;
+  webvtt_uint16 out[ 64 ];
+  const char *next = 0;
+  webvtt_uint n = webvtt_utf8_to_utf16_buffer( UTF8Mixed, end, out, 64,
+                                               &next );
+  ASSERT_EQ( 37U, n );
+  EXPECT_EQ( end, next );
+  EXPECT_EQ( n, webvtt_utf8_utf16_length( UTF8Mixed, end ) );
+  EXPECT_EQ( 0xC548, out[ 0 ] );
+  EXPECT_EQ( ' ', out[ 2 ] );
+  EXPECT_EQ( 0xD83D, out[ 3 ] );
+  EXPECT_EQ( 0xDE00, out[ 4 ] );
+  EXPECT_EQ( 'p', out[ 31 ] );
+  EXPECT_EQ( 0xD558, out[ 32 ] );
+  EXPECT_EQ( 'd', out[ 36 ] );
+
+  /* The same units as a character at a time */
+  String str( UTF8Mixed );
+  CodePointIndex index( str.view() );
+  webvtt_uint i = 0;
+  for( uint ch = 0; ch < index.charCount(); ++ch ) {
+    uint16 high, low = index.utf16At( ch, high );
+    if( high ) {
+      EXPECT_EQ( high, out[ i++ ] );
+    }
+    EXPECT_EQ( low, out[ i++ ] ) << "character " << ch;
+  }
+  EXPECT_EQ( n, i );
+}
+
+TEST(String,UTF8ToUTF32Buffer)
+{
+  const char *end = UTF8Mixed + sizeof( UTF8Mixed ) - 1;
+  webvtt_uint32 out[ 64 ];
+  webvtt_uint n = webvtt_utf8_to_utf32_buffer( UTF8Mixed, end, out, 64, 0 );
+  ASSERT_EQ( 36U, n );
+  EXPECT_EQ( 0xC548U, out[ 0 ] );
+  EXPECT_EQ( 0x1F600U, out[ 3 ] );
+  EXPECT_EQ( 'a', out[ 15 ] );
+  EXPECT_EQ( 0xD558U, out[ 31 ] );
+  EXPECT_EQ( n, String( UTF8Mixed ).charCount() );
+}
+
+/**
+ * Conversion stops before a character which does not fit, and a surrogate
+ * pair is never split
+ */
+TEST(String,UTF8ToUTF16BufferFull)
+{
+  const char *end = UTF8Mixed + sizeof( UTF8Mixed ) - 1;
+  webvtt_uint16 out[ 64 ];
+  const char *next = 0;
+  EXPECT_EQ( 3U, webvtt_utf8_to_utf16_buffer( UTF8Mixed, end, out, 4,
+                                              &next ) );
+  EXPECT_EQ( UTF8Mixed + 7, next );
+  EXPECT_EQ( 2U, webvtt_utf8_to_utf16_buffer( next, end, out, 2, &next ) );
+  EXPECT_EQ( 0xDE00, out[ 1 ] );
+  EXPECT_EQ( 20U, webvtt_utf8_to_utf16_buffer( next, end, out, 20, &next ) );
+  EXPECT_EQ( 'j', *next );
+  EXPECT_EQ( 0U, webvtt_utf8_to_utf16_buffer( next, end, out, 0, &next ) );
+  EXPECT_EQ( 'j', *next );
+}
+
+/**
+ * Malformed sequences are each replaced with U+FFFD
+ */
+TEST(String,UTF8ToUTF32Malformed)
+{
+  static const char text[] =
+    "a\x80\x80\x80"  /* stray trail bytes */
+    "b\xC0\xAF"       /* overlong '/' */
+    "c\xED\xA0\x80"  /* surrogate */
+    "d\xEF\xBF\xBE"  /* non-character */
+    "e\xE2\x82"       /* truncated, followed by ASCII */
+    "f\xFF"
+    "g\xF0\x9F";     /* truncated at the end */
+  webvtt_uint32 out[ 32 ];
+  const webvtt_uint32 expected[] = {
+    'a', 0xFFFD, 'b', 0xFFFD, 'c', 0xFFFD, 'd', 0xFFFD, 'e', 0xFFFD,
+    'f', 0xFFFD, 'g', 0xFFFD
+  };
+  webvtt_uint n = webvtt_utf8_to_utf32_buffer( text, text + sizeof( text ) - 1,
+                                               out, 32, 0 );
+  ASSERT_EQ( sizeof( expected ) / sizeof( *expected ), n );
+  for( webvtt_uint i = 0; i < n; ++i ) {
+    EXPECT_EQ( expected[ i ], out[ i ] ) << "at " << i;
+  }
+
+  const char *p = text + 1;
+  EXPECT_EQ( 0xFFFDU, webvtt_utf8_decode( &p, text + sizeof( text ) - 1 ) );
+  EXPECT_EQ( 'b', *p );
+  EXPECT_EQ( 0U, webvtt_utf8_decode( &p, p ) );
+}
+
+TEST(String,CodePointsCXX)
+{
+  String str( UTF8Mixed );
+  webvtt_uint32 out[ 64 ];
+  uint n = str.copyUtf32( out, 64 );
+  uint i = 0;
+  for( uint32 ch : str.codePoints() ) {
+    ASSERT_LT( i, n );
+    EXPECT_EQ( out[ i++ ], ch );
+  }
+  EXPECT_EQ( n, i );
+  EXPECT_TRUE( String().codePoints().begin() == String().codePoints().end() );
+}
+
+/**
+ * String::utf16At and a CodePointIndex give the same results in any order
+ */
+TEST(String,UTF16AtCXX)
+{
+  String str( UTF8AnNyungHaSeYo );
+  CodePointIndex index( str.view() );
+  EXPECT_EQ( 5U, str.charCount() );
+  EXPECT_EQ( 5U, index.charCount() );
+  const int order[] = { 3, 1, 4, 4, 0, 2 };
+  for( size_t i = 0; i < sizeof( order ) / sizeof( *order ); ++i ) {
+    EXPECT_EQ( UTF16AnNyungHaSeYo[ order[ i ] ], str.utf16At( order[ i ] ) );
+    EXPECT_EQ( UTF16AnNyungHaSeYo[ order[ i ] ], index.utf16At( order[ i ] ) );
+  }
+  EXPECT_EQ( 0, str.utf16At( 5 ) );
+  EXPECT_EQ( 0, str.utf16At( -1 ) );
+  EXPECT_EQ( 0, index.utf16At( 5 ) );
+  EXPECT_EQ( 0, index.utf16At( -1 ) );
+
+  str.append( "xyz" );
+  EXPECT_EQ( 8U, str.charCount() );
+  EXPECT_EQ( 'x', str.utf16At( 5 ) );
+  EXPECT_EQ( UTF16AnNyungHaSeYo[ 4 ], str.utf16At( 4 ) );
+
+  String ascii( "plain" );
+  CodePointIndex asciiIndex( ascii.view() );
+  uint16 high = 1;
+  EXPECT_EQ( 'n', ascii.utf16At( 4, high ) );
+  EXPECT_EQ( 0, high );
+  high = 1;
+  EXPECT_EQ( 'n', asciiIndex.utf16At( 4, high ) );
+  EXPECT_EQ( 0, high );
+  EXPECT_EQ( 0, ascii.utf16At( 5 ) );
+  EXPECT_EQ( 0, asciiIndex.utf16At( 5 ) );
+  swap( ascii, str );
+  EXPECT_EQ( 5U, str.charCount() );
+  EXPECT_EQ( 'l', str.utf16At( 1 ) );
+  EXPECT_EQ( 'z', ascii.utf16At( 7 ) );
+  EXPECT_EQ( 8U, ascii.utf16Length() );
+}
+
 /**
  * Test that replace behaves correctly
  */
@@ -401,3 +618,226 @@ TEST(String,ReplaceAllStrlen)
   EXPECT_STREQ( expectedOutput, webvtt_string_text( &str ) );
   webvtt_release_string( &str );
 }
+
+/**
+ * Short text is kept in the string itself, and copied rather than shared
+ */
+TEST(String,Small)
+{
+  webvtt_string a, b;
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_create_string_with_text( &a, "loud", -1 ) );
+  EXPECT_EQ( (webvtt_uint)WEBVTT_SMALL_STRING, webvtt_string_capacity( &a ) );
+  webvtt_copy_string( &b, &a );
+  EXPECT_NE( webvtt_string_text( &a ), webvtt_string_text( &b ) );
+  EXPECT_EQ( WEBVTT_SUCCESS, webvtt_string_putc( &a, '!' ) );
+  EXPECT_STREQ( "loud!", webvtt_string_text( &a ) );
+  EXPECT_STREQ( "loud", webvtt_string_text( &b ) );
+  EXPECT_TRUE( webvtt_string_is_equal( &b, "loud", -1 ) );
+  webvtt_release_string( &a );
+  EXPECT_EQ( 0, webvtt_string_text( &a ) );
+  webvtt_release_string( &b );
+}
+
+/**
+ * A small string moves to allocated data once it outgrows the string, and
+ * keeps its text
+ */
+TEST(String,SmallGrows)
+{
+  std::string expected;
+  webvtt_string str;
+  webvtt_init_string( &str );
+  for( int i = 0; i < 40; ++i ) {
+    char c = (char)( 'a' + i % 26 );
+    expected += c;
+    ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_putc( &str, c ) );
+    ASSERT_STREQ( expected.c_str(), webvtt_string_text( &str ) );
+    ASSERT_EQ( expected.size(), webvtt_string_length( &str ) );
+  }
+  EXPECT_LT( (webvtt_uint)WEBVTT_SMALL_STRING, webvtt_string_capacity( &str ) );
+
+  /* Exactly WEBVTT_SMALL_STRING bytes still fit */
+  webvtt_string full;
+  std::string text( WEBVTT_SMALL_STRING, 'x' );
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_create_string_with_text( &full,
+                                                             text.c_str(),
+                                                             -1 ) );
+  EXPECT_EQ( (webvtt_uint)WEBVTT_SMALL_STRING, webvtt_string_capacity( &full ) );
+  EXPECT_EQ( WEBVTT_SUCCESS, webvtt_string_append_string( &full, &full ) );
+  EXPECT_EQ( text + text, webvtt_string_text( &full ) );
+  webvtt_release_string( &full );
+  webvtt_release_string( &str );
+}
+
+/**
+ * Detaching a shared string short enough to be small needs no allocation, and
+ * leaves the other holder's text alone
+ */
+TEST(String,SmallDetach)
+{
+  const char *text = "Hello, this is shared";
+  webvtt_string shared, copy;
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_create_string_with_text( &shared, text, -1 ) );
+  ASSERT_EQ( 1, webvtt_string_replace( &shared, ", this is shared", -1, "",
+                                       0 ) );
+  webvtt_copy_string( &copy, &shared );
+  EXPECT_EQ( webvtt_string_text( &shared ), webvtt_string_text( &copy ) );
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_detach( &copy ) );
+  EXPECT_NE( webvtt_string_text( &shared ), webvtt_string_text( &copy ) );
+  EXPECT_EQ( (webvtt_uint)WEBVTT_SMALL_STRING, webvtt_string_capacity( &copy ) );
+  EXPECT_EQ( WEBVTT_SUCCESS, webvtt_string_putc( &copy, '!' ) );
+  EXPECT_STREQ( "Hello!", webvtt_string_text( &copy ) );
+  EXPECT_STREQ( "Hello", webvtt_string_text( &shared ) );
+  webvtt_release_string( &copy );
+  webvtt_release_string( &shared );
+}
+
+/**
+ * Small strings can be pushed to, and popped from, a string list
+ */
+TEST(String,SmallInStringList)
+{
+  webvtt_stringlist *list;
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_create_stringlist( &list ) );
+  for( int i = 0; i < 20; ++i ) {
+    webvtt_string str;
+    std::string text( (size_t)i + 1, (char)( 'a' + i ) );
+    ASSERT_EQ( WEBVTT_SUCCESS, webvtt_create_string_with_text( &str,
+                                                               text.c_str(),
+                                                               -1 ) );
+    ASSERT_EQ( WEBVTT_SUCCESS, webvtt_stringlist_push( list, &str ) );
+    webvtt_release_string( &str );
+  }
+  for( int i = 19; i >= 0; --i ) {
+    webvtt_string str;
+    ASSERT_TRUE( webvtt_stringlist_pop( list, &str ) );
+    EXPECT_EQ( std::string( (size_t)i + 1, (char)( 'a' + i ) ),
+               webvtt_string_text( &str ) );
+    webvtt_release_string( &str );
+  }
+  webvtt_release_stringlist( &list );
+}
+
+/**
+ * Const lookups keep no state, so threads can share a String
+ */
+TEST(String,SharedLookupsCXX)
+{
+  const String str( UTF8Mixed );
+  const uint count = str.charCount();
+  std::vector<uint16> expected( count );
+  for( uint ch = 0; ch < count; ++ch ) {
+    expected[ ch ] = str.utf16At( (int)ch );
+  }
+  std::vector<std::thread> threads;
+  std::vector<int> mismatches( 4, 0 );
+  for( int t = 0; t < 4; ++t ) {
+    threads.push_back( std::thread( [&, t]() {
+      for( int round = 0; round < 50; ++round ) {
+        for( uint ch = 0; ch < count; ++ch ) {
+          uint ahead = ( ch * ( t + 1 ) ) % count;
+          mismatches[ t ] += str.utf16At( (int)ahead ) != expected[ ahead ];
+          mismatches[ t ] += str.charCount() != count;
+        }
+      }
+    } ) );
+  }
+  for( size_t t = 0; t < threads.size(); ++t ) {
+    threads[ t ].join();
+  }
+  EXPECT_EQ( std::vector<int>( 4, 0 ), mismatches );
+}
+
+/**
+ * Appending holds at most half as much again as the text needs
+ */
+TEST(String,AppendGrowth)
+{
+  std::string text( 1000, 'a' );
+  webvtt_string str;
+  webvtt_init_string( &str );
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_append( &str, "ab", 2 ) );
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_string_append( &str, text.data(), (int)text.size() ) );
+  EXPECT_LE( 1002u, webvtt_string_capacity( &str ) );
+  EXPECT_GT( 1100u, webvtt_string_capacity( &str ) );
+
+  for( int i = 0; i < 5000; ++i ) {
+    ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_putc( &str, 'b' ) );
+  }
+  EXPECT_EQ( 6002u, webvtt_string_length( &str ) );
+  EXPECT_GE( 6002u * 3 / 2, webvtt_string_capacity( &str ) );
+
+  /* Appending a string to itself */
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_append_string( &str, &str ) );
+  EXPECT_EQ( 12004u, webvtt_string_length( &str ) );
+  EXPECT_EQ( 'b', webvtt_string_text( &str )[ 12003 ] );
+  EXPECT_EQ( 'a', webvtt_string_text( &str )[ 6002 ] );
+  webvtt_release_string( &str );
+}
+
+/**
+ * Appending to a copy leaves the original alone
+ */
+TEST(String,AppendShared)
+{
+  const char *text = "Hello, this is shared";
+  webvtt_string str, copy;
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_create_string_with_text( &str, text, -1 ) );
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_reserve( &str, 100 ) );
+  webvtt_copy_string( &copy, &str );
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_append( &copy, "!", 1 ) );
+  EXPECT_STREQ( text, webvtt_string_text( &str ) );
+  EXPECT_EQ( std::string( text ) + "!", webvtt_string_text( &copy ) );
+  webvtt_release_string( &copy );
+  webvtt_release_string( &str );
+}
+
+TEST(String,Reserve)
+{
+  webvtt_string str;
+  webvtt_init_string( &str );
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_reserve( &str, 300 ) );
+  EXPECT_EQ( 300u, webvtt_string_capacity( &str ) );
+  const char *text = webvtt_string_text( &str );
+  for( int i = 0; i < 300; ++i ) {
+    ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_putc( &str, 'x' ) );
+  }
+  EXPECT_EQ( text, webvtt_string_text( &str ) );
+
+  /* Reserving less than is held does nothing */
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_reserve( &str, 10 ) );
+  EXPECT_EQ( text, webvtt_string_text( &str ) );
+  EXPECT_EQ( 300u, webvtt_string_length( &str ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_string_reserve( 0, 10 ) );
+  webvtt_release_string( &str );
+}
+
+TEST(String,ShrinkToFit)
+{
+  std::string text( 100, 'a' );
+  webvtt_string str, copy;
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_create_string( 1000, &str ) );
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_string_append( &str, text.data(), (int)text.size() ) );
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_shrink_to_fit( &str ) );
+  EXPECT_EQ( 100u, webvtt_string_capacity( &str ) );
+  EXPECT_EQ( text, webvtt_string_text( &str ) );
+
+  /* Shared text is kept */
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_reserve( &str, 200 ) );
+  webvtt_copy_string( &copy, &str );
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_shrink_to_fit( &copy ) );
+  EXPECT_EQ( 200u, webvtt_string_capacity( &copy ) );
+  webvtt_release_string( &copy );
+
+  /* Short text moves into the string itself */
+  ASSERT_EQ( 1, webvtt_string_replace( &str, text.data(), 95, "", 0 ) );
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_string_shrink_to_fit( &str ) );
+  EXPECT_EQ( (webvtt_uint)WEBVTT_SMALL_STRING, webvtt_string_capacity( &str ) );
+  EXPECT_STREQ( "aaaaa", webvtt_string_text( &str ) );
+  webvtt_release_string( &str );
+}
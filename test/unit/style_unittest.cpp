@@ -0,0 +1,373 @@
+#include "chunkparser_testfixture"
+#include <webvttxx/abstract_parser>
+#include <webvttxx/cue>
+
+class StyleTest : public ChunkParserTest
+{
+public:
+  /**
+   * The style of 'node' as "property:value;" pairs
+   */
+  std::string style( const webvtt_node *node ) const
+  {
+    const webvtt_declaration *declarations = 0;
+    webvtt_uint count = webvtt_get_node_style( node, &declarations );
+    std::string result;
+    for( webvtt_uint i = 0; i < count; ++i ) {
+      result.append( webvtt_string_text( &declarations[ i ].property ) );
+      result += ':';
+      result.append( webvtt_string_text( &declarations[ i ].value ) );
+      result += ';';
+    }
+    return result;
+  }
+
+  const webvtt_node *child( const webvtt_node *node, webvtt_uint index ) const
+  {
+    return node->data.internal_data->children[ index ];
+  }
+
+  const webvtt_style *nodeStyle( const webvtt_node *node ) const
+  {
+    return node->data.internal_data->style;
+  }
+};
+
+static const char document[] =
+  "WEBVTT\n\n"
+  "STYLE\n"
+  "::cue { color: white; background: black }\n"
+  "/* Voices */\n"
+  "::cue(v[voice=\"Fred\"]) { color: red }\n"
+  "::cue(v[voice=Bill]), ::cue(.loud) { font-weight: bold; }\n\n"
+  "STYLE\n"
+  "::cue(.loud.yell) { font-size: 200% }\n"
+  "::cue(i) { font-style: normal }\n"
+  "::cue(:lang(fr)) { font-family: \"Times; New Roman\" }\n\n"
+  "00:00.000 --> 00:01.000\n"
+  "<v Fred>Hi</v> <v Bill>Hey</v> <v Nobody>Hm</v>\n\n"
+  "00:01.000 --> 00:02.000\n"
+  "<c.loud>A</c> <c.yell.loud.other>B</c> <c.other>C</c> <c.x.y>D</c>\n\n"
+  "00:02.000 --> 00:03.000\n"
+  "<i>One</i><lang fr><i>Deux</i><b>Trois</b></lang>\n";
+
+TEST_F(StyleTest, CueSelector)
+{
+  parse( document );
+  EXPECT_EQ( 0U, errors.size() );
+  ASSERT_EQ( 3U, cues.size() );
+  EXPECT_EQ( "color:white;background:black;", style( cues[ 0 ]->node_head ) );
+}
+
+TEST_F(StyleTest, VoiceSelector)
+{
+  parse( document );
+  ASSERT_EQ( 3U, cues.size() );
+  const webvtt_node *head = cues[ 0 ]->node_head;
+  EXPECT_EQ( "color:red;", style( child( head, 0 ) ) );
+  EXPECT_EQ( "font-weight:bold;", style( child( head, 2 ) ) );
+  EXPECT_EQ( "", style( child( head, 4 ) ) );
+}
+
+TEST_F(StyleTest, ClassSelector)
+{
+  parse( document );
+  ASSERT_EQ( 3U, cues.size() );
+  const webvtt_node *head = cues[ 1 ]->node_head;
+  EXPECT_EQ( "font-weight:bold;", style( child( head, 0 ) ) );
+  EXPECT_EQ( "font-weight:bold;font-size:200%;", style( child( head, 2 ) ) );
+  EXPECT_EQ( "", style( child( head, 4 ) ) );
+}
+
+/**
+ * ':lang' matches every node inside a <lang> node with that language,
+ * including the <lang> node itself
+ */
+TEST_F(StyleTest, LangSelector)
+{
+  parse( document );
+  ASSERT_EQ( 3U, cues.size() );
+  const webvtt_node *head = cues[ 2 ]->node_head;
+  const webvtt_node *lang = child( head, 1 );
+  EXPECT_EQ( "font-style:normal;", style( child( head, 0 ) ) );
+  EXPECT_EQ( "font-family:\"Times; New Roman\";", style( lang ) );
+  EXPECT_EQ( "font-style:normal;font-family:\"Times; New Roman\";",
+             style( child( lang, 0 ) ) );
+  EXPECT_EQ( "font-family:\"Times; New Roman\";", style( child( lang, 1 ) ) );
+}
+
+/**
+ * Nodes which only differ in names no selector uses share a style
+ */
+TEST_F(StyleTest, SharedStyles)
+{
+  parse( document );
+  ASSERT_EQ( 3U, cues.size() );
+  const webvtt_node *classes = cues[ 1 ]->node_head;
+  EXPECT_TRUE( nodeStyle( child( classes, 0 ) ) != 0 );
+  EXPECT_TRUE( nodeStyle( child( classes, 4 ) ) == 0 );
+  EXPECT_TRUE( nodeStyle( child( classes, 6 ) ) == 0 );
+  EXPECT_TRUE( nodeStyle( cues[ 0 ]->node_head ) != 0 );
+  EXPECT_EQ( nodeStyle( cues[ 0 ]->node_head ),
+             nodeStyle( cues[ 2 ]->node_head ) );
+}
+
+TEST_F(StyleTest, AcrossChunks)
+{
+  parse( document, 1 );
+  EXPECT_EQ( 0U, errors.size() );
+  ASSERT_EQ( 3U, cues.size() );
+  EXPECT_EQ( "color:white;background:black;", style( cues[ 1 ]->node_head ) );
+  EXPECT_EQ( "font-weight:bold;font-size:200%;",
+             style( child( cues[ 1 ]->node_head, 2 ) ) );
+}
+
+TEST_F(StyleTest, BadRules)
+{
+  parse( "WEBVTT\n\n"
+         "STYLE\n"
+         "::cue(.a) { color: red }\n"
+         "  video::cue { color: blue }\n"
+         "::cue(span) { color: green }, ::cue(.b) { }\n"
+         "::cue(.a), p { color: pink }\n"
+         "::cue(.a) { : ; color ; color: yellow }\n\n"
+         "00:00.000 --> 00:01.000\n"
+         "<c.a>Text</c>\n" );
+  ASSERT_EQ( 4U, errors.size() );
+  EXPECT_EQ( WEBVTT_INVALID_STYLE_RULE, errors[ 0 ].error );
+  EXPECT_EQ( 5U, errors[ 0 ].line );
+  EXPECT_EQ( 3U, errors[ 0 ].column );
+  EXPECT_EQ( 6U, errors[ 1 ].line );
+  EXPECT_EQ( 1U, errors[ 1 ].column );
+  EXPECT_EQ( 6U, errors[ 2 ].line );
+  EXPECT_EQ( 29U, errors[ 2 ].column );
+  EXPECT_EQ( 7U, errors[ 3 ].line );
+
+  ASSERT_EQ( 1U, cues.size() );
+  EXPECT_EQ( "color:red;color:yellow;",
+             style( child( cues[ 0 ]->node_head, 0 ) ) );
+}
+
+/**
+ * A STYLE block after the first cue is not a style sheet
+ */
+TEST_F(StyleTest, OnlyInHeader)
+{
+  parse( "WEBVTT\n\n"
+         "00:00.000 --> 00:01.000\nText\n\n"
+         "STYLE\n::cue { color: red }\n\n"
+         "00:01.000 --> 00:02.000\nText\n" );
+  ASSERT_EQ( 2U, cues.size() );
+  EXPECT_TRUE( nodeStyle( cues[ 1 ]->node_head ) == 0 );
+  EXPECT_EQ( "", style( cues[ 1 ]->node_head ) );
+}
+
+/**
+ * A block whose second line holds cue timings is a cue, even if its first
+ * line reads STYLE; that line is the cue's id
+ */
+TEST_F(StyleTest, HeaderIsCueId)
+{
+  const std::string text =
+    "WEBVTT\n\nSTYLE\n00:00.000 --> 00:01.000\n<b>hello</b>\n\n"
+    "00:01.000 --> 00:02.000\n<b>bye</b>\n";
+  for( size_t chunkSize = 1; chunkSize <= text.size(); chunkSize *= 3 ) {
+    clear();
+    webvtt_reset_parser( parser );
+    parse( text, chunkSize );
+    EXPECT_EQ( 0U, errors.size() ) << chunkSize;
+    ASSERT_EQ( 2U, cues.size() ) << chunkSize;
+    EXPECT_STREQ( "STYLE", webvtt_string_text( &cues[ 0 ]->id ) );
+    EXPECT_EQ( 1000U, cues[ 0 ]->until );
+    EXPECT_EQ( WEBVTT_BOLD, child( cues[ 0 ]->node_head, 0 )->kind );
+    EXPECT_STREQ( "", webvtt_string_text( &cues[ 1 ]->id ) );
+  }
+}
+
+TEST_F(StyleTest, NoStyleSheet)
+{
+  parse( "WEBVTT\n\n00:00.000 --> 00:01.000\n<b>Text</b>\n" );
+  ASSERT_EQ( 1U, cues.size() );
+  EXPECT_TRUE( nodeStyle( cues[ 0 ]->node_head ) == 0 );
+  EXPECT_TRUE( nodeStyle( child( cues[ 0 ]->node_head, 0 ) ) == 0 );
+
+  const webvtt_declaration *declarations = 0;
+  EXPECT_EQ( 0U, webvtt_get_node_style( cues[ 0 ]->node_head,
+                                        &declarations ) );
+  EXPECT_EQ( 0U, webvtt_get_node_style( child( child( cues[ 0 ]->node_head,
+                                                      0 ), 0 ),
+                                        &declarations ) );
+  EXPECT_EQ( 0U, webvtt_get_node_style( 0, &declarations ) );
+}
+
+/**
+ * Every combination of classes gets its own style
+ */
+TEST_F(StyleTest, ManyStyles)
+{
+  const char *names[] = { "a", "b", "c", "d", "e", "f" };
+  std::string text = "WEBVTT\n\nSTYLE\n";
+  for( int i = 0; i < 6; ++i ) {
+    text += std::string( "::cue(." ) + names[ i ] + ") { order: " + names[ i ]
+            + " }\n";
+  }
+  text += "\n00:00.000 --> 00:01.000\n";
+  for( int set = 0; set < 64; ++set ) {
+    text += "<c";
+    for( int i = 0; i < 6; ++i ) {
+      if( set & ( 1 << i ) ) {
+        text += std::string( "." ) + names[ i ];
+      }
+    }
+    text += ">x</c>";
+  }
+  parse( text + "\n" );
+  ASSERT_EQ( 1U, cues.size() );
+  for( int set = 0; set < 64; ++set ) {
+    std::string expected;
+    for( int i = 0; i < 6; ++i ) {
+      if( set & ( 1 << i ) ) {
+        expected += std::string( "order:" ) + names[ i ] + ";";
+      }
+    }
+    EXPECT_EQ( expected, style( child( cues[ 0 ]->node_head, set ) ) ) << set;
+  }
+}
+
+/**
+ * Styles are resolved without recursion, so any nesting depth the parser
+ * allows can be styled
+ */
+TEST_F(StyleTest, DeepNesting)
+{
+  const int depth = 100000;
+  std::string text = "WEBVTT\n\nSTYLE\n::cue(b) { color: red }\n"
+                     "::cue(:lang(fr)) { color: blue }\n\n"
+                     "00:00.000 --> 00:01.000\n<lang fr>";
+  for( int i = 0; i < depth; ++i ) {
+    text += "<b>";
+  }
+  webvtt_limits limits;
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_get_limits( parser, &limits ) );
+  limits.max_line_bytes = 4 * depth;
+  ASSERT_EQ( WEBVTT_SUCCESS, webvtt_set_limits( parser, &limits ) );
+  parse( text + "x\n" );
+  EXPECT_EQ( 0U, errors.size() );
+  ASSERT_EQ( 1U, cues.size() );
+  const webvtt_node *node = child( cues[ 0 ]->node_head, 0 );
+  EXPECT_EQ( "color:blue;", style( node ) );
+  for( int i = 0; i < depth; ++i ) {
+    node = child( node, 0 );
+  }
+  EXPECT_EQ( WEBVTT_BOLD, node->kind );
+  EXPECT_EQ( "color:red;color:blue;", style( node ) );
+}
+
+TEST_F(StyleTest, ResetForgetsStyles)
+{
+  parse( document );
+  webvtt_reset_parser( parser );
+  clear();
+  parse( "WEBVTT\n\nSTYLE\n::cue(b) { color: green }\n\n"
+         "00:00.000 --> 00:01.000\n<b>A</b><i>B</i>\n" );
+  ASSERT_EQ( 1U, cues.size() );
+  EXPECT_EQ( "", style( cues[ 0 ]->node_head ) );
+  EXPECT_EQ( "color:green;", style( child( cues[ 0 ]->node_head, 0 ) ) );
+  EXPECT_EQ( "", style( child( cues[ 0 ]->node_head, 1 ) ) );
+}
+
+/**
+ * A cue's nodes keep their styles after the parser has been reset or deleted
+ */
+TEST_F(StyleTest, NodesKeepStyles)
+{
+  parse( document );
+  ASSERT_EQ( 3U, cues.size() );
+  webvtt_reset_parser( parser );
+  parse( "WEBVTT\n\nSTYLE\n::cue { color: blue }\n\n"
+         "00:00.000 --> 00:01.000\nText\n" );
+  ASSERT_EQ( 4U, cues.size() );
+  EXPECT_EQ( "color:white;background:black;", style( cues[ 0 ]->node_head ) );
+  EXPECT_EQ( "color:blue;", style( cues[ 3 ]->node_head ) );
+  webvtt_delete_parser( parser );
+  parser = 0;
+  EXPECT_EQ( "color:white;background:black;", style( cues[ 2 ]->node_head ) );
+}
+
+/**
+ * A STYLE block still being read when the parser is reset or deleted is
+ * released
+ */
+TEST_F(StyleTest, UnfinishedStyle)
+{
+  const char text[] = "WEBVTT\n\nSTYLE\n::cue { color: red }\n::cue(b) {";
+  webvtt_parse_chunk( parser, text, sizeof( text ) - 1 );
+  webvtt_reset_parser( parser );
+  webvtt_parse_chunk( parser, text, sizeof( text ) - 1 );
+}
+
+/**
+ * Validators check the style sheet, but have no cue text to style
+ */
+TEST_F(StyleTest, Validator)
+{
+  webvtt_parser validator;
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_create_validator( &error, this, &validator ) );
+  const char text[] = "WEBVTT\n\nSTYLE\n::cue(p) { color: red }\n\n"
+                      "00:00.000 --> 00:01.000\nText\n";
+  webvtt_parse_chunk( validator, text, sizeof( text ) - 1 );
+  webvtt_finish_parsing( validator );
+  webvtt_delete_parser( validator );
+  ASSERT_EQ( 1U, errors.size() );
+  EXPECT_EQ( WEBVTT_INVALID_STYLE_RULE, errors[ 0 ].error );
+}
+
+namespace
+{
+  class StringParser : public WebVTT::AbstractParser
+  {
+  public:
+    virtual bool reportError( const WebVTT::Error & ) { return true; }
+
+    ~StringParser()
+    {
+      for( size_t i = 0; i < styles.size(); ++i ) {
+        webvtt_release_style( &styles[ i ] );
+      }
+    }
+
+    virtual void parsedCue( WebVTT::Cue &cue )
+    {
+      styles.push_back( cue.nodeHead().style() );
+      styles.push_back( cue.nodeHead()[ 0 ].style() );
+      webvtt_ref_style( styles.end()[ -2 ] );
+      webvtt_ref_style( styles.end()[ -1 ] );
+    }
+
+    void parse( const char *text, webvtt_uint length )
+    {
+      parseChunk( text, length );
+      finishParsing();
+    }
+
+    std::vector<const webvtt_style *> styles;
+  };
+}
+
+/**
+ * Styles outlive the cues they were read with once referenced
+ */
+TEST(StyleXX, NodeStyle)
+{
+  StringParser parser;
+  parser.parse( document, sizeof( document ) - 1 );
+  ASSERT_EQ( 6U, parser.styles.size() );
+  ASSERT_TRUE( parser.styles[ 1 ] != 0 );
+  ASSERT_EQ( 1U, parser.styles[ 1 ]->count );
+  const webvtt_declaration *declarations = parser.styles[ 1 ]->declarations;
+  EXPECT_STREQ( "color", webvtt_string_text( &declarations[ 0 ].property ) );
+  EXPECT_STREQ( "red", webvtt_string_text( &declarations[ 0 ].value ) );
+  ASSERT_TRUE( parser.styles[ 0 ] != 0 );
+  EXPECT_EQ( 2U, parser.styles[ 0 ]->count );
+}
@@ -0,0 +1,150 @@
+#include "chunkparser_testfixture"
+
+class Utf8Test : public ChunkParserTest
+{
+public:
+  std::string body( size_t index ) const
+  {
+    const webvtt_string *body = &cues[ index ]->body;
+    return std::string( webvtt_string_text( body ),
+                        webvtt_string_length( body ) );
+  }
+};
+
+static const char document[] =
+  "WEBVTT\n\n"
+  "00:00.000 --> 00:01.000\n"
+  "\xE4\xBD\xA0\xE5\xA5\xBD \xF0\x9F\x98\x80\n\n"
+  "00:01.000 --> 00:02.000\n"
+  "bad \xC0\xAF here\r\n"
+  "and \xE4\xBD here\n\n"
+  "00:02.000 --> 00:03.000\n"
+  "fine\n";
+
+TEST(Utf8Validate, FindsMalformed)
+{
+  static const char valid[] = "a\xC3\xA9\xE4\xBD\xA0\xF0\x9F\x98\x80\xEF\xBF\xBE"
+                              "0123456789abcdef0123456789abcdef";
+  EXPECT_EQ( valid + sizeof( valid ) - 1,
+             webvtt_utf8_validate( valid, valid + sizeof( valid ) - 1 ) );
+
+  static const char *const bad[] = {
+    "0123456789abcdef0123\x80", "ab\xC0\xAF", "ab\xED\xA0\x80",
+    "ab\xF4\x90\x80\x80", "ab\xE4\xBD", "ab\xE4\xBDx", "ab\xFF"
+  };
+  for( size_t i = 0; i < sizeof( bad ) / sizeof( *bad ); ++i ) {
+    const char *end = bad[ i ] + strlen( bad[ i ] );
+    const char *at = webvtt_utf8_validate( bad[ i ], end );
+    ASSERT_NE( end, at ) << i;
+    EXPECT_TRUE( (unsigned char)*at >= 0x80 ) << i;
+    EXPECT_TRUE( at == bad[ i ] + 2 || at == bad[ i ] + 20 ) << i;
+  }
+}
+
+TEST_F(Utf8Test, TrustedByDefault)
+{
+  EXPECT_EQ( WEBVTT_SUCCESS, parse( document ) );
+  EXPECT_EQ( 0U, errors.size() );
+  ASSERT_EQ( 3U, cues.size() );
+  EXPECT_EQ( "bad \xC0\xAF here\nand \xE4\xBD here", body( 1 ) );
+}
+
+TEST_F(Utf8Test, Validate)
+{
+  ASSERT_EQ( WEBVTT_SUCCESS,
+             webvtt_set_utf8_mode( parser, WEBVTT_UTF8_VALIDATE ) );
+  EXPECT_EQ( WEBVTT_SUCCESS, parse( document ) );
+  ASSERT_EQ( 2U, errors.size() );
+  EXPECT_EQ( WEBVTT_INVALID_UTF8, errors[ 0 ].error );
+  EXPECT_EQ( 7U, errors[ 0 ].line );
+  EXPECT_EQ( 5U, errors[ 0 ].column );
+  EXPECT_EQ( WEBVTT_INVALID_UTF8, errors[ 1 ].error );
+  EXPECT_EQ( 8U, errors[ 1 ].line );
+  EXPECT_EQ( 5U, errors[ 1 ].column );
+
+  /* The text is left as it is */
+  ASSERT_EQ( 3U, cues.size() );
+  EXPECT_EQ( "bad \xC0\xAF here\nand \xE4\xBD here", body( 1 ) );
+  EXPECT_EQ( 2U, webvtt_error_count( parser, WEBVTT_INVALID_UTF8 ) );
+}
+
+TEST_F(Utf8Test, ValidateAborts)
+{
+  abort = true;
+  webvtt_set_utf8_mode( parser, WEBVTT_UTF8_VALIDATE );
+  EXPECT_EQ( WEBVTT_PARSE_ERROR, parse( document ) );
+  ASSERT_EQ( 1U, errors.size() );
+  EXPECT_EQ( 7U, errors[ 0 ].line );
+  EXPECT_EQ( 1U, cues.size() );
+}
+
+TEST_F(Utf8Test, Repair)
+{
+  abort = true;
+  webvtt_set_utf8_mode( parser, WEBVTT_UTF8_REPAIR );
+  EXPECT_EQ( WEBVTT_SUCCESS, parse( document ) );
+  EXPECT_EQ( 2U, errors.size() );
+  ASSERT_EQ( 3U, cues.size() );
+  EXPECT_EQ( "\xE4\xBD\xA0\xE5\xA5\xBD \xF0\x9F\x98\x80", body( 0 ) );
+  EXPECT_EQ( "bad \xEF\xBF\xBD here\nand \xEF\xBF\xBD here", body( 1 ) );
+  for( size_t i = 0; i < cues.size(); ++i ) {
+    const std::string text = body( i );
+    EXPECT_EQ( text.data() + text.size(),
+               webvtt_utf8_validate( text.data(),
+                                     text.data() + text.size() ) );
+  }
+}
+
+/**
+ * Sequences split between chunks are checked whole, and errors are found at
+ * the same positions
+ */
+TEST_F(Utf8Test, AcrossChunks)
+{
+  webvtt_set_utf8_mode( parser, WEBVTT_UTF8_REPAIR );
+  EXPECT_EQ( WEBVTT_SUCCESS, parse( document, 1 ) );
+  ASSERT_EQ( 2U, errors.size() );
+  EXPECT_EQ( 7U, errors[ 0 ].line );
+  EXPECT_EQ( 5U, errors[ 0 ].column );
+  EXPECT_EQ( 8U, errors[ 1 ].line );
+  EXPECT_EQ( 5U, errors[ 1 ].column );
+  ASSERT_EQ( 3U, cues.size() );
+  EXPECT_EQ( "\xE4\xBD\xA0\xE5\xA5\xBD \xF0\x9F\x98\x80", body( 0 ) );
+  EXPECT_EQ( "bad \xEF\xBF\xBD here\nand \xEF\xBF\xBD here", body( 1 ) );
+}
+
+/**
+ * A sequence cut off by the end of the file is malformed
+ */
+TEST_F(Utf8Test, CutOffAtEnd)
+{
+  webvtt_set_utf8_mode( parser, WEBVTT_UTF8_REPAIR );
+  EXPECT_EQ( WEBVTT_SUCCESS,
+             parse( "WEBVTT\n\n00:00.000 --> 00:01.000\nend \xF0\x9F\x98", 3 ) );
+  ASSERT_EQ( 1U, errors.size() );
+  EXPECT_EQ( 4U, errors[ 0 ].line );
+  EXPECT_EQ( 5U, errors[ 0 ].column );
+  ASSERT_EQ( 1U, cues.size() );
+  EXPECT_EQ( "end \xEF\xBF\xBD", body( 0 ) );
+}
+
+TEST_F(Utf8Test, ResetForgetsPartialSequence)
+{
+  static const char partial[] = "WEBVTT\n\n00:00.000 --> 00:01.000\nx\xE4";
+  webvtt_set_utf8_mode( parser, WEBVTT_UTF8_VALIDATE );
+  webvtt_parse_chunk( parser, partial, sizeof( partial ) - 1 );
+  webvtt_reset_parser( parser );
+  EXPECT_EQ( WEBVTT_SUCCESS,
+             parse( "WEBVTT\n\n00:00.000 --> 00:01.000\n\xBD\xA0" ) );
+  ASSERT_EQ( 1U, errors.size() );
+  EXPECT_EQ( 4U, errors[ 0 ].line );
+  EXPECT_EQ( 1U, errors[ 0 ].column );
+}
+
+TEST_F(Utf8Test, InvalidParams)
+{
+  EXPECT_EQ( WEBVTT_INVALID_PARAM,
+             webvtt_set_utf8_mode( 0, WEBVTT_UTF8_REPAIR ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM,
+             webvtt_set_utf8_mode( parser, (webvtt_utf8_mode)3 ) );
+}
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+#include <webvtt/parser.h>
+#include <string>
+#include <vector>
+
+class ValidatorTest : public ::testing::Test
+{
+public:
+  struct Error
+  {
+    webvtt_uint line;
+    webvtt_uint column;
+    webvtt_error error;
+
+    bool operator==( const Error &other ) const
+    {
+      return line == other.line && column == other.column
+             && error == other.error;
+    }
+  };
+
+  /* Run 'text' through a parser (or validator) in chunks of 'chunkSize'
+     bytes, collecting errors and cues */
+  void parse( const std::string &text, bool validate, size_t chunkSize = 0x1000 )
+  {
+    webvtt_parser parser;
+    errors.clear();
+    ncues = 0;
+    if( validate ) {
+      ASSERT_EQ( WEBVTT_SUCCESS,
+                 webvtt_create_validator( &error, this, &parser ) );
+    } else {
+      ASSERT_EQ( WEBVTT_SUCCESS,
+                 webvtt_create_parser( &read, &error, this, &parser ) );
+    }
+    for( size_t i = 0; i < text.size(); i += chunkSize ) {
+      size_t n = std::min( chunkSize, text.size() - i );
+      webvtt_parse_chunk( parser, text.data() + i, (webvtt_uint)n );
+    }
+    webvtt_finish_parsing( parser );
+    webvtt_delete_parser( parser );
+  }
+
+  /* Expect the validator to report the same errors as the parser */
+  void expectSameErrors( const std::string &text, size_t chunkSize = 0x1000 )
+  {
+    parse( text, false, chunkSize );
+    std::vector<Error> expected = errors;
+    parse( text, true, chunkSize );
+    EXPECT_EQ( 0U, ncues );
+    ASSERT_EQ( expected.size(), errors.size() );
+    for( size_t i = 0; i < errors.size(); ++i ) {
+      EXPECT_TRUE( expected[ i ] == errors[ i ] )
+        << "error " << i << ": expected " << expected[ i ].error << " at "
+        << expected[ i ].line << ":" << expected[ i ].column << ", got "
+        << errors[ i ].error << " at " << errors[ i ].line << ":"
+        << errors[ i ].column;
+    }
+  }
+
+  static std::string cues( size_t count )
+  {
+    std::string text = "WEBVTT\n\n";
+    for( size_t i = 0; i < count; ++i ) {
+      char timing[ 64 ];
+      sprintf( timing, "00:%02u:%02u.000 --> 00:%02u:%02u.500 align:start\n",
+               (unsigned)( i / 60 ) % 60, (unsigned)( i % 60 ),
+               (unsigned)( i / 60 ) % 60, (unsigned)( i % 60 ) );
+      if( i % 2 ) {
+        text += "cue\n";
+      }
+      text += timing;
+      text += "Some <b>bold</b> and <i>italic</i> text\nspanning two lines\n\n";
+    }
+    return text;
+  }
+
+  std::vector<Error> errors;
+  size_t ncues;
+
+private:
+  static void WEBVTT_CALLBACK read( void *userdata, webvtt_cue *cue )
+  {
+    ++( (ValidatorTest *)userdata )->ncues;
+    webvtt_release_cue( &cue );
+  }
+
+  static int WEBVTT_CALLBACK error( void *userdata, webvtt_uint line,
+                                    webvtt_uint col, webvtt_error error )
+  {
+    Error e = { line, col, error };
+    ( (ValidatorTest *)userdata )->errors.push_back( e );
+    return 0;
+  }
+};
+
+namespace
+{
+  unsigned allocations;
+
+  void *WEBVTT_CALLBACK
+  countingAlloc( void *, webvtt_uint nbytes )
+  {
+    ++allocations;
+    return malloc( nbytes );
+  }
+
+  void WEBVTT_CALLBACK
+  countingFree( void *, void *pmem )
+  {
+    free( pmem );
+  }
+}
+
+TEST_F(ValidatorTest, RequiresErrorCallback)
+{
+  webvtt_parser parser;
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_create_validator( 0, this, &parser ) );
+  EXPECT_EQ( WEBVTT_INVALID_PARAM, webvtt_create_validator( 0, this, 0 ) );
+}
+
+TEST_F(ValidatorTest, ValidFileHasNoErrors)
+{
+  parse( cues( 20 ), true );
+  EXPECT_EQ( 0U, errors.size() );
+  EXPECT_EQ( 0U, ncues );
+}
+
+TEST_F(ValidatorTest, SameErrorsAsParser)
+{
+  const std::string text =
+    "WEBVTT\n\n"
+    "00:01.000 --> 00:02.000 align:middle vertical:rl\n"
+    "Text\n\n"
+    "id\n"
+    "00:02.000 -> 00:03.000\n"
+    "Bad arrow\n\n"
+    "00:03.00 --> 00:04.000 size:200% line:x\n"
+    "Bad settings\n"
+    "00:04.000 --> 00:05.000 position:10%\n"
+    "Cue following a cue without a blank line\n"
+    "\n\n\n"
+    "id\n"
+    "more text\n"
+    "00:05.000 --> 00:06.000\n"
+    "\n"
+    "00:06.000 --> 00:07.000align:end\n"
+    "Last";
+  expectSameErrors( text );
+  EXPECT_LT( 0U, errors.size() );
+}
+
+TEST_F(ValidatorTest, SameErrorsAcrossChunks)
+{
+  const std::string text =
+    "WEBVTT\n\n"
+    "00:01.000 --> 00:02.000 align:bogus\n"
+    "Text\n\n"
+    "00:02.000 --> 00:0x.000\n"
+    "Text\n\n"
+    "id\n"
+    "00:03.000 --> 00:04.000 line:-1\n"
+    "<b>Text</b>\n";
+  expectSameErrors( text, 1 );
+  expectSameErrors( text, 7 );
+  EXPECT_LT( 0U, errors.size() );
+}
+
+TEST_F(ValidatorTest, ReportsCuesOutOfOrder)
+{
+  const std::string text =
+    "WEBVTT\n\n"
+    "00:05.000 --> 00:06.000\n"
+    "First\n\n"
+    "id\n"
+    "00:04.000 --> 00:05.000\n"
+    "Second\n\n"
+    "00:04.000 --> 00:05.000\n"
+    "Third\n";
+  parse( text, true );
+  ASSERT_EQ( 1U, errors.size() );
+  EXPECT_EQ( WEBVTT_CUE_OUT_OF_ORDER, errors[ 0 ].error );
+  EXPECT_EQ( 7U, errors[ 0 ].line );
+  EXPECT_EQ( 1U, errors[ 0 ].column );
+
+  /* Ordering is not checked when parsing */
+  parse( text, false );
+  EXPECT_EQ( 0U, errors.size() );
+  EXPECT_EQ( 3U, ncues );
+}
+
+/**
+ * The number of allocations made by a validator should not depend on the
+ * number of cues in the document.
+ */
+TEST_F(ValidatorTest, NoPerCueAllocation)
+{
+  unsigned few, many;
+  webvtt_set_allocator( &countingAlloc, &countingFree, 0 );
+  allocations = 0;
+  parse( cues( 10 ), true );
+  few = allocations;
+  allocations = 0;
+  parse( cues( 500 ), true );
+  many = allocations;
+  webvtt_set_allocator( 0, 0, 0 );
+  if( few == 0 ) {
+    /* Something else is holding memory, so the allocator was not replaced */
+    return;
+  }
+  EXPECT_EQ( 0U, errors.size() );
+  EXPECT_EQ( few, many );
+}
@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <webvttxx/abstract_parser>
+#include <webvttxx/cue>
+#include <webvttxx/error>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace WebVTT;
+
+namespace
+{
+  class StringParser : public AbstractParser
+  {
+  public:
+    virtual bool reportError( const Error &error )
+    {
+      errors.push_back( error );
+      return true;
+    }
+
+    virtual void parsedCue( Cue &cue ) { cues.push_back( cue ); }
+
+    void parse( const char *text )
+    {
+      parseChunk( text, (webvtt_uint)strlen( text ) );
+      finishParsing();
+    }
+
+    std::vector<Cue> cues;
+    std::vector<Error> errors;
+  };
+}
+
+class Wrappers : public ::testing::Test
+{
+public:
+  virtual void SetUp()
+  {
+    parser.parse( "WEBVTT\n\n"
+                  "id\n"
+                  "00:00.000 --> 00:01.000 align:bad\n"
+                  "<v Fred>Hello</v> <lang en>World</lang>\n" );
+    ASSERT_EQ( 1U, parser.cues.size() );
+  }
+
+  StringParser parser;
+};
+
+TEST_F(Wrappers, CueMove)
+{
+  Cue cue( std::move( parser.cues[ 0 ] ) );
+  EXPECT_TRUE( cue.idView() == StringView( "id" ) );
+
+  Cue other( cue );
+  other = std::move( cue );
+  swap( other, parser.cues[ 0 ] );
+  EXPECT_TRUE( parser.cues[ 0 ].idView() == StringView( "id" ) );
+  EXPECT_TRUE( parser.cues[ 0 ].bodyView()
+               == StringView( "<v Fred>Hello</v> <lang en>World</lang>" ) );
+}
+
+/**
+ * Assigning a Node holds a reference of its own, so both can be destroyed
+ */
+TEST_F(Wrappers, NodeAssign)
+{
+  Node voice;
+  EXPECT_TRUE( voice.isEmpty() );
+  {
+    Node head = parser.cues[ 0 ].nodeHead();
+    voice = head[ 0 ];
+    Node copy;
+    copy = voice;
+    EXPECT_EQ( Node::Voice, copy.kind() );
+  }
+  EXPECT_EQ( Node::Voice, voice.kind() );
+  EXPECT_TRUE( voice.annotationView() == StringView( "Fred" ) );
+  EXPECT_TRUE( voice[ 0 ].textView() == StringView( "Hello" ) );
+}
+
+TEST_F(Wrappers, NodeMove)
+{
+  Node head = parser.cues[ 0 ].nodeHead();
+  Node moved( std::move( head ) );
+  EXPECT_TRUE( head.isEmpty() );
+  EXPECT_EQ( Node::Head, moved.kind() );
+
+  head = std::move( moved[ 2 ] );
+  EXPECT_EQ( Node::Lang, head.kind() );
+  EXPECT_TRUE( head.langView() == StringView( "en" ) );
+  EXPECT_TRUE( head.textView().isEmpty() );
+
+  swap( head, moved );
+  EXPECT_EQ( Node::Head, head.kind() );
+  EXPECT_EQ( Node::Lang, moved.kind() );
+}
+
+TEST_F(Wrappers, ErrorAssign)
+{
+  ASSERT_EQ( 1U, parser.errors.size() );
+  Error error( 0, 0, WEBVTT_MALFORMED_TAG );
+  error = parser.errors[ 0 ];
+  EXPECT_EQ( WEBVTT_ALIGN_BAD_VALUE, error.error() );
+  EXPECT_EQ( 4U, error.line() );
+  EXPECT_STREQ( parser.errors[ 0 ].message(), error.message() );
+}
+
+TEST_F(Wrappers, ChildRange)
+{
+  const Cue &cue = parser.cues[ 0 ];
+  NodeRange children = cue.nodeHead().ref().children();
+  ASSERT_EQ( 3, children.size() );
+  EXPECT_EQ( WEBVTT_VOICE, children[ 0 ].kind() );
+  EXPECT_EQ( WEBVTT_TEXT, children[ 1 ].kind() );
+  EXPECT_EQ( WEBVTT_LANG, children[ 2 ].kind() );
+
+  int count = 0;
+  for( NodeRef child : children ) {
+    EXPECT_EQ( cue.nodeHead().ref(), child.parent() );
+    ++count;
+  }
+  EXPECT_EQ( 3, count );
+
+  /* Leaves have no children */
+  NodeRef text = children[ 0 ].child( 0 );
+  EXPECT_TRUE( text.isLeaf() );
+  EXPECT_EQ( 0, text.childCount() );
+  EXPECT_TRUE( text.children().isEmpty() );
+  EXPECT_EQ( 0, cue.nodeHead()[ 0 ][ 0 ].childCount() );
+}
+
+static std::string walk( const NodeWalk &nodes )
+{
+  std::string result;
+  for( NodeWalk::iterator i = nodes.begin(); i != nodes.end(); ++i ) {
+    NodeRef node = *i;
+    if( i.isExit() ) {
+      result += "/";
+    }
+    switch( node.kind() ) {
+      case WEBVTT_TEXT:
+        result.append( node.textView().data(), node.textView().length() );
+        break;
+      case WEBVTT_VOICE: result += "v"; break;
+      case WEBVTT_LANG: result += "lang"; break;
+      case WEBVTT_BOLD: result += "b"; break;
+      case WEBVTT_ITALIC: result += "i"; break;
+      default: result += "?"; break;
+    }
+    result += ",";
+  }
+  return result;
+}
+
+TEST_F(Wrappers, PreOrder)
+{
+  EXPECT_EQ( "v,Hello, ,lang,World,", walk( parser.cues[ 0 ].nodes() ) );
+  EXPECT_EQ( "v,Hello,/v, ,lang,World,/lang,",
+             walk( parser.cues[ 0 ].events() ) );
+
+  int count = 0;
+  for( auto node : parser.cues[ 0 ].nodes() ) {
+    EXPECT_FALSE( node.isNull() );
+    ++count;
+  }
+  EXPECT_EQ( 5, count );
+}
+
+TEST(WrappersWalk, EmptyNodes)
+{
+  StringParser parser;
+  parser.parse( "WEBVTT\n\n00:00.000 --> 00:01.000\n<b></b><i>x</i><b></b>\n\n"
+                "00:01.000 --> 00:02.000\n\n" );
+  ASSERT_EQ( 2U, parser.cues.size() );
+  EXPECT_EQ( "b,i,x,b,", walk( parser.cues[ 0 ].nodes() ) );
+  EXPECT_EQ( "b,/b,i,x,/i,b,/b,", walk( parser.cues[ 0 ].events() ) );
+  EXPECT_EQ( "", walk( parser.cues[ 1 ].nodes() ) );
+  EXPECT_EQ( "", walk( parser.cues[ 1 ].events() ) );
+}
+
+/**
+ * Below NodeWalk::MAX_DEPTH, positions are found from the parent instead
+ */
+TEST(WrappersWalk, Deep)
+{
+  std::string text = "WEBVTT\n\n00:00.000 --> 00:01.000\n", open, close,
+              expected, events;
+  for( int i = 0; i < 24; ++i ) {
+    open += "<b>x";
+    close += "</b>y";
+    expected += "b,x,";
+    events += "b,x,";
+  }
+  for( int i = 0; i < 24; ++i ) {
+    expected += "y,";
+    events += "/b,y,";
+  }
+  StringParser parser;
+  parser.parse( ( text + open + close + "\n" ).c_str() );
+  ASSERT_EQ( 1U, parser.cues.size() );
+  EXPECT_EQ( expected, walk( parser.cues[ 0 ].nodes() ) );
+  EXPECT_EQ( events, walk( parser.cues[ 0 ].events() ) );
+}